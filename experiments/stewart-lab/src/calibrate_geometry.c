@@ -0,0 +1,346 @@
+#define _DEFAULT_SOURCE
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <stewart/calibrate.h>
+#include <stewart/geometry.h>
+#include <stewart/geometry_file.h>
+#include <stewart/kinematics.h>
+#include <stewart/pose.h>
+
+/*
+ * Kalibrering av Stewart geometri fra loggede data
+ *
+ * Logg-format (én sample per linje, '#' er kommentar):
+ *   rx ry rz tx ty tz m0 m1 m2 m3 m4 m5
+ * der pose er i grader/mm og motor vinkler i grader.
+ *
+ * Med -S genereres syntetiske data fra en perturbert "sann" geometri,
+ * slik at man kan se hvor godt kalibreringen finner den igjen.
+ */
+
+/**
+ * struct sample_buffer - Voksende array av samples
+ * @data: samples
+ * @count: antall samples
+ * @capacity: allokert kapasitet
+ */
+struct sample_buffer {
+	struct stewart_calib_sample *data;
+	size_t count;
+	size_t capacity;
+};
+
+static int sample_buffer_push(struct sample_buffer *buf,
+			      const struct stewart_calib_sample *sample)
+{
+	struct stewart_calib_sample *grown;
+
+	if (buf->count == buf->capacity) {
+		buf->capacity = buf->capacity ? buf->capacity * 2 : 1024;
+		grown = realloc(buf->data, buf->capacity * sizeof(*grown));
+		if (!grown)
+			return -1;
+		buf->data = grown;
+	}
+
+	buf->data[buf->count++] = *sample;
+	return 0;
+}
+
+/**
+ * load_log - Les samples fra loggfil
+ * @path: filsti
+ * @buf: output buffer
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+static int load_log(const char *path, struct sample_buffer *buf)
+{
+	struct stewart_calib_sample s;
+	char line[512];
+	FILE *f;
+	int line_no = 0, n;
+
+	f = fopen(path, "r");
+	if (!f) {
+		perror(path);
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), f)) {
+		line_no++;
+		if (line[strspn(line, " \t\r\n")] == '\0' || line[0] == '#')
+			continue;
+
+		n = sscanf(line, "%f %f %f %f %f %f %f %f %f %f %f %f",
+			   &s.pose.rx, &s.pose.ry, &s.pose.rz, &s.pose.tx,
+			   &s.pose.ty, &s.pose.tz, &s.motor_angles_deg[0],
+			   &s.motor_angles_deg[1], &s.motor_angles_deg[2],
+			   &s.motor_angles_deg[3], &s.motor_angles_deg[4],
+			   &s.motor_angles_deg[5]);
+		if (n != 12) {
+			fprintf(stderr, "%s:%d: expected 12 values\n", path,
+				line_no);
+			fclose(f);
+			return -1;
+		}
+
+		if (sample_buffer_push(buf, &s) < 0) {
+			fprintf(stderr, "Out of memory\n");
+			fclose(f);
+			return -1;
+		}
+	}
+
+	fclose(f);
+	return 0;
+}
+
+/* Normalfordelt N(0, sigma²) med Box-Muller */
+static float gaussian(float sigma)
+{
+	double u1 = drand48() + 1e-12;
+	double u2 = drand48();
+
+	return sigma * (float)(sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2));
+}
+
+static float uniform(float amplitude)
+{
+	return amplitude * (float)(2.0 * drand48() - 1.0);
+}
+
+/**
+ * make_synthetic - Generer syntetiske samples fra perturbert geometri
+ * @nominal: nominell geometri
+ * @count: antall samples
+ * @sigma_point: perturbasjon av festepunkter (mm)
+ * @noise_deg: målestøy på motor vinkler (grader)
+ * @truth: output - "sann" geometri
+ * @buf: output samples
+ */
+static int make_synthetic(const struct stewart_geometry *nominal, long count,
+			  float sigma_point, float noise_deg,
+			  struct stewart_geometry *truth,
+			  struct sample_buffer *buf)
+{
+	struct stewart_inverse_result inverse;
+	struct stewart_calib_sample s;
+	float rot = nominal->max_pose_rotation_amplitude;
+	float trans = nominal->max_pose_translation_amplitude;
+	int i;
+
+	*truth = *nominal;
+	for (i = 0; i < 6; i++) {
+		truth->base_points[i].x += gaussian(sigma_point);
+		truth->base_points[i].y += gaussian(sigma_point);
+		truth->base_points[i].z += gaussian(sigma_point);
+		truth->platform_points_flat[i].x += gaussian(sigma_point);
+		truth->platform_points_flat[i].z += gaussian(sigma_point);
+	}
+	truth->short_foot_length += gaussian(sigma_point * 0.5f);
+	truth->long_foot_length += gaussian(sigma_point * 0.5f);
+
+	while ((long)buf->count < count) {
+		stewart_pose_set(&s.pose, uniform(rot), uniform(rot),
+				 uniform(rot), uniform(trans), uniform(trans),
+				 uniform(trans));
+
+		/*
+		 * Motor vinkler fra IK, og posen roboten (sann geometri)
+		 * faktisk får med dem fra FK. Da stemmer data eksakt med
+		 * kne-modellen også når IK clamper vinklene.
+		 */
+		stewart_kinematics_inverse(truth, &s.pose, &inverse, 0);
+		if (stewart_kinematics_forward_solve(truth,
+						     inverse.motor_angles_deg,
+						     &s.pose, 20, 0.001f) < 0)
+			continue;
+
+		for (i = 0; i < 6; i++)
+			s.motor_angles_deg[i] = inverse.motor_angles_deg[i] +
+						gaussian(noise_deg);
+
+		if (sample_buffer_push(buf, &s) < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * geometry_error_rms - RMS avvik mellom to geometrier (mm)
+ *
+ * Over base punkter, platform punkter (x, z) og benlengder.
+ */
+static float geometry_error_rms(const struct stewart_geometry *a,
+				const struct stewart_geometry *b)
+{
+	double sum = 0.0, d;
+	int i, n = 0;
+
+	for (i = 0; i < 6; i++) {
+		d = a->base_points[i].x - b->base_points[i].x;
+		sum += d * d;
+		d = a->base_points[i].y - b->base_points[i].y;
+		sum += d * d;
+		d = a->base_points[i].z - b->base_points[i].z;
+		sum += d * d;
+		d = a->platform_points_flat[i].x - b->platform_points_flat[i].x;
+		sum += d * d;
+		d = a->platform_points_flat[i].z - b->platform_points_flat[i].z;
+		sum += d * d;
+		n += 5;
+	}
+	d = a->short_foot_length - b->short_foot_length;
+	sum += d * d;
+	d = a->long_foot_length - b->long_foot_length;
+	sum += d * d;
+	n += 2;
+
+	return (float)sqrt(sum / n);
+}
+
+static void print_usage(const char *prog)
+{
+	printf("Usage: %s [options] <logfile>\n", prog);
+	printf("       %s [options] -S <samples>\n", prog);
+	printf("  -r mx64|ax18   Initial geometry (default mx64)\n");
+	printf("  -g <file>      Initial geometry from geometry file\n");
+	printf("  -o <file>      Save calibrated geometry to file\n");
+	printf("  -j <threads>   Threads (default: online CPUs)\n");
+	printf("  -i <iter>      Max LM iterations (default 50)\n");
+	printf("  -H             Also estimate home_height\n");
+	printf("  -v             Print LM progress\n");
+	printf("  -S <samples>   Synthetic data from a perturbed geometry\n");
+	printf("  -p <mm>        Synthetic: attachment point sigma (default 2)\n");
+	printf("  -m <deg>       Synthetic: motor angle noise (default 0.05)\n");
+}
+
+int main(int argc, char **argv)
+{
+	const struct stewart_geometry *initial = &ROBOT_MX64;
+	struct stewart_geometry loaded, truth, calibrated;
+	struct stewart_calib_options options;
+	struct stewart_calib_report report;
+	struct sample_buffer samples = { NULL, 0, 0 };
+	struct timespec t0, t1;
+	const char *output = NULL;
+	long synthetic = 0;
+	float sigma_point = 2.0f, noise_deg = 0.05f;
+	int opt;
+
+	stewart_calib_options_default(&options);
+
+	while ((opt = getopt(argc, argv, "r:g:o:j:i:HvS:p:m:h")) != -1) {
+		switch (opt) {
+		case 'r':
+			if (strcmp(optarg, "mx64") == 0) {
+				initial = &ROBOT_MX64;
+			} else if (strcmp(optarg, "ax18") == 0) {
+				initial = &ROBOT_AX18;
+			} else {
+				fprintf(stderr, "Unknown robot: %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 'g':
+			if (stewart_geometry_load(optarg, &loaded) < 0)
+				return 1;
+			initial = &loaded;
+			break;
+		case 'o':
+			output = optarg;
+			break;
+		case 'j':
+			options.num_threads = atoi(optarg);
+			break;
+		case 'i':
+			options.max_iterations = atoi(optarg);
+			break;
+		case 'H':
+			options.params |= STEWART_CALIB_HOME_HEIGHT;
+			break;
+		case 'v':
+			options.verbose = 1;
+			break;
+		case 'S':
+			synthetic = atol(optarg);
+			break;
+		case 'p':
+			sigma_point = strtof(optarg, NULL);
+			break;
+		case 'm':
+			noise_deg = strtof(optarg, NULL);
+			break;
+		default:
+			print_usage(argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	printf("Stewart Platform Geometry Calibration\n");
+	printf("=====================================\n\n");
+
+	if (synthetic > 0) {
+		srand48(1);
+		if (make_synthetic(initial, synthetic, sigma_point, noise_deg,
+				   &truth, &samples) < 0) {
+			fprintf(stderr, "Out of memory\n");
+			return 1;
+		}
+		printf("Synthetic: %zu samples, point sigma %.2f mm, "
+		       "angle noise %.3f deg\n",
+		       samples.count, sigma_point, noise_deg);
+	} else if (optind < argc) {
+		if (load_log(argv[optind], &samples) < 0)
+			return 1;
+		printf("Loaded %zu samples from %s\n", samples.count,
+		       argv[optind]);
+	} else {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	if (stewart_calibrate(initial, samples.data, samples.count, &options,
+			      &calibrated, &report) < 0) {
+		fprintf(stderr, "Calibration failed\n");
+		free(samples.data);
+		return 1;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	printf("\nLevenberg-Marquardt: %d iterations%s, %d params, "
+	       "%zu residuals, %.3f s\n",
+	       report.iterations, report.converged ? "" : " (not converged)",
+	       report.num_params, report.num_residuals,
+	       (t1.tv_sec - t0.tv_sec) + 1e-9 * (t1.tv_nsec - t0.tv_nsec));
+	printf("  Leg closure RMS: %.4f mm -> %.4f mm (max %.4f mm)\n",
+	       report.rms_initial_mm, report.rms_final_mm,
+	       report.max_final_mm);
+
+	if (synthetic > 0) {
+		printf("  Geometry error vs truth: %.4f mm -> %.4f mm RMS\n",
+		       geometry_error_rms(initial, &truth),
+		       geometry_error_rms(&calibrated, &truth));
+	}
+
+	printf("\nCalibrated ");
+	stewart_geometry_print(&calibrated);
+
+	if (output) {
+		if (stewart_geometry_save(output, &calibrated) < 0) {
+			free(samples.data);
+			return 1;
+		}
+		printf("\nSaved calibrated geometry to %s\n", output);
+	}
+
+	free(samples.data);
+	return 0;
+}
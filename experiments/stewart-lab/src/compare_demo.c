@@ -1,11 +1,11 @@
+#define _DEFAULT_SOURCE
+#include "transport.h"
+#include "udp.h"
 #include "viz_protocol.h"
-#include <arpa/inet.h>
 #include <math.h>
-#include <netinet/in.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/socket.h>
 #include <unistd.h>
 #include <stewart/geometry.h>
 #include <stewart/kinematics.h>
@@ -21,65 +21,28 @@ static struct stewart_forward_result forward_result;
 struct stewart_pose pose_reference = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
 struct stewart_pose pose_calculated = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
 
-/**
- * udp_create_sender - Lag UDP socket for sending
- */
-static int udp_create_sender(void)
-{
-	int sock;
-
-	sock = socket(AF_INET, SOCK_DGRAM, 0);
-	if (sock < 0) {
-		perror("socket");
-		return -1;
-	}
-
-	return sock;
-}
+/* Strøm 0 går til port 9001 (reference), strøm 1 til 9002 (calculated) */
+static const int compare_ports[2] = { 9001, 9002 };
 
 /**
- * send_pose_to_port - Send pose via UDP til spesifikk port
- * @sock: UDP socket
+ * pack_pose - Pakk stewart_pose inn i viz_pose_packet
  * @pose: stewart_pose struktur
  * @robot_type: robot konfigurasjon type
- * @port: destinasjons port
- *
- * Konverterer stewart_pose til viz_pose_packet og sender via UDP.
+ * @packet: output packet
  */
-static int send_pose_to_port(int sock, const struct stewart_pose *pose,
-			     enum stewart_robot_type robot_type, int port)
+static void pack_pose(const struct stewart_pose *pose,
+		      enum stewart_robot_type robot_type,
+		      struct viz_pose_packet *packet)
 {
-	struct sockaddr_in addr;
-	struct viz_pose_packet packet;
-	ssize_t sent;
-
-	/* Pakk stewart_pose inn i viz_pose_packet */
-	packet.magic = VIZ_MAGIC;
-	packet.type = VIZ_PACKET_POSE;
-	packet.robot_type = robot_type;
-	packet.rx = pose->rx;
-	packet.ry = pose->ry;
-	packet.rz = pose->rz;
-	packet.tx = pose->tx;
-	packet.ty = pose->ty;
-	packet.tz = pose->tz;
-
-	/* Sett opp destinasjonsadresse */
-	memset(&addr, 0, sizeof(addr));
-	addr.sin_family = AF_INET;
-	addr.sin_port = htons(port);
-	addr.sin_addr.s_addr = inet_addr("127.0.0.1");
-
-	/* Send pakke */
-	sent = sendto(sock, &packet, sizeof(packet), 0,
-		      (struct sockaddr *)&addr, sizeof(addr));
-
-	if (sent < 0) {
-		perror("sendto");
-		return -1;
-	}
-
-	return 0;
+	packet->magic = VIZ_MAGIC;
+	packet->type = VIZ_PACKET_POSE;
+	packet->robot_type = robot_type;
+	packet->rx = pose->rx;
+	packet->ry = pose->ry;
+	packet->rz = pose->rz;
+	packet->tx = pose->tx;
+	packet->ty = pose->ty;
+	packet->tz = pose->tz;
 }
 
 /**
@@ -136,20 +99,6 @@ generate_calculated_motion(const struct stewart_geometry *geometry,
 			   struct stewart_forward_result *forward_result,
 			   struct stewart_pose *calc_pose)
 {
-
-	/*
-	 * Itererer, basert på faste kneledd pos (inverse_result) og
-	 * fast platform pos (ref_pose)
-	 */
-	for (int i = 0; i < 20; i++) {
-		stewart_kinematics_forward(geometry, &calc_pose,
-					   &inverse_result, &forward_result);
-
-		// ++++ result_inv->platform_points_transformed
-		calculate_transformed_platform_points(active_robot, &pose_calc,
-						      &result_inv);
-	}
-
 	int i;
 
 	/*
@@ -173,27 +122,98 @@ generate_calculated_motion(const struct stewart_geometry *geometry,
 	*calc_pose = forward_result->pose_result;
 }
 
-int main(void)
+int main(int argc, char **argv)
 {
 	struct stewart_pose pose1, pose2;
-	int sock;
+	struct viz_pose_packet poses[2];
+	struct viz_pose_packet_v2 packets[2];
+	union viz_pose_q16_packet q16_packets[2];
+	struct viz_q16_encoder q16[2];
+	uint32_t sequences[2] = { 0, 0 };
+	struct udp_message msgs[2] = {
+		{ 0, &packets[0], sizeof(packets[0]) },
+		{ 1, &packets[1], sizeof(packets[1]) },
+	};
+	struct udp_sender sender;
+	struct viz_transport transports[2];
+	const char *host = NULL;
+	int i, opt, ret, use_transports = 0, quantize = 0;
 	float time = 0.0f;
 	float dt = 0.016f; /* ~60 FPS */
 
+	while ((opt = getopt(argc, argv, "d:qh")) != -1) {
+		switch (opt) {
+		case 'd':
+			host = optarg;
+			break;
+		case 'q':
+			quantize = 1;
+			break;
+		default:
+			printf("Usage: %s [-d host] [-q] [endpoint1 endpoint2]\n",
+			       argv[0]);
+			printf("  -q        Quantized int16 poses with delta "
+			       "encoding\n");
+			printf("  endpoint  udp:[host:]<port> or shm:<name>\n");
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	/*
+	 * Egne endpoints, f.eks. shm:ref shm:calc for shared memory. Ellers
+	 * UDP til 9001/9002 med begge packets i ett sendmmsg-kall.
+	 */
+	if (optind + 2 == argc) {
+		use_transports = 1;
+	} else if (optind != argc) {
+		fprintf(stderr, "Expected two endpoints\n");
+		return 1;
+	}
+
 	printf("Stewart Platform Comparison Demo\n");
 	printf("=================================\n\n");
 	printf("Sending poses to:\n");
-	printf("  Port 9001: Reference/Target (CYAN)\n");
-	printf("  Port 9002: Calculated/Forward (MAGENTA)\n\n");
+	printf("  %s: Reference/Target (CYAN)\n",
+	       use_transports ? argv[optind] : "Port 9001");
+	printf("  %s: Calculated/Forward (MAGENTA)\n\n",
+	       use_transports ? argv[optind + 1] : "Port 9002");
 	printf("Shows difference between reference pose and forward kinematics.\n");
 	printf("Press Ctrl+C to stop\n\n");
 
 	/* Initialiser robot geometri */
 	geometry = ROBOT_MX64;
 
-	/* Lag UDP sender */
-	sock = udp_create_sender();
-	if (sock < 0) {
+	/* Kvantiseringsområde fra geometriens pose-grenser */
+	if (quantize) {
+		struct viz_q16_scale scale = {
+			.rotation_range = geometry.max_pose_rotation_amplitude +
+					  geometry.max_pose_rotation_bias,
+			.translation_range =
+				geometry.max_pose_translation_amplitude +
+				geometry.max_pose_translation_bias,
+		};
+		float rotation_error, translation_error;
+
+		viz_q16_encoder_init(&q16[0], &scale, 0);
+		viz_q16_encoder_init(&q16[1], &scale, 0);
+		viz_q16_error_bound(&scale, &rotation_error,
+				    &translation_error);
+		printf("Quantized: ±%.1f° / ±%.1f mm, error ≤ %.4f° / "
+		       "%.4f mm\n\n", scale.rotation_range,
+		       scale.translation_range, rotation_error,
+		       translation_error);
+	}
+
+	/* Lag sender */
+	if (use_transports) {
+		if (viz_transport_open_sender(&transports[0], argv[optind]) < 0)
+			return 1;
+		if (viz_transport_open_sender(&transports[1],
+					      argv[optind + 1]) < 0) {
+			viz_transport_close(&transports[0]);
+			return 1;
+		}
+	} else if (udp_sender_open(&sender, host, compare_ports, 2, 0) < 0) {
 		fprintf(stderr, "Failed to create UDP sender\n");
 		return 1;
 	}
@@ -206,11 +226,31 @@ int main(void)
 		generate_calculated_motion(&geometry, &inverse_result,
 					   &forward_result, &pose2);
 
-		/* Send til hver sin port */
-		if (send_pose_to_port(sock, &pose1, ROBOT_TYPE_MX64, 9001) <
-			    0 ||
-		    send_pose_to_port(sock, &pose2, ROBOT_TYPE_MX64, 9002) <
-			    0) {
+		/* Send til hver sin strøm */
+		pack_pose(&pose1, ROBOT_TYPE_MX64, &poses[0]);
+		pack_pose(&pose2, ROBOT_TYPE_MX64, &poses[1]);
+		for (i = 0; i < 2; i++) {
+			if (quantize) {
+				msgs[i].data = &q16_packets[i];
+				msgs[i].length = viz_pose_q16_encode(
+					&q16[i], &poses[i], &sequences[i],
+					&q16_packets[i]);
+			} else {
+				viz_pose_encode(&poses[i], &sequences[i],
+						&packets[i]);
+			}
+		}
+		if (use_transports) {
+			ret = viz_transport_send(&transports[0], msgs[0].data,
+						 msgs[0].length);
+			if (ret == 0)
+				ret = viz_transport_send(&transports[1],
+							 msgs[1].data,
+							 msgs[1].length);
+		} else {
+			ret = udp_sender_send_batch(&sender, msgs, 2);
+		}
+		if (ret < 0) {
 			fprintf(stderr, "Failed to send poses\n");
 			break;
 		}
@@ -226,6 +266,15 @@ int main(void)
 			       "tx=%.1fmm ty=%.1fmm tz=%.1fmm\n\n",
 			       pose2.rx, pose2.ry, pose2.rz, pose2.tx, pose2.ty,
 			       pose2.tz);
+			if (quantize)
+				printf("  Quantized: %llu keyframes, %llu deltas, "
+				       "%llu clipped\n\n",
+				       (unsigned long long)(q16[0].keyframes +
+							    q16[1].keyframes),
+				       (unsigned long long)(q16[0].deltas +
+							    q16[1].deltas),
+				       (unsigned long long)(q16[0].clipped +
+							    q16[1].clipped));
 		}
 
 		/* Oppdater tid */
@@ -235,6 +284,11 @@ int main(void)
 		usleep((int)(dt * 1000000));
 	}
 
-	close(sock);
+	if (use_transports) {
+		viz_transport_close(&transports[0]);
+		viz_transport_close(&transports[1]);
+	} else {
+		udp_sender_close(&sender);
+	}
 	return 0;
 }
@@ -0,0 +1,173 @@
+#define _DEFAULT_SOURCE
+#include "udp.h"
+#include "viz_protocol.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846f
+#endif
+
+/*
+ * Poser for en hel flåte av plattformer
+ *
+ * Alle roboter sendes som batch packets (opptil VIZ_BATCH_MAX_RECORDS
+ * poser per datagram), og alle datagrammer for én tick går i ett
+ * sendmmsg-kall. Hver robot kjører samme kombinerte bevegelse med egen
+ * fase, så flåten "bølger".
+ */
+
+#define FLEET_MAX_DATAGRAMS \
+	((VIZ_FLEET_MAX_ROBOTS + VIZ_BATCH_MAX_RECORDS - 1) / \
+	 VIZ_BATCH_MAX_RECORDS)
+
+/**
+ * generate_fleet_motion - Generer pose for én robot i flåten
+ * @time: tid i sekunder
+ * @robot_id: robot
+ * @num_robots: antall roboter
+ * @robot_type: robot konfigurasjon type
+ * @rec: output record
+ */
+static void generate_fleet_motion(float time, int robot_id, int num_robots,
+				  enum stewart_robot_type robot_type,
+				  struct viz_pose_record *rec)
+{
+	float phase = 2.0f * M_PI * robot_id / num_robots;
+
+	rec->robot_id = robot_id;
+	rec->robot_type = robot_type;
+
+	rec->rx = 5.0f * sinf(time * 1.2f + phase);
+	rec->ry = 5.0f * cosf(time * 0.8f + phase);
+	rec->rz = 10.0f * sinf(time * 0.5f + phase);
+
+	rec->tx = 15.0f * cosf(time * 0.6f + phase);
+	rec->ty = 5.0f * sinf(time * 1.0f + phase);
+	rec->tz = 15.0f * sinf(time * 0.6f + phase);
+}
+
+static void print_usage(const char *prog)
+{
+	printf("Usage: %s [options]\n", prog);
+	printf("  -n <robots>  Number of robots (default 30, max %d)\n",
+	       VIZ_FLEET_MAX_ROBOTS);
+	printf("  -r <hz>      Send rate (default 60)\n");
+	printf("  -a           AX18 geometry (default MX64)\n");
+	printf("  -d <host>    Destination (default localhost)\n");
+	printf("  -p <port>    Destination port (default %d)\n", VIZ_PORT);
+}
+
+int main(int argc, char **argv)
+{
+	static struct viz_pose_record records[VIZ_FLEET_MAX_ROBOTS];
+	static struct viz_pose_batch_packet packets[FLEET_MAX_DATAGRAMS];
+	struct udp_message msgs[FLEET_MAX_DATAGRAMS];
+	enum stewart_robot_type robot_type = ROBOT_TYPE_MX64;
+	struct udp_sender sender;
+	struct timespec next;
+	const char *host = NULL;
+	uint32_t sequence = 0;
+	int num_robots = 30, port = VIZ_PORT;
+	int i, n, opt, num_datagrams;
+	long tick = 0, period_ns;
+	float rate = 60.0f;
+
+	while ((opt = getopt(argc, argv, "n:r:ad:p:h")) != -1) {
+		switch (opt) {
+		case 'n':
+			num_robots = atoi(optarg);
+			break;
+		case 'r':
+			rate = strtof(optarg, NULL);
+			break;
+		case 'a':
+			robot_type = ROBOT_TYPE_AX18;
+			break;
+		case 'd':
+			host = optarg;
+			break;
+		case 'p':
+			port = atoi(optarg);
+			break;
+		default:
+			print_usage(argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (num_robots < 1 || num_robots > VIZ_FLEET_MAX_ROBOTS ||
+	    rate <= 0.0f) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (udp_sender_open(&sender, host, &port, 1, 0) < 0) {
+		fprintf(stderr, "Failed to create UDP sender\n");
+		return 1;
+	}
+
+	num_datagrams = (num_robots + VIZ_BATCH_MAX_RECORDS - 1) /
+			VIZ_BATCH_MAX_RECORDS;
+	period_ns = (long)(1e9f / rate);
+
+	printf("Stewart Platform Fleet Patterns\n");
+	printf("===============================\n\n");
+	printf("Sending %d robots to %s:%d at %.0f Hz\n", num_robots,
+	       host ? host : "localhost", port, rate);
+	printf("%d datagram(s) per tick instead of %d single-pose packets\n",
+	       num_datagrams, num_robots);
+	printf("Press Ctrl+C to stop\n\n");
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+
+	while (1) {
+		float time = tick / rate;
+
+		for (i = 0; i < num_robots; i++)
+			generate_fleet_motion(time, i, num_robots, robot_type,
+					      &records[i]);
+
+		/* Del flåten i MTU-store batch packets */
+		for (i = 0; i < num_datagrams; i++) {
+			n = num_robots - i * VIZ_BATCH_MAX_RECORDS;
+			if (n > VIZ_BATCH_MAX_RECORDS)
+				n = VIZ_BATCH_MAX_RECORDS;
+
+			msgs[i].stream = 0;
+			msgs[i].data = &packets[i];
+			msgs[i].length = viz_pose_batch_encode(
+				&records[i * VIZ_BATCH_MAX_RECORDS], n,
+				&sequence, &packets[i]);
+		}
+
+		if (udp_sender_send_batch(&sender, msgs, num_datagrams) < 0) {
+			fprintf(stderr, "Failed to send poses\n");
+			break;
+		}
+
+		/* Print status hvert sekund */
+		if (tick % (long)rate == 0) {
+			printf("t=%.1fs  robot 0: rx=%.1f° ry=%.1f° rz=%.1f°  "
+			       "%ld datagrams\n", time, records[0].rx,
+			       records[0].ry, records[0].rz,
+			       (long)sequence);
+		}
+
+		/* Fast rate uten drift: sov til neste absolutte tick */
+		tick++;
+		next.tv_nsec += period_ns;
+		while (next.tv_nsec >= 1000000000L) {
+			next.tv_nsec -= 1000000000L;
+			next.tv_sec++;
+		}
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+	}
+
+	udp_sender_close(&sender);
+	return 0;
+}
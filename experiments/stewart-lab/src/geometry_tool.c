@@ -0,0 +1,240 @@
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stewart/geometry.h>
+#include <stewart/geometry_file.h>
+#include <stewart/kinematics.h>
+#include <stewart/pose.h>
+
+/*
+ * Verktøy for geometri-filer
+ *
+ * Eksporterer innebygde geometrier til tekstformat, validerer filer,
+ * bygger binær cache og måler IK med forberedt geometri.
+ */
+
+static double elapsed_s(const struct timespec *t0, const struct timespec *t1)
+{
+	return (t1->tv_sec - t0->tv_sec) + 1e-9 * (t1->tv_nsec - t0->tv_nsec);
+}
+
+/**
+ * geometry_name - Navn fra filsti (basename uten endelse)
+ * @path: filsti
+ * @name: output buffer (STEWART_GEOMETRY_NAME_MAX)
+ */
+static void geometry_name(const char *path, char *name)
+{
+	const char *base = strrchr(path, '/');
+	char *dot;
+
+	base = base ? base + 1 : path;
+	snprintf(name, STEWART_GEOMETRY_NAME_MAX, "%s", base);
+	dot = strrchr(name, '.');
+	if (dot && dot != name)
+		*dot = '\0';
+}
+
+static int cmd_export(int argc, char **argv)
+{
+	const struct stewart_geometry *geom;
+
+	if (argc != 2)
+		return -1;
+
+	if (strcmp(argv[0], "mx64") == 0) {
+		geom = &ROBOT_MX64;
+	} else if (strcmp(argv[0], "ax18") == 0) {
+		geom = &ROBOT_AX18;
+	} else {
+		fprintf(stderr, "Unknown robot: %s\n", argv[0]);
+		return 1;
+	}
+
+	if (stewart_geometry_save(argv[1], geom) < 0)
+		return 1;
+
+	printf("Wrote %s\n", argv[1]);
+	return 0;
+}
+
+static int cmd_check(int argc, char **argv)
+{
+	struct stewart_geometry geom;
+	int i, failed = 0;
+
+	if (argc < 1)
+		return -1;
+
+	for (i = 0; i < argc; i++) {
+		if (stewart_geometry_load(argv[i], &geom) < 0) {
+			failed = 1;
+			continue;
+		}
+		printf("%s: OK\n", argv[i]);
+		if (argc == 1)
+			stewart_geometry_print(&geom);
+	}
+
+	return failed;
+}
+
+static int cmd_cache(int argc, char **argv)
+{
+	struct stewart_geometry *geoms;
+	char (*names)[STEWART_GEOMETRY_NAME_MAX];
+	const char **name_ptrs;
+	int i, n = argc - 1, ret = 1;
+
+	if (argc < 2)
+		return -1;
+
+	geoms = calloc(n, sizeof(*geoms));
+	names = calloc(n, sizeof(*names));
+	name_ptrs = calloc(n, sizeof(*name_ptrs));
+	if (!geoms || !names || !name_ptrs) {
+		fprintf(stderr, "Out of memory\n");
+		goto out;
+	}
+
+	for (i = 0; i < n; i++) {
+		if (stewart_geometry_load(argv[i + 1], &geoms[i]) < 0)
+			goto out;
+		geometry_name(argv[i + 1], names[i]);
+		name_ptrs[i] = names[i];
+	}
+
+	if (stewart_geometry_cache_write(argv[0], name_ptrs, geoms, n) < 0)
+		goto out;
+
+	printf("Wrote %d geometries to %s\n", n, argv[0]);
+	ret = 0;
+out:
+	free(geoms);
+	free(names);
+	free(name_ptrs);
+	return ret;
+}
+
+static int cmd_list(int argc, char **argv)
+{
+	struct stewart_geometry_cache cache;
+	struct timespec t0, t1;
+	size_t i;
+
+	if (argc != 1)
+		return -1;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	if (stewart_geometry_cache_open(argv[0], &cache) < 0)
+		return 1;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	printf("%s: %zu geometries, opened in %.1f us\n", argv[0], cache.count,
+	       1e6 * elapsed_s(&t0, &t1));
+	for (i = 0; i < cache.count; i++) {
+		const struct stewart_geometry *geom =
+			&cache.entries[i].prepared.geom;
+
+		printf("  %-24s home %.2f mm, short %.2f mm, long %.2f mm\n",
+		       cache.entries[i].name, geom->home_height,
+		       geom->short_foot_length, geom->long_foot_length);
+	}
+
+	stewart_geometry_cache_close(&cache);
+	return 0;
+}
+
+static int cmd_bench(int argc, char **argv)
+{
+	struct stewart_geometry_prepared prep;
+	struct stewart_inverse_result *results;
+	struct stewart_pose *poses;
+	struct timespec t0, t1, t2;
+	float amp;
+	long i, n = argc > 1 ? atol(argv[1]) : 200000;
+
+	if (argc < 1 || n <= 0)
+		return -1;
+
+	if (stewart_geometry_load_prepared(argv[0], &prep) < 0)
+		return 1;
+
+	poses = malloc(n * sizeof(*poses));
+	results = malloc(n * sizeof(*results));
+	if (!poses || !results) {
+		fprintf(stderr, "Out of memory\n");
+		free(poses);
+		free(results);
+		return 1;
+	}
+
+	srand48(1);
+	amp = prep.geom.max_pose_rotation_amplitude;
+	for (i = 0; i < n; i++) {
+		stewart_pose_set(&poses[i], amp * (2.0 * drand48() - 1.0),
+				 amp * (2.0 * drand48() - 1.0),
+				 amp * (2.0 * drand48() - 1.0),
+				 amp * (2.0 * drand48() - 1.0),
+				 amp * (2.0 * drand48() - 1.0),
+				 amp * (2.0 * drand48() - 1.0));
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (i = 0; i < n; i++)
+		stewart_kinematics_inverse(&prep.geom, &poses[i], &results[i], 0);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	stewart_kinematics_inverse_batch(&prep, poses, n, results);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+
+	printf("IK, %ld poses:\n", n);
+	printf("  stewart_kinematics_inverse:       %7.1f ns/pose\n",
+	       1e9 * elapsed_s(&t0, &t1) / n);
+	printf("  stewart_kinematics_inverse_batch: %7.1f ns/pose\n",
+	       1e9 * elapsed_s(&t1, &t2) / n);
+
+	free(poses);
+	free(results);
+	return 0;
+}
+
+static void print_usage(const char *prog)
+{
+	printf("Usage: %s <command> [args]\n", prog);
+	printf("  export mx64|ax18 <file>    Write built-in geometry\n");
+	printf("  check <file>...            Load and validate\n");
+	printf("  cache <out> <file>...      Build binary cache\n");
+	printf("  list <cache>               List cache contents\n");
+	printf("  bench <file> [poses]       Time IK with prepared geometry\n");
+}
+
+int main(int argc, char **argv)
+{
+	int ret;
+
+	if (argc < 2) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (strcmp(argv[1], "export") == 0)
+		ret = cmd_export(argc - 2, argv + 2);
+	else if (strcmp(argv[1], "check") == 0)
+		ret = cmd_check(argc - 2, argv + 2);
+	else if (strcmp(argv[1], "cache") == 0)
+		ret = cmd_cache(argc - 2, argv + 2);
+	else if (strcmp(argv[1], "list") == 0)
+		ret = cmd_list(argc - 2, argv + 2);
+	else if (strcmp(argv[1], "bench") == 0)
+		ret = cmd_bench(argc - 2, argv + 2);
+	else
+		ret = -1;
+
+	if (ret < 0) {
+		print_usage(argv[0]);
+		return 1;
+	}
+	return ret;
+}
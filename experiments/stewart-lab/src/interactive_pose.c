@@ -1,11 +1,10 @@
+#define _DEFAULT_SOURCE
+#include "udp.h"
 #include "viz_protocol.h"
-#include <arpa/inet.h>
 #include <math.h>
-#include <netinet/in.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/socket.h>
 #include <unistd.h>
 
 #ifndef M_PI
@@ -14,25 +13,8 @@
 
 /* Current pose state */
 static struct viz_pose_packet current_pose;
-static int udp_sock = -1;
-
-/**
- * udp_create_sender - Lag UDP socket for sending
- *
- * Retur: socket file descriptor, eller -1 ved feil
- */
-static int udp_create_sender(void)
-{
-	int sock;
-
-	sock = socket(AF_INET, SOCK_DGRAM, 0);
-	if (sock < 0) {
-		perror("socket");
-		return -1;
-	}
-
-	return sock;
-}
+static struct udp_sender sender;
+static uint32_t sequence;
 
 /**
  * send_current_pose - Send current pose via UDP til visualizer
@@ -41,23 +23,10 @@ static int udp_create_sender(void)
  */
 static int send_current_pose(void)
 {
-	struct sockaddr_in addr;
-	ssize_t sent;
+	struct viz_pose_packet_v2 packet;
 
-	memset(&addr, 0, sizeof(addr));
-	addr.sin_family = AF_INET;
-	addr.sin_port = htons(VIZ_PORT);
-	addr.sin_addr.s_addr = inet_addr("127.0.0.1");
-
-	sent = sendto(udp_sock, &current_pose, sizeof(current_pose), 0,
-		      (struct sockaddr *)&addr, sizeof(addr));
-
-	if (sent < 0) {
-		perror("sendto");
-		return -1;
-	}
-
-	return 0;
+	viz_pose_encode(&current_pose, &sequence, &packet);
+	return udp_sender_send(&sender, 0, &packet, sizeof(packet));
 }
 
 /**
@@ -181,9 +150,23 @@ static int parse_and_execute(const char *line)
 	return 0;
 }
 
-int main(void)
+int main(int argc, char **argv)
 {
+	const char *host = NULL;
+	int port = VIZ_PORT;
 	char line[256];
+	int opt;
+
+	while ((opt = getopt(argc, argv, "d:h")) != -1) {
+		switch (opt) {
+		case 'd':
+			host = optarg;
+			break;
+		default:
+			printf("Usage: %s [-d host]\n", argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
 
 	printf("Stewart Platform Interactive Pose Controller\n");
 	printf("=============================================\n\n");
@@ -195,13 +178,12 @@ int main(void)
 	current_pose.robot_type = ROBOT_TYPE_MX64;
 
 	/* Create UDP sender */
-	udp_sock = udp_create_sender();
-	if (udp_sock < 0) {
+	if (udp_sender_open(&sender, host, &port, 1, 0) < 0) {
 		fprintf(stderr, "Failed to create UDP sender\n");
 		return 1;
 	}
 
-	printf("Sending poses to localhost:%d\n", VIZ_PORT);
+	printf("Sending poses to %s:%d\n", host ? host : "localhost", port);
 	printf("Type 'help' for commands, 'quit' to exit\n\n");
 
 	/* Send initial home pose */
@@ -225,6 +207,6 @@ int main(void)
 	}
 
 	printf("\nExiting...\n");
-	close(udp_sock);
+	udp_sender_close(&sender);
 	return 0;
 }
@@ -1,65 +1,16 @@
+#define _DEFAULT_SOURCE
+#include "udp.h"
 #include "viz_protocol.h"
-#include <arpa/inet.h>
 #include <math.h>
-#include <netinet/in.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/socket.h>
 #include <unistd.h>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846f
 #endif
 
-/**
- * udp_create_sender - Lag UDP socket for sending
- *
- * Retur: socket file descriptor, eller -1 ved feil
- */
-static int udp_create_sender(void)
-{
-	int sock;
-
-	sock = socket(AF_INET, SOCK_DGRAM, 0);
-	if (sock < 0) {
-		perror("socket");
-		return -1;
-	}
-
-	return sock;
-}
-
-/**
- * send_pose - Send pose packet via UDP
- * @sock: UDP socket
- * @pose: pose packet som skal sendes
- *
- * Sender til localhost:9001 (visualizer)
- *
- * Retur: 0 ved suksess, -1 ved feil
- */
-static int send_pose(int sock, const struct viz_pose_packet *pose)
-{
-	struct sockaddr_in addr;
-	ssize_t sent;
-
-	memset(&addr, 0, sizeof(addr));
-	addr.sin_family = AF_INET;
-	addr.sin_port = htons(VIZ_PORT);
-	addr.sin_addr.s_addr = inet_addr("127.0.0.1");
-
-	sent = sendto(sock, pose, sizeof(*pose), 0, (struct sockaddr *)&addr,
-		      sizeof(addr));
-
-	if (sent < 0) {
-		perror("sendto");
-		return -1;
-	}
-
-	return 0;
-}
-
 /**
  * generate_circular_motion - Generer sirkulær bevegelse
  * @time: tid i sekunder
@@ -152,14 +103,29 @@ static void print_menu(void)
 	printf("Select pattern (1-4): ");
 }
 
-int main(void)
+int main(int argc, char **argv)
 {
 	struct viz_pose_packet pose;
-	int sock;
-	int choice;
+	struct viz_pose_packet_v2 packet;
+	struct udp_sender sender;
+	uint32_t sequence = 0;
+	const char *host = NULL;
+	int port = VIZ_PORT;
+	int choice, opt;
 	float time = 0.0f;
 	float dt = 0.016f; /* ~60 FPS */
 
+	while ((opt = getopt(argc, argv, "d:h")) != -1) {
+		switch (opt) {
+		case 'd':
+			host = optarg;
+			break;
+		default:
+			printf("Usage: %s [-d host]\n", argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
 	print_menu();
 	if (scanf("%d", &choice) != 1) {
 		fprintf(stderr, "Invalid input\n");
@@ -167,13 +133,12 @@ int main(void)
 	}
 
 	/* Lag UDP sender */
-	sock = udp_create_sender();
-	if (sock < 0) {
+	if (udp_sender_open(&sender, host, &port, 1, 0) < 0) {
 		fprintf(stderr, "Failed to create UDP sender\n");
 		return 1;
 	}
 
-	printf("\nSending poses to localhost:%d\n", VIZ_PORT);
+	printf("\nSending poses to %s:%d\n", host ? host : "localhost", port);
 	printf("Press Ctrl+C to stop\n\n");
 
 	/* Main loop */
@@ -203,12 +168,13 @@ int main(void)
 			break;
 		default:
 			fprintf(stderr, "Invalid choice\n");
-			close(sock);
+			udp_sender_close(&sender);
 			return 1;
 		}
 
 		/* Send pose */
-		if (send_pose(sock, &pose) < 0) {
+		viz_pose_encode(&pose, &sequence, &packet);
+		if (udp_sender_send(&sender, 0, &packet, sizeof(packet)) < 0) {
 			fprintf(stderr, "Failed to send pose\n");
 			break;
 		}
@@ -228,6 +194,6 @@ int main(void)
 		usleep((int)(dt * 1000000));
 	}
 
-	close(sock);
+	udp_sender_close(&sender);
 	return 0;
 }
\ No newline at end of file
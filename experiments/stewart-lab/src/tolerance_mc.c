@@ -0,0 +1,528 @@
+#define _DEFAULT_SOURCE
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <stewart/geometry.h>
+#include <stewart/kinematics.h>
+#include <stewart/pose.h>
+
+/*
+ * Monte Carlo toleranse-analyse
+ *
+ * Trekker tusenvis av perturberte kopier av en robot (jitter på
+ * festepunkter og benlengder), kjører IK på nominell geometri for
+ * kommandert pose (det kontrolleren gjør), og FK på den perturberte
+ * geometrien med de samme motor vinklene (det roboten faktisk gjør).
+ * Forskjellen er pose-feilen produksjonstoleransene gir.
+ */
+
+#define MAX_THREADS 64
+#define FK_MAX_ITERATIONS 20
+#define FK_TOLERANCE_MM 0.001f
+
+/**
+ * struct mc_config - Parametere for analysen
+ * @nominal: nominell robot geometri
+ * @command: kommandert pose (når random_pose = 0)
+ * @samples: antall perturberte kopier
+ * @threads: antall worker-tråder
+ * @seed: RNG seed
+ * @sigma_point_mm: standardavvik for festepunkter (mm)
+ * @sigma_length_mm: standardavvik for short/long foot (mm)
+ * @random_pose: 1 = trekk kommando uniformt innenfor max_pose_* per sample
+ */
+struct mc_config {
+	const struct stewart_geometry *nominal;
+	struct stewart_pose command;
+	long samples;
+	int threads;
+	uint64_t seed;
+	float sigma_point_mm;
+	float sigma_length_mm;
+	int random_pose;
+};
+
+/**
+ * struct mc_sample - Resultat for én perturbert kopi
+ * @error: pose-feil (faktisk - kommandert)
+ * @translation_error_mm: lengde av translasjonsfeil
+ * @rotation_error_deg: lengde av rotasjonsfeil (Euler, små vinkler)
+ * @converged: 1 hvis FK konvergerte
+ * @clamped: 1 hvis kommandoen er utenfor nominell arbeidsområde
+ *
+ * Samples med clamped motor vinkler tas ikke med i fordelingene, siden
+ * feilen der kommer fra clamping og ikke fra toleransene.
+ */
+struct mc_sample {
+	struct stewart_pose error;
+	float translation_error_mm;
+	float rotation_error_deg;
+	int converged;
+	int clamped;
+};
+
+/**
+ * struct mc_worker - Arbeidsområde for én tråd
+ * @config: delt konfigurasjon
+ * @results: delt resultat-array, indeksert med sample nummer
+ * @begin: første sample (inklusiv)
+ * @end: siste sample (eksklusiv)
+ */
+struct mc_worker {
+	const struct mc_config *config;
+	struct mc_sample *results;
+	long begin;
+	long end;
+};
+
+/**
+ * struct rng - splitmix64 RNG strøm
+ * @state: intern tilstand
+ */
+struct rng {
+	uint64_t state;
+};
+
+static uint64_t rng_next(struct rng *rng)
+{
+	uint64_t z = (rng->state += 0x9e3779b97f4a7c15ULL);
+
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+/**
+ * rng_seed_sample - Lag RNG strøm for ett sample
+ * @rng: RNG som skal seedes
+ * @seed: global seed
+ * @sample: sample nummer
+ *
+ * Hver tråd eier sin egen RNG, men strømmen seedes på nytt fra
+ * (seed, sample) for hvert sample. Resultatet for et sample er dermed
+ * det samme uansett hvilken tråd som regner det, og hele kjøringen er
+ * reproduserbar uavhengig av antall tråder.
+ */
+static void rng_seed_sample(struct rng *rng, uint64_t seed, long sample)
+{
+	rng->state = seed;
+	rng->state = rng_next(rng) ^ (uint64_t)sample;
+	rng_next(rng);
+}
+
+/* Uniform i [0, 1) med 24 bit oppløsning */
+static float rng_uniform(struct rng *rng)
+{
+	return (float)(rng_next(rng) >> 40) * (1.0f / 16777216.0f);
+}
+
+/* Normalfordelt N(0, 1) med Box-Muller */
+static float rng_gaussian(struct rng *rng)
+{
+	float u1 = rng_uniform(rng) + 1.0f / 16777216.0f;
+	float u2 = rng_uniform(rng);
+
+	return sqrtf(-2.0f * logf(u1)) * cosf(2.0f * (float)M_PI * u2);
+}
+
+static void jitter_point(struct rng *rng, struct vec3 *p, float sigma)
+{
+	p->x += sigma * rng_gaussian(rng);
+	p->y += sigma * rng_gaussian(rng);
+	p->z += sigma * rng_gaussian(rng);
+}
+
+/**
+ * perturb_geometry - Lag en perturbert kopi av geometrien
+ * @rng: RNG strøm for dette sample
+ * @nominal: nominell geometri
+ * @sigma_point: standardavvik for festepunkter (mm)
+ * @sigma_length: standardavvik for benlengder (mm)
+ * @out: perturbert geometri
+ */
+static void perturb_geometry(struct rng *rng,
+			     const struct stewart_geometry *nominal,
+			     float sigma_point, float sigma_length,
+			     struct stewart_geometry *out)
+{
+	int i;
+
+	*out = *nominal;
+
+	for (i = 0; i < 6; i++) {
+		jitter_point(rng, &out->base_points[i], sigma_point);
+		jitter_point(rng, &out->platform_points_flat[i], sigma_point);
+	}
+
+	out->short_foot_length += sigma_length * rng_gaussian(rng);
+	out->long_foot_length += sigma_length * rng_gaussian(rng);
+}
+
+static float uniform_range(struct rng *rng, float amplitude)
+{
+	return amplitude * (2.0f * rng_uniform(rng) - 1.0f);
+}
+
+/**
+ * random_command - Trekk kommandert pose innenfor geometri-grensene
+ */
+static void random_command(struct rng *rng,
+			   const struct stewart_geometry *geom,
+			   struct stewart_pose *pose)
+{
+	float rot = geom->max_pose_rotation_amplitude;
+	float trans = geom->max_pose_translation_amplitude;
+
+	pose->rx = uniform_range(rng, rot);
+	pose->ry = uniform_range(rng, rot);
+	pose->rz = uniform_range(rng, rot);
+	pose->tx = uniform_range(rng, trans);
+	pose->ty = uniform_range(rng, trans);
+	pose->tz = uniform_range(rng, trans);
+}
+
+/**
+ * motor_angles_clamped - Sjekk om IK har clampet noen motor vinkel
+ * @geom: geometri IK ble kjørt med
+ * @angles: motor vinkler fra IK
+ *
+ * Retur: 1 hvis minst én vinkel ligger på en hard limit
+ */
+static int motor_angles_clamped(const struct stewart_geometry *geom,
+				const float angles[6])
+{
+	float min, max;
+	int i;
+
+	for (i = 0; i < 6; i++) {
+		if (i & 1) { /* 1, 3, 5 */
+			min = geom->min_motor_angle_135_deg;
+			max = geom->max_motor_angle_135_deg;
+		} else { /* 0, 2, 4 */
+			min = geom->min_motor_angle_024_deg;
+			max = geom->max_motor_angle_024_deg;
+		}
+		if (angles[i] <= min || angles[i] >= max)
+			return 1;
+	}
+
+	return 0;
+}
+
+/**
+ * run_sample - Kjør ett Monte Carlo sample
+ * @config: konfigurasjon
+ * @rng: RNG strøm (seedet for dette sample)
+ * @out: resultat
+ */
+static void run_sample(const struct mc_config *config, struct rng *rng,
+		       struct mc_sample *out)
+{
+	struct stewart_geometry actual;
+	struct stewart_inverse_result inverse;
+	struct stewart_pose command, reached;
+	int iterations;
+
+	if (config->random_pose)
+		random_command(rng, config->nominal, &command);
+	else
+		command = config->command;
+
+	perturb_geometry(rng, config->nominal, config->sigma_point_mm,
+			 config->sigma_length_mm, &actual);
+
+	/* Kontrolleren regner med nominell geometri */
+	stewart_kinematics_inverse(config->nominal, &command, &inverse, 0);
+
+	memset(out, 0, sizeof(*out));
+	if (motor_angles_clamped(config->nominal, inverse.motor_angles_deg)) {
+		out->clamped = 1;
+		return;
+	}
+
+	/* Roboten er bygget med perturbert geometri */
+	reached = command;
+	iterations = stewart_kinematics_forward_solve(
+		&actual, inverse.motor_angles_deg, &reached,
+		FK_MAX_ITERATIONS, FK_TOLERANCE_MM);
+
+	if (iterations < 0)
+		return;
+
+	out->converged = 1;
+	out->error.rx = reached.rx - command.rx;
+	out->error.ry = reached.ry - command.ry;
+	out->error.rz = reached.rz - command.rz;
+	out->error.tx = reached.tx - command.tx;
+	out->error.ty = reached.ty - command.ty;
+	out->error.tz = reached.tz - command.tz;
+
+	out->translation_error_mm = sqrtf(out->error.tx * out->error.tx +
+					  out->error.ty * out->error.ty +
+					  out->error.tz * out->error.tz);
+	out->rotation_error_deg = sqrtf(out->error.rx * out->error.rx +
+					out->error.ry * out->error.ry +
+					out->error.rz * out->error.rz);
+}
+
+static void *worker_main(void *arg)
+{
+	struct mc_worker *worker = arg;
+	struct rng rng;
+	long i;
+
+	for (i = worker->begin; i < worker->end; i++) {
+		rng_seed_sample(&rng, worker->config->seed, i);
+		run_sample(worker->config, &rng, &worker->results[i]);
+	}
+
+	return NULL;
+}
+
+static int compare_float(const void *a, const void *b)
+{
+	float fa = *(const float *)a;
+	float fb = *(const float *)b;
+
+	return (fa > fb) - (fa < fb);
+}
+
+/**
+ * print_distribution - Print fordeling for én feil-komponent
+ * @name: komponent navn
+ * @unit: enhet
+ * @values: verdier (sorteres in-place)
+ * @n: antall verdier
+ */
+static void print_distribution(const char *name, const char *unit,
+			       float *values, long n)
+{
+	double sum = 0.0, sum_sq = 0.0, mean, std;
+	long i;
+
+	if (n == 0)
+		return;
+
+	for (i = 0; i < n; i++) {
+		sum += values[i];
+		sum_sq += (double)values[i] * values[i];
+	}
+	mean = sum / n;
+	std = sqrt(fmax(sum_sq / n - mean * mean, 0.0));
+
+	qsort(values, n, sizeof(float), compare_float);
+
+	printf("  %-8s %-4s %9.4f %9.4f %9.4f %9.4f %9.4f %9.4f %9.4f\n",
+	       name, unit, mean, std, values[0], values[n / 2],
+	       values[(long)(0.95 * (n - 1))], values[(long)(0.99 * (n - 1))],
+	       values[n - 1]);
+}
+
+/* Komponent c av et sample: rx, ry, rz, tx, ty, tz, |rot|, |trans| */
+static float sample_component(const struct mc_sample *s, int c)
+{
+	switch (c) {
+	case 0:
+		return s->error.rx;
+	case 1:
+		return s->error.ry;
+	case 2:
+		return s->error.rz;
+	case 3:
+		return s->error.tx;
+	case 4:
+		return s->error.ty;
+	case 5:
+		return s->error.tz;
+	case 6:
+		return s->rotation_error_deg;
+	default:
+		return s->translation_error_mm;
+	}
+}
+
+static void print_report(const struct mc_config *config,
+			 const struct mc_sample *results, double seconds)
+{
+	float *values;
+	long i, n = 0, failed = 0, clamped = 0;
+	int c;
+	static const char *const names[8] = { "rx", "ry", "rz", "tx",
+					      "ty", "tz", "|rot|", "|trans|" };
+	static const char *const units[8] = { "deg", "deg", "deg", "mm",
+					      "mm",  "mm",  "deg", "mm" };
+
+	values = malloc(config->samples * sizeof(float));
+	if (!values) {
+		fprintf(stderr, "Out of memory\n");
+		return;
+	}
+
+	for (i = 0; i < config->samples; i++) {
+		if (results[i].clamped)
+			clamped++;
+		else if (!results[i].converged)
+			failed++;
+	}
+
+	printf("\nSamples: %ld (%ld unreachable, %ld FK failures), "
+	       "%d threads, %.2f s (%.1f us/sample)\n\n",
+	       config->samples, clamped, failed, config->threads, seconds,
+	       1e6 * seconds / config->samples);
+	printf("  %-8s %-4s %9s %9s %9s %9s %9s %9s %9s\n", "error", "unit",
+	       "mean", "std", "min", "p50", "p95", "p99", "max");
+
+	for (c = 0; c < 8; c++) {
+		n = 0;
+		for (i = 0; i < config->samples; i++) {
+			const struct mc_sample *s = &results[i];
+
+			if (s->converged)
+				values[n++] = sample_component(s, c);
+		}
+		print_distribution(names[c], units[c], values, n);
+	}
+
+	free(values);
+}
+
+static void print_usage(const char *prog)
+{
+	printf("Usage: %s [options]\n", prog);
+	printf("  -r mx64|ax18     Robot (default mx64)\n");
+	printf("  -n <samples>     Number of perturbed copies (default 10000)\n");
+	printf("  -j <threads>     Worker threads (default: online CPUs)\n");
+	printf("  -s <seed>        RNG seed (default 1)\n");
+	printf("  -p <sigma>       Attachment point sigma in mm (default 0.1)\n");
+	printf("  -l <sigma>       Link length sigma in mm (default 0.05)\n");
+	printf("  -c rx,ry,rz,tx,ty,tz  Commanded pose (default home)\n");
+	printf("  -R               Random command per sample within max_pose\n");
+}
+
+int main(int argc, char **argv)
+{
+	struct mc_config config;
+	struct mc_worker workers[MAX_THREADS];
+	pthread_t threads[MAX_THREADS];
+	struct mc_sample *results;
+	struct timespec t0, t1;
+	struct stewart_pose *cmd;
+	double seconds;
+	int opt, t;
+
+	memset(&config, 0, sizeof(config));
+	config.nominal = &ROBOT_MX64;
+	config.samples = 10000;
+	config.threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	config.seed = 1;
+	config.sigma_point_mm = 0.1f;
+	config.sigma_length_mm = 0.05f;
+	stewart_pose_init(&config.command);
+
+	while ((opt = getopt(argc, argv, "r:n:j:s:p:l:c:Rh")) != -1) {
+		switch (opt) {
+		case 'r':
+			if (strcmp(optarg, "mx64") == 0) {
+				config.nominal = &ROBOT_MX64;
+			} else if (strcmp(optarg, "ax18") == 0) {
+				config.nominal = &ROBOT_AX18;
+			} else {
+				fprintf(stderr, "Unknown robot: %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 'n':
+			config.samples = atol(optarg);
+			break;
+		case 'j':
+			config.threads = atoi(optarg);
+			break;
+		case 's':
+			config.seed = strtoull(optarg, NULL, 0);
+			break;
+		case 'p':
+			config.sigma_point_mm = strtof(optarg, NULL);
+			break;
+		case 'l':
+			config.sigma_length_mm = strtof(optarg, NULL);
+			break;
+		case 'c':
+			cmd = &config.command;
+			if (sscanf(optarg, "%f,%f,%f,%f,%f,%f", &cmd->rx,
+				   &cmd->ry, &cmd->rz, &cmd->tx, &cmd->ty,
+				   &cmd->tz) != 6) {
+				fprintf(stderr, "Invalid pose: %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 'R':
+			config.random_pose = 1;
+			break;
+		default:
+			print_usage(argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (config.samples <= 0) {
+		fprintf(stderr, "Sample count must be positive\n");
+		return 1;
+	}
+	if (config.threads < 1)
+		config.threads = 1;
+	if (config.threads > MAX_THREADS)
+		config.threads = MAX_THREADS;
+
+	results = calloc(config.samples, sizeof(*results));
+	if (!results) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	printf("Stewart Platform Tolerance Analysis (Monte Carlo)\n");
+	printf("=================================================\n");
+	printf("Robot: %s, point sigma %.3f mm, length sigma %.3f mm\n",
+	       config.nominal == &ROBOT_MX64 ? "MX64" : "AX18",
+	       config.sigma_point_mm, config.sigma_length_mm);
+	if (config.random_pose) {
+		printf("Command: random within max_pose amplitudes\n");
+	} else {
+		printf("Command: ");
+		stewart_pose_print(&config.command);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+
+	/* Statisk oppdeling - resultat avhenger ikke av oppdelingen */
+	for (t = 0; t < config.threads; t++) {
+		workers[t].config = &config;
+		workers[t].results = results;
+		workers[t].begin = config.samples * t / config.threads;
+		workers[t].end = config.samples * (t + 1) / config.threads;
+
+		if (pthread_create(&threads[t], NULL, worker_main,
+				   &workers[t]) != 0) {
+			fprintf(stderr, "Failed to create thread %d\n", t);
+			/* Regn resten på denne tråden */
+			worker_main(&workers[t]);
+			threads[t] = pthread_self();
+		}
+	}
+
+	for (t = 0; t < config.threads; t++)
+		if (!pthread_equal(threads[t], pthread_self()))
+			pthread_join(threads[t], NULL);
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	seconds = (t1.tv_sec - t0.tv_sec) + 1e-9 * (t1.tv_nsec - t0.tv_nsec);
+
+	print_report(&config, results, seconds);
+
+	free(results);
+	return 0;
+}
@@ -0,0 +1,17 @@
+#ifndef ROBOTICS_MATH_SOLVE_H
+#define ROBOTICS_MATH_SOLVE_H
+
+/**
+ * solve_linear_system - Løs A·x = b med Gauss-eliminasjon
+ * @a: n×n matrise i row-major order (ødelegges)
+ * @b: høyre side med n elementer, erstattes med løsningen x
+ * @n: dimensjon
+ *
+ * Gauss-eliminasjon med partial pivoting, in-place uten allokering.
+ * Ment for små systemer (n ≤ ~10), f.eks. 6×6 Jacobi i forward kinematics.
+ *
+ * Retur: 0 ved suksess, -1 hvis matrisen er singulær
+ */
+int solve_linear_system(float *a, float *b, int n);
+
+#endif /* ROBOTICS_MATH_SOLVE_H */
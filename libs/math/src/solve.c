@@ -0,0 +1,55 @@
+#include "robotics/math/solve.h"
+#include <math.h>
+
+int solve_linear_system(float *a, float *b, int n)
+{
+	int row, col, k, pivot;
+	float max, tmp, factor;
+
+	for (col = 0; col < n; col++) {
+		/*
+		 * Finn største pivot i kolonnen for numerisk stabilitet
+		 */
+		pivot = col;
+		max = fabsf(a[col * n + col]);
+		for (row = col + 1; row < n; row++) {
+			if (fabsf(a[row * n + col]) > max) {
+				max = fabsf(a[row * n + col]);
+				pivot = row;
+			}
+		}
+
+		if (max < 1e-12f)
+			return -1;
+
+		/* Bytt rader */
+		if (pivot != col) {
+			for (k = 0; k < n; k++) {
+				tmp = a[col * n + k];
+				a[col * n + k] = a[pivot * n + k];
+				a[pivot * n + k] = tmp;
+			}
+			tmp = b[col];
+			b[col] = b[pivot];
+			b[pivot] = tmp;
+		}
+
+		/* Eliminer under pivot */
+		for (row = col + 1; row < n; row++) {
+			factor = a[row * n + col] / a[col * n + col];
+			for (k = col; k < n; k++)
+				a[row * n + k] -= factor * a[col * n + k];
+			b[row] -= factor * b[col];
+		}
+	}
+
+	/* Baklengs substitusjon */
+	for (row = n - 1; row >= 0; row--) {
+		tmp = b[row];
+		for (k = row + 1; k < n; k++)
+			tmp -= a[row * n + k] * b[k];
+		b[row] = tmp / a[row * n + row];
+	}
+
+	return 0;
+}
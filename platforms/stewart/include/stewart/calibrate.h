@@ -0,0 +1,115 @@
+#ifndef STEWART_CALIBRATE_H
+#define STEWART_CALIBRATE_H
+
+#include <stddef.h>
+#include <stewart/geometry.h>
+#include <stewart/pose.h>
+
+/**
+ * struct stewart_calib_sample - Ett logget måle-par
+ * @pose: platform pose (kommandert, eller målt eksternt)
+ * @motor_angles_deg: motor vinkler (målt, eller kommandert) (6)
+ *
+ * Begge datakilder gir samme lukke-ligning: med riktig geometri skal
+ * avstanden fra hvert kne (fra motor vinkel) til tilhørende platform
+ * punkt (fra pose) være lik long_foot_length.
+ *
+ * - Kommandert pose + målte motor vinkler (servo feedback)
+ * - Målt pose (f.eks. motion capture) + kommanderte motor vinkler
+ */
+struct stewart_calib_sample {
+	struct stewart_pose pose;
+	float motor_angles_deg[6];
+};
+
+/**
+ * enum stewart_calib_param - Parametergrupper som kan estimeres
+ * @STEWART_CALIB_BASE_POINTS: base_points[6] (x, y, z)
+ * @STEWART_CALIB_PLATFORM_POINTS: platform_points_flat[6] (x, z)
+ * @STEWART_CALIB_HOME_HEIGHT: home_height
+ * @STEWART_CALIB_FOOT_LENGTHS: short_foot_length og long_foot_length
+ *
+ * home_height er ikke med som standard: den er degenerert med en felles
+ * y-forskyvning av alle base_points.
+ */
+enum stewart_calib_param {
+	STEWART_CALIB_BASE_POINTS = 1 << 0,
+	STEWART_CALIB_PLATFORM_POINTS = 1 << 1,
+	STEWART_CALIB_HOME_HEIGHT = 1 << 2,
+	STEWART_CALIB_FOOT_LENGTHS = 1 << 3,
+};
+
+/**
+ * struct stewart_calib_options - Innstillinger for kalibrering
+ * @params: bitmaske av enum stewart_calib_param
+ * @max_iterations: maks antall Levenberg-Marquardt iterasjoner
+ * @num_threads: antall tråder for residual-evaluering (0 = alle CPUer)
+ * @tolerance: stopp når relativ kost-reduksjon er under denne
+ * @verbose: 1 = print fremdrift per iterasjon
+ */
+struct stewart_calib_options {
+	unsigned int params;
+	int max_iterations;
+	int num_threads;
+	double tolerance;
+	int verbose;
+};
+
+/**
+ * struct stewart_calib_report - Resultat fra kalibrering
+ * @iterations: antall iterasjoner brukt
+ * @num_params: antall estimerte parametere
+ * @num_residuals: antall residualer (6 per sample)
+ * @rms_initial_mm: RMS benlengde-feil med start-geometri (mm)
+ * @rms_final_mm: RMS benlengde-feil med kalibrert geometri (mm)
+ * @max_final_mm: største absolutte benlengde-feil etter kalibrering (mm)
+ * @converged: 1 hvis toleransen ble nådd før max_iterations
+ */
+struct stewart_calib_report {
+	int iterations;
+	int num_params;
+	size_t num_residuals;
+	double rms_initial_mm;
+	double rms_final_mm;
+	double max_final_mm;
+	int converged;
+};
+
+/**
+ * stewart_calib_options_default - Fyll inn standard innstillinger
+ * @options: innstillinger som skal initialiseres
+ *
+ * Estimerer base/platform punkter og benlengder, 50 iterasjoner,
+ * alle CPUer, tolerance 1e-9.
+ */
+void stewart_calib_options_default(struct stewart_calib_options *options);
+
+/**
+ * stewart_calibrate - Estimer korrigert geometri fra loggede data
+ * @initial: start-geometri (typisk ROBOT_MX64/ROBOT_AX18)
+ * @samples: måle-par
+ * @num_samples: antall måle-par
+ * @options: innstillinger, eller NULL for standard
+ * @result: output - kalibrert geometri (kan være samme som @initial)
+ * @report: output - statistikk, eller NULL
+ *
+ * Minste kvadraters tilpasning av lukke-residualen
+ *   r = |P(pose) - K(motor vinkel)| - long_foot_length
+ * over alle ben og samples, med Levenberg-Marquardt og analytisk Jacobi
+ * med hensyn på geometri-parametrene. Normal-ligningene akkumuleres i
+ * double parallelt over samples (én blokk per tråd, summert i fast
+ * tråd-rekkefølge slik at resultatet er deterministisk).
+ *
+ * Felter som ikke estimeres (grenser, motor_arm_outward, osv.) kopieres
+ * uendret fra @initial.
+ *
+ * Retur: 0 ved suksess, -1 ved ugyldig input eller singulært system
+ */
+int stewart_calibrate(const struct stewart_geometry *initial,
+		      const struct stewart_calib_sample *samples,
+		      size_t num_samples,
+		      const struct stewart_calib_options *options,
+		      struct stewart_geometry *result,
+		      struct stewart_calib_report *report);
+
+#endif /* STEWART_CALIBRATE_H */
@@ -0,0 +1,89 @@
+#ifndef STEWART_COLLISION_H
+#define STEWART_COLLISION_H
+
+#include <stddef.h>
+#include <stewart/geometry.h>
+#include <stewart/kinematics.h>
+
+/* Antall ben-par (6 velg 2) */
+#define STEWART_COLLISION_PAIRS 15
+
+/**
+ * struct stewart_collision_result - Klaringer for én pose
+ * @pair_distance_mm: minste avstand mellom ben-par (15), se
+ *                    stewart_collision_pair_legs() for rekkefølge
+ * @min_pair_distance_mm: minste av pair_distance_mm
+ * @min_pair: ben-paret med minst avstand (0-14)
+ * @knee_base_clearance_mm: kne over base plan (6), negativ = under
+ * @knee_platform_clearance_mm: kne under platform plan (6), negativ = over
+ * @min_plate_clearance_mm: minste av knee_base/knee_platform klaringene
+ *
+ * Et ben består av to segmenter: motor arm (base punkt -> kne) og
+ * pushrod (kne -> transformert platform punkt). Avstand mellom to ben
+ * er minste avstand over alle fire segment-kombinasjoner. Avstandene
+ * er mellom senterlinjer; trekk fra stang/arm radius for fysisk klaring.
+ */
+struct stewart_collision_result {
+	float pair_distance_mm[STEWART_COLLISION_PAIRS];
+	float min_pair_distance_mm;
+	int min_pair;
+
+	float knee_base_clearance_mm[6];
+	float knee_platform_clearance_mm[6];
+	float min_plate_clearance_mm;
+};
+
+/**
+ * stewart_collision_pair_legs - Ben-nummer for et ben-par
+ * @pair: ben-par (0-14)
+ * @leg_a: output - første ben
+ * @leg_b: output - andre ben (leg_b > leg_a)
+ *
+ * Parene er ordnet (0,1), (0,2), ... (0,5), (1,2), ... (4,5).
+ */
+void stewart_collision_pair_legs(int pair, int *leg_a, int *leg_b);
+
+/**
+ * stewart_collision_check - Beregn ben-ben og ben-plate klaringer
+ * @geom: robot geometri
+ * @inverse: IK resultat (kne og transformerte platform punkter)
+ * @result: output - klaringer
+ *
+ * Alle 60 segment-segment avstander (15 par × 4 kombinasjoner) beregnes
+ * i én gren-fri løkke over SoA-arrays, som kompilatoren kan vektorisere.
+ * Kostnaden er av samme størrelsesorden som selve IK, så den kan kjøres
+ * på hver kommanderte pose.
+ *
+ * Base plan går gjennom base punktene; platform plan gjennom de
+ * transformerte platform punktene.
+ */
+void stewart_collision_check(const struct stewart_geometry *geom,
+			     const struct stewart_inverse_result *inverse,
+			     struct stewart_collision_result *result);
+
+/**
+ * stewart_collision_check_batch - Klaringer for en hel trajektorie
+ * @geom: robot geometri
+ * @inverse: IK resultater (@count)
+ * @count: antall poser
+ * @results: output - klaringer per pose (@count), eller NULL
+ * @worst: output - klaringer for verste pose, eller NULL
+ *
+ * Verste pose er den med minst min_pair_distance_mm.
+ *
+ * Retur: indeks til verste pose (0 hvis @count er 0)
+ */
+size_t stewart_collision_check_batch(const struct stewart_geometry *geom,
+				     const struct stewart_inverse_result *inverse,
+				     size_t count,
+				     struct stewart_collision_result *results,
+				     struct stewart_collision_result *worst);
+
+/**
+ * stewart_collision_result_print - Print klaringer
+ * @result: resultat struktur
+ */
+void stewart_collision_result_print(
+	const struct stewart_collision_result *result);
+
+#endif /* STEWART_COLLISION_H */
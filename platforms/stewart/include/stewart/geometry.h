@@ -53,6 +53,63 @@ struct stewart_geometry {
 	float max_pose_translation_bias;
 };
 
+/**
+ * struct stewart_geometry_prepared - Geometri med forhåndsberegnede IK-data
+ * @geom: geometrien dataene er beregnet fra
+ * @motor_x_axis: enhetsvektor langs motor planet (6), fra base punkt par
+ * @motor_normal: normal til motor planet (6), motor_x_axis × Y
+ * @knee_sin_y: sin av motorens rotasjon rundt Y-aksen (6)
+ * @knee_cos_y: cos av motorens rotasjon rundt Y-aksen (6)
+ * @min_motor_angle_deg: hard limit min vinkel per motor (6)
+ * @max_motor_angle_deg: hard limit max vinkel per motor (6)
+ * @short_foot_length_sq: short_foot_length²
+ * @long_foot_length_sq: long_foot_length²
+ *
+ * Alt som kun avhenger av geometrien og ikke av posen. Beregnes én gang
+ * med stewart_geometry_prepare() (eller ved lasting fra fil), slik at
+ * stewart_kinematics_inverse_prepared() slipper normalisering og
+ * trigonometri for motor planene på hvert kall.
+ *
+ * Inneholder ingen pekere, så den kan lagres rått i en binær cache.
+ */
+struct stewart_geometry_prepared {
+	struct stewart_geometry geom;
+
+	struct vec3 motor_x_axis[6];
+	struct vec3 motor_normal[6];
+	float knee_sin_y[6];
+	float knee_cos_y[6];
+	float min_motor_angle_deg[6];
+	float max_motor_angle_deg[6];
+
+	float short_foot_length_sq;
+	float long_foot_length_sq;
+};
+
+/**
+ * stewart_geometry_prepare - Beregn avledede IK-data for en geometri
+ * @geom: robot geometri
+ * @prepared: output - geometri med forhåndsberegnede data
+ *
+ * Må kalles på nytt hvis @geom endres.
+ */
+void stewart_geometry_prepare(const struct stewart_geometry *geom,
+			      struct stewart_geometry_prepared *prepared);
+
+/**
+ * stewart_geometry_validate - Sjekk at en geometri er fysisk gyldig
+ * @geom: robot geometri
+ * @what: output - beskrivelse av første feil, eller NULL
+ *
+ * Sjekker at alle verdier er endelige, at lengder og home_height er
+ * positive, at motor grensene har min < max og at base punkt parene som
+ * definerer motor planene ikke faller sammen.
+ *
+ * Retur: 0 hvis gyldig, -1 ellers
+ */
+int stewart_geometry_validate(const struct stewart_geometry *geom,
+			      const char **what);
+
 /**
  * stewart_geometry_print - Print geometri til stdout
  * @geom: geometri struktur
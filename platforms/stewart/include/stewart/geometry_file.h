@@ -0,0 +1,155 @@
+#ifndef STEWART_GEOMETRY_FILE_H
+#define STEWART_GEOMETRY_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stewart/geometry.h>
+
+/*
+ * Geometri-filer
+ *
+ * Tekstformat, én "nøkkel = verdi" per linje, '#' er kommentar.
+ * Nøklene er feltnavnene i struct stewart_geometry; punktene heter
+ * base_point_0 .. base_point_5 og platform_point_0 .. platform_point_5
+ * med tre tall (x y z). Alle nøkler må være med nøyaktig én gang:
+ *
+ *   home_height = 205
+ *   short_foot_length = 70
+ *   base_point_0 = 59.24 0 62.49
+ *   ...
+ *
+ * Binær cache: mange forberedte geometrier i én fil som mmap-es direkte,
+ * slik at verktøy som laster mange geometrier slipper parsing, validering
+ * og stewart_geometry_prepare(). Cachen er plattform-spesifikk (rå structs);
+ * header har byte order, versjon og størrelse, og avvises ved mismatch.
+ */
+
+#define STEWART_GEOMETRY_CACHE_MAGIC "STWGEOM"
+#define STEWART_GEOMETRY_CACHE_VERSION 1
+#define STEWART_GEOMETRY_NAME_MAX 32
+
+/**
+ * struct stewart_geometry_cache_header - Start av binær cache-fil
+ * @magic: STEWART_GEOMETRY_CACHE_MAGIC, null-terminert
+ * @version: STEWART_GEOMETRY_CACHE_VERSION
+ * @byte_order: 0x01020304 skrevet med vertens byte order
+ * @entry_size: sizeof(struct stewart_geometry_cache_entry)
+ * @count: antall geometrier
+ * @checksum: FNV-1a over alle entries
+ * @reserved: 0
+ */
+struct stewart_geometry_cache_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint32_t entry_size;
+	uint32_t count;
+	uint32_t checksum;
+	uint32_t reserved;
+};
+
+/**
+ * struct stewart_geometry_cache_entry - Én geometri i cachen
+ * @name: navn, null-terminert (typisk filnavn uten endelse)
+ * @prepared: validert og forberedt geometri
+ */
+struct stewart_geometry_cache_entry {
+	char name[STEWART_GEOMETRY_NAME_MAX];
+	struct stewart_geometry_prepared prepared;
+};
+
+/**
+ * struct stewart_geometry_cache - Åpnet (mmap-et) cache
+ * @entries: geometriene, peker rett inn i mappingen
+ * @count: antall geometrier
+ * @map: mapping, for stewart_geometry_cache_close()
+ * @map_size: størrelse på mapping
+ */
+struct stewart_geometry_cache {
+	const struct stewart_geometry_cache_entry *entries;
+	size_t count;
+	void *map;
+	size_t map_size;
+};
+
+/**
+ * stewart_geometry_load - Les og valider geometri fra tekstfil
+ * @path: filsti
+ * @geom: output - geometri
+ *
+ * Feil (syntaks, ukjent/manglende/duplisert nøkkel, ugyldig geometri)
+ * skrives til stderr med filnavn og linjenummer.
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int stewart_geometry_load(const char *path, struct stewart_geometry *geom);
+
+/**
+ * stewart_geometry_load_prepared - Les, valider og forbered geometri
+ * @path: filsti til tekstfil
+ * @prep: output - forberedt geometri
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int stewart_geometry_load_prepared(const char *path,
+				   struct stewart_geometry_prepared *prep);
+
+/**
+ * stewart_geometry_save - Skriv geometri til tekstfil
+ * @path: filsti
+ * @geom: geometri
+ *
+ * Verdiene skrives med nok siffer til at de leses tilbake bit-eksakt.
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int stewart_geometry_save(const char *path,
+			  const struct stewart_geometry *geom);
+
+/**
+ * stewart_geometry_cache_write - Skriv binær cache
+ * @path: filsti
+ * @names: navn per geometri (@count), maks STEWART_GEOMETRY_NAME_MAX - 1
+ * @geoms: geometrier (@count)
+ * @count: antall geometrier
+ *
+ * Geometriene valideres og forberedes før de skrives. Filen skrives til
+ * en midlertidig fil og renames, slik at lesere aldri ser en halv cache.
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int stewart_geometry_cache_write(const char *path, const char *const names[],
+				 const struct stewart_geometry geoms[],
+				 size_t count);
+
+/**
+ * stewart_geometry_cache_open - mmap binær cache
+ * @path: filsti
+ * @cache: output - åpnet cache
+ *
+ * Sjekker magic, versjon, byte order, entry-størrelse, filstørrelse og
+ * checksum. Geometriene brukes direkte fra mappingen uten kopiering.
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int stewart_geometry_cache_open(const char *path,
+				struct stewart_geometry_cache *cache);
+
+/**
+ * stewart_geometry_cache_find - Slå opp geometri på navn
+ * @cache: åpnet cache
+ * @name: navn
+ *
+ * Retur: forberedt geometri (gyldig til cachen lukkes), eller NULL
+ */
+const struct stewart_geometry_prepared *
+stewart_geometry_cache_find(const struct stewart_geometry_cache *cache,
+			    const char *name);
+
+/**
+ * stewart_geometry_cache_close - Lukk cache
+ * @cache: cache fra stewart_geometry_cache_open()
+ */
+void stewart_geometry_cache_close(struct stewart_geometry_cache *cache);
+
+#endif /* STEWART_GEOMETRY_FILE_H */
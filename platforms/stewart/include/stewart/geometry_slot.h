@@ -0,0 +1,105 @@
+#ifndef STEWART_GEOMETRY_SLOT_H
+#define STEWART_GEOMETRY_SLOT_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stewart/geometry.h>
+
+/**
+ * struct stewart_geometry_slot - Geometri som kan byttes mens den brukes
+ * @buffers: to forberedte geometrier, én aktiv og én for neste versjon
+ * @readers: antall lesere som holder hver buffer
+ * @current: indeks til aktiv buffer
+ * @generation: økes for hver publisering
+ * @publish_lock: serialiserer skrivere (aldri tatt av lesere)
+ *
+ * Dobbel-buffer med pointer flip: skriver forbereder ny geometri i den
+ * inaktive bufferen og flipper @current atomisk. Lesere teller seg inn
+ * på bufferen de bruker, så skriver venter til den gamle bufferen er fri
+ * før den overskrives neste gang. IK-løkken tar aldri lås og ser aldri
+ * en halvveis oppdatert geometri.
+ *
+ * Slot-en er stor (to prepared structs); legg den statisk eller på heap.
+ */
+struct stewart_geometry_slot {
+	struct stewart_geometry_prepared buffers[2];
+	atomic_int readers[2];
+	atomic_uint current;
+	atomic_uint generation;
+	pthread_mutex_t publish_lock;
+};
+
+/**
+ * stewart_geometry_slot_init - Initialiser slot med en geometri
+ * @slot: slot
+ * @geom: start-geometri
+ *
+ * Ikke trådsikker; kalles før slot-en deles.
+ */
+void stewart_geometry_slot_init(struct stewart_geometry_slot *slot,
+				const struct stewart_geometry *geom);
+
+/**
+ * stewart_geometry_slot_destroy - Frigjør ressurser i slot
+ * @slot: slot uten aktive lesere
+ */
+void stewart_geometry_slot_destroy(struct stewart_geometry_slot *slot);
+
+/**
+ * stewart_geometry_slot_acquire - Hent aktiv geometri for lesing
+ * @slot: slot
+ *
+ * Lock-free: to atomiske operasjoner i vanlig tilfelle. Geometrien er
+ * uforandret til stewart_geometry_slot_release() kalles, også om en ny
+ * versjon publiseres i mellomtiden. Hold den kort (f.eks. ett IK-kall
+ * eller én frame); en skriver venter på at den slippes.
+ *
+ * Retur: forberedt geometri
+ */
+const struct stewart_geometry_prepared *
+stewart_geometry_slot_acquire(struct stewart_geometry_slot *slot);
+
+/**
+ * stewart_geometry_slot_release - Slipp geometri fra acquire
+ * @slot: slot
+ * @prep: peker fra stewart_geometry_slot_acquire()
+ */
+void stewart_geometry_slot_release(struct stewart_geometry_slot *slot,
+				   const struct stewart_geometry_prepared *prep);
+
+/**
+ * stewart_geometry_slot_publish - Bytt til ny geometri
+ * @slot: slot
+ * @geom: ny geometri
+ *
+ * Validerer og forbereder @geom i den inaktive bufferen og gjør den
+ * aktiv. Nye acquire ser den nye geometrien; lesere som allerede holder
+ * den gamle beholder den til de slipper. Blokkerer til eventuelle lesere
+ * av forrige-forrige versjon er ferdige.
+ *
+ * Retur: 0 ved suksess, -1 hvis @geom er ugyldig (slot uendret)
+ */
+int stewart_geometry_slot_publish(struct stewart_geometry_slot *slot,
+				  const struct stewart_geometry *geom);
+
+/**
+ * stewart_geometry_slot_reload - Last geometri-fil og publiser den
+ * @slot: slot
+ * @path: geometri-fil (se stewart/geometry_file.h)
+ *
+ * Retur: 0 ved suksess, -1 ved feil (slot uendret)
+ */
+int stewart_geometry_slot_reload(struct stewart_geometry_slot *slot,
+				 const char *path);
+
+/**
+ * stewart_geometry_slot_generation - Antall publiseringer så langt
+ * @slot: slot
+ *
+ * Brukes for å oppdage at geometrien er byttet, f.eks. for å
+ * invalidere data avledet av den.
+ */
+unsigned int
+stewart_geometry_slot_generation(struct stewart_geometry_slot *slot);
+
+#endif /* STEWART_GEOMETRY_SLOT_H */
@@ -0,0 +1,99 @@
+#ifndef STEWART_IK_CACHE_H
+#define STEWART_IK_CACHE_H
+
+#include <stewart/geometry.h>
+#include <stewart/kinematics.h>
+#include <stewart/pose.h>
+
+/*
+ * Liten cache foran inverse kinematics
+ *
+ * Mottakere og kontrollere får ofte samme pose mange ganger på rad
+ * (statisk setpunkt, interaktiv styring uten tastetrykk). Cachen husker
+ * de siste STEWART_IK_CACHE_SIZE resultatene, nøklet på pose og geometri,
+ * og hopper over IK når nøkkelen finnes. Oppslag er et lineært søk over
+ * noen få entries, så en bom koster nesten ingenting ekstra.
+ *
+ * Ikke trådsikker; én cache per tråd som kjører IK.
+ */
+
+#define STEWART_IK_CACHE_SIZE 4
+
+/**
+ * struct stewart_ik_cache_entry - Ett cachet IK-resultat
+ * @pose: nøkkel-pose (eksakt eller avrundet til @quantum)
+ * @prep: geometrien resultatet er beregnet med
+ * @geometry_id: versjon av @prep (se stewart_ik_cache_inverse())
+ * @valid: 1 hvis entry er i bruk
+ * @result: IK-resultat
+ */
+struct stewart_ik_cache_entry {
+	struct stewart_pose pose;
+	const struct stewart_geometry_prepared *prep;
+	unsigned int geometry_id;
+	int valid;
+	struct stewart_inverse_result result;
+};
+
+/**
+ * struct stewart_ik_cache - Cache med treff-tellere
+ * @entries: cachede resultater
+ * @newest: indeks til sist brukte entry, søkes først
+ * @next: entry som erstattes ved neste bom (round-robin)
+ * @quantum: avrunding av nøkkelen, 0 = bit-eksakt
+ * @hits: oppslag som ble besvart fra cachen
+ * @misses: oppslag som kjørte IK
+ */
+struct stewart_ik_cache {
+	struct stewart_ik_cache_entry entries[STEWART_IK_CACHE_SIZE];
+	unsigned int newest;
+	unsigned int next;
+	float quantum;
+	unsigned long hits;
+	unsigned long misses;
+};
+
+/**
+ * stewart_ik_cache_init - Tom cache
+ * @cache: cache som initialiseres
+ * @quantum: 0 for bit-eksakt nøkkel, ellers avrunding av alle seks
+ *	     komponentene (grader og mm), f.eks. 0.01
+ *
+ * Med @quantum > 0 kjøres IK på posen avrundet til nærmeste multiplum av
+ * @quantum, så resultatet er det samme uansett om det kom fra cachen.
+ */
+void stewart_ik_cache_init(struct stewart_ik_cache *cache, float quantum);
+
+/**
+ * stewart_ik_cache_clear - Glem alle resultater (tellerne beholdes)
+ * @cache: cache
+ */
+void stewart_ik_cache_clear(struct stewart_ik_cache *cache);
+
+/**
+ * stewart_ik_cache_inverse - Inverse kinematics via cachen
+ * @cache: cache
+ * @prep: forberedt geometri
+ * @geometry_id: versjon av @prep; endres når innholdet i @prep endres
+ *		 uten at pekeren gjør det (f.eks.
+ *		 stewart_geometry_slot_generation()), ellers 0
+ * @pose: ønsket pose
+ * @result: output - som stewart_kinematics_inverse_prepared()
+ *
+ * Retur: 1 ved treff, 0 hvis IK ble kjørt
+ */
+int stewart_ik_cache_inverse(struct stewart_ik_cache *cache,
+			     const struct stewart_geometry_prepared *prep,
+			     unsigned int geometry_id,
+			     const struct stewart_pose *pose,
+			     struct stewart_inverse_result *result);
+
+/**
+ * stewart_ik_cache_stats_print - Print treff og bom
+ * @cache: cache
+ * @label: navn i utskriften
+ */
+void stewart_ik_cache_stats_print(const struct stewart_ik_cache *cache,
+				  const char *label);
+
+#endif /* STEWART_IK_CACHE_H */
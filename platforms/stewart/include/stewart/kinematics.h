@@ -2,6 +2,7 @@
 #define STEWART_KINEMATICS_H
 
 #include "robotics/math/vec3.h"
+#include <stddef.h>
 #include <stewart/geometry.h>
 #include <stewart/pose.h>
 
@@ -66,6 +67,9 @@ struct stewart_forward_result {
  *
  * Motor vinkler blir hard eller soft clamped til geometri-grenser.
  *
+ * Forbereder geometrien på hvert kall; se
+ * stewart_kinematics_inverse_prepared() for gjentatte kall.
+ *
  * NB: ty er offset fra home-posisjon (ty = 0 betyr platform ved home_height).
  */
 void stewart_kinematics_inverse(const struct stewart_geometry *geom,
@@ -73,6 +77,34 @@ void stewart_kinematics_inverse(const struct stewart_geometry *geom,
 				struct stewart_inverse_result *result,
 				int debug);
 
+/**
+ * stewart_kinematics_inverse_prepared - Inverse kinematics med forberedt geometri
+ * @prep: forberedt geometri fra stewart_geometry_prepare() eller fil
+ * @pose_in: gitt platform pose
+ * @result: output - motor vinkler, kne posisjoner, transformerte punkter
+ * @debug: 1 = print debug info, 0 = stille
+ *
+ * Samme resultat som stewart_kinematics_inverse(), men motor planene,
+ * kvadrerte lengder og kne-rotasjonene er beregnet på forhånd. Brukes
+ * når samme geometri kjøres mot mange poser.
+ */
+void stewart_kinematics_inverse_prepared(
+	const struct stewart_geometry_prepared *prep,
+	const struct stewart_pose *pose_in, struct stewart_inverse_result *result,
+	int debug);
+
+/**
+ * stewart_kinematics_inverse_batch - Inverse kinematics for mange poser
+ * @prep: forberedt geometri
+ * @poses: poser (@count)
+ * @count: antall poser
+ * @results: output - ett resultat per pose (@count)
+ */
+void stewart_kinematics_inverse_batch(
+	const struct stewart_geometry_prepared *prep,
+	const struct stewart_pose *poses, size_t count,
+	struct stewart_inverse_result *results);
+
 /**
  * calculate_transformed_platform_points - Transform platform punkter med pose
  * @param[in]  geom     robot geometri
@@ -90,6 +122,20 @@ void calculate_transformed_platform_points(
 	const struct stewart_geometry *geom, const struct stewart_pose *pose_in,
 	struct stewart_inverse_result *result);
 
+/**
+ * stewart_kinematics_knee_points - Beregn kne posisjoner fra motor vinkler
+ * @geom: robot geometri
+ * @motor_angles_deg: motor vinkler (6)
+ * @knee_points: output - kne posisjoner (6)
+ *
+ * Kne er der servo arm møter pushrod. Samme beregning som siste steg i
+ * stewart_kinematics_inverse(), men kan også brukes med målte motor
+ * vinkler eller en annen geometri enn den IK ble kjørt med.
+ */
+void stewart_kinematics_knee_points(const struct stewart_geometry *geom,
+				    const float motor_angles_deg[6],
+				    struct vec3 knee_points[6]);
+
 /**
  * @brief Forward kinematics med iterativ fjær-modell
  *
@@ -108,6 +154,32 @@ void stewart_kinematics_forward(const struct stewart_geometry *geom,
 				const struct stewart_inverse_result *result_inv,
 				struct stewart_forward_result *result_forv);
 
+/**
+ * stewart_kinematics_forward_solve - Forward kinematics med Newton-Raphson
+ * @geom: robot geometri
+ * @motor_angles_deg: motor vinkler (6)
+ * @pose_io: startgjetning inn, beregnet pose ut
+ * @max_iterations: maks antall Newton-iterasjoner
+ * @tolerance_mm: konvergert når alle benlengde-avvik er under denne (mm)
+ *
+ * Finner posen der alle pushrods har lengde long_foot_length, gitt kne
+ * posisjonene fra motor vinklene. Bruker analytisk 6×6 Jacobi av
+ * benlengdene med hensyn på (rx, ry, rz, tx, ty, tz), og konvergerer
+ * typisk på 3-5 iterasjoner fra en startgjetning nær løsningen.
+ * Kommandert pose eller forrige løsning er en god startgjetning.
+ *
+ * Til forskjell fra stewart_kinematics_forward() gir dette den faktiske
+ * posen for gitte motor vinkler, ikke ett steg i en fjær-simulering.
+ *
+ * NB: ty er offset fra home-posisjon (ty = 0 betyr platform ved home_height).
+ *
+ * Retur: antall iterasjoner brukt, eller -1 ved divergens/singularitet
+ */
+int stewart_kinematics_forward_solve(const struct stewart_geometry *geom,
+				     const float motor_angles_deg[6],
+				     struct stewart_pose *pose_io,
+				     int max_iterations, float tolerance_mm);
+
 /**
  * stewart_inverse_result_print - Print inverse kinematics resultat
  * @result: resultat struktur
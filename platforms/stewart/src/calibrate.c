@@ -0,0 +1,579 @@
+#define _DEFAULT_SOURCE
+#include "stewart/calibrate.h"
+#include "robotics/math/matrix.h"
+#include "robotics/math/utils.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define CALIB_MAX_THREADS 64
+
+/*
+ * Parameter-layout (fast indeks uavhengig av hvilke som estimeres):
+ *   0..17   base_points[i].{x,y,z}        i*3 + akse
+ *   18..29  platform_points_flat[i].{x,z} 18 + i*2 + {0,1}
+ *   30      home_height
+ *   31      short_foot_length
+ *   32      long_foot_length
+ */
+#define P_BASE 0
+#define P_PLATFORM 18
+#define P_HOME_HEIGHT 30
+#define P_SHORT 31
+#define P_LONG 32
+#define NUM_PARAMS 33
+
+/* Maks antall ikke-null Jacobi-elementer per residual: 3 + 2 + 3 */
+#define MAX_NONZERO 8
+
+/**
+ * struct calib_frame - Parameter-uavhengige størrelser for ett sample
+ * @rotation: platform rotasjon fra pose (column-major, som mat3)
+ * @translation: (tx, ty, tz) fra pose
+ * @foot: enhetsvektor langs motor arm for hvert ben
+ *
+ * Regnes ut én gang før iterasjonene, slik at residual-evalueringen er
+ * ren aritmetikk uten trigonometri.
+ */
+struct calib_frame {
+	float rotation[9];
+	float translation[3];
+	float foot[6][3];
+};
+
+/**
+ * enum calib_job_kind - Hva en tråd skal gjøre med sin blokk
+ * @JOB_PREPARE: regn ut calib_frame fra samples
+ * @JOB_COST: kun Σ r²
+ * @JOB_NORMAL: Σ r² samt JᵀJ og Jᵀr
+ */
+enum calib_job_kind {
+	JOB_PREPARE,
+	JOB_COST,
+	JOB_NORMAL,
+};
+
+/**
+ * struct calib_problem - Delt tilstand for en evaluering
+ * @samples: måle-par
+ * @frames: forhåndsberegnede størrelser per sample
+ * @num_samples: antall måle-par
+ * @theta: parametervektor
+ */
+struct calib_problem {
+	const struct stewart_calib_sample *samples;
+	struct calib_frame *frames;
+	size_t num_samples;
+	const double *theta;
+};
+
+/**
+ * struct calib_job - Arbeidsområde for én tråd
+ * @problem: delt problem
+ * @begin: første sample (inklusiv)
+ * @end: siste sample (eksklusiv)
+ * @kind: hva som skal beregnes
+ * @cost: Σ r²
+ * @max_abs: største |r|
+ * @jtj: JᵀJ i full parameter-indeks (NUM_PARAMS × NUM_PARAMS)
+ * @jtr: Jᵀr i full parameter-indeks
+ */
+struct calib_job {
+	const struct calib_problem *problem;
+	size_t begin;
+	size_t end;
+	enum calib_job_kind kind;
+	double cost;
+	double max_abs;
+	double jtj[NUM_PARAMS * NUM_PARAMS];
+	double jtr[NUM_PARAMS];
+};
+
+static void geometry_to_theta(const struct stewart_geometry *geom,
+			      double theta[NUM_PARAMS])
+{
+	int i;
+
+	for (i = 0; i < 6; i++) {
+		theta[P_BASE + i * 3 + 0] = geom->base_points[i].x;
+		theta[P_BASE + i * 3 + 1] = geom->base_points[i].y;
+		theta[P_BASE + i * 3 + 2] = geom->base_points[i].z;
+		theta[P_PLATFORM + i * 2 + 0] = geom->platform_points_flat[i].x;
+		theta[P_PLATFORM + i * 2 + 1] = geom->platform_points_flat[i].z;
+	}
+
+	theta[P_HOME_HEIGHT] = geom->home_height;
+	theta[P_SHORT] = geom->short_foot_length;
+	theta[P_LONG] = geom->long_foot_length;
+}
+
+static void theta_to_geometry(const double theta[NUM_PARAMS],
+			      struct stewart_geometry *geom)
+{
+	int i;
+
+	for (i = 0; i < 6; i++) {
+		geom->base_points[i].x = (float)theta[P_BASE + i * 3 + 0];
+		geom->base_points[i].y = (float)theta[P_BASE + i * 3 + 1];
+		geom->base_points[i].z = (float)theta[P_BASE + i * 3 + 2];
+		geom->platform_points_flat[i].x =
+			(float)theta[P_PLATFORM + i * 2 + 0];
+		geom->platform_points_flat[i].z =
+			(float)theta[P_PLATFORM + i * 2 + 1];
+	}
+
+	geom->home_height = (float)theta[P_HOME_HEIGHT];
+	geom->short_foot_length = (float)theta[P_SHORT];
+	geom->long_foot_length = (float)theta[P_LONG];
+}
+
+/**
+ * motor_y_angle_rad - Motor-akse orientering rundt Y
+ *
+ * Samme som stewart_kinematics_knee_points(): -30° + 120° per motor-par.
+ */
+static float motor_y_angle_rad(int motor_no)
+{
+	return deg_to_rad(-30.0f + (motor_no / 2) * 120.0f);
+}
+
+/**
+ * prepare_frame - Forhåndsberegn rotasjon og motor arm retninger
+ * @sample: måle-par
+ * @frame: output
+ */
+static void prepare_frame(const struct stewart_calib_sample *sample,
+			  struct calib_frame *frame)
+{
+	struct mat3 rotation;
+	float sa, ca, sb, cb;
+	int i;
+
+	mat3_identity(&rotation);
+	mat3_rotate_xyz(&rotation, deg_to_rad(sample->pose.rx),
+			deg_to_rad(sample->pose.ry),
+			deg_to_rad(sample->pose.rz));
+	memcpy(frame->rotation, rotation.m, sizeof(frame->rotation));
+
+	frame->translation[0] = sample->pose.tx;
+	frame->translation[1] = sample->pose.ty;
+	frame->translation[2] = sample->pose.tz;
+
+	for (i = 0; i < 6; i++) {
+		/* Enhetsvektor langs motor arm: Ry(b)·Rx(a)·(0, -1, 0) */
+		sa = sinf(deg_to_rad(sample->motor_angles_deg[i]));
+		ca = cosf(deg_to_rad(sample->motor_angles_deg[i]));
+		sb = sinf(motor_y_angle_rad(i));
+		cb = cosf(motor_y_angle_rad(i));
+		frame->foot[i][0] = -sb * sa;
+		frame->foot[i][1] = -ca;
+		frame->foot[i][2] = -cb * sa;
+	}
+}
+
+/**
+ * accumulate_frame - Residualer og Jacobi for ett sample (6 ben)
+ * @job: tråd-arbeidsområde
+ * @frame: forhåndsberegnet sample
+ *
+ * Lukke-residual for ben i:
+ *   P = R·flat + (tx, ty + h, tz)
+ *   K = base + short · F(vinkel)
+ *   r = |P - K| - long
+ * med u = (P - K) / |P - K|:
+ *   dr/dbase = -u,  dr/dflat_x = u·R[:,0],  dr/dflat_z = u·R[:,2]
+ *   dr/dh = u_y,    dr/dshort = -u·F,       dr/dlong = -1
+ */
+static void accumulate_frame(struct calib_job *job,
+			     const struct calib_frame *frame)
+{
+	const double *theta = job->problem->theta;
+	const float *rot = frame->rotation;
+	const float *foot;
+	double d[3], u[3];
+	double length, r, fx, fz;
+	double jac[MAX_NONZERO];
+	int idx[MAX_NONZERO];
+	int i, a, b, k;
+
+	for (i = 0; i < 6; i++) {
+		foot = frame->foot[i];
+		fx = theta[P_PLATFORM + i * 2 + 0];
+		fz = theta[P_PLATFORM + i * 2 + 1];
+
+		/* d = P - K (flat punkt har y = 0) */
+		for (k = 0; k < 3; k++) {
+			d[k] = rot[k] * fx + rot[6 + k] * fz +
+			       frame->translation[k] -
+			       theta[P_BASE + i * 3 + k] -
+			       theta[P_SHORT] * foot[k];
+		}
+		d[1] += theta[P_HOME_HEIGHT];
+
+		length = sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+		if (!(length > 0.0))
+			continue;
+
+		r = length - theta[P_LONG];
+		job->cost += r * r;
+		if (fabs(r) > job->max_abs)
+			job->max_abs = fabs(r);
+
+		if (job->kind != JOB_NORMAL)
+			continue;
+
+		for (k = 0; k < 3; k++)
+			u[k] = d[k] / length;
+
+		for (k = 0; k < 3; k++) {
+			idx[k] = P_BASE + i * 3 + k;
+			jac[k] = -u[k];
+		}
+		idx[3] = P_PLATFORM + i * 2 + 0;
+		jac[3] = u[0] * rot[0] + u[1] * rot[1] + u[2] * rot[2];
+		idx[4] = P_PLATFORM + i * 2 + 1;
+		jac[4] = u[0] * rot[6] + u[1] * rot[7] + u[2] * rot[8];
+		idx[5] = P_HOME_HEIGHT;
+		jac[5] = u[1];
+		idx[6] = P_SHORT;
+		jac[6] = -(u[0] * foot[0] + u[1] * foot[1] + u[2] * foot[2]);
+		idx[7] = P_LONG;
+		jac[7] = -1.0;
+
+		/* Sparse ytre produkt inn i normal-ligningene */
+		for (a = 0; a < MAX_NONZERO; a++) {
+			job->jtr[idx[a]] += jac[a] * r;
+			for (b = 0; b < MAX_NONZERO; b++)
+				job->jtj[idx[a] * NUM_PARAMS + idx[b]] +=
+					jac[a] * jac[b];
+		}
+	}
+}
+
+static void *job_main(void *arg)
+{
+	struct calib_job *job = arg;
+	const struct calib_problem *problem = job->problem;
+	size_t s;
+
+	if (job->kind == JOB_PREPARE) {
+		for (s = job->begin; s < job->end; s++)
+			prepare_frame(&problem->samples[s], &problem->frames[s]);
+		return NULL;
+	}
+
+	for (s = job->begin; s < job->end; s++)
+		accumulate_frame(job, &problem->frames[s]);
+
+	return NULL;
+}
+
+/**
+ * evaluate - Kjør én jobb-type parallelt over alle samples
+ * @problem: problem med parametervektor
+ * @jobs: tråd-arbeidsområder (num_threads)
+ * @num_threads: antall tråder
+ * @kind: hva som skal beregnes
+ * @cost: output - Σ r² (ikke for JOB_PREPARE)
+ * @max_abs: output - største |r| (ikke for JOB_PREPARE)
+ * @jtj: output - JᵀJ (kun for JOB_NORMAL, ellers NULL)
+ * @jtr: output - Jᵀr (kun for JOB_NORMAL, ellers NULL)
+ *
+ * Delsummene reduseres i fast tråd-rekkefølge.
+ */
+static void evaluate(const struct calib_problem *problem,
+		     struct calib_job *jobs, int num_threads,
+		     enum calib_job_kind kind, double *cost, double *max_abs,
+		     double *jtj, double *jtr)
+{
+	pthread_t threads[CALIB_MAX_THREADS];
+	int started[CALIB_MAX_THREADS];
+	int t, k;
+
+	for (t = 0; t < num_threads; t++) {
+		struct calib_job *job = &jobs[t];
+
+		job->problem = problem;
+		job->begin = problem->num_samples * t / num_threads;
+		job->end = problem->num_samples * (t + 1) / num_threads;
+		job->kind = kind;
+		job->cost = 0.0;
+		job->max_abs = 0.0;
+		if (kind == JOB_NORMAL) {
+			memset(job->jtj, 0, sizeof(job->jtj));
+			memset(job->jtr, 0, sizeof(job->jtr));
+		}
+
+		/* Tråd 0 kjører på kallende tråd */
+		started[t] = 0;
+		if (t == 0)
+			continue;
+		if (pthread_create(&threads[t], NULL, job_main, job) == 0)
+			started[t] = 1;
+		else
+			job_main(job);
+	}
+
+	job_main(&jobs[0]);
+
+	for (t = 1; t < num_threads; t++)
+		if (started[t])
+			pthread_join(threads[t], NULL);
+
+	if (kind == JOB_PREPARE)
+		return;
+
+	*cost = 0.0;
+	*max_abs = 0.0;
+	if (kind == JOB_NORMAL) {
+		memset(jtj, 0, NUM_PARAMS * NUM_PARAMS * sizeof(double));
+		memset(jtr, 0, NUM_PARAMS * sizeof(double));
+	}
+
+	for (t = 0; t < num_threads; t++) {
+		*cost += jobs[t].cost;
+		if (jobs[t].max_abs > *max_abs)
+			*max_abs = jobs[t].max_abs;
+
+		if (kind != JOB_NORMAL)
+			continue;
+		for (k = 0; k < NUM_PARAMS * NUM_PARAMS; k++)
+			jtj[k] += jobs[t].jtj[k];
+		for (k = 0; k < NUM_PARAMS; k++)
+			jtr[k] += jobs[t].jtr[k];
+	}
+}
+
+/**
+ * solve_cholesky - Løs symmetrisk positiv-definitt system in-place
+ * @a: n×n matrise (row-major, ødelegges)
+ * @b: høyre side, erstattes med løsningen
+ * @n: dimensjon
+ *
+ * Retur: 0 ved suksess, -1 hvis matrisen ikke er positiv-definitt
+ */
+static int solve_cholesky(double *a, double *b, int n)
+{
+	int i, j, k;
+	double sum;
+
+	/* A = L·Lᵀ, L lagres i nedre triangel */
+	for (j = 0; j < n; j++) {
+		sum = a[j * n + j];
+		for (k = 0; k < j; k++)
+			sum -= a[j * n + k] * a[j * n + k];
+		if (sum <= 0.0)
+			return -1;
+		a[j * n + j] = sqrt(sum);
+
+		for (i = j + 1; i < n; i++) {
+			sum = a[i * n + j];
+			for (k = 0; k < j; k++)
+				sum -= a[i * n + k] * a[j * n + k];
+			a[i * n + j] = sum / a[j * n + j];
+		}
+	}
+
+	/* L·y = b */
+	for (i = 0; i < n; i++) {
+		sum = b[i];
+		for (k = 0; k < i; k++)
+			sum -= a[i * n + k] * b[k];
+		b[i] = sum / a[i * n + i];
+	}
+
+	/* Lᵀ·x = y */
+	for (i = n - 1; i >= 0; i--) {
+		sum = b[i];
+		for (k = i + 1; k < n; k++)
+			sum -= a[k * n + i] * b[k];
+		b[i] = sum / a[i * n + i];
+	}
+
+	return 0;
+}
+
+/**
+ * select_params - Lag liste over aktive parametere
+ * @mask: bitmaske av enum stewart_calib_param
+ * @active: output - full parameter-indeks for hver aktiv parameter
+ *
+ * Retur: antall aktive parametere
+ */
+static int select_params(unsigned int mask, int active[NUM_PARAMS])
+{
+	int n = 0, i;
+
+	if (mask & STEWART_CALIB_BASE_POINTS)
+		for (i = 0; i < 18; i++)
+			active[n++] = P_BASE + i;
+	if (mask & STEWART_CALIB_PLATFORM_POINTS)
+		for (i = 0; i < 12; i++)
+			active[n++] = P_PLATFORM + i;
+	if (mask & STEWART_CALIB_HOME_HEIGHT)
+		active[n++] = P_HOME_HEIGHT;
+	if (mask & STEWART_CALIB_FOOT_LENGTHS) {
+		active[n++] = P_SHORT;
+		active[n++] = P_LONG;
+	}
+
+	return n;
+}
+
+void stewart_calib_options_default(struct stewart_calib_options *options)
+{
+	if (!options)
+		return;
+
+	options->params = STEWART_CALIB_BASE_POINTS |
+			  STEWART_CALIB_PLATFORM_POINTS |
+			  STEWART_CALIB_FOOT_LENGTHS;
+	options->max_iterations = 50;
+	options->num_threads = 0;
+	options->tolerance = 1e-9;
+	options->verbose = 0;
+}
+
+int stewart_calibrate(const struct stewart_geometry *initial,
+		      const struct stewart_calib_sample *samples,
+		      size_t num_samples,
+		      const struct stewart_calib_options *options,
+		      struct stewart_geometry *result,
+		      struct stewart_calib_report *report)
+{
+	struct calib_job *jobs;
+	struct stewart_calib_options defaults;
+	struct stewart_calib_report local_report;
+	struct calib_problem problem;
+	double theta[NUM_PARAMS], trial[NUM_PARAMS];
+	double jtj[NUM_PARAMS * NUM_PARAMS], jtr[NUM_PARAMS];
+	double system[NUM_PARAMS * NUM_PARAMS], step[NUM_PARAMS];
+	double cost, trial_cost, max_abs, trial_max_abs, lambda;
+	int active[NUM_PARAMS];
+	int num_active, num_threads, iteration, i, j;
+
+	if (!initial || !samples || num_samples == 0 || !result)
+		return -1;
+
+	if (!options) {
+		stewart_calib_options_default(&defaults);
+		options = &defaults;
+	}
+	if (!report)
+		report = &local_report;
+	memset(report, 0, sizeof(*report));
+
+	num_active = select_params(options->params, active);
+	if (num_active == 0)
+		return -1;
+
+	num_threads = options->num_threads;
+	if (num_threads <= 0)
+		num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if (num_threads < 1)
+		num_threads = 1;
+	if (num_threads > CALIB_MAX_THREADS)
+		num_threads = CALIB_MAX_THREADS;
+	if ((size_t)num_threads > num_samples)
+		num_threads = (int)num_samples;
+
+	geometry_to_theta(initial, theta);
+	problem.samples = samples;
+	problem.num_samples = num_samples;
+	problem.theta = theta;
+	problem.frames = malloc(num_samples * sizeof(*problem.frames));
+
+	/* Ett arbeidsområde (med egen JᵀJ) per tråd */
+	jobs = calloc(num_threads, sizeof(*jobs));
+	if (!jobs || !problem.frames) {
+		free(jobs);
+		free(problem.frames);
+		return -1;
+	}
+
+	evaluate(&problem, jobs, num_threads, JOB_PREPARE, NULL, NULL, NULL,
+		 NULL);
+	evaluate(&problem, jobs, num_threads, JOB_NORMAL, &cost, &max_abs, jtj,
+		 jtr);
+
+	report->num_params = num_active;
+	report->num_residuals = num_samples * 6;
+	report->rms_initial_mm = sqrt(cost / report->num_residuals);
+
+	lambda = 1e-3;
+	for (iteration = 1; iteration <= options->max_iterations;
+	     iteration++) {
+		report->iterations = iteration;
+
+		/* (JᵀJ + λ·diag(JᵀJ))·δ = -Jᵀr, kun aktive parametere */
+		for (i = 0; i < num_active; i++) {
+			for (j = 0; j < num_active; j++)
+				system[i * num_active + j] =
+					jtj[active[i] * NUM_PARAMS + active[j]];
+			system[i * num_active + i] *= 1.0 + lambda;
+			system[i * num_active + i] += 1e-12;
+			step[i] = -jtr[active[i]];
+		}
+
+		if (solve_cholesky(system, step, num_active) < 0) {
+			free(jobs);
+			free(problem.frames);
+			return -1;
+		}
+
+		memcpy(trial, theta, sizeof(trial));
+		for (i = 0; i < num_active; i++)
+			trial[active[i]] += step[i];
+
+		problem.theta = trial;
+		evaluate(&problem, jobs, num_threads, JOB_COST, &trial_cost,
+			 &trial_max_abs, NULL, NULL);
+
+		if (options->verbose) {
+			printf("  LM %2d: rms %.6f -> %.6f mm, lambda %.1e%s\n",
+			       iteration, sqrt(cost / report->num_residuals),
+			       sqrt(trial_cost / report->num_residuals),
+			       lambda, trial_cost < cost ? "" : " (rejected)");
+		}
+
+		if (trial_cost < cost) {
+			double decrease = (cost - trial_cost) / cost;
+
+			memcpy(theta, trial, sizeof(theta));
+			max_abs = trial_max_abs;
+			lambda = fmax(lambda * 0.1, 1e-12);
+
+			problem.theta = theta;
+			evaluate(&problem, jobs, num_threads, JOB_NORMAL,
+				 &cost, &max_abs, jtj, jtr);
+
+			if (decrease < options->tolerance) {
+				report->converged = 1;
+				break;
+			}
+		} else {
+			problem.theta = theta;
+			lambda *= 10.0;
+			if (lambda > 1e12) {
+				/* Ingen retning reduserer kosten: minimum */
+				report->converged = 1;
+				break;
+			}
+		}
+	}
+
+	free(jobs);
+	free(problem.frames);
+
+	report->rms_final_mm = sqrt(cost / report->num_residuals);
+	report->max_final_mm = max_abs;
+
+	if (result != initial)
+		*result = *initial;
+	theta_to_geometry(theta, result);
+
+	return 0;
+}
@@ -0,0 +1,282 @@
+#include "robotics/math/vec3.h"
+#include <math.h>
+#include <stdio.h>
+#include <stewart/collision.h>
+
+/*
+ * 15 par × 4 segment-kombinasjoner = 60 segment-par, regnet 4 om gangen
+ * med GCC/Clang vektor-utvidelser (SSE på x86, NEON på ARM). Eksplisitte
+ * vektorer fordi prosjektet bygges uten -O, og selv med -O3 vektoriserer
+ * ikke gcc clamp-grenene i segment-avstanden.
+ */
+typedef float vec4f __attribute__((vector_size(16)));
+typedef int vec4i __attribute__((vector_size(16)));
+
+/* Ben-par i fast rekkefølge (0,1), (0,2), ... (4,5) */
+static const unsigned char PAIR_A[STEWART_COLLISION_PAIRS] = {
+	0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 3, 3, 4
+};
+static const unsigned char PAIR_B[STEWART_COLLISION_PAIRS] = {
+	1, 2, 3, 4, 5, 2, 3, 4, 5, 3, 4, 5, 4, 5, 5
+};
+
+/**
+ * struct leg_segments - Arm og pushrod for alle ben i SoA layout
+ * @x, @y, @z: startpunkt, [0] = motor arm (base -> kne),
+ *             [1] = pushrod (kne -> platform)
+ * @dx, @dy, @dz: retning (slutt - start)
+ */
+struct leg_segments {
+	float x[2][6], y[2][6], z[2][6];
+	float dx[2][6], dy[2][6], dz[2][6];
+};
+
+/* Lane-vis a < b ? a : b uten grener */
+static inline vec4f vec4f_min(vec4f a, vec4f b)
+{
+	vec4i mask = a < b;
+
+	return (vec4f)((mask & (vec4i)a) | (~mask & (vec4i)b));
+}
+
+static inline vec4f vec4f_max(vec4f a, vec4f b)
+{
+	vec4i mask = a > b;
+
+	return (vec4f)((mask & (vec4i)a) | (~mask & (vec4i)b));
+}
+
+static inline vec4f clamp01(vec4f x)
+{
+	const vec4f zero = { 0.0f, 0.0f, 0.0f, 0.0f };
+	const vec4f one = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+	return vec4f_min(vec4f_max(x, zero), one);
+}
+
+/**
+ * fill_segments - Hent arm og pushrod segmenter fra IK resultat
+ * @geom: robot geometri (base punkter)
+ * @inverse: IK resultat (kne og platform punkter)
+ * @seg: output - segmenter
+ */
+static void fill_segments(const struct stewart_geometry *geom,
+			  const struct stewart_inverse_result *inverse,
+			  struct leg_segments *seg)
+{
+	const struct vec3 *base = geom->base_points;
+	const struct vec3 *knee = inverse->knee_points;
+	const struct vec3 *top = inverse->platform_points_transformed;
+	int i;
+
+	for (i = 0; i < 6; i++) {
+		seg->x[0][i] = base[i].x;
+		seg->y[0][i] = base[i].y;
+		seg->z[0][i] = base[i].z;
+		seg->dx[0][i] = knee[i].x - base[i].x;
+		seg->dy[0][i] = knee[i].y - base[i].y;
+		seg->dz[0][i] = knee[i].z - base[i].z;
+
+		seg->x[1][i] = knee[i].x;
+		seg->y[1][i] = knee[i].y;
+		seg->z[1][i] = knee[i].z;
+		seg->dx[1][i] = top[i].x - knee[i].x;
+		seg->dy[1][i] = top[i].y - knee[i].y;
+		seg->dz[1][i] = top[i].z - knee[i].z;
+	}
+}
+
+/* Lanes for segment 1 (arm a, arm a, rod a, rod a) */
+#define LANES_A(f, a) ((vec4f){ f[0][a], f[0][a], f[1][a], f[1][a] })
+/* Lanes for segment 2 (arm b, rod b, arm b, rod b) */
+#define LANES_B(f, b) ((vec4f){ f[0][b], f[1][b], f[0][b], f[1][b] })
+
+/**
+ * pair_distance_sq - Kvadrert avstand for de fire segment-parene i et par
+ * @seg: segmenter for alle ben
+ * @a: første ben
+ * @b: andre ben
+ *
+ * Lane c er kombinasjon 0 arm/arm, 1 arm/pushrod, 2 pushrod/arm,
+ * 3 pushrod/pushrod.
+ *
+ * Nærmeste punkter på to segmenter (Ericson, Real-Time Collision
+ * Detection 5.1.9), skrevet uten grener: s fra ubegrenset løsning,
+ * t = clamp(t(s)), s = clamp(s(t)). Nesten parallelle segmenter får
+ * s = 0 eller 1 fra første steg, og de to projeksjonene gir da riktig
+ * avstand. Segmentene må ha lengde > 0.
+ */
+static inline vec4f pair_distance_sq(const struct leg_segments *seg, int a,
+				     int b)
+{
+	const vec4f eps = { 1e-6f, 1e-6f, 1e-6f, 1e-6f };
+	vec4f ux = LANES_A(seg->dx, a), vx = LANES_B(seg->dx, b);
+	vec4f uy = LANES_A(seg->dy, a), vy = LANES_B(seg->dy, b);
+	vec4f uz = LANES_A(seg->dz, a), vz = LANES_B(seg->dz, b);
+	vec4f rx = LANES_A(seg->x, a) - LANES_B(seg->x, b);
+	vec4f ry = LANES_A(seg->y, a) - LANES_B(seg->y, b);
+	vec4f rz = LANES_A(seg->z, a) - LANES_B(seg->z, b);
+	vec4f sa = ux * ux + uy * uy + uz * uz;
+	vec4f se = vx * vx + vy * vy + vz * vz;
+	vec4f sb = ux * vx + uy * vy + uz * vz;
+	vec4f sc = ux * rx + uy * ry + uz * rz;
+	vec4f sf = vx * rx + vy * ry + vz * rz;
+	vec4f denom = vec4f_max(sa * se - sb * sb, eps * sa * se);
+	vec4f s, t, dx, dy, dz;
+
+	s = clamp01((sb * sf - sc * se) / denom);
+	t = clamp01((sb * s + sf) / se);
+	s = clamp01((sb * t - sc) / sa);
+
+	dx = rx + ux * s - vx * t;
+	dy = ry + uy * s - vy * t;
+	dz = rz + uz * s - vz * t;
+	return dx * dx + dy * dy + dz * dz;
+}
+
+/**
+ * plane_from_points - Plan gjennom punkt 0, 2 og 4
+ * @points: 6 punkter
+ * @center: output - tyngdepunkt av alle 6
+ * @normal: output - enhets-normal med positiv y
+ */
+static void plane_from_points(const struct vec3 points[6],
+			      struct vec3 *center, struct vec3 *normal)
+{
+	struct vec3 u, v;
+	int i;
+
+	*center = (struct vec3){ 0.0f, 0.0f, 0.0f };
+	for (i = 0; i < 6; i++)
+		vec3_add(center, &points[i], center);
+	vec3_scale(center, 1.0f / 6.0f);
+
+	vec3_sub(&points[2], &points[0], &u);
+	vec3_sub(&points[4], &points[0], &v);
+	vec3_cross(&u, &v, normal);
+	if (normal->y < 0.0f)
+		vec3_scale(normal, -1.0f);
+	vec3_normalize(normal);
+}
+
+void stewart_collision_pair_legs(int pair, int *leg_a, int *leg_b)
+{
+	if (pair < 0 || pair >= STEWART_COLLISION_PAIRS)
+		return;
+
+	if (leg_a)
+		*leg_a = PAIR_A[pair];
+	if (leg_b)
+		*leg_b = PAIR_B[pair];
+}
+
+void stewart_collision_check(const struct stewart_geometry *geom,
+			     const struct stewart_inverse_result *inverse,
+			     struct stewart_collision_result *result)
+{
+	struct leg_segments seg;
+	struct vec3 base_center, base_normal;
+	struct vec3 top_center, top_normal, relative;
+	float d, min_sq;
+	vec4f d4;
+	int k, i;
+
+	if (!geom || !inverse || !result)
+		return;
+
+	fill_segments(geom, inverse, &seg);
+
+	/* Minste av de fire kombinasjonene per par */
+	result->min_pair = 0;
+	result->min_pair_distance_mm = INFINITY;
+	for (k = 0; k < STEWART_COLLISION_PAIRS; k++) {
+		d4 = pair_distance_sq(&seg, PAIR_A[k], PAIR_B[k]);
+		min_sq = fminf(fminf(d4[0], d4[1]), fminf(d4[2], d4[3]));
+		result->pair_distance_mm[k] = sqrtf(min_sq);
+
+		if (result->pair_distance_mm[k] < result->min_pair_distance_mm) {
+			result->min_pair_distance_mm = result->pair_distance_mm[k];
+			result->min_pair = k;
+		}
+	}
+
+	/* Kne mot base og platform plan */
+	plane_from_points(geom->base_points, &base_center, &base_normal);
+	plane_from_points(inverse->platform_points_transformed, &top_center,
+			  &top_normal);
+
+	result->min_plate_clearance_mm = INFINITY;
+	for (i = 0; i < 6; i++) {
+		vec3_sub(&inverse->knee_points[i], &base_center, &relative);
+		d = vec3_dot(&relative, &base_normal);
+		result->knee_base_clearance_mm[i] = d;
+		result->min_plate_clearance_mm =
+			fminf(result->min_plate_clearance_mm, d);
+
+		vec3_sub(&top_center, &inverse->knee_points[i], &relative);
+		d = vec3_dot(&relative, &top_normal);
+		result->knee_platform_clearance_mm[i] = d;
+		result->min_plate_clearance_mm =
+			fminf(result->min_plate_clearance_mm, d);
+	}
+}
+
+size_t stewart_collision_check_batch(const struct stewart_geometry *geom,
+				     const struct stewart_inverse_result *inverse,
+				     size_t count,
+				     struct stewart_collision_result *results,
+				     struct stewart_collision_result *worst)
+{
+	struct stewart_collision_result current;
+	float worst_distance = INFINITY;
+	size_t i, worst_index = 0;
+
+	if (!geom || !inverse)
+		return 0;
+
+	for (i = 0; i < count; i++) {
+		stewart_collision_check(geom, &inverse[i], &current);
+		if (results)
+			results[i] = current;
+
+		if (current.min_pair_distance_mm < worst_distance) {
+			worst_distance = current.min_pair_distance_mm;
+			worst_index = i;
+			if (worst)
+				*worst = current;
+		}
+	}
+
+	return worst_index;
+}
+
+void stewart_collision_result_print(
+	const struct stewart_collision_result *result)
+{
+	int k, i;
+
+	if (!result) {
+		printf("stewart_collision_result: NULL\n");
+		return;
+	}
+
+	printf("stewart_collision_result:\n");
+	printf("  Min leg distance: %.2f mm (legs %d-%d)\n",
+	       result->min_pair_distance_mm, PAIR_A[result->min_pair],
+	       PAIR_B[result->min_pair]);
+	printf("  Min plate clearance: %.2f mm\n",
+	       result->min_plate_clearance_mm);
+
+	printf("\n  Leg pair distances (mm):\n");
+	for (k = 0; k < STEWART_COLLISION_PAIRS; k++) {
+		printf("    [%d-%d]: %7.2f\n", PAIR_A[k], PAIR_B[k],
+		       result->pair_distance_mm[k]);
+	}
+
+	printf("\n  Knee clearance base/platform (mm):\n");
+	for (i = 0; i < 6; i++) {
+		printf("    [%d]: %7.2f %7.2f\n", i,
+		       result->knee_base_clearance_mm[i],
+		       result->knee_platform_clearance_mm[i]);
+	}
+}
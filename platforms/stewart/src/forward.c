@@ -1,6 +1,10 @@
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
 #include <stewart/kinematics.h>
+#include "robotics/math/matrix.h"
+#include "robotics/math/solve.h"
+#include "robotics/math/utils.h"
 #include "robotics/math/vec3.h"
 
 /* Simulerings-parametere for fjær-modell */
@@ -144,6 +148,169 @@ void stewart_kinematics_forward(const struct stewart_geometry *geom,
 	result_forv->pose_result = *pose_calc;
 }
 
+/**
+ * axis_rotation - Lag rotasjonsmatrise (eller derivert) rundt én akse
+ * @mat: output matrise
+ * @axis: 0 = X, 1 = Y, 2 = Z
+ * @angle_rad: vinkel i radianer
+ * @derivative: 1 = d(R)/d(vinkel), 0 = R
+ *
+ * Samme fortegn som mat3_rotate_x/y/z.
+ */
+static void axis_rotation(struct mat3 *mat, int axis, float angle_rad,
+			  int derivative)
+{
+	float c = cosf(angle_rad);
+	float s = sinf(angle_rad);
+	float dc = derivative ? -s : c;
+	float ds = derivative ? c : s;
+
+	memset(mat->m, 0, sizeof(mat->m));
+	mat->m[axis * 4] = derivative ? 0.0f : 1.0f;
+
+	switch (axis) {
+	case 0:
+		mat->m[4] = dc;
+		mat->m[5] = ds;
+		mat->m[7] = -ds;
+		mat->m[8] = dc;
+		break;
+	case 1:
+		mat->m[0] = dc;
+		mat->m[2] = -ds;
+		mat->m[6] = ds;
+		mat->m[8] = dc;
+		break;
+	default:
+		mat->m[0] = dc;
+		mat->m[1] = ds;
+		mat->m[3] = -ds;
+		mat->m[4] = dc;
+		break;
+	}
+}
+
+/**
+ * rotation_with_partials - ZYX rotasjon og partiellderiverte
+ * @pose: pose (grader)
+ * @rotation: output R = Rz·Ry·Rx (som mat3_rotate_xyz)
+ * @partials: output dR/drx, dR/dry, dR/drz (per radian)
+ */
+static void rotation_with_partials(const struct stewart_pose *pose,
+				   struct mat3 *rotation,
+				   struct mat3 partials[3])
+{
+	struct mat3 r[3], d[3];
+	float angles[3];
+	int axis;
+
+	angles[0] = deg_to_rad(pose->rx);
+	angles[1] = deg_to_rad(pose->ry);
+	angles[2] = deg_to_rad(pose->rz);
+
+	for (axis = 0; axis < 3; axis++) {
+		axis_rotation(&r[axis], axis, angles[axis], 0);
+		axis_rotation(&d[axis], axis, angles[axis], 1);
+	}
+
+	/* R = Rz·Ry·Rx */
+	mat3_multiply(&r[2], &r[1], rotation);
+	mat3_multiply(rotation, &r[0], rotation);
+
+	/* dR/drx = Rz·Ry·dRx */
+	mat3_multiply(&r[2], &r[1], &partials[0]);
+	mat3_multiply(&partials[0], &d[0], &partials[0]);
+
+	/* dR/dry = Rz·dRy·Rx */
+	mat3_multiply(&r[2], &d[1], &partials[1]);
+	mat3_multiply(&partials[1], &r[0], &partials[1]);
+
+	/* dR/drz = dRz·Ry·Rx */
+	mat3_multiply(&d[2], &r[1], &partials[2]);
+	mat3_multiply(&partials[2], &r[0], &partials[2]);
+}
+
+int stewart_kinematics_forward_solve(const struct stewart_geometry *geom,
+				     const float motor_angles_deg[6],
+				     struct stewart_pose *pose_io,
+				     int max_iterations, float tolerance_mm)
+{
+	struct vec3 knees[6];
+	struct mat3 rotation, partials[3];
+	struct vec3 rotated, leg, dp;
+	float jacobian[36], step[6];
+	float length, max_error;
+	const float deg_per_rad = 180.0f / M_PI;
+	int iteration, i, k;
+
+	if (!geom || !motor_angles_deg || !pose_io)
+		return -1;
+
+	stewart_kinematics_knee_points(geom, motor_angles_deg, knees);
+
+	for (iteration = 0;; iteration++) {
+		rotation_with_partials(pose_io, &rotation, partials);
+		max_error = 0.0f;
+
+		for (i = 0; i < 6; i++) {
+			/* Platform punkt i world coordinates */
+			mat3_transform_vec3(&rotation,
+					    &geom->platform_points_flat[i],
+					    &rotated);
+			leg.x = rotated.x + pose_io->tx - knees[i].x;
+			leg.y = rotated.y + pose_io->ty + geom->home_height -
+				knees[i].y;
+			leg.z = rotated.z + pose_io->tz - knees[i].z;
+
+			/* Residual: faktisk minus ønsket pushrod lengde */
+			length = vec3_length(&leg);
+			if (!(length > 0.0f))
+				return -1;
+
+			step[i] = geom->long_foot_length - length;
+			if (fabsf(step[i]) > max_error)
+				max_error = fabsf(step[i]);
+
+			/*
+			 * Jacobi-rad: d(lengde)/d(pose) = u · d(P)/d(pose)
+			 * der u er enhetsvektor langs pushrod. Rotasjon
+			 * er i grader, så radian-derivert skaleres ned.
+			 */
+			vec3_scale(&leg, 1.0f / length);
+			for (k = 0; k < 3; k++) {
+				mat3_transform_vec3(&partials[k],
+						    &geom->platform_points_flat[i],
+						    &dp);
+				jacobian[i * 6 + k] =
+					vec3_dot(&leg, &dp) / deg_per_rad;
+			}
+			jacobian[i * 6 + 3] = leg.x;
+			jacobian[i * 6 + 4] = leg.y;
+			jacobian[i * 6 + 5] = leg.z;
+		}
+
+		if (max_error < tolerance_mm)
+			return iteration;
+		if (iteration >= max_iterations)
+			return -1;
+
+		/* Newton-steg: J·Δ = -f */
+		if (solve_linear_system(jacobian, step, 6) < 0)
+			return -1;
+
+		pose_io->rx += step[0];
+		pose_io->ry += step[1];
+		pose_io->rz += step[2];
+		pose_io->tx += step[3];
+		pose_io->ty += step[4];
+		pose_io->tz += step[5];
+
+		if (!isfinite(pose_io->rx + pose_io->ry + pose_io->rz +
+			      pose_io->tx + pose_io->ty + pose_io->tz))
+			return -1;
+	}
+}
+
 void stewart_forward_result_print(const struct stewart_forward_result *result)
 {
 	int i;
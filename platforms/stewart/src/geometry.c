@@ -1,6 +1,117 @@
+#include "robotics/math/utils.h"
 #include "stewart/geometry.h"
+#include <math.h>
 #include <stdio.h>
 
+/* Motor par for plan-definisjon */
+static const int MOTOR_PAIRS[6] = { 1, 0, 3, 2, 5, 4 };
+
+void stewart_geometry_prepare(const struct stewart_geometry *geom,
+			      struct stewart_geometry_prepared *prepared)
+{
+	const struct vec3 y_axis = { 0.0f, 1.0f, 0.0f };
+	float y_angle_rad;
+	int i, pair;
+
+	if (!geom || !prepared)
+		return;
+
+	prepared->geom = *geom;
+
+	for (i = 0; i < 6; i++) {
+		pair = MOTOR_PAIRS[i];
+
+		/*
+		 * Motor plan X-akse peker til høyre (CCW sett utenfra),
+		 * Y-akse peker opp
+		 */
+		if (i & 1) { /* 1, 3, 5 */
+			vec3_sub(&geom->base_points[i], &geom->base_points[pair],
+				 &prepared->motor_x_axis[i]);
+			prepared->min_motor_angle_deg[i] =
+				geom->min_motor_angle_135_deg;
+			prepared->max_motor_angle_deg[i] =
+				geom->max_motor_angle_135_deg;
+		} else { /* 0, 2, 4 */
+			vec3_sub(&geom->base_points[pair], &geom->base_points[i],
+				 &prepared->motor_x_axis[i]);
+			prepared->min_motor_angle_deg[i] =
+				geom->min_motor_angle_024_deg;
+			prepared->max_motor_angle_deg[i] =
+				geom->max_motor_angle_024_deg;
+		}
+		vec3_normalize(&prepared->motor_x_axis[i]);
+		vec3_cross(&prepared->motor_x_axis[i], &y_axis,
+			   &prepared->motor_normal[i]);
+
+		/* Motor par deler rotasjon rundt Y: -30°, 90°, 210° */
+		y_angle_rad = deg_to_rad(-30.0f + (i / 2) * 120.0f);
+		prepared->knee_sin_y[i] = sinf(y_angle_rad);
+		prepared->knee_cos_y[i] = cosf(y_angle_rad);
+	}
+
+	prepared->short_foot_length_sq =
+		geom->short_foot_length * geom->short_foot_length;
+	prepared->long_foot_length_sq =
+		geom->long_foot_length * geom->long_foot_length;
+}
+
+static int vec3_finite(const struct vec3 *v)
+{
+	return isfinite(v->x) && isfinite(v->y) && isfinite(v->z);
+}
+
+int stewart_geometry_validate(const struct stewart_geometry *geom,
+			      const char **what)
+{
+	const char *error = NULL;
+	int i;
+
+	if (!geom) {
+		error = "geometry is NULL";
+		goto out;
+	}
+
+	for (i = 0; i < 6 && !error; i++) {
+		if (!vec3_finite(&geom->base_points[i]))
+			error = "base point is not finite";
+		else if (!vec3_finite(&geom->platform_points_flat[i]))
+			error = "platform point is not finite";
+		else if (vec3_distance(&geom->base_points[i],
+				       &geom->base_points[MOTOR_PAIRS[i]]) <
+			 1e-3f)
+			error = "base point pair coincides (no motor plane)";
+	}
+	if (error)
+		goto out;
+
+	if (!(geom->home_height > 0.0f))
+		error = "home_height must be positive";
+	else if (!(geom->short_foot_length > 0.0f))
+		error = "short_foot_length must be positive";
+	else if (!(geom->long_foot_length > 0.0f))
+		error = "long_foot_length must be positive";
+	else if (geom->motor_arm_outward != 0 && geom->motor_arm_outward != 1)
+		error = "motor_arm_outward must be 0 or 1";
+	else if (!(geom->min_motor_angle_024_deg <
+		   geom->max_motor_angle_024_deg))
+		error = "motor 0/2/4 angle limits need min < max";
+	else if (!(geom->min_motor_angle_135_deg <
+		   geom->max_motor_angle_135_deg))
+		error = "motor 1/3/5 angle limits need min < max";
+	else if (!isfinite(geom->motor_clamp_limit_angle_deg) ||
+		 !(geom->max_pose_rotation_amplitude >= 0.0f) ||
+		 !(geom->max_pose_rotation_bias >= 0.0f) ||
+		 !(geom->max_pose_translation_amplitude >= 0.0f) ||
+		 !(geom->max_pose_translation_bias >= 0.0f))
+		error = "pose limits must be finite and non-negative";
+
+out:
+	if (what)
+		*what = error;
+	return error ? -1 : 0;
+}
+
 void stewart_geometry_print(const struct stewart_geometry *geom)
 {
 	int i;
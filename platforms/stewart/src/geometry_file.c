@@ -0,0 +1,468 @@
+#define _DEFAULT_SOURCE
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stewart/geometry_file.h>
+
+#define BYTE_ORDER_MARK 0x01020304u
+
+enum field_type { FIELD_FLOAT, FIELD_INT, FIELD_VEC3 };
+
+/**
+ * struct field - Én nøkkel i tekstformatet
+ * @key: nøkkel
+ * @offset: offset i struct stewart_geometry
+ * @type: verditype
+ */
+struct field {
+	const char *key;
+	size_t offset;
+	enum field_type type;
+};
+
+#define FLOAT_FIELD(name) \
+	{ #name, offsetof(struct stewart_geometry, name), FIELD_FLOAT }
+#define POINT_FIELD(key, array, i)                                  \
+	{ key,                                                      \
+	  offsetof(struct stewart_geometry, array) +                \
+		  (i) * sizeof(struct vec3),                        \
+	  FIELD_VEC3 }
+
+/* Rekkefølgen er også rekkefølgen stewart_geometry_save() skriver i */
+static const struct field FIELDS[] = {
+	FLOAT_FIELD(home_height),
+	FLOAT_FIELD(short_foot_length),
+	FLOAT_FIELD(long_foot_length),
+	{ "motor_arm_outward",
+	  offsetof(struct stewart_geometry, motor_arm_outward), FIELD_INT },
+	FLOAT_FIELD(max_motor_angle_024_deg),
+	FLOAT_FIELD(min_motor_angle_024_deg),
+	FLOAT_FIELD(max_motor_angle_135_deg),
+	FLOAT_FIELD(min_motor_angle_135_deg),
+	FLOAT_FIELD(motor_clamp_limit_angle_deg),
+	FLOAT_FIELD(max_pose_rotation_amplitude),
+	FLOAT_FIELD(max_pose_rotation_bias),
+	FLOAT_FIELD(max_pose_translation_amplitude),
+	FLOAT_FIELD(max_pose_translation_bias),
+	POINT_FIELD("base_point_0", base_points, 0),
+	POINT_FIELD("base_point_1", base_points, 1),
+	POINT_FIELD("base_point_2", base_points, 2),
+	POINT_FIELD("base_point_3", base_points, 3),
+	POINT_FIELD("base_point_4", base_points, 4),
+	POINT_FIELD("base_point_5", base_points, 5),
+	POINT_FIELD("platform_point_0", platform_points_flat, 0),
+	POINT_FIELD("platform_point_1", platform_points_flat, 1),
+	POINT_FIELD("platform_point_2", platform_points_flat, 2),
+	POINT_FIELD("platform_point_3", platform_points_flat, 3),
+	POINT_FIELD("platform_point_4", platform_points_flat, 4),
+	POINT_FIELD("platform_point_5", platform_points_flat, 5),
+};
+
+#define NUM_FIELDS (sizeof(FIELDS) / sizeof(FIELDS[0]))
+
+static char *trim(char *s)
+{
+	char *end;
+
+	while (isspace((unsigned char)*s))
+		s++;
+	end = s + strlen(s);
+	while (end > s && isspace((unsigned char)end[-1]))
+		*--end = '\0';
+	return s;
+}
+
+/**
+ * parse_value - Parse verdi for ett felt
+ * @field: felt
+ * @value: tekst etter '='
+ * @geom: geometri som skrives til
+ *
+ * Retur: 0 ved suksess, -1 hvis verdien ikke er på riktig form
+ */
+static int parse_value(const struct field *field, const char *value,
+		       struct stewart_geometry *geom)
+{
+	char *dst = (char *)geom + field->offset;
+	char *end;
+	float v[3];
+	long n;
+	int i, count = field->type == FIELD_VEC3 ? 3 : 1;
+
+	if (field->type == FIELD_INT) {
+		errno = 0;
+		n = strtol(value, &end, 10);
+		if (errno || end == value || *trim(end) != '\0')
+			return -1;
+		*(int *)dst = (int)n;
+		return 0;
+	}
+
+	for (i = 0; i < count; i++) {
+		v[i] = strtof(value, &end);
+		if (end == value)
+			return -1;
+		value = end;
+	}
+	if (*value && *trim((char *)value) != '\0')
+		return -1;
+
+	memcpy(dst, v, count * sizeof(float));
+	return 0;
+}
+
+int stewart_geometry_load(const char *path, struct stewart_geometry *geom)
+{
+	struct stewart_geometry loaded;
+	unsigned char seen[NUM_FIELDS] = { 0 };
+	const char *what;
+	char line[256], *key, *value, *eq;
+	size_t i;
+	int line_no = 0, ret = -1;
+	FILE *f;
+
+	if (!path || !geom)
+		return -1;
+
+	f = fopen(path, "r");
+	if (!f) {
+		perror(path);
+		return -1;
+	}
+
+	memset(&loaded, 0, sizeof(loaded));
+
+	while (fgets(line, sizeof(line), f)) {
+		line_no++;
+
+		/* Fjern kommentar */
+		eq = strchr(line, '#');
+		if (eq)
+			*eq = '\0';
+		key = trim(line);
+		if (*key == '\0')
+			continue;
+
+		eq = strchr(key, '=');
+		if (!eq) {
+			fprintf(stderr, "%s:%d: expected 'key = value'\n", path,
+				line_no);
+			goto out;
+		}
+		*eq = '\0';
+		key = trim(key);
+		value = trim(eq + 1);
+
+		for (i = 0; i < NUM_FIELDS; i++) {
+			if (strcmp(key, FIELDS[i].key) == 0)
+				break;
+		}
+		if (i == NUM_FIELDS) {
+			fprintf(stderr, "%s:%d: unknown key '%s'\n", path,
+				line_no, key);
+			goto out;
+		}
+		if (seen[i]) {
+			fprintf(stderr, "%s:%d: duplicate key '%s'\n", path,
+				line_no, key);
+			goto out;
+		}
+		if (parse_value(&FIELDS[i], value, &loaded) < 0) {
+			fprintf(stderr, "%s:%d: bad value for '%s': %s\n", path,
+				line_no, key, value);
+			goto out;
+		}
+		seen[i] = 1;
+	}
+
+	for (i = 0; i < NUM_FIELDS; i++) {
+		if (!seen[i]) {
+			fprintf(stderr, "%s: missing key '%s'\n", path,
+				FIELDS[i].key);
+			goto out;
+		}
+	}
+
+	if (stewart_geometry_validate(&loaded, &what) < 0) {
+		fprintf(stderr, "%s: invalid geometry: %s\n", path, what);
+		goto out;
+	}
+
+	*geom = loaded;
+	ret = 0;
+out:
+	fclose(f);
+	return ret;
+}
+
+int stewart_geometry_load_prepared(const char *path,
+				   struct stewart_geometry_prepared *prep)
+{
+	struct stewart_geometry geom;
+
+	if (!prep || stewart_geometry_load(path, &geom) < 0)
+		return -1;
+
+	stewart_geometry_prepare(&geom, prep);
+	return 0;
+}
+
+/**
+ * write_float - Skriv float med færrest siffer som leses tilbake eksakt
+ * @f: fil
+ * @v: verdi
+ *
+ * 202.42f skrives som "202.42", ikke "202.419998".
+ */
+static void write_float(FILE *f, float v)
+{
+	char buf[32];
+	int precision;
+
+	for (precision = 6; precision < 9; precision++) {
+		snprintf(buf, sizeof(buf), "%.*g", precision, v);
+		if (strtof(buf, NULL) == v)
+			break;
+	}
+	fprintf(f, "%.*g", precision, v);
+}
+
+int stewart_geometry_save(const char *path, const struct stewart_geometry *geom)
+{
+	const char *base;
+	const float *v;
+	size_t i;
+	FILE *f;
+
+	if (!path || !geom)
+		return -1;
+
+	f = fopen(path, "w");
+	if (!f) {
+		perror(path);
+		return -1;
+	}
+
+	base = (const char *)geom;
+	fprintf(f, "# Stewart platform geometry (mm, degrees)\n");
+	for (i = 0; i < NUM_FIELDS; i++) {
+		v = (const float *)(base + FIELDS[i].offset);
+
+		fprintf(f, "%s =", FIELDS[i].key);
+		switch (FIELDS[i].type) {
+		case FIELD_INT:
+			fprintf(f, " %d", *(const int *)(base + FIELDS[i].offset));
+			break;
+		case FIELD_FLOAT:
+			fputc(' ', f);
+			write_float(f, v[0]);
+			break;
+		case FIELD_VEC3:
+			fputc(' ', f);
+			write_float(f, v[0]);
+			fputc(' ', f);
+			write_float(f, v[1]);
+			fputc(' ', f);
+			write_float(f, v[2]);
+			break;
+		}
+		fputc('\n', f);
+	}
+
+	if (fclose(f) != 0) {
+		perror(path);
+		return -1;
+	}
+	return 0;
+}
+
+/* FNV-1a, 32 bit */
+static uint32_t checksum(const void *data, size_t size)
+{
+	const unsigned char *p = data;
+	uint32_t hash = 2166136261u;
+	size_t i;
+
+	for (i = 0; i < size; i++) {
+		hash ^= p[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+int stewart_geometry_cache_write(const char *path, const char *const names[],
+				 const struct stewart_geometry geoms[],
+				 size_t count)
+{
+	struct stewart_geometry_cache_header header;
+	struct stewart_geometry_cache_entry *entries;
+	const char *what;
+	char tmp_path[4096];
+	size_t i;
+	FILE *f;
+	int ret = -1;
+
+	if (!path || !names || !geoms || count > UINT32_MAX)
+		return -1;
+
+	entries = calloc(count ? count : 1, sizeof(*entries));
+	if (!entries) {
+		perror("calloc");
+		return -1;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (strlen(names[i]) >= STEWART_GEOMETRY_NAME_MAX) {
+			fprintf(stderr, "%s: name too long: %s\n", path,
+				names[i]);
+			goto out;
+		}
+		if (stewart_geometry_validate(&geoms[i], &what) < 0) {
+			fprintf(stderr, "%s: invalid geometry '%s': %s\n", path,
+				names[i], what);
+			goto out;
+		}
+
+		/* calloc: navn og padding er null, så checksum er stabil */
+		strcpy(entries[i].name, names[i]);
+		stewart_geometry_prepare(&geoms[i], &entries[i].prepared);
+	}
+
+	memset(&header, 0, sizeof(header));
+	strcpy(header.magic, STEWART_GEOMETRY_CACHE_MAGIC);
+	header.version = STEWART_GEOMETRY_CACHE_VERSION;
+	header.byte_order = BYTE_ORDER_MARK;
+	header.entry_size = sizeof(*entries);
+	header.count = (uint32_t)count;
+	header.checksum = checksum(entries, count * sizeof(*entries));
+
+	if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >=
+	    (int)sizeof(tmp_path)) {
+		fprintf(stderr, "%s: path too long\n", path);
+		goto out;
+	}
+
+	f = fopen(tmp_path, "wb");
+	if (!f) {
+		perror(tmp_path);
+		goto out;
+	}
+	if (fwrite(&header, sizeof(header), 1, f) != 1 ||
+	    fwrite(entries, sizeof(*entries), count, f) != count) {
+		perror(tmp_path);
+		fclose(f);
+		unlink(tmp_path);
+		goto out;
+	}
+	if (fclose(f) != 0 || rename(tmp_path, path) != 0) {
+		perror(path);
+		unlink(tmp_path);
+		goto out;
+	}
+
+	ret = 0;
+out:
+	free(entries);
+	return ret;
+}
+
+int stewart_geometry_cache_open(const char *path,
+				struct stewart_geometry_cache *cache)
+{
+	const struct stewart_geometry_cache_header *header;
+	struct stat st;
+	size_t expected;
+	void *map;
+	int fd;
+
+	if (!path || !cache)
+		return -1;
+
+	memset(cache, 0, sizeof(*cache));
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		perror(path);
+		return -1;
+	}
+	if (fstat(fd, &st) < 0) {
+		perror(path);
+		close(fd);
+		return -1;
+	}
+	if ((size_t)st.st_size < sizeof(*header)) {
+		fprintf(stderr, "%s: not a geometry cache\n", path);
+		close(fd);
+		return -1;
+	}
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		perror(path);
+		return -1;
+	}
+
+	header = map;
+	expected = sizeof(*header) + (size_t)header->count *
+					     sizeof(struct stewart_geometry_cache_entry);
+
+	if (memcmp(header->magic, STEWART_GEOMETRY_CACHE_MAGIC,
+		   sizeof(STEWART_GEOMETRY_CACHE_MAGIC)) != 0) {
+		fprintf(stderr, "%s: not a geometry cache\n", path);
+	} else if (header->byte_order != BYTE_ORDER_MARK ||
+		   header->version != STEWART_GEOMETRY_CACHE_VERSION ||
+		   header->entry_size !=
+			   sizeof(struct stewart_geometry_cache_entry)) {
+		fprintf(stderr, "%s: cache built for another version/platform\n",
+			path);
+	} else if ((size_t)st.st_size != expected) {
+		fprintf(stderr, "%s: truncated cache\n", path);
+	} else if (checksum(header + 1, expected - sizeof(*header)) !=
+		   header->checksum) {
+		fprintf(stderr, "%s: cache checksum mismatch\n", path);
+	} else {
+		cache->entries =
+			(const struct stewart_geometry_cache_entry *)(header + 1);
+		cache->count = header->count;
+		cache->map = map;
+		cache->map_size = st.st_size;
+		return 0;
+	}
+
+	munmap(map, st.st_size);
+	return -1;
+}
+
+const struct stewart_geometry_prepared *
+stewart_geometry_cache_find(const struct stewart_geometry_cache *cache,
+			    const char *name)
+{
+	size_t i;
+
+	if (!cache || !name)
+		return NULL;
+
+	for (i = 0; i < cache->count; i++) {
+		if (strncmp(cache->entries[i].name, name,
+			    STEWART_GEOMETRY_NAME_MAX) == 0)
+			return &cache->entries[i].prepared;
+	}
+	return NULL;
+}
+
+void stewart_geometry_cache_close(struct stewart_geometry_cache *cache)
+{
+	if (!cache || !cache->map)
+		return;
+
+	munmap(cache->map, cache->map_size);
+	memset(cache, 0, sizeof(*cache));
+}
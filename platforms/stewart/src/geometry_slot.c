@@ -0,0 +1,102 @@
+#define _DEFAULT_SOURCE
+#include <sched.h>
+#include <stdio.h>
+#include <stewart/geometry_file.h>
+#include <stewart/geometry_slot.h>
+
+void stewart_geometry_slot_init(struct stewart_geometry_slot *slot,
+				const struct stewart_geometry *geom)
+{
+	if (!slot || !geom)
+		return;
+
+	stewart_geometry_prepare(geom, &slot->buffers[0]);
+	slot->buffers[1] = slot->buffers[0];
+	atomic_init(&slot->readers[0], 0);
+	atomic_init(&slot->readers[1], 0);
+	atomic_init(&slot->current, 0);
+	atomic_init(&slot->generation, 0);
+	pthread_mutex_init(&slot->publish_lock, NULL);
+}
+
+void stewart_geometry_slot_destroy(struct stewart_geometry_slot *slot)
+{
+	if (!slot)
+		return;
+
+	pthread_mutex_destroy(&slot->publish_lock);
+}
+
+const struct stewart_geometry_prepared *
+stewart_geometry_slot_acquire(struct stewart_geometry_slot *slot)
+{
+	unsigned int idx;
+
+	/*
+	 * Tell oss inn på bufferen og sjekk at den fortsatt er aktiv.
+	 * Hvis skriver flippet mellom load og inntelling kan den være i
+	 * ferd med å skrive til bufferen; da teller vi oss ut og prøver
+	 * igjen. seq_cst på inntelling og sjekk pares med skriverens
+	 * sjekk av readers før den skriver (Dekker).
+	 */
+	for (;;) {
+		idx = atomic_load(&slot->current);
+		atomic_fetch_add(&slot->readers[idx], 1);
+		if (atomic_load(&slot->current) == idx)
+			return &slot->buffers[idx];
+		atomic_fetch_sub_explicit(&slot->readers[idx], 1,
+					  memory_order_release);
+	}
+}
+
+void stewart_geometry_slot_release(struct stewart_geometry_slot *slot,
+				   const struct stewart_geometry_prepared *prep)
+{
+	if (!slot || !prep)
+		return;
+
+	atomic_fetch_sub_explicit(&slot->readers[prep - slot->buffers], 1,
+				  memory_order_release);
+}
+
+int stewart_geometry_slot_publish(struct stewart_geometry_slot *slot,
+				  const struct stewart_geometry *geom)
+{
+	const char *what;
+	unsigned int next;
+
+	if (!slot || stewart_geometry_validate(geom, &what) < 0)
+		return -1;
+
+	pthread_mutex_lock(&slot->publish_lock);
+
+	next = atomic_load(&slot->current) ^ 1;
+
+	/* Vent til siste leser av forrige versjon har sluppet */
+	while (atomic_load(&slot->readers[next]) != 0)
+		sched_yield();
+
+	stewart_geometry_prepare(geom, &slot->buffers[next]);
+	atomic_store(&slot->current, next);
+	atomic_fetch_add_explicit(&slot->generation, 1, memory_order_release);
+
+	pthread_mutex_unlock(&slot->publish_lock);
+	return 0;
+}
+
+int stewart_geometry_slot_reload(struct stewart_geometry_slot *slot,
+				 const char *path)
+{
+	struct stewart_geometry geom;
+
+	if (stewart_geometry_load(path, &geom) < 0)
+		return -1;
+
+	return stewart_geometry_slot_publish(slot, &geom);
+}
+
+unsigned int
+stewart_geometry_slot_generation(struct stewart_geometry_slot *slot)
+{
+	return atomic_load_explicit(&slot->generation, memory_order_acquire);
+}
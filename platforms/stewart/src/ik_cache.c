@@ -0,0 +1,104 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <stewart/ik_cache.h>
+
+void stewart_ik_cache_init(struct stewart_ik_cache *cache, float quantum)
+{
+	if (!cache)
+		return;
+
+	memset(cache, 0, sizeof(*cache));
+	cache->quantum = quantum > 0.0f ? quantum : 0.0f;
+}
+
+void stewart_ik_cache_clear(struct stewart_ik_cache *cache)
+{
+	unsigned int i;
+
+	if (!cache)
+		return;
+
+	for (i = 0; i < STEWART_IK_CACHE_SIZE; i++)
+		cache->entries[i].valid = 0;
+}
+
+/* Nærmeste multiplum av @q; + 0 gjør -0 til 0 så nøkkelen blir entydig */
+static float quantize(float v, float q)
+{
+	return roundf(v / q) * q + 0.0f;
+}
+
+static void quantize_pose(struct stewart_pose *pose, float q)
+{
+	pose->rx = quantize(pose->rx, q);
+	pose->ry = quantize(pose->ry, q);
+	pose->rz = quantize(pose->rz, q);
+	pose->tx = quantize(pose->tx, q);
+	pose->ty = quantize(pose->ty, q);
+	pose->tz = quantize(pose->tz, q);
+}
+
+/*
+ * Bit-sammenligning: stewart_pose er seks floats uten padding. Uten
+ * quantum regnes -0 og 0 som ulike, og NaN treffer bare en bit-lik NaN;
+ * begge deler gir bare en ekstra bom.
+ */
+static int entry_matches(const struct stewart_ik_cache_entry *e,
+			 const struct stewart_geometry_prepared *prep,
+			 unsigned int geometry_id,
+			 const struct stewart_pose *pose)
+{
+	return e->valid && e->prep == prep &&
+	       e->geometry_id == geometry_id &&
+	       memcmp(&e->pose, pose, sizeof(*pose)) == 0;
+}
+
+int stewart_ik_cache_inverse(struct stewart_ik_cache *cache,
+			     const struct stewart_geometry_prepared *prep,
+			     unsigned int geometry_id,
+			     const struct stewart_pose *pose,
+			     struct stewart_inverse_result *result)
+{
+	struct stewart_ik_cache_entry *e;
+	struct stewart_pose key = *pose;
+	unsigned int i, idx;
+
+	if (cache->quantum > 0.0f)
+		quantize_pose(&key, cache->quantum);
+
+	/* Sist brukte først; gjentatt setpunkt treffer på første sjekk */
+	for (i = 0; i < STEWART_IK_CACHE_SIZE; i++) {
+		idx = (cache->newest + i) % STEWART_IK_CACHE_SIZE;
+		e = &cache->entries[idx];
+		if (entry_matches(e, prep, geometry_id, &key)) {
+			*result = e->result;
+			cache->newest = idx;
+			cache->hits++;
+			return 1;
+		}
+	}
+
+	e = &cache->entries[cache->next];
+	stewart_kinematics_inverse_prepared(prep, &key, &e->result, 0);
+	e->pose = key;
+	e->prep = prep;
+	e->geometry_id = geometry_id;
+	e->valid = 1;
+	*result = e->result;
+
+	cache->newest = cache->next;
+	cache->next = (cache->next + 1) % STEWART_IK_CACHE_SIZE;
+	cache->misses++;
+	return 0;
+}
+
+void stewart_ik_cache_stats_print(const struct stewart_ik_cache *cache,
+				  const char *label)
+{
+	unsigned long total = cache->hits + cache->misses;
+
+	printf("%s IK cache: %lu hits, %lu misses (%.1f%% hit rate)\n", label,
+	       cache->hits, cache->misses,
+	       total ? 100.0 * (double)cache->hits / (double)total : 0.0);
+}
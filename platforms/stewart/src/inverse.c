@@ -1,4 +1,3 @@
-#include "robotics/math/geometry.h"
 #include "robotics/math/matrix.h"
 #include "robotics/math/utils.h"
 #include "robotics/math/vec3.h"
@@ -7,9 +6,6 @@
 #include <stewart/kinematics.h>
 #include <string.h>
 
-/* Motor par for plan-definisjon */
-static const int MOTOR_PAIRS[6] = { 1, 0, 3, 2, 5, 4 };
-
 /**
  * soft_clamp - Soft clamp med dampening nær grenser
  * @value: verdi som skal clampes
@@ -93,47 +89,30 @@ void calculate_transformed_platform_points(
  *                       y-
  */
 static void calculate_motor_angle(int motor_no,
-				  const struct stewart_geometry *geom,
+				  const struct stewart_geometry_prepared *prep,
 				  struct stewart_inverse_result *result,
 				  int debug)
 {
-	struct vec3 v_x_axis_2d, v_y_axis_2d;
-	struct vec3 p_origin, relative;
-	struct vec3 normal;
+	const struct stewart_geometry *geom = &prep->geom;
+	const struct vec3 *v_x_axis_2d = &prep->motor_x_axis[motor_no];
+	const struct vec3 *p_origin = &geom->base_points[motor_no];
+	struct vec3 relative;
 	float p_pro_x, p_pro_y;
 	float distance, target_angle_rad;
 	float dist_to_plane, radius;
 	float cos_angle_rad, motor_angle_rad;
-	int motor_pair;
-
-	/*
-	 * transformed_platform_points hentes fra result
-	 */
-
-	motor_pair = MOTOR_PAIRS[motor_no];
-	p_origin = geom->base_points[motor_no];
 
 	/*
-	 * Lag 2D plan for å projisere platform punkt på
-	 * X-akse peker til høyre (CCW sett utenfra)
-	 * Y-akse peker opp
+	 * transformed_platform_points hentes fra result. Motor planet
+	 * (X-akse til høyre CCW sett utenfra, Y-akse opp) og normalen er
+	 * forhåndsberegnet i stewart_geometry_prepare().
 	 */
-	if (motor_no & 1) { /* 1, 3, 5 */
-		vec3_sub(&geom->base_points[motor_no],
-			 &geom->base_points[motor_pair], &v_x_axis_2d);
-	} else { /* 0, 2, 4 */
-		vec3_sub(&geom->base_points[motor_pair],
-			 &geom->base_points[motor_no], &v_x_axis_2d);
-	}
-
-	vec3_normalize(&v_x_axis_2d);
-	v_y_axis_2d = (struct vec3){ 0.0f, 1.0f, 0.0f };
 
 	/* Projiser platform punkt på 2D plan */
-	vec3_sub(&result->platform_points_transformed[motor_no], &p_origin,
+	vec3_sub(&result->platform_points_transformed[motor_no], p_origin,
 		 &relative);
 
-	p_pro_x = vec3_dot(&relative, &v_x_axis_2d);
+	p_pro_x = vec3_dot(&relative, v_x_axis_2d);
 	p_pro_y = relative.y; /* Enklere enn dot siden Y-akse er (0,1,0) */
 
 	/* Beregn avstand i 2D plan */
@@ -146,10 +125,7 @@ static void calculate_motor_angle(int motor_no,
 	 * Finn avstand fra platform punkt til plan
 	 * Brukes for å beregne effektiv radius av servo arm sirkel
 	 */
-	vec3_cross(&v_x_axis_2d, &v_y_axis_2d, &normal);
-	dist_to_plane = distance_point_to_plane(
-		&result->platform_points_transformed[motor_no], &p_origin,
-		&normal);
+	dist_to_plane = vec3_dot(&relative, &prep->motor_normal[motor_no]);
 
 	/*
 	 * Beregn radius av servo arm sirkel på plan
@@ -157,7 +133,7 @@ static void calculate_motor_angle(int motor_no,
 	 */
 	radius = 0.0f;
 	if (dist_to_plane < geom->long_foot_length) {
-		radius = sqrtf(geom->long_foot_length * geom->long_foot_length -
+		radius = sqrtf(prep->long_foot_length_sq -
 			       dist_to_plane * dist_to_plane);
 	}
 
@@ -174,8 +150,8 @@ static void calculate_motor_angle(int motor_no,
 		cos_angle_rad = M_PI;
 	} else {
 		cos_angle_rad = acosf(
-			(geom->short_foot_length * geom->short_foot_length +
-			 distance * distance - radius * radius) /
+			(prep->short_foot_length_sq + distance * distance -
+			 radius * radius) /
 			(2.0f * geom->short_foot_length * distance));
 	}
 
@@ -204,33 +180,48 @@ static void calculate_motor_angle(int motor_no,
 	result->motor_angles_deg[motor_no] = rad_to_deg(motor_angle_rad);
 
 	/* Hard clamp til geometri-grenser */
-	if (motor_no & 1) { /* 1, 3, 5 */
-		result->motor_angles_deg[motor_no] =
-			soft_clamp(result->motor_angles_deg[motor_no],
-				   geom->min_motor_angle_135_deg,
-				   geom->max_motor_angle_135_deg, 10.0f);
-	} else { /* 0, 2, 4 */
-		result->motor_angles_deg[motor_no] =
-			soft_clamp(result->motor_angles_deg[motor_no],
-				   geom->min_motor_angle_024_deg,
-				   geom->max_motor_angle_024_deg, 10.0f);
-	}
+	result->motor_angles_deg[motor_no] =
+		soft_clamp(result->motor_angles_deg[motor_no],
+			   prep->min_motor_angle_deg[motor_no],
+			   prep->max_motor_angle_deg[motor_no], 10.0f);
 }
 
 /**
- * calculate_knee_positions - Beregn kne posisjoner fra motor vinkler
- * @geom: robot geometri
- * @result: inverse kinematics resultat (input/output)
+ * calculate_knee_points - Kne posisjoner med forhåndsberegnet Y-rotasjon
+ * @prep: forberedt geometri
+ * @result: inverse kinematics resultat (motor vinkler inn, kne ut)
  *
- * Beregner 3D posisjon av hvert kne basert på motor vinkel.
- * Kne er der servo arm møter pushrod.
+ * Samme som stewart_kinematics_knee_points(), men Rx(vinkel) og
+ * Ry(motor) er skrevet ut: foot = Ry·Rx·(0, -short, 0) blir
+ * short · (-sin(y)·sin(a), -cos(a), -cos(y)·sin(a)).
  */
-static void calculate_knee_positions(const struct stewart_geometry *geom,
-				     struct stewart_inverse_result *result)
+static void calculate_knee_points(const struct stewart_geometry_prepared *prep,
+				  struct stewart_inverse_result *result)
+{
+	const struct stewart_geometry *geom = &prep->geom;
+	float angle_rad, sin_a, cos_a;
+	int i;
+
+	for (i = 0; i < 6; i++) {
+		angle_rad = deg_to_rad(result->motor_angles_deg[i]);
+		sin_a = sinf(angle_rad);
+		cos_a = cosf(angle_rad);
+
+		result->knee_points[i].x = geom->base_points[i].x -
+					   geom->short_foot_length *
+						   prep->knee_sin_y[i] * sin_a;
+		result->knee_points[i].y = geom->base_points[i].y -
+					   geom->short_foot_length * cos_a;
+		result->knee_points[i].z = geom->base_points[i].z -
+					   geom->short_foot_length *
+						   prep->knee_cos_y[i] * sin_a;
+	}
+}
+
+void stewart_kinematics_knee_points(const struct stewart_geometry *geom,
+				    const float motor_angles_deg[6],
+				    struct vec3 knee_points[6])
 {
-	/*
-	 * Henter motorvinkler fra result
-	 */
 	struct mat3 rot_x, rot_y;
 	struct vec3 foot;
 	float y_angle;
@@ -242,8 +233,7 @@ static void calculate_knee_positions(const struct stewart_geometry *geom,
 
 		/* Roter rundt X-akse med motor vinkel */
 		mat3_identity(&rot_x);
-		mat3_rotate_x(&rot_x,
-			      deg_to_rad(result->motor_angles_deg[motor_no]));
+		mat3_rotate_x(&rot_x, deg_to_rad(motor_angles_deg[motor_no]));
 		mat3_transform_vec3(&rot_x, &foot, &foot);
 
 		/* Roter rundt Y-akse til motor posisjon */
@@ -259,32 +249,61 @@ static void calculate_knee_positions(const struct stewart_geometry *geom,
 
 		/* Translater til motor posisjon (world coordinates) */
 		vec3_add(&foot, &geom->base_points[motor_no],
-			 &result->knee_points[motor_no]);
+			 &knee_points[motor_no]);
 	}
 }
 
-void stewart_kinematics_inverse(const struct stewart_geometry *geom,
-				const struct stewart_pose *pose_in,
-				struct stewart_inverse_result *result,
-				int debug)
+void stewart_kinematics_inverse_prepared(
+	const struct stewart_geometry_prepared *prep,
+	const struct stewart_pose *pose_in, struct stewart_inverse_result *result,
+	int debug)
 {
 	int i;
 
-	if (!geom || !pose_in || !result)
+	if (!prep || !pose_in || !result)
 		return;
 
 	/* Nullstill resultat */
 	memset(result, 0, sizeof(struct stewart_inverse_result));
 
 	/* Transform alle platform punkter med pose */
-	calculate_transformed_platform_points(geom, pose_in, result);
+	calculate_transformed_platform_points(&prep->geom, pose_in, result);
 
 	/* Beregn motor vinkler for alle 6 motorer */
 	for (i = 0; i < 6; i++)
-		calculate_motor_angle(i, geom, result, debug);
+		calculate_motor_angle(i, prep, result, debug);
 
 	/* Beregn kne posisjoner */
-	calculate_knee_positions(geom, result);
+	calculate_knee_points(prep, result);
+}
+
+void stewart_kinematics_inverse_batch(
+	const struct stewart_geometry_prepared *prep,
+	const struct stewart_pose *poses, size_t count,
+	struct stewart_inverse_result *results)
+{
+	size_t i;
+
+	if (!prep || !poses || !results)
+		return;
+
+	for (i = 0; i < count; i++)
+		stewart_kinematics_inverse_prepared(prep, &poses[i],
+						    &results[i], 0);
+}
+
+void stewart_kinematics_inverse(const struct stewart_geometry *geom,
+				const struct stewart_pose *pose_in,
+				struct stewart_inverse_result *result,
+				int debug)
+{
+	struct stewart_geometry_prepared prepared;
+
+	if (!geom || !pose_in || !result)
+		return;
+
+	stewart_geometry_prepare(geom, &prepared);
+	stewart_kinematics_inverse_prepared(&prepared, pose_in, result, debug);
 }
 
 void stewart_inverse_result_print(const struct stewart_inverse_result *result)
@@ -0,0 +1,174 @@
+#ifndef VIZ_BENCH_H
+#define VIZ_BENCH_H
+
+#include <stdint.h>
+
+/*
+ * Headless rendering og frame-tid
+ *
+ * For å måle render-kost uten skjerm, f.eks. på Linux-servere med Mesa
+ * (llvmpipe). viz_bench_context_init() lager en offscreen GL-context med
+ * EGL (pbuffer, surfaceless platform når den finnes), så GLFW og vindu
+ * trengs ikke. Visualizerne kjører ellers som vanlig: ingest-tråden
+ * mottar pose-strømmen, og hver frame tegnes, avsluttes med glFinish()
+ * og tidtas. Til slutt skrives persentiler.
+ *
+ * viz_window_open() velger mellom vanlig vindu og offscreen context ut
+ * fra -B, og viz_bench_run() kjører målingen med visualizerens egen
+ * tegnefunksjon, så main() i hver visualizer bare gir tittel og
+ * tegnefunksjon.
+ *
+ * Offscreen-context finnes bare på Linux; andre steder feiler init.
+ */
+
+#define VIZ_BENCH_WARMUP 10 /* Frames som ikke telles (kompilering, upload) */
+
+/**
+ * struct viz_bench_context - Offscreen GL-context
+ * @display: EGLDisplay
+ * @surface: EGLSurface (pbuffer)
+ * @context: EGLContext
+ * @width, @height: størrelse i piksler
+ */
+struct viz_bench_context {
+	void *display;
+	void *surface;
+	void *context;
+	int width;
+	int height;
+};
+
+struct GLFWwindow;
+struct viz_camera;
+
+/**
+ * struct viz_window - Vindu, eller offscreen context med -B
+ * @window: GLFW-vindu, NULL med -B
+ * @headless: offscreen context med -B
+ * @bench_frames: frames som måles (-B), 0 for vanlig vindu
+ * @width, @height: størrelse i piksler
+ * @redraw: 1 når vinduet må tegnes på nytt (eksponert, endret størrelse,
+ *	    tastetrykk), nullstilles av kalleren når det er tegnet
+ * @camera: kamera styrt med tastaturet (viz_camera_attach()), ellers NULL
+ */
+struct viz_window {
+	struct GLFWwindow *window;
+	struct viz_bench_context headless;
+	int bench_frames;
+	int width;
+	int height;
+	int redraw;
+	struct viz_camera *camera;
+};
+
+/**
+ * viz_draw_fn - Tegn én frame
+ * @ctx: kallerens kontekst
+ */
+typedef void (*viz_draw_fn)(void *ctx);
+
+/**
+ * struct viz_bench - Frame-tider
+ * @samples: frame-tid per frame (ms)
+ * @count: antall målte frames
+ * @frames: antall frames som skal måles
+ * @warmup: frames igjen før måling starter
+ * @start_ns: viz_time_ns() ved start av gjeldende frame
+ */
+struct viz_bench {
+	double *samples;
+	int count;
+	int frames;
+	int warmup;
+	uint64_t start_ns;
+};
+
+/**
+ * viz_bench_context_init - Lag offscreen context og gjør den current
+ * @ctx: context som initialiseres
+ * @width, @height: størrelse i piksler
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_bench_context_init(struct viz_bench_context *ctx, int width,
+			   int height);
+
+/**
+ * viz_bench_context_destroy - Frigjør offscreen context
+ * @ctx: context
+ */
+void viz_bench_context_destroy(struct viz_bench_context *ctx);
+
+/**
+ * viz_window_open - Lag vindu, eller offscreen context med -B
+ * @w: vindu som initialiseres (må leve til viz_window_close())
+ * @title: vindustittel
+ * @width, @height: størrelse i piksler
+ * @bench_frames: -B, 0 for vanlig vindu med vsync
+ *
+ * Context er current ved retur. @w->redraw starter på 1.
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_window_open(struct viz_window *w, const char *title, int width,
+		    int height, int bench_frames);
+
+/**
+ * viz_window_close - Lukk vindu eller offscreen context
+ * @w: vindu
+ */
+void viz_window_close(struct viz_window *w);
+
+/**
+ * viz_bench_run - Tegn @frames frames uten vsync og skriv frame-tidene
+ * @frames: antall frames som måles (etter VIZ_BENCH_WARMUP)
+ * @draw: tegner én frame
+ * @ctx: sendes til @draw
+ * @label: navn i rapporten
+ */
+void viz_bench_run(int frames, viz_draw_fn draw, void *ctx,
+		   const char *label);
+
+/**
+ * viz_bench_init - Klargjør måling
+ * @b: bench som initialiseres
+ * @frames: antall frames som skal måles (etter VIZ_BENCH_WARMUP)
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_bench_init(struct viz_bench *b, int frames);
+
+/**
+ * viz_bench_done - Sjekk om alle frames er målt
+ * @b: bench
+ *
+ * Retur: 1 når @b->frames frames er målt, ellers 0
+ */
+int viz_bench_done(const struct viz_bench *b);
+
+/**
+ * viz_bench_begin - Start tidtaking av en frame
+ * @b: bench
+ */
+void viz_bench_begin(struct viz_bench *b);
+
+/**
+ * viz_bench_end - Vent på GPU og registrer frame-tiden
+ * @b: bench
+ */
+void viz_bench_end(struct viz_bench *b);
+
+/**
+ * viz_bench_report - Skriv mean, p50, p90, p99 og max
+ * @b: bench
+ * @label: navn i rapporten
+ */
+void viz_bench_report(const struct viz_bench *b, const char *label);
+
+/**
+ * viz_bench_destroy - Frigjør målingene
+ * @b: bench
+ */
+void viz_bench_destroy(struct viz_bench *b);
+
+#endif /* VIZ_BENCH_H */
@@ -0,0 +1,93 @@
+#ifndef VIZ_CAMERA_H
+#define VIZ_CAMERA_H
+
+#include "bench.h"
+
+/*
+ * Orbit-kamera og tastatur for visualizerne
+ *
+ * Ortografisk projeksjon med kameraet i en bane rundt
+ * (0, VIZ_CAMERA_TARGET_Y, 0), midt på Stewart-platformen. Tastene er
+ * like i alle visualizerne:
+ *
+ *  - piltaster roterer kameraet
+ *  - +/- eller Q/W zoomer inn/ut
+ *  - R resetter kameraet
+ *  - ESC lukker vinduet
+ *
+ * Andre taster går til visualizerens egen handler (f.eks. T for spor).
+ * Alle taster ber om ny tegning via @redraw i struct viz_window.
+ */
+
+#define VIZ_CAMERA_TARGET_Y 100.0f /* mm over basen */
+#define VIZ_CAMERA_MIN_ORTHO 50.0f /* Nærmeste zoom */
+
+/**
+ * viz_key_fn - Tast som kameraet ikke bruker
+ * @ctx: kallerens kontekst
+ * @key: GLFW_KEY_*
+ */
+typedef void (*viz_key_fn)(void *ctx, int key);
+
+/**
+ * struct viz_camera - Orbit-kamera med ortografisk projeksjon
+ * @azimuth: horisontal rotasjon (grader)
+ * @elevation: vertikal vinkel (grader), -89..89
+ * @distance: avstand fra målet
+ * @ortho_scale: halv høyde av synsfeltet (mm)
+ * @default_ortho_scale: @ortho_scale etter reset
+ * @max_ortho_scale: lengste zoom ut
+ * @clip_depth: near/far for projeksjonen
+ * @on_key: handler for andre taster (kan være NULL)
+ * @key_ctx: sendes til @on_key
+ */
+struct viz_camera {
+	float azimuth;
+	float elevation;
+	float distance;
+	float ortho_scale;
+	float default_ortho_scale;
+	float max_ortho_scale;
+	float clip_depth;
+	viz_key_fn on_key;
+	void *key_ctx;
+};
+
+/**
+ * viz_camera_init - Default kamera
+ * @c: kamera som initialiseres
+ *
+ * 45° azimuth, 30° elevation, 600 mm unna, 400 mm synsfelt. Feltene
+ * kan justeres etterpå (f.eks. større synsfelt i flåtemodus).
+ */
+void viz_camera_init(struct viz_camera *c);
+
+/**
+ * viz_camera_attach - Styr kameraet med tastaturet i vinduet
+ * @c: kamera (må leve til vinduet lukkes)
+ * @w: vindu fra viz_window_open(), uten effekt med -B
+ * @on_key: handler for taster kameraet ikke bruker (kan være NULL)
+ * @ctx: sendes til @on_key
+ */
+void viz_camera_attach(struct viz_camera *c, struct viz_window *w,
+		       viz_key_fn on_key, void *ctx);
+
+/**
+ * viz_camera_key - Bruk en tast på kameraet
+ * @c: kamera
+ * @key: GLFW_KEY_*
+ *
+ * Retur: 1 hvis tasten styrer kameraet, ellers 0
+ */
+int viz_camera_key(struct viz_camera *c, int key);
+
+/**
+ * viz_camera_apply - Sett projection og modelview for kameraet
+ * @c: kamera
+ * @w: vindu (for aspect ratio)
+ *
+ * Etterlater GL_MODELVIEW som aktiv matrise.
+ */
+void viz_camera_apply(const struct viz_camera *c, const struct viz_window *w);
+
+#endif /* VIZ_CAMERA_H */
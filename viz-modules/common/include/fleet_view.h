@@ -0,0 +1,134 @@
+#ifndef VIZ_FLEET_VIEW_H
+#define VIZ_FLEET_VIEW_H
+
+#include "robotics/math/vec3.h"
+#include "stewart/geometry.h"
+#include "stewart/kinematics.h"
+#include "viz_protocol.h"
+
+/*
+ * Instansiert tegning av en hel flåte i ett vindu
+ *
+ * Hvert ben (6 per robot) er én instans med alt som trengs for å tegne
+ * det: robotens posisjon, base- og platform-punktet og naboene deres
+ * (for sekskantene), kneet og motor-vinkelen. Instans-dataene eies av
+ * kalleren (typisk fylt i IK-tråden og publisert via en triple buffer),
+ * lastes opp bare når de er nye, og hele flåten tegnes med to
+ * instansierte kall:
+ * én liten linje-mal (base-kant, arm, pushrod, platform-kant) og én
+ * kule for kneet. En vertex shader plukker punkter og farger per ben.
+ *
+ * Krever GLSL 1.20 og GL_ARB_instanced_arrays/GL_ARB_draw_instanced
+ * (macOS legacy context og Mesa har begge).
+ */
+
+#define VIZ_FLEET_VIEW_SPACING 400.0f /* Default avstand i grid (mm) */
+#define VIZ_FLEET_VIEW_KNEE_RADIUS 5.0f
+
+/**
+ * struct viz_fleet_leg - Instans-data for ett ben (80 bytes)
+ * @offset: robotens posisjon i scenen
+ * @base: base punkt
+ * @base_next: neste bens base punkt
+ * @knee: kne
+ * @platform: transformert platform punkt
+ * @platform_next: neste bens platform punkt
+ * @motor_load: motor-vinkel relativt til grensene, 0 = midt, 1 = grense
+ * @error: 1 hvis IK feilet for roboten
+ */
+struct viz_fleet_leg {
+	float offset[3];
+	float base[3];
+	float base_next[3];
+	float knee[3];
+	float platform[3];
+	float platform_next[3];
+	float motor_load;
+	float error;
+};
+
+/**
+ * struct viz_fleet_view - GL-objekter og instans-data for flåten
+ * @count: antall roboter som vises
+ * @position: posisjon per robot (x, z i gulvplanet)
+ * @extent: største avstand fra origo til en robot
+ * @program: shader program
+ * @u_knee_radius: uniform, > 0 når knærne tegnes
+ * @template_vbo: linje-malen for ett ben
+ * @sphere_vbo: enhetskule
+ * @sphere_ibo: indekser for enhetskulen
+ * @instance_vbo: @legs på GPU
+ */
+struct viz_fleet_view {
+	int count;
+	struct vec3 position[VIZ_FLEET_MAX_ROBOTS];
+	float extent;
+
+	unsigned int program;
+	int u_knee_radius;
+	unsigned int template_vbo;
+	unsigned int sphere_vbo;
+	unsigned int sphere_ibo;
+	unsigned int instance_vbo;
+};
+
+/**
+ * viz_fleet_view_init - Kompiler shader og lag buffere
+ * @v: view som initialiseres
+ * @count: antall roboter (1..VIZ_FLEET_MAX_ROBOTS)
+ *
+ * Robotene plasseres i et kvadratisk grid med VIZ_FLEET_VIEW_SPACING.
+ * Krever current context.
+ *
+ * Retur: 0 ved suksess, -1 ved feil (f.eks. mangler instancing)
+ */
+int viz_fleet_view_init(struct viz_fleet_view *v, int count);
+
+/**
+ * viz_fleet_view_grid - Plasser robotene i kvadratisk grid rundt origo
+ * @v: view
+ * @spacing: avstand mellom robotene (mm)
+ */
+void viz_fleet_view_grid(struct viz_fleet_view *v, float spacing);
+
+/**
+ * viz_fleet_view_load_positions - Les posisjoner fra fil
+ * @v: view
+ * @path: fil med "x z" (mm) per linje, robot 0 først; '#' er kommentar
+ *
+ * Antall roboter settes til antall linjer.
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_fleet_view_load_positions(struct viz_fleet_view *v, const char *path);
+
+/**
+ * viz_fleet_view_set - Oppdater én robot fra IK-resultatet
+ * @v: view (leses bare, så kallet kan gjøres fra en annen tråd)
+ * @legs: instans-data, 6 per robot
+ * @robot: robot-indeks (under @v->count)
+ * @prep: geometrien IK ble kjørt med
+ * @result: IK-resultat
+ */
+void viz_fleet_view_set(const struct viz_fleet_view *v,
+			struct viz_fleet_leg *legs, int robot,
+			const struct stewart_geometry_prepared *prep,
+			const struct stewart_inverse_result *result);
+
+/**
+ * viz_fleet_view_draw - Last opp nye instanser og tegn flåten
+ * @v: view
+ * @legs: nye instans-data (@v->count * 6), NULL hvis uendret siden sist
+ *
+ * Tegner med gjeldende projection og modelview.
+ */
+void viz_fleet_view_draw(struct viz_fleet_view *v,
+			 const struct viz_fleet_leg *legs);
+
+/**
+ * viz_fleet_view_destroy - Frigjør shader og buffere
+ * @v: view
+ */
+void viz_fleet_view_destroy(struct viz_fleet_view *v);
+
+#endif /* VIZ_FLEET_VIEW_H */
@@ -0,0 +1,112 @@
+#ifndef VIZ_INGEST_H
+#define VIZ_INGEST_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+/*
+ * Mottak og beregning i egen tråd
+ *
+ * Tråden venter på en fd (poll) og kaller @step når den er lesbar. @step
+ * mottar, regner (IK) og publiserer resultatet, typisk i en triple
+ * buffer som render-tråden leser. Mottaket begrenses da ikke av vsync,
+ * og en treg frame forsinker ikke pakkene.
+ *
+ * Uten fd (shared memory) kalles @step hvert VIZ_INGEST_SHM_POLL_MS.
+ */
+
+#define VIZ_INGEST_SHM_POLL_MS 1
+
+/**
+ * struct viz_wake - Vekker en tråd som venter i poll() eller epoll
+ * @pipe: [0] ventes på (POLLIN), [1] skrives av viz_wake_signal()
+ *
+ * Brukes av ingest-tråden og av mottaks-tråden i stream_set.h.
+ */
+struct viz_wake {
+	int pipe[2];
+};
+
+/**
+ * viz_wake_init - Lag non-blocking vekke-pipe
+ * @w: vekker som initialiseres
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_wake_init(struct viz_wake *w);
+
+/**
+ * viz_wake_signal - Vekk tråden
+ * @w: vekker
+ *
+ * Async-signal-safe, så den kan kalles fra en signal handler (SIGHUP).
+ */
+void viz_wake_signal(struct viz_wake *w);
+
+/**
+ * viz_wake_drain - Tøm pipen etter at tråden er vekket
+ * @w: vekker
+ */
+void viz_wake_drain(struct viz_wake *w);
+
+/**
+ * viz_wake_close - Lukk pipen
+ * @w: vekker
+ */
+void viz_wake_close(struct viz_wake *w);
+
+/**
+ * typedef viz_ingest_step - Motta, beregn og publiser
+ * @ctx: kallerens kontekst
+ *
+ * Kalles i ingest-tråden når fd er lesbar, etter viz_ingest_wake() og
+ * én gang ved start (armerer f.eks. io_uring i riktig tråd). Må ikke
+ * blokkere.
+ */
+typedef void (*viz_ingest_step)(void *ctx);
+
+/**
+ * struct viz_ingest - Ingest-tråd
+ * @fd: fd som ventes på, -1 for å polle
+ * @step: callback
+ * @ctx: argument til @step
+ * @wake: vekker tråden ved viz_ingest_wake() og stopp
+ * @thread: tråden
+ * @running: 1 mens tråden kjører
+ */
+struct viz_ingest {
+	int fd;
+	viz_ingest_step step;
+	void *ctx;
+	struct viz_wake wake;
+	pthread_t thread;
+	atomic_int running;
+};
+
+/**
+ * viz_ingest_start - Start ingest-tråd
+ * @in: ingest som initialiseres
+ * @fd: fd som blir lesbar ved nye data (viz_transport_fd()), eller -1
+ * @step: callback
+ * @ctx: argument til @step
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_ingest_start(struct viz_ingest *in, int fd, viz_ingest_step step,
+		     void *ctx);
+
+/**
+ * viz_ingest_wake - Få tråden til å kalle @step snarest
+ * @in: ingest
+ *
+ * Async-signal-safe, så den kan kalles fra en signal handler (SIGHUP).
+ */
+void viz_ingest_wake(struct viz_ingest *in);
+
+/**
+ * viz_ingest_stop - Stopp tråden og vent på den
+ * @in: ingest
+ */
+void viz_ingest_stop(struct viz_ingest *in);
+
+#endif /* VIZ_INGEST_H */
@@ -0,0 +1,110 @@
+#ifndef VIZ_POSE_ESTIMATOR_H
+#define VIZ_POSE_ESTIMATOR_H
+
+#include <stdint.h>
+#include "viz_protocol.h"
+
+/*
+ * Pose til render-tidspunktet for ujevne strømmer (dead reckoning)
+ *
+ * Uten estimat står posen stille til neste packet og hopper så, så en
+ * strøm med jitter eller lav rate hakker. Estimatoren holder de to
+ * siste samplene med tid og regner posen lineært til tidspunktet som
+ * tegnes: mellom samplene interpoleres det, etter det siste
+ * ekstrapoleres det med farten mellom dem, høyst @max_extrapolate_ns.
+ * Stopper strømmen, blir posen stående der grensen nås.
+ *
+ * Tid per sample er sende-tidsstempelet (v2+), flyttet til lokal klokke
+ * med minste observerte (mottak - sending) i de to siste offset-vinduene.
+ * Det fjerner jitter i nettet og klokke-offset mellom maskiner, og drift
+ * fanges opp når vinduet roterer. v1-packets har ikke tidsstempel og
+ * bruker mottakstiden, med jitteren den har.
+ *
+ * Med @delay_ns > 0 tegnes strømmen så mye bak, så posen oftere kan
+ * interpoleres i stedet for ekstrapoleres (mindre overshoot, mer
+ * latency).
+ *
+ * Fast kost per frame: to samples, ingen historikk. Én tråd per
+ * estimator.
+ */
+
+#define VIZ_POSE_ESTIMATOR_WINDOW_NS 2000000000ULL /* Offset-vindu */
+#define VIZ_POSE_ESTIMATOR_MAX_GAP_NS 500000000ULL /* Lengre: ingen fart */
+#define VIZ_POSE_ESTIMATOR_DEFAULT_MS 100 /* Default maks ekstrapolering */
+
+/**
+ * struct viz_pose_estimator - To siste samples og klokke-offset
+ * @max_extrapolate_ns: lengste ekstrapolering forbi siste sample
+ * @delay_ns: hvor langt bak render-tidspunktet strømmen tegnes
+ * @prev: nest siste pose
+ * @last: siste pose
+ * @prev_ns: tid for @prev (sender- eller mottaksklokke)
+ * @last_ns: tid for @last
+ * @samples: antall samples, høyst 2
+ * @timestamped: 1 hvis samplene har sende-tidsstempel
+ * @offset_min: minste (mottak - sending) i forrige og gjeldende vindu
+ * @window_start_ns: mottakstid da gjeldende vindu startet
+ * @extrapolated: frames tegnet forbi siste sample
+ * @capped: frames der ekstrapoleringen ble begrenset
+ */
+struct viz_pose_estimator {
+	uint64_t max_extrapolate_ns;
+	uint64_t delay_ns;
+	struct viz_pose_packet prev;
+	struct viz_pose_packet last;
+	uint64_t prev_ns;
+	uint64_t last_ns;
+	int samples;
+	int timestamped;
+	int64_t offset_min[2];
+	uint64_t window_start_ns;
+	uint64_t extrapolated;
+	uint64_t capped;
+};
+
+/**
+ * viz_pose_estimator_init - Start uten samples
+ * @e: estimator
+ * @max_extrapolate_ms: lengste ekstrapolering, 0 for bare interpolering
+ * @delay_ms: hvor langt bak strømmen tegnes, 0 for ren ekstrapolering
+ */
+void viz_pose_estimator_init(struct viz_pose_estimator *e,
+			     float max_extrapolate_ms, float delay_ms);
+
+/**
+ * viz_pose_estimator_push - Legg til mottatt pose
+ * @e: estimator
+ * @pose: pose
+ * @send_time_ns: sende-tidsstempel, 0 hvis pakken ikke har det (v1)
+ * @recv_time_ns: viz_time_ns() ved mottak
+ *
+ * Poser som er eldre enn siste sample (reordering) ignoreres. Går tiden
+ * mer enn VIZ_POSE_ESTIMATOR_MAX_GAP_NS bakover, eller hopper
+ * klokke-offset like mye (senderen startet på nytt med ny klokke),
+ * startes det på nytt fra denne posen.
+ */
+void viz_pose_estimator_push(struct viz_pose_estimator *e,
+			     const struct viz_pose_packet *pose,
+			     uint64_t send_time_ns, uint64_t recv_time_ns);
+
+/**
+ * viz_pose_estimator_predict - Pose ved render-tidspunktet
+ * @e: estimator
+ * @now_ns: viz_time_ns() for framen
+ * @pose: output - estimert pose (uendret uten samples)
+ *
+ * Retur: 1 hvis posen fortsatt endrer seg (tegn neste frame også),
+ *        0 hvis den står stille til neste sample
+ */
+int viz_pose_estimator_predict(struct viz_pose_estimator *e, uint64_t now_ns,
+			       struct viz_pose_packet *pose);
+
+/**
+ * viz_pose_estimator_reset - Glem samplene
+ * @e: estimator
+ *
+ * Neste sample vises som det er, uten fart.
+ */
+void viz_pose_estimator_reset(struct viz_pose_estimator *e);
+
+#endif /* VIZ_POSE_ESTIMATOR_H */
@@ -0,0 +1,171 @@
+#ifndef VIZ_RECORDING_H
+#define VIZ_RECORDING_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "viz_protocol.h"
+
+/*
+ * Opptak og avspilling av pose-strømmer
+ *
+ * Et opptak er en header med navnet på hver strøm, fulgt av én record
+ * per mottatt pose (også de latest-wins forkaster) med mottakstid og
+ * sende-tidsstempel. Avspilling gir samme poser i samme rekkefølge, i
+ * opptakets tempo, skalert, eller så fort som mulig, så en arbeidslast
+ * kan kjøres om igjen likt (profilering) og en hendelse kan ses på nytt.
+ *
+ * Binært i vertens byte-rekkefølge, packed som viz_protocol.h: 44 bytes
+ * per pose. Filen skrives bufret fra mottaks-tråden; avbrytes programmet
+ * mangler bare de siste recordene.
+ */
+
+#define VIZ_RECORDING_MAGIC 0x53545752 /* "STWR" */
+#define VIZ_RECORDING_VERSION 1
+#define VIZ_RECORDING_MAX_STREAMS 64
+#define VIZ_RECORDING_NAME_MAX 64 /* Med avsluttende '\0' */
+
+/**
+ * struct viz_recording_header - Start av opptaksfil
+ * @magic: VIZ_RECORDING_MAGIC
+ * @version: VIZ_RECORDING_VERSION
+ * @streams: antall strømmer, fulgt av @streams navn à
+ *	     VIZ_RECORDING_NAME_MAX bytes
+ * @start_time_ns: viz_time_ns() da opptaket startet
+ */
+struct viz_recording_header {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t streams;
+	uint64_t start_time_ns;
+} __attribute__((packed));
+
+/**
+ * struct viz_recording_record - Én mottatt pose
+ * @recv_offset_ns: mottakstid relativt til @start_time_ns i headeren
+ * @send_time_ns: sende-tidsstempel (senderens klokke), 0 for v1
+ * @stream: strøm-indeks
+ * @robot_type: robot configuration type
+ * @rx: roll rotation (degrees)
+ * @ry: pitch rotation (degrees)
+ * @rz: yaw rotation (degrees)
+ * @tx: X translation (mm)
+ * @ty: Y translation (mm)
+ * @tz: Z translation (mm)
+ */
+struct viz_recording_record {
+	uint64_t recv_offset_ns;
+	uint64_t send_time_ns;
+	uint16_t stream;
+	uint16_t robot_type;
+	float rx, ry, rz;
+	float tx, ty, tz;
+} __attribute__((packed));
+
+/**
+ * struct viz_recorder - Åpent opptak
+ * @file: opptaksfil
+ * @start_time_ns: @start_time_ns i headeren
+ * @records: poser skrevet
+ * @failed: 1 etter skrivefeil (resten forkastes)
+ */
+struct viz_recorder {
+	FILE *file;
+	uint64_t start_time_ns;
+	uint64_t records;
+	int failed;
+};
+
+/**
+ * struct viz_replay - Opptak som spilles av
+ * @file: opptaksfil
+ * @streams: antall strømmer i opptaket
+ * @names: navn per strøm (endpoint ved opptak)
+ * @speed: tempo, 1 = som opptaket, 0 = så fort som mulig
+ * @start_time_ns: @start_time_ns i headeren
+ * @first_recv_ns: mottakstid for første record (opptakets klokke)
+ * @replay_start_ns: viz_time_ns() da første record ble lest
+ * @records: records lest
+ */
+struct viz_replay {
+	FILE *file;
+	int streams;
+	char names[VIZ_RECORDING_MAX_STREAMS][VIZ_RECORDING_NAME_MAX];
+	float speed;
+	uint64_t start_time_ns;
+	uint64_t first_recv_ns;
+	uint64_t replay_start_ns;
+	uint64_t records;
+};
+
+/**
+ * viz_recorder_open - Start opptak
+ * @rec: opptak som initialiseres
+ * @path: filsti (overskrives)
+ * @names: navn per strøm
+ * @streams: antall strømmer (1..VIZ_RECORDING_MAX_STREAMS)
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_recorder_open(struct viz_recorder *rec, const char *path,
+		      const char *const *names, int streams);
+
+/**
+ * viz_recorder_write - Skriv én mottatt pose
+ * @rec: opptak
+ * @stream: strøm-indeks
+ * @pose: pose
+ * @info: metadata fra dekodingen
+ * @recv_time_ns: viz_time_ns() ved mottak
+ *
+ * Bare én tråd skriver til et opptak.
+ */
+void viz_recorder_write(struct viz_recorder *rec, int stream,
+			const struct viz_pose_packet *pose,
+			const struct viz_packet_info *info,
+			uint64_t recv_time_ns);
+
+/**
+ * viz_recorder_close - Skriv ut bufferen og lukk filen
+ * @rec: opptak
+ *
+ * Retur: 0 ved suksess, -1 hvis noe ikke ble skrevet
+ */
+int viz_recorder_close(struct viz_recorder *rec);
+
+/**
+ * viz_replay_open - Åpne opptak for avspilling
+ * @r: avspilling som initialiseres
+ * @path: filsti
+ * @speed: tempo, 1 = som opptaket, 10 = ti ganger så fort, 0 = så fort
+ *	   som mulig
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_replay_open(struct viz_replay *r, const char *path, float speed);
+
+/**
+ * viz_replay_next - Les neste pose
+ * @r: avspilling
+ * @stream: output - strøm-indeks (< @r->streams)
+ * @pose: output - pose i v1-layout
+ * @send_time_ns: output - sende-tidsstempel, 0 for v1 og med speed 0
+ * @recv_time_ns: output - når posen skal regnes som mottatt
+ *		  (viz_time_ns()-klokken), vent til da før den brukes
+ *
+ * Tidene flyttes til avspillingens klokke og skaleres med @r->speed,
+ * så avstanden mellom dem (og til sende-tidsstempelet) er som i
+ * opptaket delt på tempoet. Med speed 0 er mottakstiden nå.
+ *
+ * Retur: 1 ved pose, 0 ved slutten av opptaket, -1 ved feil
+ */
+int viz_replay_next(struct viz_replay *r, int *stream,
+		    struct viz_pose_packet *pose, uint64_t *send_time_ns,
+		    uint64_t *recv_time_ns);
+
+/**
+ * viz_replay_close - Lukk opptaket
+ * @r: avspilling
+ */
+void viz_replay_close(struct viz_replay *r);
+
+#endif /* VIZ_RECORDING_H */
@@ -0,0 +1,213 @@
+#ifndef VIZ_RENDER_H
+#define VIZ_RENDER_H
+
+#include <stdint.h>
+#include "robotics/math/vec3.h"
+
+/*
+ * Retained-mode renderer for visualizerne
+ *
+ * Erstatter glBegin/glEnd og gluSphere per kule. Kallene under tegner
+ * ingenting selv; de legger primitiver i batcher, og viz_render_flush()
+ * laster opp hver batch én gang og tegner den med ett kall:
+ *
+ *  - linjer: én dynamisk vertex buffer, ett glDrawArrays per linjebredde
+ *    (bredden er GL-state og kan ikke variere innenfor et kall)
+ *  - kuler og sylindre: tessellert én gang ved init. Topologien for
+ *    VIZ_RENDER_MAX_* instanser ligger i en statisk index buffer; per
+ *    frame skrives bare posisjonene, og alle instanser tegnes med ett
+ *    glDrawElements per mesh
+ *
+ * Fixed-function GL 1.5 (VBO + client arrays), så ingen shadere og samme
+ * kode på macOS (legacy context) og Mesa/llvmpipe. Krever current context
+ * ved init, flush og destroy.
+ */
+
+#define VIZ_RENDER_LINE_WIDTHS 4 /* Ulike linjebredder per frame */
+#define VIZ_RENDER_LINE_VERTICES 4096 /* Per linjebredde */
+#define VIZ_RENDER_MAX_SPHERES 256
+#define VIZ_RENDER_MAX_CYLINDERS 256
+#define VIZ_RENDER_SPHERE_SLICES 12
+#define VIZ_RENDER_SPHERE_STACKS 12
+#define VIZ_RENDER_CYLINDER_SLICES 12
+
+#define VIZ_RENDER_SPHERE_VERTICES \
+	((VIZ_RENDER_SPHERE_STACKS + 1) * (VIZ_RENDER_SPHERE_SLICES + 1))
+#define VIZ_RENDER_SPHERE_INDICES \
+	(VIZ_RENDER_SPHERE_STACKS * VIZ_RENDER_SPHERE_SLICES * 6)
+
+/**
+ * struct viz_vertex - Vertex i alle batcher (16 bytes)
+ * @x, @y, @z: posisjon
+ * @rgba: farge
+ */
+struct viz_vertex {
+	float x, y, z;
+	uint8_t rgba[4];
+};
+
+/**
+ * struct viz_line_batch - Linjesegmenter med samme bredde
+ * @width: linjebredde (piksler)
+ * @count: antall vertices (to per segment)
+ * @vertices: segmentene
+ */
+struct viz_line_batch {
+	float width;
+	int count;
+	struct viz_vertex vertices[VIZ_RENDER_LINE_VERTICES];
+};
+
+/**
+ * struct viz_mesh - Forhånds-tessellert mesh og instansene denne framen
+ * @unit: enhets-mesh (kule: radius 1; sylinder: radius 1, y fra 0 til 1)
+ * @vertex_count: vertices per instans
+ * @index_count: indekser per instans
+ * @max_instances: kapasitet
+ * @instances: instanser lagt til denne framen
+ * @vertices: transformerte vertices, @vertex_count per instans
+ * @vbo: dynamisk vertex buffer
+ * @ibo: statisk index buffer for @max_instances instanser
+ */
+struct viz_mesh {
+	struct vec3 *unit;
+	int vertex_count;
+	int index_count;
+	int max_instances;
+	int instances;
+	struct viz_vertex *vertices;
+	unsigned int vbo;
+	unsigned int ibo;
+};
+
+/**
+ * struct viz_render_stats - Renderer-statistikk
+ * @draw_calls: antall glDraw*-kall i siste viz_render_flush()
+ * @vertices: antall vertices lastet opp i siste viz_render_flush()
+ * @dropped: primitiver forkastet totalt fordi en batch var full
+ */
+struct viz_render_stats {
+	unsigned int draw_calls;
+	unsigned int vertices;
+	unsigned int dropped;
+};
+
+/**
+ * struct viz_renderer - Batcher og GL-objekter
+ * @color: gjeldende farge (som glColor)
+ * @line: gjeldende linje-batch
+ * @line_batches: antall batcher i bruk denne framen
+ * @lines: linje-batcher, én per bredde
+ * @line_vbo: dynamisk vertex buffer for alle linjer
+ * @sphere: kuler
+ * @cylinder: sylindre
+ * @stats: statistikk for forrige frame
+ */
+struct viz_renderer {
+	uint8_t color[4];
+	struct viz_line_batch *line;
+	int line_batches;
+	struct viz_line_batch lines[VIZ_RENDER_LINE_WIDTHS];
+	unsigned int line_vbo;
+	struct viz_mesh sphere;
+	struct viz_mesh cylinder;
+	struct viz_render_stats stats;
+};
+
+/**
+ * viz_render_init - Tessellér meshene og lag GL-buffere
+ * @r: renderer som initialiseres
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_render_init(struct viz_renderer *r);
+
+/**
+ * viz_render_color - Sett farge for primitiver som legges til etterpå
+ * @r: renderer
+ * @red, @green, @blue: farge (0-1)
+ */
+void viz_render_color(struct viz_renderer *r, float red, float green,
+		      float blue);
+
+/**
+ * viz_render_line_width - Velg linjebredde for viz_render_line*()
+ * @r: renderer
+ * @width: bredde i piksler
+ *
+ * Er alle VIZ_RENDER_LINE_WIDTHS batcher i bruk med andre bredder,
+ * tegnes linjene med bredden til den siste.
+ */
+void viz_render_line_width(struct viz_renderer *r, float width);
+
+/**
+ * viz_render_line - Legg til linjesegment
+ * @r: renderer
+ * @a: startpunkt
+ * @b: sluttpunkt
+ */
+void viz_render_line(struct viz_renderer *r, const struct vec3 *a,
+		     const struct vec3 *b);
+
+/**
+ * viz_render_line_loop - Legg til lukket polygon (som GL_LINE_LOOP)
+ * @r: renderer
+ * @points: hjørner
+ * @count: antall hjørner
+ */
+void viz_render_line_loop(struct viz_renderer *r, const struct vec3 *points,
+			  int count);
+
+/**
+ * viz_render_axes - Legg til koordinatsystemet i origo
+ * @r: renderer
+ * @length: lengde på hver akse
+ * @width: linjebredde
+ *
+ * X rød, Y grønn, Z blå.
+ */
+void viz_render_axes(struct viz_renderer *r, float length, float width);
+
+/**
+ * viz_render_sphere - Legg til kule
+ * @r: renderer
+ * @center: senterpunkt
+ * @radius: radius
+ */
+void viz_render_sphere(struct viz_renderer *r, const struct vec3 *center,
+		       float radius);
+
+/**
+ * viz_render_cylinder - Legg til sylinder mellom to punkter
+ * @r: renderer
+ * @a: senter i den ene enden
+ * @b: senter i den andre enden
+ * @radius: radius
+ */
+void viz_render_cylinder(struct viz_renderer *r, const struct vec3 *a,
+			 const struct vec3 *b, float radius);
+
+/**
+ * viz_render_flush - Last opp og tegn alt som er lagt til, og tøm batchene
+ * @r: renderer
+ *
+ * Tegner med gjeldende projection og modelview.
+ */
+void viz_render_flush(struct viz_renderer *r);
+
+/**
+ * viz_render_sphere_mesh - Tessellér enhetskule
+ * @unit: output - VIZ_RENDER_SPHERE_VERTICES posisjoner (radius 1)
+ * @index: output - VIZ_RENDER_SPHERE_INDICES indekser (GL_TRIANGLES)
+ *
+ * Samme kule som viz_render_sphere(), for kode som laster den opp selv.
+ */
+void viz_render_sphere_mesh(struct vec3 *unit, uint16_t *index);
+
+/**
+ * viz_render_destroy - Frigjør GL-buffere og minne
+ * @r: renderer
+ */
+void viz_render_destroy(struct viz_renderer *r);
+
+#endif /* VIZ_RENDER_H */
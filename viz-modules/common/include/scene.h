@@ -0,0 +1,204 @@
+#ifndef VIZ_SCENE_H
+#define VIZ_SCENE_H
+
+#include <signal.h>
+#include "robotics/math/vec3.h"
+#include "stewart/geometry_slot.h"
+#include "stewart/kinematics.h"
+#include "bench.h"
+#include "camera.h"
+#include "ingest.h"
+#include "render.h"
+#include "trail.h"
+
+/*
+ * Felles for visualizerne som regner IK for Stewart-platformen
+ * (kinematics, compare og multi)
+ *
+ *  - delt MX64/AX18-geometri fra -m/-a, lastes på nytt ved SIGHUP
+ *  - spor av platform-senter og de seks knærne for hver pose
+ *  - tegning av ben, knær og ben-paret nærmest kollisjon
+ *  - start og slutt på hver frame (kamera, akser, flush og spor)
+ *
+ * Visualizerne har selv bare mottaket, fargene og sine egne taster.
+ */
+
+#define VIZ_SCENE_TRAIL_TRACKS 7 /* Spor per pose: senter og seks knær */
+#define VIZ_SCENE_TRAIL_MAX_POSES \
+	(VIZ_TRAIL_MAX_TRACKS / VIZ_SCENE_TRAIL_TRACKS)
+#define VIZ_SCENE_KNEE_RADIUS 5.0f
+#define VIZ_SCENE_AXIS_LENGTH 100.0f /* mm */
+
+/**
+ * struct viz_geometry_set - Delt geometri for MX64 og AX18
+ * @mx64: MX64-geometri
+ * @ax18: AX18-geometri
+ * @file_mx64: geometri-fil (-m), eller NULL for innebygd
+ * @file_ax18: geometri-fil (-a), eller NULL for innebygd
+ * @reload_requested: satt av SIGHUP, se viz_geometry_reload_pending()
+ */
+struct viz_geometry_set {
+	struct stewart_geometry_slot mx64;
+	struct stewart_geometry_slot ax18;
+	const char *file_mx64;
+	const char *file_ax18;
+	volatile sig_atomic_t reload_requested;
+};
+
+/**
+ * viz_geometry_init - Innebygd geometri, deretter filene
+ * @g: sett som initialiseres
+ * @file_mx64: -m, eller NULL
+ * @file_ax18: -a, eller NULL
+ *
+ * Retur: 0 ved suksess, -1 hvis en fil ikke kunne lastes
+ */
+int viz_geometry_init(struct viz_geometry_set *g, const char *file_mx64,
+		      const char *file_ax18);
+
+/**
+ * viz_geometry_reload - Last geometri-filene på nytt
+ * @g: sett
+ *
+ * Publiserer ny geometri i slot-ene; IK og rendering plukker den opp ved
+ * neste acquire. Ved feil beholdes forrige geometri.
+ *
+ * Retur: 0 ved suksess, -1 hvis en fil ikke kunne lastes
+ */
+int viz_geometry_reload(struct viz_geometry_set *g);
+
+/**
+ * viz_geometry_select - Slot for en robot type
+ * @g: sett
+ * @robot_type: ROBOT_TYPE_* fra pakken
+ *
+ * Retur: AX18-slot for ROBOT_TYPE_AX18, ellers MX64
+ */
+struct stewart_geometry_slot *viz_geometry_select(struct viz_geometry_set *g,
+						  int robot_type);
+
+/**
+ * viz_geometry_watch - Last geometrien på nytt ved SIGHUP
+ * @g: sett (ett per prosess)
+ * @wake: vekker tråden som kaller viz_geometry_reload_pending()
+ */
+void viz_geometry_watch(struct viz_geometry_set *g, struct viz_wake *wake);
+
+/**
+ * viz_geometry_unwatch - Tilbake til default SIGHUP
+ *
+ * Kalles før tråden som ble vekket stoppes.
+ */
+void viz_geometry_unwatch(void);
+
+/**
+ * viz_geometry_reload_pending - Sjekk og nullstill SIGHUP-forespørsel
+ * @g: sett
+ *
+ * Retur: 1 hvis geometrien skal lastes på nytt, ellers 0
+ */
+int viz_geometry_reload_pending(struct viz_geometry_set *g);
+
+/**
+ * viz_geometry_destroy - Frigjør begge slot-ene
+ * @g: sett
+ */
+void viz_geometry_destroy(struct viz_geometry_set *g);
+
+/**
+ * viz_scene_trail_color - Samme farge på alle sporene til én pose
+ * @t: spor
+ * @pose: pose-indeks, sporene VIZ_SCENE_TRAIL_TRACKS * @pose og utover
+ * @color: farge (0-1)
+ */
+void viz_scene_trail_color(struct viz_trail *t, int pose,
+			   const float color[3]);
+
+/**
+ * viz_scene_trail_update - Legg nye poser til sporet og fjern gamle samples
+ * @t: spor med VIZ_SCENE_TRAIL_TRACKS spor per pose
+ * @poses: IK-resultat per pose, i samme rekkefølge som sporene
+ * @count: antall poser, høyst VIZ_SCENE_TRAIL_MAX_POSES
+ * @fresh: 1 hvis posene er nye siden forrige frame
+ *
+ * Retur: 1 hvis sporet har samples som skal forsvinne senere
+ */
+int viz_scene_trail_update(struct viz_trail *t,
+			   const struct stewart_inverse_result *const *poses,
+			   int count, int fresh);
+
+/**
+ * struct viz_leg_colors - Farger for benene til én pose
+ * @arm: motor arms (base → kne)
+ * @pushrod: pushrods (kne → platform)
+ * @knee: knær (kuler)
+ */
+struct viz_leg_colors {
+	float arm[3];
+	float pushrod[3];
+	float knee[3];
+};
+
+/**
+ * viz_leg_colors_from - Ben-farger avledet fra posens farge
+ * @c: output
+ * @color: posens farge (0-1)
+ *
+ * Arms mot gult, pushrods mot rødt, knærne i posens farge.
+ */
+void viz_leg_colors_from(struct viz_leg_colors *c, const float color[3]);
+
+/**
+ * viz_scene_draw_legs - Legg motor arms, pushrods og knær i batchen
+ * @r: renderer
+ * @base_points: base punkter fra geometrien IK ble kjørt med
+ * @ik: IK-resultat
+ * @c: farger
+ */
+void viz_scene_draw_legs(struct viz_renderer *r,
+			 const struct vec3 *base_points,
+			 const struct stewart_inverse_result *ik,
+			 const struct viz_leg_colors *c);
+
+/**
+ * viz_scene_draw_collision_pair - Ben-paret nærmest kollisjon i rødt
+ * @r: renderer
+ * @base_points: base punkter fra geometrien IK ble kjørt med
+ * @ik: IK-resultat
+ * @pair: benene (stewart_collision_pair_legs())
+ */
+void viz_scene_draw_collision_pair(struct viz_renderer *r,
+				   const struct vec3 *base_points,
+				   const struct stewart_inverse_result *ik,
+				   const int pair[2]);
+
+/**
+ * viz_scene_init - GL-state for scenen og renderer
+ * @r: renderer som initialiseres
+ *
+ * Krever current context (etter viz_window_open()).
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_scene_init(struct viz_renderer *r);
+
+/**
+ * viz_scene_begin - Start en frame
+ * @c: kamera
+ * @w: vindu
+ *
+ * Tømmer bildet og setter projection og modelview fra kameraet.
+ */
+void viz_scene_begin(const struct viz_camera *c, const struct viz_window *w);
+
+/**
+ * viz_scene_end - Avslutt en frame
+ * @r: renderer med alt som er lagt til
+ * @trail: spor som tegnes over, eller NULL
+ *
+ * Legger til koordinatsystemet i origo og tegner batchene: kulene i ett
+ * kall, linjene i ett kall per bredde, og hele sporet i ett kall.
+ */
+void viz_scene_end(struct viz_renderer *r, struct viz_trail *trail);
+
+#endif /* VIZ_SCENE_H */
@@ -0,0 +1,163 @@
+#ifndef VIZ_SHM_H
+#define VIZ_SHM_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "udp.h"
+
+/*
+ * Shared memory transport for produsent og konsument på samme maskin
+ *
+ * Ett segment i /dev/shm per strøm, med samme meldings-semantikk som UDP
+ * (datagrammer opptil UDP_DATAGRAM_MAX) og samme mottaks-API:
+ *
+ *  - en single-producer/single-consumer ring for shm_receive_batch(),
+ *    der alle meldinger trengs (f.eks. flåte fordelt på flere packets)
+ *  - en seqlock "latest" slot for shm_receive_latest(), O(1) uansett
+ *    hvor mye som ligger i ringen
+ *
+ * Ingen låser og ingen syscalls per melding. Er ringen full, forkastes
+ * nye meldinger (telles i @dropped); latest-slot skrives alltid. En
+ * konsument bør bruke bare én av mottaksfunksjonene.
+ *
+ * Mottaker lager segmentet (som bind for UDP). Sender åpner det ved
+ * første send og på nytt hvis mottaker er startet på nytt, så
+ * rekkefølgen prosessene startes i er likegyldig.
+ */
+
+#define SHM_MAGIC 0x53484d56 /* "SHMV" */
+#define SHM_VERSION 1
+#define SHM_RING_SLOTS 64 /* Potens av 2 */
+#define SHM_NAME_MAX 32
+
+/**
+ * struct shm_message - Én melding i segmentet
+ * @length: antall bytes i @data
+ * @data: payload
+ */
+struct shm_message {
+	uint32_t length;
+	unsigned char data[UDP_DATAGRAM_MAX];
+};
+
+/**
+ * struct shm_segment - Layout i /dev/shm
+ * @magic: SHM_MAGIC
+ * @version: SHM_VERSION
+ * @message_size: sizeof(struct shm_message)
+ * @ring_slots: SHM_RING_SLOTS
+ * @receiver_alive: 0 når mottaker har lukket segmentet
+ * @latest_seq: seqlock for @latest, odde under skriving; /2 = antall
+ * @latest: siste melding
+ * @head: neste ring-indeks produsenten skriver (kun produsent skriver)
+ * @dropped: meldinger forkastet fordi ringen var full
+ * @tail: neste ring-indeks konsumenten leser (kun konsument skriver)
+ * @ring: meldinger, indeks modulo SHM_RING_SLOTS
+ *
+ * Produsent- og konsument-felt ligger på egne cache-linjer.
+ */
+struct shm_segment {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t message_size;
+	uint32_t ring_slots;
+	atomic_int receiver_alive;
+
+	_Alignas(64) atomic_uint latest_seq;
+	struct shm_message latest;
+
+	_Alignas(64) atomic_ullong head;
+	atomic_ullong dropped;
+
+	_Alignas(64) atomic_ullong tail;
+
+	_Alignas(64) struct shm_message ring[SHM_RING_SLOTS];
+};
+
+/**
+ * struct shm_channel - Åpent segment (sender eller mottaker)
+ * @seg: mapping, NULL hvis sender ikke har funnet mottaker ennå
+ * @name: shm_open-navn ("/viz-<navn>")
+ * @is_receiver: 1 hvis denne prosessen eier segmentet
+ * @latest_seen: @latest_seq ved forrige shm_receive_latest()
+ */
+struct shm_channel {
+	struct shm_segment *seg;
+	char name[SHM_NAME_MAX];
+	int is_receiver;
+	unsigned int latest_seen;
+};
+
+/**
+ * shm_create_receiver - Lag segment og vent på meldinger
+ * @ch: kanal som initialiseres
+ * @name: strøm-navn (segment /dev/shm/viz-<name>)
+ *
+ * Et gammelt segment med samme navn erstattes. Det merkes først som dødt
+ * (@receiver_alive = 0), så sendere som fortsatt har det mappet kobler
+ * seg til det nye også når forrige mottaker ble drept.
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int shm_create_receiver(struct shm_channel *ch, const char *name);
+
+/**
+ * shm_open_sender - Forbered sending til strøm
+ * @ch: kanal som initialiseres
+ * @name: strøm-navn
+ *
+ * Segmentet åpnes ved første shm_send(); det er ikke en feil at
+ * mottakeren ikke finnes ennå.
+ *
+ * Retur: 0 ved suksess, -1 ved ugyldig navn
+ */
+int shm_open_sender(struct shm_channel *ch, const char *name);
+
+/**
+ * shm_send - Send én melding
+ * @ch: sender-kanal
+ * @data: payload
+ * @length: antall bytes (maks UDP_DATAGRAM_MAX)
+ *
+ * Uten mottaker forkastes meldingen, som med UDP.
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int shm_send(struct shm_channel *ch, const void *data, size_t length);
+
+/**
+ * shm_receive_batch - Hent meldinger fra ringen (opptil UDP_BATCH_MAX)
+ * @ch: mottaker-kanal
+ * @batch: output - meldinger
+ *
+ * Retur: antall meldinger, 0 hvis ingen
+ */
+int shm_receive_batch(struct shm_channel *ch, struct udp_batch *batch);
+
+/**
+ * shm_receive_latest - Hent nyeste melding
+ * @ch: mottaker-kanal
+ * @buffer: output - nyeste melding
+ * @buffer_size: størrelse på buffer
+ * @accept: validering, NULL godtar alt som passer i @buffer
+ * @coalesced: output - antall eldre meldinger som ble hoppet over
+ *             (kan være NULL)
+ *
+ * Leser seqlock-slotten og tømmer ringen uten å kopiere den.
+ *
+ * Retur: antall bytes i @buffer, 0 hvis ingen ny gyldig melding
+ */
+int shm_receive_latest(struct shm_channel *ch, void *buffer,
+		       size_t buffer_size, udp_accept_fn accept,
+		       int *coalesced);
+
+/**
+ * shm_close - Lukk kanal
+ * @ch: kanal
+ *
+ * Mottaker markerer segmentet som lukket og fjerner det fra /dev/shm.
+ */
+void shm_close(struct shm_channel *ch);
+
+#endif /* VIZ_SHM_H */
@@ -0,0 +1,211 @@
+#ifndef VIZ_STREAM_SET_H
+#define VIZ_STREAM_SET_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include "ingest.h"
+#include "transport.h"
+#include "viz_protocol.h"
+
+/*
+ * Mottak fra mange pose-strømmer
+ *
+ * Alle strømmer registreres i én epoll-instans (poll() utenfor Linux),
+ * og bare de som er lesbare leses, så antall strømmer koster ingenting
+ * så lenge de er stille. Hver strøm har en latest-value slot (seqlock)
+ * som kan leses fra en annen tråd enn den som mottar.
+ *
+ * Brukes enten ved å kalle viz_stream_set_poll() selv (f.eks. med
+ * timeout 0 én gang per frame), eller med egen mottaks-tråd via
+ * viz_stream_set_start(). Med viz_stream_set_on_update() kan kalleren
+ * gjøre arbeid per pose (IK) i mottaks-tråden.
+ *
+ * Shared memory-strømmer har ingen fd; de sjekkes hver runde, og
+ * ventetiden begrenses til VIZ_STREAM_SET_SHM_POLL_MS.
+ *
+ * Strømmer fra viz_stream_set_add_replay() har ingen transport; kalleren
+ * fyller slotten med viz_stream_set_inject() (avspilling av opptak).
+ */
+
+#define VIZ_STREAM_SET_MAX 64
+#define VIZ_STREAM_SET_SHM_POLL_MS 1
+
+/**
+ * struct viz_stream_slot - Siste pose for en strøm
+ * @seq: seqlock, odde under skriving; seq / 2 er versjonen
+ * @pose: siste pose
+ * @send_time_ns: sende-tidsstempel for @pose, 0 for v1
+ * @recv_time_ns: viz_time_ns() ved mottak av @pose
+ */
+struct viz_stream_slot {
+	atomic_uint seq;
+	struct viz_pose_packet pose;
+	uint64_t send_time_ns;
+	uint64_t recv_time_ns;
+};
+
+/**
+ * struct viz_stream - Én strøm i settet
+ * @transport: mottaker-transport
+ * @stats: statistikk, oppdateres av mottaks-tråden
+ * @slot: latest-value slot
+ * @replay: 1 hvis strømmen ikke har transport (viz_stream_set_inject())
+ */
+struct viz_stream {
+	struct viz_transport transport;
+	struct viz_stream_stats stats;
+	struct viz_stream_slot slot;
+	int replay;
+};
+
+/**
+ * struct viz_stream_set - Sett av strømmer med felles readiness-venting
+ * @streams: strømmene, indeks returneres av viz_stream_set_add()
+ * @count: antall strømmer
+ * @poll_fd: epoll-instans (-1 utenfor Linux)
+ * @wake: vekker mottaks-tråden ved viz_stream_set_wake() og stopp
+ * @unpollable: antall strømmer uten fd (shared memory)
+ * @thread: mottaks-tråd
+ * @running: 1 mens mottaks-tråden kjører
+ * @update: kalles i mottaks-tråden etter hver runde, eller NULL
+ * @update_ctx: argument til @update
+ *
+ * Stor; legg den statisk eller på heap.
+ */
+struct viz_stream_set {
+	struct viz_stream streams[VIZ_STREAM_SET_MAX];
+	int count;
+	int poll_fd;
+	struct viz_wake wake;
+	int unpollable;
+	pthread_t thread;
+	atomic_int running;
+	void (*update)(void *ctx);
+	void *update_ctx;
+};
+
+/**
+ * viz_stream_set_init - Initialiser tomt sett
+ * @set: sett
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_stream_set_init(struct viz_stream_set *set);
+
+/**
+ * viz_stream_set_add - Åpne og registrer en strøm
+ * @set: sett (mottaks-tråden må ikke kjøre)
+ * @endpoint: endpoint-streng (se transport.h)
+ *
+ * Retur: strøm-indeks, eller -1 ved feil
+ */
+int viz_stream_set_add(struct viz_stream_set *set, const char *endpoint);
+
+/**
+ * viz_stream_set_add_replay - Registrer en strøm uten transport
+ * @set: sett (mottaks-tråden må ikke kjøre)
+ *
+ * Slotten fylles med viz_stream_set_inject(); mottaks-tråden og
+ * viz_stream_set_poll() ser bort fra strømmen.
+ *
+ * Retur: strøm-indeks, eller -1 ved feil
+ */
+int viz_stream_set_add_replay(struct viz_stream_set *set);
+
+/**
+ * viz_stream_set_inject - Publiser en pose i slotten til en strøm
+ * @set: sett
+ * @index: strøm fra viz_stream_set_add_replay()
+ * @pose: pose
+ * @send_time_ns: sende-tidsstempel, 0 hvis ukjent
+ * @recv_time_ns: mottakstid (viz_time_ns()-klokken)
+ *
+ * Som et mottak: leses med viz_stream_set_latest() fra en annen tråd.
+ * Bare én tråd injiserer i en strøm.
+ */
+void viz_stream_set_inject(struct viz_stream_set *set, int index,
+			   const struct viz_pose_packet *pose,
+			   uint64_t send_time_ns, uint64_t recv_time_ns);
+
+/**
+ * viz_stream_set_poll - Vent på og les strømmer som har data
+ * @set: sett
+ * @timeout_ms: maks ventetid, 0 for å ikke vente, -1 for å vente til data
+ *
+ * Retur: antall strømmer med ny pose, -1 ved feil
+ */
+int viz_stream_set_poll(struct viz_stream_set *set, int timeout_ms);
+
+/**
+ * viz_stream_set_start - Start egen mottaks-tråd
+ * @set: sett
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_stream_set_start(struct viz_stream_set *set);
+
+/**
+ * viz_stream_set_on_update - Registrer callback for mottaks-tråden
+ * @set: sett (mottaks-tråden må ikke kjøre)
+ * @update: kalles etter hver runde med nye poser og etter
+ *	    viz_stream_set_wake(); leser slottene med viz_stream_set_latest()
+ * @ctx: argument til @update
+ */
+void viz_stream_set_on_update(struct viz_stream_set *set,
+			      void (*update)(void *ctx), void *ctx);
+
+/**
+ * viz_stream_set_wake - Vekk mottaks-tråden så @update kalles
+ * @set: sett
+ *
+ * Async-signal-safe, så den kan kalles fra en signal handler (SIGHUP).
+ */
+void viz_stream_set_wake(struct viz_stream_set *set);
+
+/**
+ * viz_stream_set_stop - Stopp mottaks-tråden og vent på den
+ * @set: sett
+ */
+void viz_stream_set_stop(struct viz_stream_set *set);
+
+/**
+ * viz_stream_set_latest - Les siste pose for en strøm
+ * @set: sett
+ * @index: strøm-indeks
+ * @pose: output - siste pose
+ * @version: inn: sist sette versjon, ut: versjonen som ble lest
+ *
+ * Trådsikker mot mottaks-tråden (seqlock, ingen lås).
+ *
+ * Retur: 1 hvis posen er nyere enn *@version, ellers 0
+ */
+int viz_stream_set_latest(struct viz_stream_set *set, int index,
+			  struct viz_pose_packet *pose, unsigned int *version);
+
+/**
+ * viz_stream_set_latest_timed - Les siste pose med tidsstempler
+ * @set: sett
+ * @index: strøm-indeks
+ * @pose: output - siste pose
+ * @send_time_ns: output - sende-tidsstempel, 0 for v1 (kan være NULL)
+ * @recv_time_ns: output - viz_time_ns() ved mottak (kan være NULL)
+ * @version: inn: sist sette versjon, ut: versjonen som ble lest
+ *
+ * Som viz_stream_set_latest(), for kallere som estimerer posen mellom
+ * packets (pose_estimator.h).
+ *
+ * Retur: 1 hvis posen er nyere enn *@version, ellers 0
+ */
+int viz_stream_set_latest_timed(struct viz_stream_set *set, int index,
+				struct viz_pose_packet *pose,
+				uint64_t *send_time_ns, uint64_t *recv_time_ns,
+				unsigned int *version);
+
+/**
+ * viz_stream_set_destroy - Stopp tråd og lukk alle strømmer
+ * @set: sett
+ */
+void viz_stream_set_destroy(struct viz_stream_set *set);
+
+#endif /* VIZ_STREAM_SET_H */
@@ -0,0 +1,132 @@
+#ifndef VIZ_TRAIL_H
+#define VIZ_TRAIL_H
+
+#include <stdint.h>
+#include "render.h"
+#include "robotics/math/vec3.h"
+
+/*
+ * Pose-historikk som spor på GPU
+ *
+ * Hvert sample er ett punkt per spor (f.eks. platform-senter og de seks
+ * knærne) og lagres som ett linjesegment per spor fra forrige sample.
+ * Segmentene ligger i en ring buffer med fast størrelse, både i minnet
+ * og i en vertex buffer på GPU. Nye samples lastes opp med
+ * glBufferSubData når de tegnes (høyst to kall ved wrap), så kostnaden
+ * per frame avhenger av hvor mye som er nytt, ikke av historikkens
+ * lengde. Hele historikken tegnes med ett glMultiDrawArrays, uansett
+ * om den ligger i ett eller to stykker i ringen.
+ *
+ * Samples eldre enn @window_ns faller ut av tegningen; er ringen full
+ * før det, overskrives de eldste.
+ *
+ * Fixed-function GL 1.5 som render.h. Krever current context ved init,
+ * draw og destroy.
+ */
+
+#define VIZ_TRAIL_MAX_TRACKS 64
+#define VIZ_TRAIL_SAMPLES 8192 /* Default kapasitet, ~2 min ved 60 Hz */
+#define VIZ_TRAIL_DEFAULT_S 5.0f /* Default lengde i sekunder */
+
+/**
+ * struct viz_trail - Ring buffer med spor
+ * @tracks: punkter per sample
+ * @capacity: antall samples i ringen
+ * @head: neste sample som skrives
+ * @count: samples i ringen som fortsatt vises
+ * @pending: samples skrevet siden forrige upload (slutter på @head)
+ * @window_ns: hvor lenge et sample vises
+ * @times: viz_time_ns() per sample
+ * @vertices: 2 * @tracks vertices per sample, speiler @vbo
+ * @last: forrige punkt per spor
+ * @has_last: 0 til første sample etter init, clear eller tom ring
+ * @colors: farge per spor
+ * @vbo: vertex buffer med hele ringen
+ */
+struct viz_trail {
+	int tracks;
+	int capacity;
+	int head;
+	int count;
+	int pending;
+	uint64_t window_ns;
+	uint64_t *times;
+	struct viz_vertex *vertices;
+	struct vec3 last[VIZ_TRAIL_MAX_TRACKS];
+	int has_last;
+	uint8_t colors[VIZ_TRAIL_MAX_TRACKS][4];
+	unsigned int vbo;
+};
+
+/**
+ * viz_trail_init - Alloker ringen og vertex bufferen
+ * @t: trail som initialiseres
+ * @tracks: punkter per sample (maks VIZ_TRAIL_MAX_TRACKS)
+ * @capacity: antall samples, f.eks. VIZ_TRAIL_SAMPLES
+ * @seconds: hvor lenge et sample vises
+ *
+ * Alle spor er hvite til viz_trail_color() kalles.
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_trail_init(struct viz_trail *t, int tracks, int capacity,
+		   float seconds);
+
+/**
+ * viz_trail_color - Sett farge for et spor
+ * @t: trail
+ * @track: spor
+ * @red, @green, @blue: farge (0-1)
+ *
+ * Gjelder samples som legges til etterpå.
+ */
+void viz_trail_color(struct viz_trail *t, int track, float red, float green,
+		     float blue);
+
+/**
+ * viz_trail_push - Legg til et sample
+ * @t: trail
+ * @points: ett punkt per spor (@t->tracks)
+ * @now_ns: viz_time_ns() for samplet
+ *
+ * Bare minnet oppdateres; opplasting skjer i viz_trail_draw(). Etter en
+ * pause lengre enn vinduet kobles samplet ikke til det forrige.
+ */
+void viz_trail_push(struct viz_trail *t, const struct vec3 *points,
+		    uint64_t now_ns);
+
+/**
+ * viz_trail_clear - Fjern historikken
+ * @t: trail
+ *
+ * Neste sample kobles ikke til det forrige.
+ */
+void viz_trail_clear(struct viz_trail *t);
+
+/**
+ * viz_trail_expire - Fjern samples eldre enn vinduet
+ * @t: trail
+ * @now_ns: viz_time_ns()
+ *
+ * Blir ringen tom, kobles neste sample ikke til det forrige.
+ *
+ * Retur: antall samples som fortsatt vises
+ */
+int viz_trail_expire(struct viz_trail *t, uint64_t now_ns);
+
+/**
+ * viz_trail_draw - Last opp nye samples og tegn historikken
+ * @t: trail
+ * @width: linjebredde (piksler)
+ *
+ * Tegner med gjeldende projection og modelview, med ett kall.
+ */
+void viz_trail_draw(struct viz_trail *t, float width);
+
+/**
+ * viz_trail_destroy - Frigjør vertex buffer og minne
+ * @t: trail
+ */
+void viz_trail_destroy(struct viz_trail *t);
+
+#endif /* VIZ_TRAIL_H */
@@ -0,0 +1,138 @@
+#ifndef VIZ_TRANSPORT_H
+#define VIZ_TRANSPORT_H
+
+#include <stddef.h>
+#include "shm.h"
+#include "udp.h"
+#include "uds.h"
+#include "uring.h"
+
+/*
+ * Transport for pose-strømmer, valgt med en endpoint-streng:
+ *
+ *   udp:9001            UDP port (mottaker), eller localhost:9001 (sender)
+ *   udp:host:9001       UDP til host (sender)
+ *   udp:239.x.y.z:9001  multicast-gruppe (sender og mottaker); én sender
+ *                       når alle mottakere, også på samme maskin
+ *   9001, host:9001     som over, "udp:" kan utelates
+ *   uring:9001          UDP mottatt med io_uring (Linux 6.0+), ellers
+ *                       som udp:9001; sender som udp:
+ *   shm:navn            shared memory segment /dev/shm/viz-navn
+ *   unix:/sti           unix datagram-socket (filsti)
+ *   unix:@navn          unix datagram-socket i abstract namespace (Linux)
+ *
+ * Samme meldings-semantikk for alle: datagrammer opptil UDP_DATAGRAM_MAX,
+ * og sendere feiler ikke om mottakeren ikke kjører.
+ */
+
+#define VIZ_ENDPOINT_MAX 128 /* Plass til "unix:" + sun_path */
+
+/**
+ * enum viz_transport_kind - Transport type
+ * @VIZ_TRANSPORT_UDP: UDP socket
+ * @VIZ_TRANSPORT_SHM: shared memory ring/seqlock (samme maskin)
+ * @VIZ_TRANSPORT_UNIX: unix datagram-socket (samme maskin)
+ */
+enum viz_transport_kind {
+	VIZ_TRANSPORT_UDP,
+	VIZ_TRANSPORT_SHM,
+	VIZ_TRANSPORT_UNIX,
+};
+
+/**
+ * struct viz_transport - Åpen transport (mottaker eller sender)
+ * @kind: transport type
+ * @sock: UDP/unix mottaker-socket, -1 ellers
+ * @uring: io_uring mottak, @uring.ring_fd er -1 hvis ikke i bruk
+ * @sender: UDP sender
+ * @uds_sender: unix sender
+ * @shm: shared memory kanal
+ * @path: unix-sti (peker inn i @endpoint)
+ * @endpoint: endpoint-strengen transporten ble åpnet med
+ */
+struct viz_transport {
+	enum viz_transport_kind kind;
+	int sock;
+	struct udp_uring uring;
+	struct udp_sender sender;
+	struct uds_sender uds_sender;
+	struct shm_channel shm;
+	const char *path;
+	char endpoint[VIZ_ENDPOINT_MAX];
+};
+
+/**
+ * viz_transport_open_receiver - Åpne transport for mottak
+ * @t: transport som initialiseres
+ * @endpoint: endpoint-streng
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_transport_open_receiver(struct viz_transport *t,
+				const char *endpoint);
+
+/**
+ * viz_transport_open_sender - Åpne transport for sending
+ * @t: transport som initialiseres
+ * @endpoint: endpoint-streng
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_transport_open_sender(struct viz_transport *t, const char *endpoint);
+
+/**
+ * viz_transport_send - Send én melding
+ * @t: sender-transport
+ * @data: payload
+ * @length: antall bytes
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_transport_send(struct viz_transport *t, const void *data,
+		       size_t length);
+
+/**
+ * viz_transport_receive_batch - Motta ventende meldinger
+ * @t: mottaker-transport
+ * @batch: output - meldinger
+ *
+ * Som udp_receive_batch().
+ *
+ * Retur: antall meldinger, 0 hvis ingen, -1 ved feil
+ */
+int viz_transport_receive_batch(struct viz_transport *t,
+				struct udp_batch *batch);
+
+/**
+ * viz_transport_receive_latest - Motta nyeste gyldige melding
+ * @t: mottaker-transport
+ * @buffer: output
+ * @buffer_size: størrelse på buffer
+ * @accept: validering (kan være NULL)
+ * @coalesced: output - antall eldre meldinger forkastet (kan være NULL)
+ *
+ * Som udp_receive_latest().
+ *
+ * Retur: antall bytes i @buffer, 0 hvis ingen, -1 ved feil
+ */
+int viz_transport_receive_latest(struct viz_transport *t, void *buffer,
+				 size_t buffer_size, udp_accept_fn accept,
+				 int *coalesced);
+
+/**
+ * viz_transport_fd - File descriptor som blir lesbar ved nye meldinger
+ * @t: mottaker-transport
+ *
+ * For poll/epoll. Shared memory har ingen fd og må polles.
+ *
+ * Retur: fd, eller -1 hvis transporten ikke har en
+ */
+int viz_transport_fd(const struct viz_transport *t);
+
+/**
+ * viz_transport_close - Lukk transport
+ * @t: transport
+ */
+void viz_transport_close(struct viz_transport *t);
+
+#endif /* VIZ_TRANSPORT_H */
@@ -0,0 +1,92 @@
+#ifndef VIZ_TRIPLE_BUFFER_H
+#define VIZ_TRIPLE_BUFFER_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+/*
+ * Lock-free triple buffer mellom én skriver og én leser
+ *
+ * Tre like store slots: skriveren fyller back, leseren leser front, og
+ * den tredje (middle) byttes atomisk mellom dem. viz_triple_publish()
+ * bytter back og middle og merker middle som ny; viz_triple_read()
+ * bytter front og middle bare hvis middle er ny. Ingen av sidene venter
+ * på den andre: leseren får alltid den nyeste komplette tilstanden, og
+ * tilstander leseren ikke rakk å se blir overskrevet.
+ *
+ * Back-slotten skriveren får etter en publish inneholder en eldre
+ * tilstand, så skriveren må skrive hele tilstanden før hver publish
+ * (typisk kopiere sin egen arbeidskopi inn).
+ */
+
+#define VIZ_TRIPLE_FRESH 4u /* Satt i @middle når slotten er ny */
+
+/**
+ * struct viz_triple_buffer - Tre slots og indeksene
+ * @slots: 3 * @size bytes
+ * @size: størrelse per slot
+ * @middle: indeks til middle-slotten, | VIZ_TRIPLE_FRESH hvis ny
+ * @back: slotten skriveren fyller (bare skriveren)
+ * @front: slotten leseren leser (bare leseren)
+ */
+struct viz_triple_buffer {
+	unsigned char *slots;
+	size_t size;
+	atomic_uint middle;
+	unsigned int back;
+	unsigned int front;
+};
+
+/**
+ * viz_triple_init - Alloker tre nullstilte slots
+ * @tb: buffer som initialiseres
+ * @size: størrelse per slot
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_triple_init(struct viz_triple_buffer *tb, size_t size);
+
+/**
+ * viz_triple_back - Slotten skriveren skal fylle
+ * @tb: buffer
+ *
+ * Retur: peker til @tb->size bytes, gyldig til neste viz_triple_publish()
+ */
+void *viz_triple_back(struct viz_triple_buffer *tb);
+
+/**
+ * viz_triple_publish - Publiser back-slotten
+ * @tb: buffer
+ *
+ * Retur: 1 hvis leseren hadde hentet forrige tilstand (og kan trenge å
+ * vekkes), 0 hvis den fortsatt lå ulest
+ */
+int viz_triple_publish(struct viz_triple_buffer *tb);
+
+/**
+ * viz_triple_pending - Sjekk om det finnes en tilstand leseren ikke har hentet
+ * @tb: buffer
+ *
+ * Kalles av leseren, f.eks. for å la være å tegne når ingenting er nytt.
+ *
+ * Retur: 1 hvis viz_triple_read() vil gi en ny tilstand, ellers 0
+ */
+int viz_triple_pending(struct viz_triple_buffer *tb);
+
+/**
+ * viz_triple_read - Hent nyeste publiserte tilstand
+ * @tb: buffer
+ * @fresh: output - 1 hvis tilstanden er ny siden forrige kall (kan være
+ *	   NULL)
+ *
+ * Retur: peker til front-slotten, gyldig til neste viz_triple_read()
+ */
+const void *viz_triple_read(struct viz_triple_buffer *tb, int *fresh);
+
+/**
+ * viz_triple_destroy - Frigjør slottene
+ * @tb: buffer
+ */
+void viz_triple_destroy(struct viz_triple_buffer *tb);
+
+#endif /* VIZ_TRIPLE_BUFFER_H */
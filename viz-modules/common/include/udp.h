@@ -1,8 +1,47 @@
 #ifndef VIZ_UDP_H
 #define VIZ_UDP_H
 
+#include <netinet/in.h>
 #include <stddef.h>
 
+/* Maks datagrammer per recvmmsg-kall og maks størrelse per datagram */
+#define UDP_BATCH_MAX 32
+#define UDP_DATAGRAM_MAX 1472
+
+/**
+ * struct udp_batch - Datagrammer mottatt i ett kall
+ * @data: payload per datagram
+ * @length: antall bytes per datagram
+ * @truncated: 1 hvis datagrammet var større enn UDP_DATAGRAM_MAX
+ * @count: antall datagrammer i @data
+ *
+ * Stor (ca. 47 KB); legg den statisk eller på heap.
+ */
+struct udp_batch {
+	unsigned char data[UDP_BATCH_MAX][UDP_DATAGRAM_MAX];
+	size_t length[UDP_BATCH_MAX];
+	unsigned char truncated[UDP_BATCH_MAX];
+	int count;
+};
+
+/**
+ * udp_accept_fn - Sjekk om et datagram er en gyldig melding
+ * @data: payload
+ * @length: antall bytes
+ *
+ * Retur: ikke-null hvis datagrammet skal brukes
+ */
+typedef int (*udp_accept_fn)(const void *data, size_t length);
+
+/**
+ * udp_batch_fn - Hent neste batch fra en mottaker
+ * @ctx: mottaker
+ * @batch: output - datagrammer
+ *
+ * Retur: antall datagrammer, 0 hvis ingen, -1 ved feil
+ */
+typedef int (*udp_batch_fn)(void *ctx, struct udp_batch *batch);
+
 /**
  * udp_create_receiver - Lag UDP socket for mottak
  * @port: port nummer å lytte på
@@ -11,6 +50,29 @@
  */
 int udp_create_receiver(int port);
 
+/* Multicast holdes på lokalt nett (TTL 1) og leveres til egen maskin */
+#define UDP_MULTICAST_TTL 1
+
+/**
+ * udp_is_multicast - Sjekk om host er en IPv4 multicast-adresse
+ * @host: numerisk adresse, f.eks. "239.255.0.1"
+ *
+ * Retur: 1 hvis 224.0.0.0/4, ellers 0
+ */
+int udp_is_multicast(const char *host);
+
+/**
+ * udp_create_multicast_receiver - Lag UDP socket som mottar fra gruppe
+ * @group: multicast-gruppe (numerisk)
+ * @port: port
+ *
+ * Flere mottakere på samme maskin kan lytte på samme gruppe og port, og
+ * hver får sin egen kopi av alle datagrammer.
+ *
+ * Retur: non-blocking socket, eller -1 ved feil
+ */
+int udp_create_multicast_receiver(const char *group, int port);
+
 /**
  * udp_receive - Motta data fra UDP socket
  * @sock: socket file descriptor
@@ -21,4 +83,124 @@ int udp_create_receiver(int port);
  */
 int udp_receive(int sock, void *buffer, size_t buffer_size);
 
+/**
+ * udp_receive_batch - Motta alle ventende datagrammer (opptil UDP_BATCH_MAX)
+ * @sock: non-blocking socket
+ * @batch: output - mottatte datagrammer
+ *
+ * Ett recvmmsg-kall på Linux, ellers recvfrom i løkke. Hvis retur er
+ * UDP_BATCH_MAX kan det ligge mer i køen.
+ *
+ * Retur: antall datagrammer, 0 hvis ingen data, -1 ved feil
+ */
+int udp_receive_batch(int sock, struct udp_batch *batch);
+
+/**
+ * udp_receive_latest - Tøm socket og behold nyeste gyldige datagram
+ * @sock: non-blocking socket
+ * @buffer: output - nyeste datagram som @accept godtar
+ * @buffer_size: størrelse på buffer
+ * @accept: validering, NULL godtar alle datagrammer som passer i @buffer
+ * @coalesced: output - antall gyldige datagrammer som ble forkastet fordi
+ *             et nyere fantes (kan være NULL)
+ *
+ * Latest-wins: en visualizer som poller én gang per frame henger ikke
+ * etter når senderen kjører raskere enn skjermen.
+ *
+ * Retur: antall bytes i @buffer, 0 hvis ingen gyldige data, -1 ved feil
+ */
+int udp_receive_latest(int sock, void *buffer, size_t buffer_size,
+		       udp_accept_fn accept, int *coalesced);
+
+/**
+ * udp_drain_latest - Som udp_receive_latest() for en vilkårlig mottaker
+ * @fetch: henter én batch
+ * @ctx: sendes til @fetch
+ * @buffer: output - nyeste gyldige datagram
+ * @buffer_size: størrelse på buffer
+ * @accept: validering (kan være NULL)
+ * @coalesced: output - antall forkastede eldre gyldige datagrammer
+ *
+ * Kaller @fetch til den returnerer mindre enn UDP_BATCH_MAX.
+ *
+ * Retur: antall bytes i @buffer, 0 hvis ingen gyldige data, -1 ved feil
+ */
+int udp_drain_latest(udp_batch_fn fetch, void *ctx, void *buffer,
+		     size_t buffer_size, udp_accept_fn accept, int *coalesced);
+
+/* Maks antall strømmer (destinasjonsporter) per sender */
+#define UDP_SENDER_MAX_STREAMS 8
+
+/**
+ * struct udp_sender - UDP sender med ferdig oppsatte destinasjoner
+ * @sock: socket, connect()-et hvis @num_streams er 1
+ * @num_streams: antall strømmer
+ * @addrs: destinasjonsadresse per strøm, bygget én gang ved open
+ */
+struct udp_sender {
+	int sock;
+	int num_streams;
+	struct sockaddr_in addrs[UDP_SENDER_MAX_STREAMS];
+};
+
+/**
+ * struct udp_message - Ett datagram i udp_sender_send_batch()
+ * @stream: strøm-indeks (rekkefølgen i @ports til udp_sender_open())
+ * @data: payload
+ * @length: antall bytes
+ */
+struct udp_message {
+	int stream;
+	const void *data;
+	size_t length;
+};
+
+/**
+ * udp_sender_open - Lag UDP sender til én eller flere porter
+ * @sender: sender som initialiseres
+ * @host: destinasjon (navn eller IPv4-adresse), NULL for 127.0.0.1,
+ *        eller multicast-gruppe
+ * @ports: destinasjonsport per strøm
+ * @num_streams: antall strømmer (1..UDP_SENDER_MAX_STREAMS)
+ * @sndbuf: SO_SNDBUF i bytes, 0 for systemets default
+ *
+ * Med én strøm connect()-es socketen og sending bruker send(); med flere
+ * sendes til adressene som ble bygget her.
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int udp_sender_open(struct udp_sender *sender, const char *host,
+		    const int ports[], int num_streams, int sndbuf);
+
+/**
+ * udp_sender_send - Send ett datagram
+ * @sender: sender
+ * @stream: strøm-indeks
+ * @data: payload
+ * @length: antall bytes
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int udp_sender_send(struct udp_sender *sender, int stream, const void *data,
+		    size_t length);
+
+/**
+ * udp_sender_send_batch - Send flere datagrammer i ett kall
+ * @sender: sender
+ * @msgs: datagrammer, kan gå til forskjellige strømmer
+ * @count: antall datagrammer (maks UDP_BATCH_MAX)
+ *
+ * Ett sendmmsg-kall på Linux, ellers send/sendto i løkke.
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int udp_sender_send_batch(struct udp_sender *sender,
+			  const struct udp_message *msgs, int count);
+
+/**
+ * udp_sender_close - Lukk sender
+ * @sender: sender fra udp_sender_open()
+ */
+void udp_sender_close(struct udp_sender *sender);
+
 #endif /* VIZ_UDP_H */
\ No newline at end of file
@@ -0,0 +1,79 @@
+#ifndef VIZ_UDS_H
+#define VIZ_UDS_H
+
+#include <stddef.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/*
+ * Unix domain datagram sockets (AF_UNIX, SOCK_DGRAM)
+ *
+ * Billigere enn UDP for lokale rigger (ingen IP/UDP-stack, ingen
+ * checksum), beholder meldingsgrenser og bruker filstier i stedet for
+ * porter. Navn som starter med '@' er i Linux abstract namespace: ingen
+ * fil, og navnet forsvinner når socketen lukkes.
+ *
+ * Mottaker-socketen er en vanlig non-blocking datagram-socket, så
+ * udp_receive_batch() og udp_receive_latest() brukes direkte på den.
+ */
+
+/**
+ * struct uds_sender - Sender til én unix datagram-socket
+ * @sock: non-blocking socket
+ * @addr: mottakerens adresse, bygget én gang
+ * @addr_len: lengde på @addr (abstract navn er ikke null-terminert)
+ */
+struct uds_sender {
+	int sock;
+	struct sockaddr_un addr;
+	socklen_t addr_len;
+};
+
+/**
+ * uds_create_receiver - Lag unix datagram-socket for mottak
+ * @path: filsti, eller "@navn" for abstract namespace
+ *
+ * En gammel socket-fil på @path fjernes først, men bare hvis ingen
+ * mottaker svarer på den; lytter en annen mottaker der, feiler kallet.
+ *
+ * Retur: socket file descriptor, eller -1 ved feil
+ */
+int uds_create_receiver(const char *path);
+
+/**
+ * uds_close_receiver - Lukk mottaker og fjern socket-filen
+ * @sock: socket fra uds_create_receiver()
+ * @path: samme sti som ved opprettelse
+ */
+void uds_close_receiver(int sock, const char *path);
+
+/**
+ * uds_sender_open - Lag sender
+ * @sender: sender som initialiseres
+ * @path: mottakerens filsti eller "@navn"
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int uds_sender_open(struct uds_sender *sender, const char *path);
+
+/**
+ * uds_sender_send - Send én melding
+ * @sender: sender
+ * @data: payload
+ * @length: antall bytes
+ *
+ * Uten mottaker, eller med full mottakskø, forkastes meldingen som med
+ * UDP; senderen blokkerer aldri.
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int uds_sender_send(struct uds_sender *sender, const void *data,
+		    size_t length);
+
+/**
+ * uds_sender_close - Lukk sender
+ * @sender: sender
+ */
+void uds_sender_close(struct uds_sender *sender);
+
+#endif /* VIZ_UDS_H */
@@ -0,0 +1,116 @@
+#ifndef VIZ_URING_H
+#define VIZ_URING_H
+
+#include <stddef.h>
+#include "udp.h"
+
+/*
+ * io_uring mottak for UDP (Linux 6.0+)
+ *
+ * Én multishot recv på socketen med provided buffers: kjernen legger hvert
+ * datagram i en ledig buffer og poster en completion, uten syscall per
+ * datagram og uten at vi må spørre. Mottak er å lese completion-køen i
+ * delt minne; io_uring_enter kalles bare når multishot må armeres på
+ * nytt (f.eks. når alle buffere var i bruk).
+ *
+ * Samme semantikk som udp_receive_batch(). Uten io_uring (eldre kjerne,
+ * io_uring_disabled, seccomp, ikke Linux) feiler udp_uring_open(), og
+ * kalleren bruker vanlig recvmmsg.
+ *
+ * Completions behandles i tråden som armerte, dvs. den som først kaller
+ * udp_uring_receive_batch(); bruk ringen fra én tråd.
+ */
+
+#define UDP_URING_BUFFERS 256 /* Provided buffers, potens av 2 */
+#define UDP_URING_BUFFER_SIZE 2048 /* > UDP_DATAGRAM_MAX, avslører trunkering */
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf_ring;
+
+/**
+ * struct udp_uring - io_uring mottaker for én socket
+ * @ring_fd: io_uring fd, -1 hvis ikke åpen
+ * @sock: socket det mottas fra
+ * @armed: 1 mens multishot recv er aktiv
+ * @draining: 1 når multishot stoppet på ENOBUFS og socketen leses direkte
+ *	      til den er tom, før multishot armeres igjen
+ * @sq_ring: SQ-ring mapping
+ * @sq_ring_size: størrelse på @sq_ring
+ * @sq_head: kjernens SQ head
+ * @sq_tail: vår SQ tail
+ * @sq_mask: SQ indeks-maske
+ * @sq_array: SQ indeks-array
+ * @sq_flags: SQ flagg (IORING_SQ_CQ_OVERFLOW)
+ * @sqes: SQE-array mapping
+ * @sqes_size: størrelse på @sqes
+ * @cq_ring: CQ-ring mapping (kan være samme som @sq_ring)
+ * @cq_ring_size: størrelse på @cq_ring
+ * @cq_head: vår CQ head
+ * @cq_tail: kjernens CQ tail
+ * @cq_mask: CQ indeks-maske
+ * @cqes: completions
+ * @buf_ring: provided buffer ring (delt med kjernen)
+ * @buffers: UDP_URING_BUFFERS buffere à UDP_URING_BUFFER_SIZE
+ * @buf_tail: neste ledige plass i @buf_ring
+ * @rearms: antall ganger multishot er armert på nytt
+ */
+struct udp_uring {
+	int ring_fd;
+	int sock;
+	int armed;
+	int draining;
+
+	void *sq_ring;
+	size_t sq_ring_size;
+	unsigned int *sq_head;
+	unsigned int *sq_tail;
+	unsigned int *sq_mask;
+	unsigned int *sq_array;
+	unsigned int *sq_flags;
+	struct io_uring_sqe *sqes;
+	size_t sqes_size;
+
+	void *cq_ring;
+	size_t cq_ring_size;
+	unsigned int *cq_head;
+	unsigned int *cq_tail;
+	unsigned int *cq_mask;
+	struct io_uring_cqe *cqes;
+
+	struct io_uring_buf_ring *buf_ring;
+	unsigned char *buffers;
+	unsigned short buf_tail;
+	unsigned long rearms;
+};
+
+/**
+ * udp_uring_open - Sett opp io_uring mottak for socket
+ * @r: mottaker som initialiseres
+ * @sock: UDP socket (fra udp_create_receiver())
+ *
+ * Retur: 0 ved suksess, -1 hvis io_uring ikke kan brukes (@sock er
+ *        uendret og kan brukes med udp_receive_batch())
+ */
+int udp_uring_open(struct udp_uring *r, int sock);
+
+/**
+ * udp_uring_receive_batch - Hent mottatte datagrammer (opptil UDP_BATCH_MAX)
+ * @r: mottaker
+ * @batch: output - datagrammer
+ *
+ * Non-blocking. Armerer multishot recv ved første kall. Det som lå i
+ * socketen da multishot stoppet (alle buffere opptatt) kommer etter
+ * completions, i rekkefølge; kall igjen så lenge batchen er full.
+ *
+ * Retur: antall datagrammer, 0 hvis ingen, -1 ved feil
+ */
+int udp_uring_receive_batch(struct udp_uring *r, struct udp_batch *batch);
+
+/**
+ * udp_uring_close - Lukk io_uring (ikke socketen)
+ * @r: mottaker
+ */
+void udp_uring_close(struct udp_uring *r);
+
+#endif /* VIZ_URING_H */
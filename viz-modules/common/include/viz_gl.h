@@ -0,0 +1,26 @@
+#ifndef VIZ_GL_H
+#define VIZ_GL_H
+
+/*
+ * OpenGL headers for begge plattformer
+ *
+ * macOS deklarerer GL 1.5/2.0-funksjonene (glGenBuffers, glCreateShader
+ * m.fl.) i <OpenGL/gl.h> og ARB-utvidelsene i <OpenGL/glext.h>. Mesa
+ * deklarerer dem bare med GL_GLEXT_PROTOTYPES, og <GL/gl.h> må
+ * inkluderes før GLFW gjør det uten.
+ */
+
+#ifdef __APPLE__
+#include <OpenGL/gl.h>
+#include <OpenGL/glext.h>
+#include <OpenGL/glu.h>
+#else
+#ifndef GL_GLEXT_PROTOTYPES
+#define GL_GLEXT_PROTOTYPES
+#endif
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <GL/glu.h>
+#endif
+
+#endif /* VIZ_GL_H */
@@ -1,19 +1,30 @@
 #ifndef VIZ_PROTOCOL_H
 #define VIZ_PROTOCOL_H
 
+#include <stddef.h>
 #include <stdint.h>
 
+struct viz_transport;
+
 #define VIZ_PORT 9001
-#define VIZ_MAGIC 0x53545750 /* "STWP" */
+#define VIZ_MAGIC 0x53545750 /* "STWP", v1 uten header */
+#define VIZ_MAGIC_V2 0x53545732 /* "STW2", v2+ starter med struct viz_header */
+#define VIZ_PROTOCOL_VERSION 2
 
 /**
  * enum viz_packet_type - Packet type identifiers
  * @VIZ_PACKET_POSE: Pose update packet
  * @VIZ_PACKET_GEOMETRY: Geometry configuration packet (future)
+ * @VIZ_PACKET_POSE_BATCH: Flere roboters poser i én packet (kun v2+)
+ * @VIZ_PACKET_POSE_Q16_KEY: Kvantisert pose, keyframe (kun v2+)
+ * @VIZ_PACKET_POSE_Q16_DELTA: Kvantisert pose, delta mot keyframe (kun v2+)
  */
 enum viz_packet_type {
 	VIZ_PACKET_POSE = 1,
 	VIZ_PACKET_GEOMETRY = 2,
+	VIZ_PACKET_POSE_BATCH = 3,
+	VIZ_PACKET_POSE_Q16_KEY = 4,
+	VIZ_PACKET_POSE_Q16_DELTA = 5,
 };
 
 /**
@@ -38,8 +49,10 @@ enum stewart_robot_type {
  * @ty: Y translation (mm)
  * @tz: Z translation (mm)
  *
- * Sendes via UDP fra eksperiment-program til visualizer.
+ * Protokoll v1. Sendes via UDP fra eksperiment-program til visualizer.
  * Packed for å garantere samme layout på alle platformer.
+ *
+ * Brukes også som dekodet pose i visualizerne, uansett protokoll-versjon.
  */
 struct viz_pose_packet {
 	uint32_t magic;
@@ -49,4 +62,492 @@ struct viz_pose_packet {
 	float tx, ty, tz;
 } __attribute__((packed));
 
+/**
+ * struct viz_header - Header for protokoll v2 og senere
+ * @magic: VIZ_MAGIC_V2
+ * @version: protokoll-versjon (VIZ_PROTOCOL_VERSION)
+ * @type: packet type (enum viz_packet_type)
+ * @sequence: økes med 1 per packet i strømmen, wrapper ved 2^32
+ * @reserved: 0
+ * @send_time_ns: CLOCK_MONOTONIC ved sending (ns)
+ *
+ * @send_time_ns er bare sammenlignbar med mottakerens klokke på samme
+ * maskin. Mellom maskiner blir latency forskjøvet med klokke-offset, men
+ * spredning (jitter) er fortsatt riktig.
+ */
+struct viz_header {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t type;
+	uint32_t sequence;
+	uint32_t reserved;
+	uint64_t send_time_ns;
+} __attribute__((packed));
+
+/**
+ * struct viz_pose_packet_v2 - Pose update packet, protokoll v2
+ * @header: header med sekvensnummer og tidsstempel
+ * @robot_type: robot configuration type
+ * @rx: roll rotation (degrees)
+ * @ry: pitch rotation (degrees)
+ * @rz: yaw rotation (degrees)
+ * @tx: X translation (mm)
+ * @ty: Y translation (mm)
+ * @tz: Z translation (mm)
+ */
+struct viz_pose_packet_v2 {
+	struct viz_header header;
+	uint32_t robot_type;
+	float rx, ry, rz;
+	float tx, ty, tz;
+} __attribute__((packed));
+
+/*
+ * Maks poser per batch packet: 24 + 4 + 48 * 28 = 1372 bytes, innenfor
+ * én ethernet-MTU (1472 bytes UDP payload).
+ */
+#define VIZ_BATCH_MAX_RECORDS 48
+
+/**
+ * struct viz_pose_record - Én robots pose i en batch packet
+ * @robot_id: robot-indeks (0..VIZ_FLEET_MAX_ROBOTS-1 hos mottaker)
+ * @robot_type: robot configuration type
+ * @rx: roll rotation (degrees)
+ * @ry: pitch rotation (degrees)
+ * @rz: yaw rotation (degrees)
+ * @tx: X translation (mm)
+ * @ty: Y translation (mm)
+ * @tz: Z translation (mm)
+ */
+struct viz_pose_record {
+	uint16_t robot_id;
+	uint16_t robot_type;
+	float rx, ry, rz;
+	float tx, ty, tz;
+} __attribute__((packed));
+
+/**
+ * struct viz_pose_batch_packet - Poser for flere roboter i ett datagram
+ * @header: header med type VIZ_PACKET_POSE_BATCH
+ * @count: antall records
+ * @reserved: 0
+ * @records: poser, bare de @count første sendes
+ *
+ * Sendes med lengde viz_pose_batch_size(@count).
+ */
+struct viz_pose_batch_packet {
+	struct viz_header header;
+	uint16_t count;
+	uint16_t reserved;
+	struct viz_pose_record records[VIZ_BATCH_MAX_RECORDS];
+} __attribute__((packed));
+
+/* Antall bytes som sendes for en batch med @count records */
+#define viz_pose_batch_size(count) \
+	(offsetof(struct viz_pose_batch_packet, records) + \
+	 (count) * sizeof(struct viz_pose_record))
+
+/*
+ * Kvantisert pose for linker med lite båndbredde
+ *
+ * Hvert felt blir int16 over [-range, range], med én range for rotasjon
+ * og én for translasjon (typisk max_pose_*_amplitude + max_pose_*_bias
+ * fra stewart_geometry). En keyframe har alle seks verdier og range, så
+ * mottakeren trenger ikke geometrien. Mellom keyframes sendes int8 delta
+ * mot siste keyframe (ikke forrige packet), så et tapt delta-packet
+ * påvirker ingen andre. Keyframe sendes periodisk, og når en delta ikke
+ * får plass i int8.
+ *
+ * Payload etter header: 24 bytes keyframe, 10 bytes delta, mot 28 bytes
+ * float (v2) og 36 bytes (v1).
+ */
+#define VIZ_Q16_MAX 32767
+#define VIZ_Q16_DELTA_MAX 127
+#define VIZ_Q16_KEYFRAME_INTERVAL 100 /* Default maks packets per keyframe */
+#define VIZ_Q16_REORDER_WINDOW 64 /* Eldre keyframe innenfor: forsinket */
+
+/**
+ * struct viz_q16_scale - Område for kvantisering
+ * @rotation_range: største |rx|, |ry|, |rz| som kan sendes (grader)
+ * @translation_range: største |tx|, |ty|, |tz| som kan sendes (mm)
+ */
+struct viz_q16_scale {
+	float rotation_range;
+	float translation_range;
+};
+
+/**
+ * struct viz_pose_q16_key - Keyframe, protokoll v2
+ * @header: header med type VIZ_PACKET_POSE_Q16_KEY
+ * @keyframe: keyframe-nummer, refereres av delta packets
+ * @robot_type: robot configuration type
+ * @rotation_range: @scale.rotation_range hos sender
+ * @translation_range: @scale.translation_range hos sender
+ * @value: rx, ry, rz, tx, ty, tz i enheter av range / VIZ_Q16_MAX
+ */
+struct viz_pose_q16_key {
+	struct viz_header header;
+	uint16_t keyframe;
+	uint16_t robot_type;
+	float rotation_range;
+	float translation_range;
+	int16_t value[6];
+} __attribute__((packed));
+
+/**
+ * struct viz_pose_q16_delta - Delta mot keyframe, protokoll v2
+ * @header: header med type VIZ_PACKET_POSE_Q16_DELTA
+ * @keyframe: keyframe deltaen gjelder
+ * @robot_type: robot configuration type
+ * @delta: verdi minus keyframe-verdi, samme enheter som keyframe
+ */
+struct viz_pose_q16_delta {
+	struct viz_header header;
+	uint16_t keyframe;
+	uint16_t robot_type;
+	int8_t delta[6];
+} __attribute__((packed));
+
+/**
+ * union viz_pose_q16_packet - Output fra viz_pose_q16_encode()
+ * @header: felles header, @header.type sier hvilken
+ * @key: keyframe
+ * @delta: delta
+ */
+union viz_pose_q16_packet {
+	struct viz_header header;
+	struct viz_pose_q16_key key;
+	struct viz_pose_q16_delta delta;
+};
+
+/**
+ * struct viz_q16_encoder - Sender-tilstand for kvantisert strøm
+ * @scale: område
+ * @keyframe_interval: maks packets fra en keyframe til neste
+ * @keyframe: nummer på siste keyframe
+ * @key_sequence: sekvensnummer til packeten med siste keyframe
+ * @key: verdiene i siste keyframe
+ * @since_keyframe: packets siden siste keyframe, -1 før første
+ * @keyframes: antall keyframes sendt
+ * @deltas: antall delta packets sendt
+ * @clipped: felt utenfor @scale (klippet, feilen er da ubegrenset)
+ */
+struct viz_q16_encoder {
+	struct viz_q16_scale scale;
+	int keyframe_interval;
+	uint16_t keyframe;
+	int16_t key[6];
+	int since_keyframe;
+	uint64_t keyframes;
+	uint64_t deltas;
+	uint64_t clipped;
+};
+
+/**
+ * struct viz_q16_decoder - Mottaker-tilstand for kvantisert strøm
+ * @has_keyframe: 1 når en keyframe er mottatt
+ * @keyframe: nummer på siste keyframe
+ * @key_sequence: sekvensnummer til packeten med siste keyframe
+ * @rotation_step: grader per enhet
+ * @translation_step: mm per enhet
+ * @key: verdiene i siste keyframe
+ * @orphans: delta packets forkastet fordi keyframen manglet
+ * @quantized: 1 når strømmen har sendt en kvantisert packet
+ */
+struct viz_q16_decoder {
+	int has_keyframe;
+	uint16_t keyframe;
+	uint32_t key_sequence;
+	float rotation_step;
+	float translation_step;
+	int16_t key[6];
+	uint64_t orphans;
+	int quantized;
+};
+
+/**
+ * struct viz_packet_info - Metadata fra en mottatt packet
+ * @version: protokoll-versjon (1 for packets uten header)
+ * @sequence: sekvensnummer (kun v2+)
+ * @send_time_ns: sende-tidsstempel (kun v2+)
+ */
+struct viz_packet_info {
+	int version;
+	uint32_t sequence;
+	uint64_t send_time_ns;
+};
+
+/* Latency-histogram: fire bøtter per dobling fra 1 us, opp til ca. 16 s */
+#define VIZ_LATENCY_BUCKETS 96
+
+/**
+ * struct viz_stream_stats - Løpende statistikk for én mottaks-strøm
+ * @received: packets brukt av mottakeren
+ * @coalesced: gyldige packets forkastet fordi et nyere fantes
+ * @lost: packets som aldri kom (hull i sekvensnummer)
+ * @reordered: packets som kom etter et nyere sekvensnummer
+ * @duplicates: packets med et sekvensnummer som allerede er sett
+ * @v1_packets: packets uten header (ingen sekvens/tid)
+ * @highest_sequence: høyeste sekvensnummer sett
+ * @has_sequence: @highest_sequence er gyldig
+ * @latency_count: antall latency-målinger
+ * @latency_hist: histogram over one-way latency
+ * @last_send_time_ns: sende-tidsstempel for siste packet, 0 for v1
+ * @last_recv_time_ns: viz_time_ns() ved mottak av siste packet
+ * @q16: keyframe-tilstand for kvantiserte poser i strømmen
+ * @record: kalles for hver dekodede pose i viz_receive_pose(), også de
+ *	    latest-wins forkaster (opptak, recording.h), eller NULL
+ * @record_ctx: første argument til @record
+ *
+ * Oppdateres fra én tråd; ingen låsing.
+ */
+struct viz_stream_stats {
+	uint64_t received;
+	uint64_t coalesced;
+	uint64_t lost;
+	uint64_t reordered;
+	uint64_t duplicates;
+	uint64_t v1_packets;
+	uint32_t highest_sequence;
+	int has_sequence;
+	uint64_t latency_count;
+	uint32_t latency_hist[VIZ_LATENCY_BUCKETS];
+	uint64_t last_send_time_ns;
+	uint64_t last_recv_time_ns;
+	struct viz_q16_decoder q16;
+	void (*record)(void *ctx, const struct viz_pose_packet *pose,
+		       const struct viz_packet_info *info,
+		       uint64_t recv_time_ns);
+	void *record_ctx;
+};
+
+/* Maks antall roboter i en flåte hos mottaker (robot_id under dette) */
+#define VIZ_FLEET_MAX_ROBOTS 256
+
+/**
+ * struct viz_fleet_slot - Siste mottatte pose for én robot
+ * @pose: pose i v1-layout
+ * @updates: antall oppdateringer, 0 hvis roboten aldri er sett
+ * @recv_time_ns: viz_time_ns() ved siste oppdatering
+ */
+struct viz_fleet_slot {
+	struct viz_pose_packet pose;
+	uint64_t updates;
+	uint64_t recv_time_ns;
+};
+
+/**
+ * struct viz_fleet - Poser demultiplekset per robot_id
+ * @robots: én slot per robot_id
+ * @dirty: bitmaske over roboter oppdatert siden viz_fleet_clear_dirty()
+ * @rejected: records med robot_id >= VIZ_FLEET_MAX_ROBOTS
+ * @stats: statistikk for strømmen (én sekvens per sender)
+ *
+ * Enkelt-pose packets (v1 og v2) går til robot 0, slik at vanlige
+ * sendere fortsatt virker. Stor (ca. 20 KB); legg den statisk eller på heap.
+ */
+struct viz_fleet {
+	struct viz_fleet_slot robots[VIZ_FLEET_MAX_ROBOTS];
+	uint64_t dirty[VIZ_FLEET_MAX_ROBOTS / 64];
+	uint64_t rejected;
+	struct viz_stream_stats stats;
+};
+
+/**
+ * viz_time_ns - Monoton tid i nanosekunder (CLOCK_MONOTONIC)
+ */
+uint64_t viz_time_ns(void);
+
+/**
+ * viz_pose_packet_accept - Sjekk om datagram er en gyldig pose packet
+ * @data: payload
+ * @length: antall bytes
+ *
+ * Godtar v1, v2 og kvantiserte poser (keyframe og delta). Kan brukes
+ * som udp_accept_fn for udp_receive_latest().
+ *
+ * Retur: 1 hvis gyldig, ellers 0
+ */
+int viz_pose_packet_accept(const void *data, size_t length);
+
+/**
+ * viz_pose_decode - Dekod pose packet (v1 eller v2)
+ * @data: payload
+ * @length: antall bytes
+ * @pose: output - pose i v1-layout
+ * @info: output - versjon, sekvens og tidsstempel (kan være NULL)
+ *
+ * Retur: 0 ved suksess, -1 hvis ikke en gyldig pose packet
+ */
+int viz_pose_decode(const void *data, size_t length,
+		    struct viz_pose_packet *pose, struct viz_packet_info *info);
+
+/**
+ * viz_pose_encode - Lag v2 pose packet
+ * @pose: pose (magic/type i @pose ignoreres)
+ * @sequence: sekvensnummer, økes av funksjonen
+ * @out: output packet, tidsstemplet nå
+ */
+void viz_pose_encode(const struct viz_pose_packet *pose, uint32_t *sequence,
+		     struct viz_pose_packet_v2 *out);
+
+/**
+ * viz_q16_encoder_init - Start kvantisert strøm
+ * @enc: encoder
+ * @scale: område, begge > 0
+ * @keyframe_interval: maks packets per keyframe, 0 for default
+ */
+void viz_q16_encoder_init(struct viz_q16_encoder *enc,
+			  const struct viz_q16_scale *scale,
+			  int keyframe_interval);
+
+/**
+ * viz_pose_q16_encode - Lag kvantisert pose packet (keyframe eller delta)
+ * @enc: encoder
+ * @pose: pose (magic/type i @pose ignoreres)
+ * @sequence: sekvensnummer, økes av funksjonen
+ * @out: output packet, tidsstemplet nå
+ *
+ * Retur: antall bytes som skal sendes
+ */
+size_t viz_pose_q16_encode(struct viz_q16_encoder *enc,
+			   const struct viz_pose_packet *pose,
+			   uint32_t *sequence, union viz_pose_q16_packet *out);
+
+/**
+ * viz_q16_error_bound - Største kvantiseringsfeil innenfor området
+ * @scale: område
+ * @rotation_deg: output - maks feil per rotasjonsfelt (grader)
+ * @translation_mm: output - maks feil per translasjonsfelt (mm)
+ *
+ * Et halvt kvantiseringssteg; delta packets har samme feil som keyframes.
+ */
+void viz_q16_error_bound(const struct viz_q16_scale *scale,
+			 float *rotation_deg, float *translation_mm);
+
+/**
+ * viz_pose_decode_q16 - Dekod kvantisert pose packet
+ * @dec: mottaker-tilstand, oppdateres av keyframes
+ * @data: payload
+ * @length: antall bytes
+ * @pose: output - pose i v1-layout
+ * @info: output - metadata (kan være NULL)
+ *
+ * Retur: 0 ved suksess, -1 hvis ikke en kvantisert pose, en forsinket
+ *        eldre keyframe, eller keyframen deltaen gjelder mangler
+ */
+int viz_pose_decode_q16(struct viz_q16_decoder *dec, const void *data,
+			size_t length, struct viz_pose_packet *pose,
+			struct viz_packet_info *info);
+
+/**
+ * viz_pose_batch_encode - Lag v2 batch packet
+ * @records: poser (@count)
+ * @count: antall poser (1..VIZ_BATCH_MAX_RECORDS)
+ * @sequence: sekvensnummer, økes av funksjonen
+ * @out: output packet, tidsstemplet nå
+ *
+ * Retur: antall bytes som skal sendes, 0 hvis @count er ugyldig
+ */
+size_t viz_pose_batch_encode(const struct viz_pose_record *records, int count,
+			     uint32_t *sequence,
+			     struct viz_pose_batch_packet *out);
+
+/**
+ * viz_fleet_apply - Demultiplekse ett datagram inn i flåten
+ * @fleet: flåte
+ * @data: payload (pose eller batch packet, v1 eller v2)
+ * @length: antall bytes
+ * @recv_time_ns: viz_time_ns() ved mottak
+ *
+ * Retur: antall roboter oppdatert, -1 hvis ikke en gyldig packet
+ */
+int viz_fleet_apply(struct viz_fleet *fleet, const void *data, size_t length,
+		    uint64_t recv_time_ns);
+
+/**
+ * viz_receive_fleet - Tøm transport inn i flåten
+ * @t: mottaker-transport
+ * @fleet: flåte
+ *
+ * Alle ventende datagrammer brukes i rekkefølge, så hver robot ender med
+ * sin nyeste pose selv om flåten er fordelt over flere datagrammer.
+ *
+ * Retur: antall robot-oppdateringer, 0 hvis ingen data, -1 ved feil
+ */
+int viz_receive_fleet(struct viz_transport *t, struct viz_fleet *fleet);
+
+/**
+ * viz_fleet_is_dirty - Sjekk om robot er oppdatert siden forrige clear
+ * @fleet: flåte
+ * @robot_id: robot
+ */
+static inline int viz_fleet_is_dirty(const struct viz_fleet *fleet,
+				     int robot_id)
+{
+	return (fleet->dirty[robot_id / 64] >> (robot_id % 64)) & 1;
+}
+
+/**
+ * viz_fleet_clear_dirty - Nullstill dirty-bitmasken
+ * @fleet: flåte
+ */
+static inline void viz_fleet_clear_dirty(struct viz_fleet *fleet)
+{
+	int i;
+
+	for (i = 0; i < VIZ_FLEET_MAX_ROBOTS / 64; i++)
+		fleet->dirty[i] = 0;
+}
+
+/**
+ * viz_stream_stats_update - Registrer en mottatt packet
+ * @stats: strøm-statistikk
+ * @info: metadata fra viz_pose_decode()
+ * @recv_time_ns: viz_time_ns() ved mottak
+ * @coalesced: antall eldre packets forkastet i samme mottak
+ *
+ * Packets forkastet av udp_receive_latest() regnes ikke som tapt.
+ */
+void viz_stream_stats_update(struct viz_stream_stats *stats,
+			     const struct viz_packet_info *info,
+			     uint64_t recv_time_ns, int coalesced);
+
+/**
+ * viz_receive_pose - Motta nyeste pose og oppdater statistikk
+ * @t: mottaker-transport
+ * @pose: output - nyeste pose (uendret hvis ingen ny)
+ * @stats: strøm-statistikk som oppdateres
+ *
+ * Latest-wins: bare nyeste pose returneres. Fra sockets leses likevel
+ * alle ventende datagrammer i rekkefølge, så keyframes i kvantiserte
+ * strømmer ikke forsvinner i coalescing. Fra shared memory brukes
+ * latest-slotten så lenge strømmen bare har sendt float-poser og ingen
+ * tar opp (@stats->record); ellers leses ringen i rekkefølge.
+ *
+ * Retur: 1 hvis ny pose, 0 hvis ingen, -1 ved feil
+ */
+int viz_receive_pose(struct viz_transport *t, struct viz_pose_packet *pose,
+		     struct viz_stream_stats *stats);
+
+/**
+ * viz_stream_stats_latency_ms - Latency-persentil
+ * @stats: strøm-statistikk
+ * @percentile: 0..100
+ *
+ * Oppløsning er en kvart dobling (ca. 19 %).
+ *
+ * Retur: latency i millisekunder, 0 hvis ingen målinger
+ */
+double viz_stream_stats_latency_ms(const struct viz_stream_stats *stats,
+				   double percentile);
+
+/**
+ * viz_stream_stats_print - Print statistikk for strøm
+ * @stats: strøm-statistikk
+ * @name: navn på strømmen
+ */
+void viz_stream_stats_print(const struct viz_stream_stats *stats,
+			    const char *name);
+
 #endif /* VIZ_PROTOCOL_H */
\ No newline at end of file
@@ -0,0 +1,362 @@
+#define _DEFAULT_SOURCE
+#include "bench.h"
+#include "viz_gl.h"
+#include "viz_protocol.h"
+#include <GLFW/glfw3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __linux__
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#ifdef __linux__
+/* Surfaceless platform trenger verken X eller DRM; ellers default display */
+static EGLDisplay open_display(void)
+{
+	const char *ext = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display;
+
+	if (!ext || !strstr(ext, "EGL_MESA_platform_surfaceless"))
+		return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+		eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (get_platform_display)
+		return get_platform_display(EGL_PLATFORM_SURFACELESS_MESA,
+					    EGL_DEFAULT_DISPLAY, NULL);
+
+	return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+#endif
+
+/**
+ * viz_bench_context_init - Lag offscreen context og gjør den current
+ * @ctx: context som initialiseres
+ * @width, @height: størrelse i piksler
+ *
+ * Legacy (compatibility) GL-context, samme som visualizerne får fra GLFW
+ * på macOS, så fixed-function tegningen virker uendret.
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_bench_context_init(struct viz_bench_context *ctx, int width,
+			   int height)
+{
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->width = width;
+	ctx->height = height;
+
+#ifdef __linux__
+	const EGLint config_attr[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+		EGL_DEPTH_SIZE, 24,
+		EGL_NONE
+	};
+	const EGLint surface_attr[] = {
+		EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE
+	};
+	EGLDisplay display;
+	EGLConfig config;
+	EGLint configs;
+
+	display = open_display();
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL)) {
+		fprintf(stderr, "bench: no EGL display\n");
+		return -1;
+	}
+	ctx->display = display;
+
+	if (!eglChooseConfig(display, config_attr, &config, 1, &configs) ||
+	    configs < 1) {
+		fprintf(stderr, "bench: no EGL config with pbuffer and GL\n");
+		goto err;
+	}
+
+	ctx->surface = eglCreatePbufferSurface(display, config, surface_attr);
+	if (ctx->surface == EGL_NO_SURFACE) {
+		fprintf(stderr, "bench: eglCreatePbufferSurface failed\n");
+		goto err;
+	}
+
+	if (!eglBindAPI(EGL_OPENGL_API)) {
+		fprintf(stderr, "bench: desktop GL not supported by EGL\n");
+		goto err;
+	}
+
+	ctx->context = eglCreateContext(display, config, EGL_NO_CONTEXT, NULL);
+	if (ctx->context == EGL_NO_CONTEXT) {
+		fprintf(stderr, "bench: eglCreateContext failed\n");
+		goto err;
+	}
+
+	if (!eglMakeCurrent(display, ctx->surface, ctx->surface,
+			    ctx->context)) {
+		fprintf(stderr, "bench: eglMakeCurrent failed\n");
+		goto err;
+	}
+
+	glViewport(0, 0, width, height);
+	printf("Headless: %s, %s\n", (const char *)glGetString(GL_RENDERER),
+	       (const char *)glGetString(GL_VERSION));
+
+	return 0;
+
+err:
+	viz_bench_context_destroy(ctx);
+	return -1;
+#else
+	fprintf(stderr, "bench: headless rendering requires EGL (Linux)\n");
+	return -1;
+#endif
+}
+
+/**
+ * viz_bench_context_destroy - Frigjør offscreen context
+ * @ctx: context
+ */
+void viz_bench_context_destroy(struct viz_bench_context *ctx)
+{
+#ifdef __linux__
+	if (!ctx->display)
+		return;
+
+	eglMakeCurrent(ctx->display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+		       EGL_NO_CONTEXT);
+	if (ctx->context)
+		eglDestroyContext(ctx->display, ctx->context);
+	if (ctx->surface)
+		eglDestroySurface(ctx->display, ctx->surface);
+	eglTerminate(ctx->display);
+#endif
+	memset(ctx, 0, sizeof(*ctx));
+}
+
+/* Vinduet eksponert eller endret størrelse */
+static void refresh_callback(GLFWwindow *window)
+{
+	struct viz_window *w = glfwGetWindowUserPointer(window);
+
+	w->redraw = 1;
+}
+
+/**
+ * viz_window_open - Lag vindu, eller offscreen context med -B
+ * @w: vindu som initialiseres (må leve til viz_window_close())
+ * @title: vindustittel
+ * @width, @height: størrelse i piksler
+ * @bench_frames: -B, 0 for vanlig vindu med vsync
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_window_open(struct viz_window *w, const char *title, int width,
+		    int height, int bench_frames)
+{
+	memset(w, 0, sizeof(*w));
+	w->bench_frames = bench_frames;
+	w->width = width;
+	w->height = height;
+	w->redraw = 1;
+
+	if (bench_frames)
+		return viz_bench_context_init(&w->headless, width, height);
+
+	/* Initialiser GLFW */
+	if (!glfwInit()) {
+		fprintf(stderr, "Failed to initialize GLFW\n");
+		return -1;
+	}
+
+	/* Lag vindu */
+	w->window = glfwCreateWindow(width, height, title, NULL, NULL);
+	if (!w->window) {
+		fprintf(stderr, "Failed to create window\n");
+		glfwTerminate();
+		return -1;
+	}
+
+	glfwMakeContextCurrent(w->window);
+	glfwSwapInterval(1); /* VSync */
+	glfwSetWindowUserPointer(w->window, w);
+	glfwSetWindowRefreshCallback(w->window, refresh_callback);
+
+	return 0;
+}
+
+/**
+ * viz_window_close - Lukk vindu eller offscreen context
+ * @w: vindu
+ */
+void viz_window_close(struct viz_window *w)
+{
+	if (w->bench_frames) {
+		viz_bench_context_destroy(&w->headless);
+		return;
+	}
+
+	glfwDestroyWindow(w->window);
+	glfwTerminate();
+	w->window = NULL;
+}
+
+/**
+ * viz_bench_run - Tegn @frames frames uten vsync og skriv frame-tidene
+ * @frames: antall frames som måles (etter VIZ_BENCH_WARMUP)
+ * @draw: tegner én frame
+ * @ctx: sendes til @draw
+ * @label: navn i rapporten
+ *
+ * Posene kommer fra endpoint som ellers (f.eks. fleet_patterns eller
+ * motion_patterns), så render-kosten måles med en realistisk strøm.
+ */
+void viz_bench_run(int frames, viz_draw_fn draw, void *ctx,
+		   const char *label)
+{
+	struct viz_bench bench;
+
+	if (viz_bench_init(&bench, frames) < 0)
+		return;
+
+	while (!viz_bench_done(&bench)) {
+		viz_bench_begin(&bench);
+		draw(ctx);
+		viz_bench_end(&bench);
+	}
+
+	viz_bench_report(&bench, label);
+	viz_bench_destroy(&bench);
+}
+
+/**
+ * viz_bench_init - Klargjør måling
+ * @b: bench som initialiseres
+ * @frames: antall frames som skal måles (etter VIZ_BENCH_WARMUP)
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_bench_init(struct viz_bench *b, int frames)
+{
+	memset(b, 0, sizeof(*b));
+
+	b->samples = calloc(frames, sizeof(*b->samples));
+	if (!b->samples) {
+		perror("calloc");
+		return -1;
+	}
+
+	b->frames = frames;
+	b->warmup = VIZ_BENCH_WARMUP;
+	return 0;
+}
+
+/**
+ * viz_bench_done - Sjekk om alle frames er målt
+ * @b: bench
+ *
+ * Retur: 1 når @b->frames frames er målt, ellers 0
+ */
+int viz_bench_done(const struct viz_bench *b)
+{
+	return b->count >= b->frames;
+}
+
+/**
+ * viz_bench_begin - Start tidtaking av en frame
+ * @b: bench
+ */
+void viz_bench_begin(struct viz_bench *b)
+{
+	b->start_ns = viz_time_ns();
+}
+
+/**
+ * viz_bench_end - Vent på GPU og registrer frame-tiden
+ * @b: bench
+ *
+ * glFinish() gjør at tiden inkluderer selve rasteriseringen, ikke bare
+ * at kommandoene er lagt i kø.
+ */
+void viz_bench_end(struct viz_bench *b)
+{
+	double ms;
+
+	glFinish();
+	ms = (double)(viz_time_ns() - b->start_ns) / 1e6;
+
+	if (b->warmup > 0) {
+		b->warmup--;
+		return;
+	}
+	if (b->count < b->frames)
+		b->samples[b->count++] = ms;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+/* Nearest-rank persentil av sorterte verdier */
+static double percentile(const double *sorted, int count, double p)
+{
+	int rank = (int)(p / 100.0 * count + 0.999999);
+
+	if (rank < 1)
+		rank = 1;
+	if (rank > count)
+		rank = count;
+	return sorted[rank - 1];
+}
+
+/**
+ * viz_bench_report - Skriv mean, p50, p90, p99 og max
+ * @b: bench
+ * @label: navn i rapporten
+ *
+ * Én linje med faste felt, så den er lett å sammenligne mellom kjøringer.
+ */
+void viz_bench_report(const struct viz_bench *b, const char *label)
+{
+	double *sorted, sum = 0.0;
+	int i;
+
+	if (b->count == 0) {
+		printf("%s: no frames measured\n", label);
+		return;
+	}
+
+	sorted = malloc(b->count * sizeof(*sorted));
+	if (!sorted) {
+		perror("malloc");
+		return;
+	}
+	memcpy(sorted, b->samples, b->count * sizeof(*sorted));
+	qsort(sorted, b->count, sizeof(*sorted), compare_double);
+
+	for (i = 0; i < b->count; i++)
+		sum += sorted[i];
+
+	printf("%s: %d frames, mean %.3f ms, p50 %.3f, p90 %.3f, "
+	       "p99 %.3f, max %.3f ms\n",
+	       label, b->count, sum / b->count,
+	       percentile(sorted, b->count, 50.0),
+	       percentile(sorted, b->count, 90.0),
+	       percentile(sorted, b->count, 99.0), sorted[b->count - 1]);
+
+	free(sorted);
+}
+
+/**
+ * viz_bench_destroy - Frigjør målingene
+ * @b: bench
+ */
+void viz_bench_destroy(struct viz_bench *b)
+{
+	free(b->samples);
+	b->samples = NULL;
+}
@@ -0,0 +1,163 @@
+#define _DEFAULT_SOURCE
+#include "camera.h"
+#include "viz_gl.h"
+#include <GLFW/glfw3.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * viz_camera_init - Default kamera
+ * @c: kamera som initialiseres
+ */
+void viz_camera_init(struct viz_camera *c)
+{
+	memset(c, 0, sizeof(*c));
+	c->azimuth = 45.0f;
+	c->elevation = 30.0f;
+	c->distance = 600.0f;
+	c->ortho_scale = 400.0f;
+	c->default_ortho_scale = 400.0f;
+	c->max_ortho_scale = 2000.0f;
+	c->clip_depth = 2000.0f;
+}
+
+/**
+ * key_callback - Håndter tastatur-input
+ * @window: GLFW vindu
+ * @key: tast som ble trykket
+ * @scancode: system-spesifikk scancode
+ * @action: GLFW_PRESS, GLFW_RELEASE, eller GLFW_REPEAT
+ * @mods: modifier bits (shift, ctrl, alt, etc)
+ *
+ * ESC lukker vinduet, kamera-taster går til kameraet og resten til
+ * visualizerens handler.
+ */
+static void key_callback(GLFWwindow *window, int key, int scancode, int action,
+			 int mods)
+{
+	struct viz_window *w = glfwGetWindowUserPointer(window);
+	struct viz_camera *c = w->camera;
+
+	(void)scancode;
+	(void)mods;
+
+	if (action != GLFW_PRESS && action != GLFW_REPEAT)
+		return;
+
+	if (key == GLFW_KEY_ESCAPE)
+		glfwSetWindowShouldClose(window, GLFW_TRUE);
+	else if (!viz_camera_key(c, key) && c->on_key)
+		c->on_key(c->key_ctx, key);
+
+	w->redraw = 1;
+}
+
+/**
+ * viz_camera_attach - Styr kameraet med tastaturet i vinduet
+ * @c: kamera (må leve til vinduet lukkes)
+ * @w: vindu fra viz_window_open(), uten effekt med -B
+ * @on_key: handler for taster kameraet ikke bruker (kan være NULL)
+ * @ctx: sendes til @on_key
+ */
+void viz_camera_attach(struct viz_camera *c, struct viz_window *w,
+		       viz_key_fn on_key, void *ctx)
+{
+	c->on_key = on_key;
+	c->key_ctx = ctx;
+
+	if (!w->window)
+		return;
+
+	w->camera = c;
+	glfwSetKeyCallback(w->window, key_callback);
+}
+
+/**
+ * viz_camera_key - Bruk en tast på kameraet
+ * @c: kamera
+ * @key: GLFW_KEY_*
+ *
+ * Piltaster: Roter kamera
+ * +/- eller Q/W: Zoom inn/ut
+ * R: Reset kamera
+ *
+ * Retur: 1 hvis tasten styrer kameraet, ellers 0
+ */
+int viz_camera_key(struct viz_camera *c, int key)
+{
+	switch (key) {
+	case GLFW_KEY_LEFT:
+		c->azimuth -= 5.0f;
+		break;
+	case GLFW_KEY_RIGHT:
+		c->azimuth += 5.0f;
+		break;
+	case GLFW_KEY_UP:
+		c->elevation += 5.0f;
+		if (c->elevation > 89.0f)
+			c->elevation = 89.0f;
+		break;
+	case GLFW_KEY_DOWN:
+		c->elevation -= 5.0f;
+		if (c->elevation < -89.0f)
+			c->elevation = -89.0f;
+		break;
+	case GLFW_KEY_EQUAL: /* + key */
+	case GLFW_KEY_Q:
+		c->ortho_scale *= 0.9f;
+		if (c->ortho_scale < VIZ_CAMERA_MIN_ORTHO)
+			c->ortho_scale = VIZ_CAMERA_MIN_ORTHO;
+		break;
+	case GLFW_KEY_MINUS: /* - key */
+	case GLFW_KEY_W:
+		c->ortho_scale *= 1.1f;
+		if (c->ortho_scale > c->max_ortho_scale)
+			c->ortho_scale = c->max_ortho_scale;
+		break;
+	case GLFW_KEY_R:
+		/* Reset kamera */
+		c->azimuth = 45.0f;
+		c->elevation = 30.0f;
+		c->ortho_scale = c->default_ortho_scale;
+		printf("Camera reset\n");
+		break;
+	default:
+		return 0;
+	}
+
+	return 1;
+}
+
+/**
+ * viz_camera_apply - Sett projection og modelview for kameraet
+ * @c: kamera
+ * @w: vindu (for aspect ratio)
+ */
+void viz_camera_apply(const struct viz_camera *c, const struct viz_window *w)
+{
+	float aspect = (float)w->width / (float)w->height;
+	float azimuth_rad, elevation_rad;
+	float eye_x, eye_y, eye_z;
+
+	/* Orthographic projection basert på ortho_scale */
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glOrtho(-c->ortho_scale * aspect, c->ortho_scale * aspect,
+		-c->ortho_scale, c->ortho_scale, -c->clip_depth, c->clip_depth);
+
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+
+	/* Kamera posisjon fra azimuth og elevation */
+	azimuth_rad = c->azimuth * (float)M_PI / 180.0f;
+	elevation_rad = c->elevation * (float)M_PI / 180.0f;
+
+	eye_x = c->distance * cosf(elevation_rad) * cosf(azimuth_rad);
+	eye_y = c->distance * sinf(elevation_rad);
+	eye_z = c->distance * cosf(elevation_rad) * sinf(azimuth_rad);
+
+	gluLookAt(eye_x, eye_y + VIZ_CAMERA_TARGET_Y, eye_z, /* eye */
+		  0.0, VIZ_CAMERA_TARGET_Y, 0.0, /* center */
+		  0.0, 1.0, 0.0); /* up */
+}
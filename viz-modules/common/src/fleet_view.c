@@ -0,0 +1,448 @@
+#define _DEFAULT_SOURCE
+#include "fleet_view.h"
+#include "render.h"
+#include "viz_gl.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Attributt-indekser; 0 må være en per-vertex attributt */
+enum {
+	ATTR_VERTEX,
+	ATTR_OFFSET,
+	ATTR_BASE,
+	ATTR_BASE_NEXT,
+	ATTR_KNEE,
+	ATTR_PLATFORM,
+	ATTR_PLATFORM_NEXT,
+	ATTR_STATE,
+	ATTR_COUNT
+};
+
+/* Linje-mal for ett ben: (punkt, del) per vertex, se shaderen */
+static const float leg_template[][2] = {
+	{ 0, 0 }, { 1, 0 }, /* base → neste base */
+	{ 0, 1 }, { 2, 1 }, /* arm: base → kne */
+	{ 2, 2 }, { 3, 2 }, /* pushrod: kne → platform */
+	{ 3, 3 }, { 4, 3 }, /* platform → neste platform */
+};
+
+static const char *vertex_shader =
+	"#version 120\n"
+	"attribute vec4 a_vertex;\n"
+	"attribute vec3 a_offset;\n"
+	"attribute vec3 a_base;\n"
+	"attribute vec3 a_base_next;\n"
+	"attribute vec3 a_knee;\n"
+	"attribute vec3 a_platform;\n"
+	"attribute vec3 a_platform_next;\n"
+	"attribute vec2 a_state;\n"
+	"uniform float u_knee_radius;\n"
+	"varying vec3 v_color;\n"
+	"\n"
+	"void main()\n"
+	"{\n"
+	"	vec3 p;\n"
+	"\n"
+	"	if (u_knee_radius > 0.0) {\n"
+	"		p = a_knee + a_vertex.xyz * u_knee_radius;\n"
+	"		v_color = vec3(0.2, 0.9, 0.2);\n"
+	"	} else {\n"
+	"		float point = a_vertex.x, part = a_vertex.y;\n"
+	"\n"
+	"		if (point < 0.5)\n"
+	"			p = a_base;\n"
+	"		else if (point < 1.5)\n"
+	"			p = a_base_next;\n"
+	"		else if (point < 2.5)\n"
+	"			p = a_knee;\n"
+	"		else if (point < 3.5)\n"
+	"			p = a_platform;\n"
+	"		else\n"
+	"			p = a_platform_next;\n"
+	"\n"
+	"		if (part < 0.5)\n"
+	"			v_color = vec3(0.4, 0.4, 1.0);\n"
+	"		else if (part < 1.5)\n"
+	"			v_color = mix(vec3(0.9, 0.9, 0.2),\n"
+	"				      vec3(1.0, 0.1, 0.1),\n"
+	"				      a_state.x);\n"
+	"		else if (part < 2.5)\n"
+	"			v_color = vec3(1.0, 0.5, 0.1);\n"
+	"		else\n"
+	"			v_color = a_state.y > 0.5 ?\n"
+	"					  vec3(1.0, 0.1, 0.1) :\n"
+	"					  vec3(1.0);\n"
+	"	}\n"
+	"\n"
+	"	gl_Position = gl_ModelViewProjectionMatrix *\n"
+	"		      vec4(p + a_offset, 1.0);\n"
+	"}\n";
+
+static const char *fragment_shader =
+	"#version 120\n"
+	"varying vec3 v_color;\n"
+	"\n"
+	"void main()\n"
+	"{\n"
+	"	gl_FragColor = vec4(v_color, 1.0);\n"
+	"}\n";
+
+static int has_extension(const char *name)
+{
+	const char *ext = (const char *)glGetString(GL_EXTENSIONS);
+	size_t len = strlen(name);
+
+	while (ext && (ext = strstr(ext, name))) {
+		if (ext[len] == ' ' || ext[len] == '\0')
+			return 1;
+		ext += len;
+	}
+
+	return 0;
+}
+
+static GLuint compile_shader(GLenum type, const char *source)
+{
+	char log[512];
+	GLuint shader;
+	GLint ok;
+
+	shader = glCreateShader(type);
+	glShaderSource(shader, 1, &source, NULL);
+	glCompileShader(shader);
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+	if (!ok) {
+		glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		fprintf(stderr, "fleet view shader: %s\n", log);
+		glDeleteShader(shader);
+		return 0;
+	}
+
+	return shader;
+}
+
+static GLuint link_program(void)
+{
+	static const char *const names[ATTR_COUNT] = {
+		"a_vertex",   "a_offset",   "a_base",	       "a_base_next",
+		"a_knee",     "a_platform", "a_platform_next", "a_state",
+	};
+	char log[512];
+	GLuint vs, fs, program;
+	GLint ok;
+	int i;
+
+	vs = compile_shader(GL_VERTEX_SHADER, vertex_shader);
+	fs = compile_shader(GL_FRAGMENT_SHADER, fragment_shader);
+	if (!vs || !fs) {
+		glDeleteShader(vs);
+		glDeleteShader(fs);
+		return 0;
+	}
+
+	program = glCreateProgram();
+	glAttachShader(program, vs);
+	glAttachShader(program, fs);
+	for (i = 0; i < ATTR_COUNT; i++)
+		glBindAttribLocation(program, i, names[i]);
+	glLinkProgram(program);
+	glDeleteShader(vs);
+	glDeleteShader(fs);
+
+	glGetProgramiv(program, GL_LINK_STATUS, &ok);
+	if (!ok) {
+		glGetProgramInfoLog(program, sizeof(log), NULL, log);
+		fprintf(stderr, "fleet view program: %s\n", log);
+		glDeleteProgram(program);
+		return 0;
+	}
+
+	return program;
+}
+
+/**
+ * viz_fleet_view_init - Kompiler shader og lag buffere
+ * @v: view som initialiseres
+ * @count: antall roboter (1..VIZ_FLEET_MAX_ROBOTS)
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_fleet_view_init(struct viz_fleet_view *v, int count)
+{
+	struct vec3 unit[VIZ_RENDER_SPHERE_VERTICES];
+	uint16_t index[VIZ_RENDER_SPHERE_INDICES];
+
+	memset(v, 0, sizeof(*v));
+	v->count = count;
+	viz_fleet_view_grid(v, VIZ_FLEET_VIEW_SPACING);
+
+	if (!has_extension("GL_ARB_instanced_arrays") ||
+	    !has_extension("GL_ARB_draw_instanced")) {
+		fprintf(stderr, "fleet view: GL_ARB_instanced_arrays and "
+				"GL_ARB_draw_instanced required\n");
+		return -1;
+	}
+
+	v->program = link_program();
+	if (!v->program)
+		return -1;
+	v->u_knee_radius = glGetUniformLocation(v->program, "u_knee_radius");
+
+	viz_render_sphere_mesh(unit, index);
+
+	glGenBuffers(1, &v->template_vbo);
+	glGenBuffers(1, &v->sphere_vbo);
+	glGenBuffers(1, &v->sphere_ibo);
+	glGenBuffers(1, &v->instance_vbo);
+
+	glBindBuffer(GL_ARRAY_BUFFER, v->template_vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(leg_template), leg_template,
+		     GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, v->sphere_vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(unit), unit, GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, v->sphere_ibo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(index), index,
+		     GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	return 0;
+}
+
+static void update_extent(struct viz_fleet_view *v)
+{
+	float d;
+	int i;
+
+	v->extent = 0.0f;
+	for (i = 0; i < v->count; i++) {
+		d = vec3_length(&v->position[i]);
+		if (d > v->extent)
+			v->extent = d;
+	}
+}
+
+/**
+ * viz_fleet_view_grid - Plasser robotene i kvadratisk grid rundt origo
+ * @v: view
+ * @spacing: avstand mellom robotene (mm)
+ */
+void viz_fleet_view_grid(struct viz_fleet_view *v, float spacing)
+{
+	int columns, rows, i;
+	float x0, z0;
+
+	columns = (int)ceilf(sqrtf((float)v->count));
+	rows = (v->count + columns - 1) / columns;
+	x0 = -(columns - 1) * 0.5f * spacing;
+	z0 = -(rows - 1) * 0.5f * spacing;
+
+	for (i = 0; i < v->count; i++) {
+		v->position[i].x = x0 + (i % columns) * spacing;
+		v->position[i].y = 0.0f;
+		v->position[i].z = z0 + (i / columns) * spacing;
+	}
+
+	update_extent(v);
+}
+
+/**
+ * viz_fleet_view_load_positions - Les posisjoner fra fil
+ * @v: view
+ * @path: fil med "x z" (mm) per linje
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_fleet_view_load_positions(struct viz_fleet_view *v, const char *path)
+{
+	char line[128];
+	float x, z;
+	int count = 0, lineno = 0;
+	FILE *f;
+
+	f = fopen(path, "r");
+	if (!f) {
+		perror(path);
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), f)) {
+		lineno++;
+		if (line[strspn(line, " \t\r\n")] == '\0' ||
+		    line[strspn(line, " \t")] == '#')
+			continue;
+
+		if (sscanf(line, "%f %f", &x, &z) != 2) {
+			fprintf(stderr, "%s:%d: expected \"x z\"\n", path,
+				lineno);
+			fclose(f);
+			return -1;
+		}
+		if (count == VIZ_FLEET_MAX_ROBOTS) {
+			fprintf(stderr, "%s: max %d robots\n", path,
+				VIZ_FLEET_MAX_ROBOTS);
+			fclose(f);
+			return -1;
+		}
+
+		v->position[count].x = x;
+		v->position[count].y = 0.0f;
+		v->position[count].z = z;
+		count++;
+	}
+	fclose(f);
+
+	if (count == 0) {
+		fprintf(stderr, "%s: no positions\n", path);
+		return -1;
+	}
+
+	v->count = count;
+	update_extent(v);
+	return 0;
+}
+
+static void copy_point(float out[3], const struct vec3 *p)
+{
+	out[0] = p->x;
+	out[1] = p->y;
+	out[2] = p->z;
+}
+
+/**
+ * viz_fleet_view_set - Oppdater én robot fra IK-resultatet
+ * @v: view
+ * @legs: instans-data, 6 per robot
+ * @robot: robot-indeks (under @v->count)
+ * @prep: geometrien IK ble kjørt med
+ * @result: IK-resultat
+ */
+void viz_fleet_view_set(const struct viz_fleet_view *v,
+			struct viz_fleet_leg *legs, int robot,
+			const struct stewart_geometry_prepared *prep,
+			const struct stewart_inverse_result *result)
+{
+	struct viz_fleet_leg *leg;
+	float min, max, t;
+	int i, next;
+
+	if (robot < 0 || robot >= v->count)
+		return;
+
+	for (i = 0; i < 6; i++) {
+		leg = &legs[robot * 6 + i];
+		next = (i + 1) % 6;
+
+		copy_point(leg->offset, &v->position[robot]);
+		copy_point(leg->base, &prep->geom.base_points[i]);
+		copy_point(leg->base_next, &prep->geom.base_points[next]);
+		copy_point(leg->knee, &result->knee_points[i]);
+		copy_point(leg->platform,
+			   &result->platform_points_transformed[i]);
+		copy_point(leg->platform_next,
+			   &result->platform_points_transformed[next]);
+
+		/* Hvor nær motoren er en av grensene */
+		min = prep->min_motor_angle_deg[i];
+		max = prep->max_motor_angle_deg[i];
+		t = max > min ? (result->motor_angles_deg[i] - min) /
+					(max - min) :
+				0.5f;
+		leg->motor_load = fminf(fabsf(2.0f * t - 1.0f), 1.0f);
+		leg->error = result->error ? 1.0f : 0.0f;
+	}
+}
+
+static void set_instance_attribute(int attr, int size, size_t offset)
+{
+	glVertexAttribPointer(attr, size, GL_FLOAT, GL_FALSE,
+			      sizeof(struct viz_fleet_leg),
+			      (const void *)offset);
+	glVertexAttribDivisorARB(attr, 1);
+	glEnableVertexAttribArray(attr);
+}
+
+/**
+ * viz_fleet_view_draw - Last opp nye instanser og tegn flåten
+ * @v: view
+ * @legs: nye instans-data, NULL hvis uendret siden sist
+ */
+void viz_fleet_view_draw(struct viz_fleet_view *v,
+			 const struct viz_fleet_leg *legs)
+{
+	GLsizei instances = v->count * 6;
+	int i;
+
+	glUseProgram(v->program);
+
+	/* Én opplasting for hele flåten, bare når noe er endret */
+	glBindBuffer(GL_ARRAY_BUFFER, v->instance_vbo);
+	if (legs)
+		glBufferData(GL_ARRAY_BUFFER,
+			     instances * sizeof(struct viz_fleet_leg), legs,
+			     GL_STREAM_DRAW);
+	set_instance_attribute(ATTR_OFFSET, 3,
+			       offsetof(struct viz_fleet_leg, offset));
+	set_instance_attribute(ATTR_BASE, 3,
+			       offsetof(struct viz_fleet_leg, base));
+	set_instance_attribute(ATTR_BASE_NEXT, 3,
+			       offsetof(struct viz_fleet_leg, base_next));
+	set_instance_attribute(ATTR_KNEE, 3,
+			       offsetof(struct viz_fleet_leg, knee));
+	set_instance_attribute(ATTR_PLATFORM, 3,
+			       offsetof(struct viz_fleet_leg, platform));
+	set_instance_attribute(ATTR_PLATFORM_NEXT, 3,
+			       offsetof(struct viz_fleet_leg, platform_next));
+	set_instance_attribute(ATTR_STATE, 2,
+			       offsetof(struct viz_fleet_leg, motor_load));
+	glEnableVertexAttribArray(ATTR_VERTEX);
+
+	/* Linjer: 8 vertices per ben */
+	glBindBuffer(GL_ARRAY_BUFFER, v->template_vbo);
+	glVertexAttribPointer(ATTR_VERTEX, 2, GL_FLOAT, GL_FALSE, 0, NULL);
+	glUniform1f(v->u_knee_radius, 0.0f);
+	glLineWidth(2.0f);
+	glDrawArraysInstancedARB(GL_LINES, 0,
+				 sizeof(leg_template) / sizeof(leg_template[0]),
+				 instances);
+
+	/* Knær: én kule per ben */
+	glBindBuffer(GL_ARRAY_BUFFER, v->sphere_vbo);
+	glVertexAttribPointer(ATTR_VERTEX, 3, GL_FLOAT, GL_FALSE, 0, NULL);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, v->sphere_ibo);
+	glUniform1f(v->u_knee_radius, VIZ_FLEET_VIEW_KNEE_RADIUS);
+	glDrawElementsInstancedARB(GL_TRIANGLES, VIZ_RENDER_SPHERE_INDICES,
+				   GL_UNSIGNED_SHORT, NULL, instances);
+
+	/* Uten VAO er attributt-state global; la den være som vi fant den */
+	for (i = 0; i < ATTR_COUNT; i++) {
+		glVertexAttribDivisorARB(i, 0);
+		glDisableVertexAttribArray(i);
+	}
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glUseProgram(0);
+}
+
+/**
+ * viz_fleet_view_destroy - Frigjør shader og buffere
+ * @v: view
+ */
+void viz_fleet_view_destroy(struct viz_fleet_view *v)
+{
+	if (v->program)
+		glDeleteProgram(v->program);
+	if (v->template_vbo)
+		glDeleteBuffers(1, &v->template_vbo);
+	if (v->sphere_vbo)
+		glDeleteBuffers(1, &v->sphere_vbo);
+	if (v->sphere_ibo)
+		glDeleteBuffers(1, &v->sphere_ibo);
+	if (v->instance_vbo)
+		glDeleteBuffers(1, &v->instance_vbo);
+	v->program = 0;
+	v->template_vbo = v->sphere_vbo = v->sphere_ibo = v->instance_vbo = 0;
+}
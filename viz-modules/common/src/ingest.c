@@ -0,0 +1,157 @@
+#define _DEFAULT_SOURCE
+#include "ingest.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * viz_wake_init - Lag non-blocking vekke-pipe
+ * @w: vekker som initialiseres
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_wake_init(struct viz_wake *w)
+{
+	if (pipe(w->pipe) < 0) {
+		perror("pipe");
+		return -1;
+	}
+	fcntl(w->pipe[0], F_SETFL, O_NONBLOCK);
+	fcntl(w->pipe[1], F_SETFL, O_NONBLOCK);
+	return 0;
+}
+
+/**
+ * viz_wake_signal - Vekk tråden
+ * @w: vekker
+ *
+ * Bare write() på en non-blocking pipe; er den full, er tråden allerede
+ * vekket.
+ */
+void viz_wake_signal(struct viz_wake *w)
+{
+	int saved = errno;
+
+	if (write(w->pipe[1], "", 1) < 0) {
+		/* EAGAIN: full pipe, tråden vekkes uansett */
+	}
+	errno = saved;
+}
+
+/**
+ * viz_wake_drain - Tøm pipen etter at tråden er vekket
+ * @w: vekker
+ */
+void viz_wake_drain(struct viz_wake *w)
+{
+	char buf[16];
+
+	while (read(w->pipe[0], buf, sizeof(buf)) > 0)
+		;
+}
+
+/**
+ * viz_wake_close - Lukk pipen
+ * @w: vekker
+ */
+void viz_wake_close(struct viz_wake *w)
+{
+	close(w->pipe[0]);
+	close(w->pipe[1]);
+}
+
+static void *ingest_thread(void *arg)
+{
+	struct viz_ingest *in = arg;
+	struct pollfd fds[2];
+	int n = 0, timeout_ms = -1;
+
+	fds[n].fd = in->wake.pipe[0];
+	fds[n++].events = POLLIN;
+	if (in->fd >= 0) {
+		fds[n].fd = in->fd;
+		fds[n++].events = POLLIN;
+	} else {
+		timeout_ms = VIZ_INGEST_SHM_POLL_MS;
+	}
+
+	in->step(in->ctx);
+
+	while (atomic_load_explicit(&in->running, memory_order_acquire)) {
+		if (poll(fds, n, timeout_ms) < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("ingest poll");
+			break;
+		}
+
+		if (fds[0].revents & POLLIN)
+			viz_wake_drain(&in->wake);
+		if (!atomic_load_explicit(&in->running, memory_order_acquire))
+			break;
+
+		in->step(in->ctx);
+	}
+
+	return NULL;
+}
+
+/**
+ * viz_ingest_start - Start ingest-tråd
+ * @in: ingest som initialiseres
+ * @fd: fd som blir lesbar ved nye data (viz_transport_fd()), eller -1
+ * @step: callback
+ * @ctx: argument til @step
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_ingest_start(struct viz_ingest *in, int fd, viz_ingest_step step,
+		     void *ctx)
+{
+	int err;
+
+	memset(in, 0, sizeof(*in));
+	in->fd = fd;
+	in->step = step;
+	in->ctx = ctx;
+
+	if (viz_wake_init(&in->wake) < 0)
+		return -1;
+
+	atomic_store_explicit(&in->running, 1, memory_order_release);
+	err = pthread_create(&in->thread, NULL, ingest_thread, in);
+	if (err) {
+		fprintf(stderr, "pthread_create: %s\n", strerror(err));
+		atomic_store(&in->running, 0);
+		viz_wake_close(&in->wake);
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * viz_ingest_wake - Få tråden til å kalle @step snarest
+ * @in: ingest
+ */
+void viz_ingest_wake(struct viz_ingest *in)
+{
+	viz_wake_signal(&in->wake);
+}
+
+/**
+ * viz_ingest_stop - Stopp tråden og vent på den
+ * @in: ingest
+ */
+void viz_ingest_stop(struct viz_ingest *in)
+{
+	if (!atomic_exchange(&in->running, 0))
+		return;
+
+	viz_ingest_wake(in);
+	pthread_join(in->thread, NULL);
+	viz_wake_close(&in->wake);
+}
@@ -0,0 +1,174 @@
+#define _DEFAULT_SOURCE
+#include "pose_estimator.h"
+#include <string.h>
+
+/**
+ * viz_pose_estimator_init - Start uten samples
+ * @e: estimator
+ * @max_extrapolate_ms: lengste ekstrapolering, 0 for bare interpolering
+ * @delay_ms: hvor langt bak strømmen tegnes, 0 for ren ekstrapolering
+ */
+void viz_pose_estimator_init(struct viz_pose_estimator *e,
+			     float max_extrapolate_ms, float delay_ms)
+{
+	memset(e, 0, sizeof(*e));
+	if (max_extrapolate_ms > 0.0f)
+		e->max_extrapolate_ns = (uint64_t)(max_extrapolate_ms * 1e6);
+	if (delay_ms > 0.0f)
+		e->delay_ns = (uint64_t)(delay_ms * 1e6);
+}
+
+/**
+ * viz_pose_estimator_reset - Glem samplene
+ * @e: estimator
+ */
+void viz_pose_estimator_reset(struct viz_pose_estimator *e)
+{
+	e->samples = 0;
+	e->window_start_ns = 0;
+}
+
+/* Minste (mottak - sending) over to vinduer; gamle minima roteres ut */
+static void update_offset(struct viz_pose_estimator *e, int64_t offset,
+			  uint64_t recv_time_ns)
+{
+	if (!e->window_start_ns ||
+	    recv_time_ns - e->window_start_ns >= VIZ_POSE_ESTIMATOR_WINDOW_NS) {
+		e->offset_min[1] = e->window_start_ns ? e->offset_min[0] :
+							offset;
+		e->offset_min[0] = offset;
+		e->window_start_ns = recv_time_ns;
+		return;
+	}
+
+	if (offset < e->offset_min[0])
+		e->offset_min[0] = offset;
+}
+
+/* Avviker (mottak - sending) fra kjent offset med mer enn et hull? */
+static int offset_jumped(const struct viz_pose_estimator *e, int64_t offset)
+{
+	int64_t min, diff;
+
+	if (!e->window_start_ns)
+		return 0;
+
+	min = e->offset_min[0] < e->offset_min[1] ? e->offset_min[0] :
+						    e->offset_min[1];
+	diff = offset > min ? offset - min : min - offset;
+	return (uint64_t)diff > VIZ_POSE_ESTIMATOR_MAX_GAP_NS;
+}
+
+/**
+ * viz_pose_estimator_push - Legg til mottatt pose
+ * @e: estimator
+ * @pose: pose
+ * @send_time_ns: sende-tidsstempel, 0 hvis pakken ikke har det (v1)
+ * @recv_time_ns: viz_time_ns() ved mottak
+ *
+ * Bytter strømmen mellom v1 og v2+, startes det på nytt, siden tidene
+ * da er på forskjellige klokker. Det samme skjer når senderens klokke
+ * hopper (ny CLOCK_MONOTONIC etter omstart av senderen): tiden går mer
+ * enn VIZ_POSE_ESTIMATOR_MAX_GAP_NS bakover, eller offset endrer seg
+ * like mye. Ellers ville alt etterpå blitt forkastet som reordering.
+ */
+void viz_pose_estimator_push(struct viz_pose_estimator *e,
+			     const struct viz_pose_packet *pose,
+			     uint64_t send_time_ns, uint64_t recv_time_ns)
+{
+	int timestamped = send_time_ns != 0;
+	uint64_t t = timestamped ? send_time_ns : recv_time_ns;
+	int64_t offset = (int64_t)(recv_time_ns - send_time_ns);
+
+	if (timestamped != e->timestamped) {
+		viz_pose_estimator_reset(e);
+		e->timestamped = timestamped;
+	}
+
+	if (e->samples && (t + VIZ_POSE_ESTIMATOR_MAX_GAP_NS < e->last_ns ||
+			   (timestamped && offset_jumped(e, offset))))
+		viz_pose_estimator_reset(e); /* Klokken hoppet */
+
+	if (timestamped)
+		update_offset(e, offset, recv_time_ns);
+
+	if (e->samples && t <= e->last_ns)
+		return; /* Reordering eller duplikat */
+
+	if (e->samples) {
+		e->prev = e->last;
+		e->prev_ns = e->last_ns;
+	}
+	e->last = *pose;
+	e->last_ns = t;
+	if (e->samples < 2)
+		e->samples++;
+}
+
+/* Like pose-felter; header og robot_type sammenlignes ikke */
+static int same_pose(const struct viz_pose_packet *a,
+		     const struct viz_pose_packet *b)
+{
+	return a->rx == b->rx && a->ry == b->ry && a->rz == b->rz &&
+	       a->tx == b->tx && a->ty == b->ty && a->tz == b->tz;
+}
+
+/**
+ * viz_pose_estimator_predict - Pose ved render-tidspunktet
+ * @e: estimator
+ * @now_ns: viz_time_ns() for framen
+ * @pose: output - estimert pose (uendret uten samples)
+ *
+ * Uten fart (ett sample, lang pause, ny robot_type, samme pose to
+ * ganger) vises siste sample som det er.
+ *
+ * Retur: 1 hvis posen fortsatt endrer seg (tegn neste frame også),
+ *        0 hvis den står stille til neste sample
+ */
+int viz_pose_estimator_predict(struct viz_pose_estimator *e, uint64_t now_ns,
+			       struct viz_pose_packet *pose)
+{
+	const struct viz_pose_packet *a = &e->prev, *b = &e->last;
+	uint64_t dt = e->last_ns - e->prev_ns;
+	int64_t target, ahead, offset = 0;
+	double u;
+	int moving = 1;
+
+	if (!e->samples)
+		return 0;
+
+	*pose = *b;
+	if (e->samples < 2 || dt > VIZ_POSE_ESTIMATOR_MAX_GAP_NS ||
+	    a->robot_type != b->robot_type || same_pose(a, b))
+		return 0;
+
+	if (e->timestamped)
+		offset = e->offset_min[0] < e->offset_min[1] ?
+				 e->offset_min[0] : e->offset_min[1];
+	target = (int64_t)(now_ns - e->delay_ns) - offset;
+
+	/* Posisjon langs linjen prev -> last: 0 = prev, 1 = last */
+	ahead = target - (int64_t)e->last_ns;
+	if (ahead > 0) {
+		e->extrapolated++;
+		if ((uint64_t)ahead >= e->max_extrapolate_ns) {
+			ahead = (int64_t)e->max_extrapolate_ns;
+			e->capped++;
+			moving = 0;
+		}
+		u = 1.0 + (double)ahead / (double)dt;
+	} else if (target > (int64_t)e->prev_ns) {
+		u = (double)(target - (int64_t)e->prev_ns) / (double)dt;
+	} else {
+		u = 0.0;
+	}
+
+	pose->rx = a->rx + (float)u * (b->rx - a->rx);
+	pose->ry = a->ry + (float)u * (b->ry - a->ry);
+	pose->rz = a->rz + (float)u * (b->rz - a->rz);
+	pose->tx = a->tx + (float)u * (b->tx - a->tx);
+	pose->ty = a->ty + (float)u * (b->ty - a->ty);
+	pose->tz = a->tz + (float)u * (b->tz - a->tz);
+
+	return moving;
+}
@@ -0,0 +1,262 @@
+#define _DEFAULT_SOURCE
+#include "recording.h"
+#include <string.h>
+
+/**
+ * viz_recorder_open - Start opptak
+ * @rec: opptak som initialiseres
+ * @path: filsti (overskrives)
+ * @names: navn per strøm, kuttes til VIZ_RECORDING_NAME_MAX - 1 tegn
+ * @streams: antall strømmer (1..VIZ_RECORDING_MAX_STREAMS)
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_recorder_open(struct viz_recorder *rec, const char *path,
+		      const char *const *names, int streams)
+{
+	struct viz_recording_header header = {
+		.magic = VIZ_RECORDING_MAGIC,
+		.version = VIZ_RECORDING_VERSION,
+	};
+	char name[VIZ_RECORDING_NAME_MAX];
+	int i;
+
+	memset(rec, 0, sizeof(*rec));
+	if (streams < 1 || streams > VIZ_RECORDING_MAX_STREAMS) {
+		fprintf(stderr, "recording: invalid stream count %d\n",
+			streams);
+		return -1;
+	}
+
+	rec->file = fopen(path, "wb");
+	if (!rec->file) {
+		perror(path);
+		return -1;
+	}
+
+	rec->start_time_ns = viz_time_ns();
+	header.streams = (uint16_t)streams;
+	header.start_time_ns = rec->start_time_ns;
+	if (fwrite(&header, sizeof(header), 1, rec->file) != 1)
+		goto err;
+
+	for (i = 0; i < streams; i++) {
+		memset(name, 0, sizeof(name));
+		strncpy(name, names[i], sizeof(name) - 1);
+		if (fwrite(name, sizeof(name), 1, rec->file) != 1)
+			goto err;
+	}
+
+	return 0;
+
+err:
+	perror(path);
+	fclose(rec->file);
+	rec->file = NULL;
+	return -1;
+}
+
+/**
+ * viz_recorder_write - Skriv én mottatt pose
+ * @rec: opptak
+ * @stream: strøm-indeks
+ * @pose: pose
+ * @info: metadata fra dekodingen
+ * @recv_time_ns: viz_time_ns() ved mottak
+ *
+ * Etter en skrivefeil meldes feilen én gang og resten forkastes, så
+ * mottaket fortsetter om disken blir full.
+ */
+void viz_recorder_write(struct viz_recorder *rec, int stream,
+			const struct viz_pose_packet *pose,
+			const struct viz_packet_info *info,
+			uint64_t recv_time_ns)
+{
+	struct viz_recording_record r = {
+		.recv_offset_ns = recv_time_ns - rec->start_time_ns,
+		.send_time_ns = info->version < 2 ? 0 : info->send_time_ns,
+		.stream = (uint16_t)stream,
+		.robot_type = (uint16_t)pose->robot_type,
+		.rx = pose->rx,
+		.ry = pose->ry,
+		.rz = pose->rz,
+		.tx = pose->tx,
+		.ty = pose->ty,
+		.tz = pose->tz,
+	};
+
+	if (rec->failed)
+		return;
+
+	if (fwrite(&r, sizeof(r), 1, rec->file) != 1) {
+		perror("recording");
+		rec->failed = 1;
+		return;
+	}
+	rec->records++;
+}
+
+/**
+ * viz_recorder_close - Skriv ut bufferen og lukk filen
+ * @rec: opptak
+ *
+ * Retur: 0 ved suksess, -1 hvis noe ikke ble skrevet
+ */
+int viz_recorder_close(struct viz_recorder *rec)
+{
+	int ret = rec->failed ? -1 : 0;
+
+	if (!rec->file)
+		return ret;
+
+	if (fclose(rec->file) != 0) {
+		perror("recording");
+		ret = -1;
+	}
+	rec->file = NULL;
+	return ret;
+}
+
+/**
+ * viz_replay_open - Åpne opptak for avspilling
+ * @r: avspilling som initialiseres
+ * @path: filsti
+ * @speed: tempo, 1 = som opptaket, 10 = ti ganger så fort, 0 = så fort
+ *	   som mulig
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_replay_open(struct viz_replay *r, const char *path, float speed)
+{
+	struct viz_recording_header header;
+	int i;
+
+	memset(r, 0, sizeof(*r));
+	r->speed = speed > 0.0f ? speed : 0.0f;
+
+	r->file = fopen(path, "rb");
+	if (!r->file) {
+		perror(path);
+		return -1;
+	}
+
+	if (fread(&header, sizeof(header), 1, r->file) != 1 ||
+	    header.magic != VIZ_RECORDING_MAGIC) {
+		fprintf(stderr, "%s: not a pose recording\n", path);
+		goto err;
+	}
+	if (header.version != VIZ_RECORDING_VERSION) {
+		fprintf(stderr, "%s: unsupported recording version %u\n", path,
+			header.version);
+		goto err;
+	}
+	if (header.streams < 1 || header.streams > VIZ_RECORDING_MAX_STREAMS) {
+		fprintf(stderr, "%s: invalid stream count %u\n", path,
+			header.streams);
+		goto err;
+	}
+
+	r->streams = header.streams;
+	r->start_time_ns = header.start_time_ns;
+	for (i = 0; i < r->streams; i++) {
+		if (fread(r->names[i], sizeof(r->names[i]), 1, r->file) != 1) {
+			fprintf(stderr, "%s: truncated header\n", path);
+			goto err;
+		}
+		r->names[i][VIZ_RECORDING_NAME_MAX - 1] = '\0';
+	}
+
+	return 0;
+
+err:
+	fclose(r->file);
+	r->file = NULL;
+	return -1;
+}
+
+/* Tid i opptakets klokke flyttet til avspillingens, delt på tempoet */
+static uint64_t replay_time(const struct viz_replay *r, uint64_t t)
+{
+	int64_t since = (int64_t)(t - r->first_recv_ns);
+
+	return r->replay_start_ns + (int64_t)((double)since / r->speed);
+}
+
+/**
+ * viz_replay_next - Les neste pose
+ * @r: avspilling
+ * @stream: output - strøm-indeks (< @r->streams)
+ * @pose: output - pose i v1-layout
+ * @send_time_ns: output - sende-tidsstempel, 0 for v1 og med speed 0
+ * @recv_time_ns: output - når posen skal regnes som mottatt
+ *
+ * Sende-tidsstempelet er på senderens klokke; det flyttes med samme
+ * avstand som mottakstiden, så klokke-offset og latency beholdes (delt
+ * på tempoet).
+ *
+ * Retur: 1 ved pose, 0 ved slutten av opptaket, -1 ved feil
+ */
+int viz_replay_next(struct viz_replay *r, int *stream,
+		    struct viz_pose_packet *pose, uint64_t *send_time_ns,
+		    uint64_t *recv_time_ns)
+{
+	struct viz_recording_record rec;
+	uint64_t recv;
+
+	if (fread(&rec, sizeof(rec), 1, r->file) != 1) {
+		if (ferror(r->file)) {
+			perror("replay");
+			return -1;
+		}
+		return 0; /* Slutt, eller avbrutt midt i siste record */
+	}
+
+	if (rec.stream >= r->streams) {
+		fprintf(stderr, "replay: record %llu has invalid stream %u\n",
+			(unsigned long long)r->records, rec.stream);
+		return -1;
+	}
+
+	recv = r->start_time_ns + rec.recv_offset_ns;
+	if (!r->records) {
+		r->first_recv_ns = recv;
+		r->replay_start_ns = viz_time_ns();
+	}
+	r->records++;
+
+	*stream = rec.stream;
+	memset(pose, 0, sizeof(*pose));
+	pose->magic = VIZ_MAGIC;
+	pose->type = VIZ_PACKET_POSE;
+	pose->robot_type = rec.robot_type;
+	pose->rx = rec.rx;
+	pose->ry = rec.ry;
+	pose->rz = rec.rz;
+	pose->tx = rec.tx;
+	pose->ty = rec.ty;
+	pose->tz = rec.tz;
+
+	if (r->speed <= 0.0f) {
+		*send_time_ns = 0;
+		*recv_time_ns = viz_time_ns();
+		return 1;
+	}
+
+	*recv_time_ns = replay_time(r, recv);
+	*send_time_ns = rec.send_time_ns ? replay_time(r, rec.send_time_ns) :
+					   0;
+	if (rec.send_time_ns && !*send_time_ns)
+		*send_time_ns = 1; /* 0 betyr "uten tidsstempel" */
+	return 1;
+}
+
+/**
+ * viz_replay_close - Lukk opptaket
+ * @r: avspilling
+ */
+void viz_replay_close(struct viz_replay *r)
+{
+	if (r->file)
+		fclose(r->file);
+	r->file = NULL;
+}
@@ -0,0 +1,489 @@
+#define _DEFAULT_SOURCE
+#include "render.h"
+#include "viz_gl.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define CYLINDER_VERTICES (2 * (VIZ_RENDER_CYLINDER_SLICES + 1) + 2)
+#define CYLINDER_INDICES (VIZ_RENDER_CYLINDER_SLICES * 12)
+
+/* Index bufferne er GLushort */
+_Static_assert(VIZ_RENDER_MAX_SPHERES * VIZ_RENDER_SPHERE_VERTICES <=
+		       65536,
+	       "sphere indices must fit in 16 bits");
+_Static_assert(VIZ_RENDER_MAX_CYLINDERS * CYLINDER_VERTICES <= 65536,
+	       "cylinder indices must fit in 16 bits");
+
+/**
+ * viz_render_sphere_mesh - Tessellér enhetskule
+ * @unit: output - VIZ_RENDER_SPHERE_VERTICES posisjoner (radius 1)
+ * @index: output - VIZ_RENDER_SPHERE_INDICES indekser (GL_TRIANGLES)
+ *
+ * Stacks fra pol til pol.
+ */
+void viz_render_sphere_mesh(struct vec3 *unit, uint16_t *index)
+{
+	const int row = VIZ_RENDER_SPHERE_SLICES + 1;
+	float phi, theta;
+	int i, j, a, n = 0;
+
+	for (i = 0; i <= VIZ_RENDER_SPHERE_STACKS; i++) {
+		phi = M_PI * i / VIZ_RENDER_SPHERE_STACKS;
+		for (j = 0; j <= VIZ_RENDER_SPHERE_SLICES; j++) {
+			theta = 2.0 * M_PI * j / VIZ_RENDER_SPHERE_SLICES;
+			unit[i * row + j].x = sinf(phi) * cosf(theta);
+			unit[i * row + j].y = cosf(phi);
+			unit[i * row + j].z = sinf(phi) * sinf(theta);
+		}
+	}
+
+	for (i = 0; i < VIZ_RENDER_SPHERE_STACKS; i++) {
+		for (j = 0; j < VIZ_RENDER_SPHERE_SLICES; j++) {
+			a = i * row + j;
+			index[n++] = a;
+			index[n++] = a + row;
+			index[n++] = a + 1;
+			index[n++] = a + 1;
+			index[n++] = a + row;
+			index[n++] = a + row + 1;
+		}
+	}
+}
+
+/*
+ * Sylinder med radius 1 langs y fra 0 til 1, med lokk. Bunn og topp
+ * ligger annenhver i vertex-listen, sentrene for lokkene sist.
+ */
+static void tessellate_cylinder(struct vec3 *unit, uint16_t *index)
+{
+	const int bottom_center = 2 * (VIZ_RENDER_CYLINDER_SLICES + 1);
+	const int top_center = bottom_center + 1;
+	float theta;
+	int j, a, n = 0;
+
+	for (j = 0; j <= VIZ_RENDER_CYLINDER_SLICES; j++) {
+		theta = 2.0 * M_PI * j / VIZ_RENDER_CYLINDER_SLICES;
+		unit[2 * j].x = unit[2 * j + 1].x = cosf(theta);
+		unit[2 * j].z = unit[2 * j + 1].z = sinf(theta);
+		unit[2 * j].y = 0.0f;
+		unit[2 * j + 1].y = 1.0f;
+	}
+	unit[bottom_center] = (struct vec3){ 0.0f, 0.0f, 0.0f };
+	unit[top_center] = (struct vec3){ 0.0f, 1.0f, 0.0f };
+
+	for (j = 0; j < VIZ_RENDER_CYLINDER_SLICES; j++) {
+		a = 2 * j;
+		index[n++] = a;
+		index[n++] = a + 1;
+		index[n++] = a + 2;
+		index[n++] = a + 2;
+		index[n++] = a + 1;
+		index[n++] = a + 3;
+
+		index[n++] = bottom_center;
+		index[n++] = a;
+		index[n++] = a + 2;
+		index[n++] = top_center;
+		index[n++] = a + 3;
+		index[n++] = a + 1;
+	}
+}
+
+static void mesh_destroy(struct viz_mesh *m)
+{
+	if (m->vbo)
+		glDeleteBuffers(1, &m->vbo);
+	if (m->ibo)
+		glDeleteBuffers(1, &m->ibo);
+	free(m->unit);
+	free(m->vertices);
+	memset(m, 0, sizeof(*m));
+}
+
+/* Tessellér og last opp topologi for @max_instances. Retur: 0 eller -1 */
+static int mesh_init(struct viz_mesh *m, int vertex_count, int index_count,
+		     int max_instances,
+		     void (*tessellate)(struct vec3 *, uint16_t *))
+{
+	uint16_t *index;
+	int i, k;
+
+	memset(m, 0, sizeof(*m));
+	m->vertex_count = vertex_count;
+	m->index_count = index_count;
+	m->max_instances = max_instances;
+
+	m->unit = malloc((size_t)vertex_count * sizeof(*m->unit));
+	m->vertices = malloc((size_t)max_instances * vertex_count *
+			     sizeof(*m->vertices));
+	index = malloc((size_t)max_instances * index_count * sizeof(*index));
+	if (!m->unit || !m->vertices || !index) {
+		fprintf(stderr, "render: out of memory\n");
+		free(index);
+		mesh_destroy(m);
+		return -1;
+	}
+
+	tessellate(m->unit, index);
+
+	/* Samme topologi for hver instans, forskjøvet til dens vertices */
+	for (k = 1; k < max_instances; k++) {
+		for (i = 0; i < index_count; i++)
+			index[k * index_count + i] =
+				index[i] + k * vertex_count;
+	}
+
+	glGenBuffers(1, &m->vbo);
+	glGenBuffers(1, &m->ibo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m->ibo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+		     (GLsizeiptr)max_instances * index_count * sizeof(*index),
+		     index, GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	free(index);
+
+	return 0;
+}
+
+/**
+ * viz_render_init - Tessellér meshene og lag GL-buffere
+ * @r: renderer som initialiseres
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_render_init(struct viz_renderer *r)
+{
+	memset(r, 0, sizeof(*r));
+	r->color[0] = r->color[1] = r->color[2] = r->color[3] = 255;
+
+	if (mesh_init(&r->sphere, VIZ_RENDER_SPHERE_VERTICES,
+		      VIZ_RENDER_SPHERE_INDICES, VIZ_RENDER_MAX_SPHERES,
+		      viz_render_sphere_mesh) < 0)
+		return -1;
+	if (mesh_init(&r->cylinder, CYLINDER_VERTICES, CYLINDER_INDICES,
+		      VIZ_RENDER_MAX_CYLINDERS, tessellate_cylinder) < 0) {
+		mesh_destroy(&r->sphere);
+		return -1;
+	}
+
+	glGenBuffers(1, &r->line_vbo);
+
+	return 0;
+}
+
+static uint8_t color_byte(float c)
+{
+	if (c <= 0.0f)
+		return 0;
+	if (c >= 1.0f)
+		return 255;
+	return (uint8_t)(c * 255.0f + 0.5f);
+}
+
+/**
+ * viz_render_color - Sett farge for primitiver som legges til etterpå
+ * @r: renderer
+ * @red, @green, @blue: farge (0-1)
+ */
+void viz_render_color(struct viz_renderer *r, float red, float green,
+		      float blue)
+{
+	r->color[0] = color_byte(red);
+	r->color[1] = color_byte(green);
+	r->color[2] = color_byte(blue);
+}
+
+/**
+ * viz_render_line_width - Velg linjebredde for viz_render_line*()
+ * @r: renderer
+ * @width: bredde i piksler
+ */
+void viz_render_line_width(struct viz_renderer *r, float width)
+{
+	int i;
+
+	for (i = 0; i < r->line_batches; i++) {
+		if (r->lines[i].width == width) {
+			r->line = &r->lines[i];
+			return;
+		}
+	}
+
+	if (r->line_batches == VIZ_RENDER_LINE_WIDTHS) {
+		r->line = &r->lines[VIZ_RENDER_LINE_WIDTHS - 1];
+		return;
+	}
+
+	r->line = &r->lines[r->line_batches++];
+	r->line->width = width;
+	r->line->count = 0;
+}
+
+static void set_vertex(struct viz_vertex *v, const uint8_t color[4], float x,
+		       float y, float z)
+{
+	v->x = x;
+	v->y = y;
+	v->z = z;
+	memcpy(v->rgba, color, sizeof(v->rgba));
+}
+
+/**
+ * viz_render_line - Legg til linjesegment
+ * @r: renderer
+ * @a: startpunkt
+ * @b: sluttpunkt
+ */
+void viz_render_line(struct viz_renderer *r, const struct vec3 *a,
+		     const struct vec3 *b)
+{
+	struct viz_line_batch *batch;
+
+	if (!r->line)
+		viz_render_line_width(r, 1.0f);
+	batch = r->line;
+
+	if (batch->count + 2 > VIZ_RENDER_LINE_VERTICES) {
+		r->stats.dropped++;
+		return;
+	}
+
+	set_vertex(&batch->vertices[batch->count++], r->color, a->x, a->y,
+		   a->z);
+	set_vertex(&batch->vertices[batch->count++], r->color, b->x, b->y,
+		   b->z);
+}
+
+/**
+ * viz_render_line_loop - Legg til lukket polygon (som GL_LINE_LOOP)
+ * @r: renderer
+ * @points: hjørner
+ * @count: antall hjørner
+ */
+void viz_render_line_loop(struct viz_renderer *r, const struct vec3 *points,
+			  int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+		viz_render_line(r, &points[i], &points[(i + 1) % count]);
+}
+
+/**
+ * viz_render_axes - Legg til koordinatsystemet i origo
+ * @r: renderer
+ * @length: lengde på hver akse
+ * @width: linjebredde
+ */
+void viz_render_axes(struct viz_renderer *r, float length, float width)
+{
+	const struct vec3 origin = { 0.0f, 0.0f, 0.0f };
+	const struct vec3 axis_x = { length, 0.0f, 0.0f };
+	const struct vec3 axis_y = { 0.0f, length, 0.0f };
+	const struct vec3 axis_z = { 0.0f, 0.0f, length };
+
+	viz_render_line_width(r, width);
+	viz_render_color(r, 1.0f, 0.0f, 0.0f); /* X-akse (rød) */
+	viz_render_line(r, &origin, &axis_x);
+	viz_render_color(r, 0.0f, 1.0f, 0.0f); /* Y-akse (grønn) */
+	viz_render_line(r, &origin, &axis_y);
+	viz_render_color(r, 0.0f, 0.0f, 1.0f); /* Z-akse (blå) */
+	viz_render_line(r, &origin, &axis_z);
+}
+
+/* Reserver neste instans i @m. Retur: dens vertices, NULL hvis full */
+static struct viz_vertex *mesh_instance(struct viz_renderer *r,
+					struct viz_mesh *m)
+{
+	if (m->instances == m->max_instances) {
+		r->stats.dropped++;
+		return NULL;
+	}
+
+	return &m->vertices[(size_t)m->instances++ * m->vertex_count];
+}
+
+/**
+ * viz_render_sphere - Legg til kule
+ * @r: renderer
+ * @center: senterpunkt
+ * @radius: radius
+ */
+void viz_render_sphere(struct viz_renderer *r, const struct vec3 *center,
+		       float radius)
+{
+	const struct vec3 *u = r->sphere.unit;
+	struct viz_vertex *v;
+	int i;
+
+	v = mesh_instance(r, &r->sphere);
+	if (!v)
+		return;
+
+	for (i = 0; i < r->sphere.vertex_count; i++)
+		set_vertex(&v[i], r->color, center->x + u[i].x * radius,
+			   center->y + u[i].y * radius,
+			   center->z + u[i].z * radius);
+}
+
+/**
+ * viz_render_cylinder - Legg til sylinder mellom to punkter
+ * @r: renderer
+ * @a: senter i den ene enden
+ * @b: senter i den andre enden
+ * @radius: radius
+ */
+void viz_render_cylinder(struct viz_renderer *r, const struct vec3 *a,
+			 const struct vec3 *b, float radius)
+{
+	const struct vec3 *u = r->cylinder.unit;
+	struct vec3 axis, dir, side, up;
+	struct viz_vertex *v;
+	float length;
+	int i;
+
+	vec3_sub(b, a, &axis);
+	length = vec3_length(&axis);
+	if (length < 1e-6f)
+		return;
+
+	/* Ortonormal basis (side, dir, up) med dir langs sylinderen */
+	dir = axis;
+	vec3_scale(&dir, 1.0f / length);
+	up = fabsf(dir.y) < 0.9f ? (struct vec3){ 0.0f, 1.0f, 0.0f } :
+				   (struct vec3){ 1.0f, 0.0f, 0.0f };
+	vec3_cross(&dir, &up, &side);
+	vec3_normalize(&side);
+	vec3_cross(&side, &dir, &up);
+
+	v = mesh_instance(r, &r->cylinder);
+	if (!v)
+		return;
+
+	for (i = 0; i < r->cylinder.vertex_count; i++) {
+		float sx = u[i].x * radius, sz = u[i].z * radius;
+
+		set_vertex(&v[i], r->color,
+			   a->x + axis.x * u[i].y + side.x * sx + up.x * sz,
+			   a->y + axis.y * u[i].y + side.y * sx + up.y * sz,
+			   a->z + axis.z * u[i].y + side.z * sx + up.z * sz);
+	}
+}
+
+static void set_vertex_pointers(void)
+{
+	glVertexPointer(3, GL_FLOAT, sizeof(struct viz_vertex),
+			(const void *)offsetof(struct viz_vertex, x));
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(struct viz_vertex),
+		       (const void *)offsetof(struct viz_vertex, rgba));
+}
+
+static void mesh_flush(struct viz_renderer *r, struct viz_mesh *m)
+{
+	size_t count = (size_t)m->instances * m->vertex_count;
+
+	if (!m->instances)
+		return;
+
+	/* Ny glBufferData hver frame: driveren bytter buffer, ingen stall */
+	glBindBuffer(GL_ARRAY_BUFFER, m->vbo);
+	glBufferData(GL_ARRAY_BUFFER, count * sizeof(*m->vertices),
+		     m->vertices, GL_STREAM_DRAW);
+	set_vertex_pointers();
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m->ibo);
+	glDrawElements(GL_TRIANGLES, m->instances * m->index_count,
+		       GL_UNSIGNED_SHORT, NULL);
+
+	r->stats.draw_calls++;
+	r->stats.vertices += count;
+	m->instances = 0;
+}
+
+static void lines_flush(struct viz_renderer *r)
+{
+	struct viz_line_batch *batch;
+	size_t total = 0, first = 0;
+	int i;
+
+	for (i = 0; i < r->line_batches; i++)
+		total += r->lines[i].count;
+	if (!total)
+		goto out;
+
+	/* Alle bredder i én buffer, lastet opp etter hverandre */
+	glBindBuffer(GL_ARRAY_BUFFER, r->line_vbo);
+	glBufferData(GL_ARRAY_BUFFER, total * sizeof(struct viz_vertex), NULL,
+		     GL_STREAM_DRAW);
+	for (i = 0; i < r->line_batches; i++) {
+		batch = &r->lines[i];
+		glBufferSubData(GL_ARRAY_BUFFER,
+				first * sizeof(struct viz_vertex),
+				batch->count * sizeof(struct viz_vertex),
+				batch->vertices);
+		first += batch->count;
+	}
+	set_vertex_pointers();
+
+	first = 0;
+	for (i = 0; i < r->line_batches; i++) {
+		batch = &r->lines[i];
+		if (!batch->count)
+			continue;
+		glLineWidth(batch->width);
+		glDrawArrays(GL_LINES, first, batch->count);
+		first += batch->count;
+		r->stats.draw_calls++;
+	}
+	r->stats.vertices += total;
+
+out:
+	r->line_batches = 0;
+	r->line = NULL;
+}
+
+/**
+ * viz_render_flush - Last opp og tegn alt som er lagt til, og tøm batchene
+ * @r: renderer
+ *
+ * Statistikken i @r->stats gjelder denne framen til neste flush.
+ */
+void viz_render_flush(struct viz_renderer *r)
+{
+	unsigned int dropped = r->stats.dropped;
+
+	memset(&r->stats, 0, sizeof(r->stats));
+	r->stats.dropped = dropped;
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+
+	mesh_flush(r, &r->sphere);
+	mesh_flush(r, &r->cylinder);
+	lines_flush(r);
+
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/**
+ * viz_render_destroy - Frigjør GL-buffere og minne
+ * @r: renderer
+ */
+void viz_render_destroy(struct viz_renderer *r)
+{
+	mesh_destroy(&r->sphere);
+	mesh_destroy(&r->cylinder);
+	if (r->line_vbo)
+		glDeleteBuffers(1, &r->line_vbo);
+	r->line_vbo = 0;
+}
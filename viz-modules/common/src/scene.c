@@ -0,0 +1,301 @@
+#define _DEFAULT_SOURCE
+#include "scene.h"
+#include "stewart/geometry.h"
+#include "viz_gl.h"
+#include "viz_protocol.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Satt av viz_geometry_watch(), lest i signal handleren */
+static struct viz_geometry_set *watched;
+static struct viz_wake *watched_wake;
+
+/**
+ * viz_geometry_init - Innebygd geometri, deretter filene
+ * @g: sett som initialiseres
+ * @file_mx64: -m, eller NULL
+ * @file_ax18: -a, eller NULL
+ *
+ * Retur: 0 ved suksess, -1 hvis en fil ikke kunne lastes
+ */
+int viz_geometry_init(struct viz_geometry_set *g, const char *file_mx64,
+		      const char *file_ax18)
+{
+	stewart_geometry_slot_init(&g->mx64, &ROBOT_MX64);
+	stewart_geometry_slot_init(&g->ax18, &ROBOT_AX18);
+	g->file_mx64 = file_mx64;
+	g->file_ax18 = file_ax18;
+	g->reload_requested = 0;
+
+	return viz_geometry_reload(g);
+}
+
+/**
+ * viz_geometry_reload - Last geometri-filene på nytt
+ * @g: sett
+ *
+ * Retur: 0 ved suksess, -1 hvis en fil ikke kunne lastes
+ */
+int viz_geometry_reload(struct viz_geometry_set *g)
+{
+	int ret = 0;
+
+	if (g->file_mx64) {
+		if (stewart_geometry_slot_reload(&g->mx64, g->file_mx64) < 0)
+			ret = -1;
+		else
+			printf("MX64 geometry loaded from %s\n", g->file_mx64);
+	}
+
+	if (g->file_ax18) {
+		if (stewart_geometry_slot_reload(&g->ax18, g->file_ax18) < 0)
+			ret = -1;
+		else
+			printf("AX18 geometry loaded from %s\n", g->file_ax18);
+	}
+
+	return ret;
+}
+
+/**
+ * viz_geometry_select - Slot for en robot type
+ * @g: sett
+ * @robot_type: ROBOT_TYPE_* fra pakken
+ *
+ * Retur: AX18-slot for ROBOT_TYPE_AX18, ellers MX64
+ */
+struct stewart_geometry_slot *viz_geometry_select(struct viz_geometry_set *g,
+						  int robot_type)
+{
+	return robot_type == ROBOT_TYPE_AX18 ? &g->ax18 : &g->mx64;
+}
+
+static void handle_sighup(int sig)
+{
+	(void)sig;
+	watched->reload_requested = 1;
+	viz_wake_signal(watched_wake);
+}
+
+/**
+ * viz_geometry_watch - Last geometrien på nytt ved SIGHUP
+ * @g: sett (ett per prosess)
+ * @wake: vekker tråden som kaller viz_geometry_reload_pending()
+ *
+ * Signal handleren setter bare et flagg og vekker tråden; filene leses
+ * i tråden.
+ */
+void viz_geometry_watch(struct viz_geometry_set *g, struct viz_wake *wake)
+{
+	watched = g;
+	watched_wake = wake;
+	signal(SIGHUP, handle_sighup);
+}
+
+/**
+ * viz_geometry_unwatch - Tilbake til default SIGHUP
+ */
+void viz_geometry_unwatch(void)
+{
+	signal(SIGHUP, SIG_DFL);
+}
+
+/**
+ * viz_geometry_reload_pending - Sjekk og nullstill SIGHUP-forespørsel
+ * @g: sett
+ *
+ * Retur: 1 hvis geometrien skal lastes på nytt, ellers 0
+ */
+int viz_geometry_reload_pending(struct viz_geometry_set *g)
+{
+	if (!g->reload_requested)
+		return 0;
+
+	g->reload_requested = 0;
+	return 1;
+}
+
+/**
+ * viz_geometry_destroy - Frigjør begge slot-ene
+ * @g: sett
+ */
+void viz_geometry_destroy(struct viz_geometry_set *g)
+{
+	stewart_geometry_slot_destroy(&g->mx64);
+	stewart_geometry_slot_destroy(&g->ax18);
+}
+
+/**
+ * viz_scene_trail_color - Samme farge på alle sporene til én pose
+ * @t: spor
+ * @pose: pose-indeks
+ * @color: farge (0-1)
+ */
+void viz_scene_trail_color(struct viz_trail *t, int pose,
+			   const float color[3])
+{
+	int i;
+
+	for (i = 0; i < VIZ_SCENE_TRAIL_TRACKS; i++)
+		viz_trail_color(t, pose * VIZ_SCENE_TRAIL_TRACKS + i, color[0],
+				color[1], color[2]);
+}
+
+/* Platform-senter og knær for én pose, VIZ_SCENE_TRAIL_TRACKS punkter */
+static void trail_points(const struct stewart_inverse_result *ik,
+			 struct vec3 *points)
+{
+	const struct vec3 *p = ik->platform_points_transformed;
+	int i;
+
+	points[0] = (struct vec3){ 0.0f, 0.0f, 0.0f };
+	for (i = 0; i < 6; i++) {
+		points[0].x += p[i].x / 6.0f;
+		points[0].y += p[i].y / 6.0f;
+		points[0].z += p[i].z / 6.0f;
+		points[i + 1] = ik->knee_points[i];
+	}
+}
+
+/**
+ * viz_scene_trail_update - Legg nye poser til sporet og fjern gamle samples
+ * @t: spor med VIZ_SCENE_TRAIL_TRACKS spor per pose
+ * @poses: IK-resultat per pose, i samme rekkefølge som sporene
+ * @count: antall poser, høyst VIZ_SCENE_TRAIL_MAX_POSES
+ * @fresh: 1 hvis posene er nye siden forrige frame
+ *
+ * Retur: 1 hvis sporet har samples som skal forsvinne senere
+ */
+int viz_scene_trail_update(struct viz_trail *t,
+			   const struct stewart_inverse_result *const *poses,
+			   int count, int fresh)
+{
+	struct vec3 points[VIZ_TRAIL_MAX_TRACKS];
+	uint64_t now = viz_time_ns();
+	int i;
+
+	if (fresh) {
+		for (i = 0; i < count; i++)
+			trail_points(poses[i],
+				     &points[i * VIZ_SCENE_TRAIL_TRACKS]);
+		viz_trail_push(t, points, now);
+	}
+
+	return viz_trail_expire(t, now) > 0;
+}
+
+/**
+ * viz_leg_colors_from - Ben-farger avledet fra posens farge
+ * @c: output
+ * @color: posens farge (0-1)
+ */
+void viz_leg_colors_from(struct viz_leg_colors *c, const float color[3])
+{
+	float r = color[0], g = color[1], b = color[2];
+
+	c->arm[0] = r * 0.9f;
+	c->arm[1] = g * 0.9f;
+	c->arm[2] = b * 0.5f;
+	c->pushrod[0] = r;
+	c->pushrod[1] = g * 0.6f;
+	c->pushrod[2] = b * 0.6f;
+	memcpy(c->knee, color, sizeof(c->knee));
+}
+
+/**
+ * viz_scene_draw_legs - Legg motor arms, pushrods og knær i batchen
+ * @r: renderer
+ * @base_points: base punkter fra geometrien IK ble kjørt med
+ * @ik: IK-resultat
+ * @c: farger
+ */
+void viz_scene_draw_legs(struct viz_renderer *r,
+			 const struct vec3 *base_points,
+			 const struct stewart_inverse_result *ik,
+			 const struct viz_leg_colors *c)
+{
+	const struct vec3 *knee = ik->knee_points;
+	const struct vec3 *platform = ik->platform_points_transformed;
+	int i;
+
+	/* Motor arms (base → knee) og pushrods (knee → platform) */
+	viz_render_line_width(r, 2.0f);
+	viz_render_color(r, c->arm[0], c->arm[1], c->arm[2]);
+	for (i = 0; i < 6; i++)
+		viz_render_line(r, &base_points[i], &knee[i]);
+	viz_render_color(r, c->pushrod[0], c->pushrod[1], c->pushrod[2]);
+	for (i = 0; i < 6; i++)
+		viz_render_line(r, &knee[i], &platform[i]);
+
+	/* Knee points (kuler) */
+	viz_render_color(r, c->knee[0], c->knee[1], c->knee[2]);
+	for (i = 0; i < 6; i++)
+		viz_render_sphere(r, &knee[i], VIZ_SCENE_KNEE_RADIUS);
+}
+
+/**
+ * viz_scene_draw_collision_pair - Ben-paret nærmest kollisjon i rødt
+ * @r: renderer
+ * @base_points: base punkter fra geometrien IK ble kjørt med
+ * @ik: IK-resultat
+ * @pair: benene (stewart_collision_pair_legs())
+ */
+void viz_scene_draw_collision_pair(struct viz_renderer *r,
+				   const struct vec3 *base_points,
+				   const struct stewart_inverse_result *ik,
+				   const int pair[2])
+{
+	const struct vec3 *knee = ik->knee_points;
+	const struct vec3 *platform = ik->platform_points_transformed;
+	int i, leg;
+
+	viz_render_color(r, 1.0f, 0.1f, 0.1f);
+	viz_render_line_width(r, 4.0f);
+	for (i = 0; i < 2; i++) {
+		leg = pair[i];
+		viz_render_line(r, &base_points[leg], &knee[leg]);
+		viz_render_line(r, &knee[leg], &platform[leg]);
+	}
+}
+
+/**
+ * viz_scene_init - GL-state for scenen og renderer
+ * @r: renderer som initialiseres
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_scene_init(struct viz_renderer *r)
+{
+	glEnable(GL_DEPTH_TEST);
+	glClearColor(0.05f, 0.05f, 0.1f, 1.0f);
+
+	return viz_render_init(r);
+}
+
+/**
+ * viz_scene_begin - Start en frame
+ * @c: kamera
+ * @w: vindu
+ */
+void viz_scene_begin(const struct viz_camera *c, const struct viz_window *w)
+{
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	viz_camera_apply(c, w);
+}
+
+/**
+ * viz_scene_end - Avslutt en frame
+ * @r: renderer med alt som er lagt til
+ * @trail: spor som tegnes over, eller NULL
+ */
+void viz_scene_end(struct viz_renderer *r, struct viz_trail *trail)
+{
+	viz_render_axes(r, VIZ_SCENE_AXIS_LENGTH, 4.0f);
+
+	/* Kulene i ett kall, linjene i ett kall per bredde */
+	viz_render_flush(r);
+
+	/* Hele historikken i ett kall, bare nye samples lastes opp */
+	if (trail)
+		viz_trail_draw(trail, 1.5f);
+}
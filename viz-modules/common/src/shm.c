@@ -0,0 +1,330 @@
+#define _DEFAULT_SOURCE
+#include "shm.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static int shm_set_name(struct shm_channel *ch, const char *name)
+{
+	int len;
+
+	memset(ch, 0, sizeof(*ch));
+	len = snprintf(ch->name, sizeof(ch->name), "/viz-%s", name);
+	if (len < 0 || len >= (int)sizeof(ch->name) || strchr(name, '/')) {
+		fprintf(stderr, "shm: invalid stream name '%s'\n", name);
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Merk et gammelt segment (mottaker drept uten shm_close()) som dødt før
+ * det fjernes fra /dev/shm. Ellers står @receiver_alive fortsatt på 1 der,
+ * og en sender som har det mappet skriver videre i et segment ingen leser.
+ */
+static void shm_retire_stale(const struct shm_channel *ch)
+{
+	struct shm_segment *seg;
+	struct stat st;
+	int fd;
+
+	fd = shm_open(ch->name, O_RDWR, 0);
+	if (fd < 0)
+		return;
+
+	if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(*seg)) {
+		close(fd);
+		return;
+	}
+
+	seg = mmap(NULL, sizeof(*seg), PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+		   0);
+	close(fd);
+	if (seg == MAP_FAILED)
+		return;
+
+	if (seg->magic == SHM_MAGIC && seg->version == SHM_VERSION)
+		atomic_store_explicit(&seg->receiver_alive, 0,
+				      memory_order_release);
+	munmap(seg, sizeof(*seg));
+}
+
+/**
+ * shm_create_receiver - Lag segment og vent på meldinger
+ * @ch: kanal som initialiseres
+ * @name: strøm-navn
+ *
+ * Et gammelt segment fra en krasjet mottaker merkes dødt før det fjernes,
+ * så sendere kobler seg til det nye. @receiver_alive settes sist
+ * (release), så en sender som ser segmentet i live også ser ferdig
+ * initialiserte felt.
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int shm_create_receiver(struct shm_channel *ch, const char *name)
+{
+	struct shm_segment *seg;
+	int fd;
+
+	if (shm_set_name(ch, name) < 0)
+		return -1;
+
+	shm_retire_stale(ch);
+	shm_unlink(ch->name);
+	fd = shm_open(ch->name, O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0) {
+		perror(ch->name);
+		return -1;
+	}
+
+	if (ftruncate(fd, sizeof(*seg)) < 0) {
+		perror("ftruncate");
+		close(fd);
+		shm_unlink(ch->name);
+		return -1;
+	}
+
+	seg = mmap(NULL, sizeof(*seg), PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+		   0);
+	close(fd);
+	if (seg == MAP_FAILED) {
+		perror("mmap");
+		shm_unlink(ch->name);
+		return -1;
+	}
+
+	/* ftruncate har nullstilt resten */
+	seg->magic = SHM_MAGIC;
+	seg->version = SHM_VERSION;
+	seg->message_size = sizeof(struct shm_message);
+	seg->ring_slots = SHM_RING_SLOTS;
+	atomic_store_explicit(&seg->receiver_alive, 1, memory_order_release);
+
+	ch->seg = seg;
+	ch->is_receiver = 1;
+
+	printf("SHM receiver listening on /dev/shm%s\n", ch->name);
+
+	return 0;
+}
+
+/**
+ * shm_open_sender - Forbered sending til strøm
+ * @ch: kanal som initialiseres
+ * @name: strøm-navn
+ *
+ * Retur: 0 ved suksess, -1 ved ugyldig navn
+ */
+int shm_open_sender(struct shm_channel *ch, const char *name)
+{
+	return shm_set_name(ch, name);
+}
+
+/* Koble sender til mottakerens segment. Retur: 0 hvis koblet, ellers -1 */
+static int shm_attach(struct shm_channel *ch)
+{
+	struct shm_segment *seg;
+	struct stat st;
+	int fd;
+
+	fd = shm_open(ch->name, O_RDWR, 0);
+	if (fd < 0)
+		return -1; /* Ingen mottaker ennå */
+
+	if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(*seg)) {
+		close(fd);
+		return -1;
+	}
+
+	seg = mmap(NULL, sizeof(*seg), PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+		   0);
+	close(fd);
+	if (seg == MAP_FAILED)
+		return -1;
+
+	if (!atomic_load_explicit(&seg->receiver_alive, memory_order_acquire) ||
+	    seg->magic != SHM_MAGIC || seg->version != SHM_VERSION ||
+	    seg->message_size != sizeof(struct shm_message) ||
+	    seg->ring_slots != SHM_RING_SLOTS) {
+		munmap(seg, sizeof(*seg));
+		return -1;
+	}
+
+	ch->seg = seg;
+	return 0;
+}
+
+/**
+ * shm_send - Send én melding
+ * @ch: sender-kanal
+ * @data: payload
+ * @length: antall bytes
+ *
+ * Ringen: skriv slot, publiser med release-store av @head. Latest:
+ * seqlock, @latest_seq er odde mens slotten skrives.
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int shm_send(struct shm_channel *ch, const void *data, size_t length)
+{
+	struct shm_segment *seg;
+	struct shm_message *msg;
+	unsigned long long head, tail;
+	unsigned int seq;
+
+	if (length > UDP_DATAGRAM_MAX) {
+		fprintf(stderr, "shm_send: message too large (%zu)\n", length);
+		return -1;
+	}
+
+	/* Mottaker borte (eller startet på nytt): koble på nytt */
+	if (ch->seg && !atomic_load_explicit(&ch->seg->receiver_alive,
+					     memory_order_acquire)) {
+		munmap(ch->seg, sizeof(*ch->seg));
+		ch->seg = NULL;
+	}
+	if (!ch->seg && shm_attach(ch) < 0)
+		return 0; /* Ingen mottaker, forkastes som med UDP */
+
+	seg = ch->seg;
+
+	head = atomic_load_explicit(&seg->head, memory_order_relaxed);
+	tail = atomic_load_explicit(&seg->tail, memory_order_acquire);
+	if (head - tail < SHM_RING_SLOTS) {
+		msg = &seg->ring[head & (SHM_RING_SLOTS - 1)];
+		msg->length = length;
+		memcpy(msg->data, data, length);
+		atomic_store_explicit(&seg->head, head + 1,
+				      memory_order_release);
+	} else {
+		atomic_fetch_add_explicit(&seg->dropped, 1,
+					  memory_order_relaxed);
+	}
+
+	seq = atomic_load_explicit(&seg->latest_seq, memory_order_relaxed);
+	atomic_store_explicit(&seg->latest_seq, seq + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	seg->latest.length = length;
+	memcpy(seg->latest.data, data, length);
+	atomic_store_explicit(&seg->latest_seq, seq + 2, memory_order_release);
+
+	return 0;
+}
+
+/**
+ * shm_receive_batch - Hent meldinger fra ringen (opptil UDP_BATCH_MAX)
+ * @ch: mottaker-kanal
+ * @batch: output - meldinger
+ *
+ * Retur: antall meldinger, 0 hvis ingen
+ */
+int shm_receive_batch(struct shm_channel *ch, struct udp_batch *batch)
+{
+	struct shm_segment *seg = ch->seg;
+	const struct shm_message *msg;
+	unsigned long long head, tail;
+	size_t len;
+	int i, n;
+
+	tail = atomic_load_explicit(&seg->tail, memory_order_relaxed);
+	head = atomic_load_explicit(&seg->head, memory_order_acquire);
+	n = head - tail < UDP_BATCH_MAX ? (int)(head - tail) : UDP_BATCH_MAX;
+
+	for (i = 0; i < n; i++) {
+		msg = &seg->ring[(tail + i) & (SHM_RING_SLOTS - 1)];
+		len = msg->length;
+		if (len > UDP_DATAGRAM_MAX)
+			len = UDP_DATAGRAM_MAX;
+		memcpy(batch->data[i], msg->data, len);
+		batch->length[i] = len;
+		batch->truncated[i] = 0;
+	}
+
+	/* Slippes først etter kopiering, så produsenten ikke overskriver */
+	atomic_store_explicit(&seg->tail, tail + n, memory_order_release);
+
+	batch->count = n;
+	return n;
+}
+
+/**
+ * shm_receive_latest - Hent nyeste melding
+ * @ch: mottaker-kanal
+ * @buffer: output - nyeste melding
+ * @buffer_size: størrelse på buffer
+ * @accept: validering, NULL godtar alt som passer i @buffer
+ * @coalesced: output - antall eldre meldinger som ble hoppet over
+ *
+ * Retur: antall bytes i @buffer, 0 hvis ingen ny gyldig melding
+ */
+int shm_receive_latest(struct shm_channel *ch, void *buffer,
+		       size_t buffer_size, udp_accept_fn accept,
+		       int *coalesced)
+{
+	struct shm_segment *seg = ch->seg;
+	unsigned int s1, s2;
+	size_t len;
+
+	if (coalesced)
+		*coalesced = 0;
+
+	/* Ringen brukes ikke her; tøm den så produsenten ikke forkaster */
+	atomic_store_explicit(&seg->tail,
+			      atomic_load_explicit(&seg->head,
+						   memory_order_acquire),
+			      memory_order_release);
+
+	do {
+		s1 = atomic_load_explicit(&seg->latest_seq,
+					  memory_order_acquire);
+		if (s1 & 1)
+			continue; /* Skriving pågår */
+
+		if (s1 == ch->latest_seen)
+			return 0;
+
+		/* Lengden kan være revet; begrens før kopiering */
+		len = seg->latest.length;
+		if (len > buffer_size || len > UDP_DATAGRAM_MAX)
+			len = 0;
+		memcpy(buffer, seg->latest.data, len);
+
+		atomic_thread_fence(memory_order_acquire);
+		s2 = atomic_load_explicit(&seg->latest_seq,
+					  memory_order_relaxed);
+	} while ((s1 & 1) || s1 != s2);
+
+	/* Usignert differanse tåler at @latest_seq wrapper */
+	if (coalesced)
+		*coalesced = (int)((s1 - ch->latest_seen) / 2 - 1);
+	ch->latest_seen = s1;
+
+	if (len == 0 || (accept && !accept(buffer, len)))
+		return 0;
+
+	return (int)len;
+}
+
+/**
+ * shm_close - Lukk kanal
+ * @ch: kanal
+ */
+void shm_close(struct shm_channel *ch)
+{
+	if (!ch->seg)
+		return;
+
+	if (ch->is_receiver) {
+		atomic_store_explicit(&ch->seg->receiver_alive, 0,
+				      memory_order_release);
+		shm_unlink(ch->name);
+	}
+
+	munmap(ch->seg, sizeof(*ch->seg));
+	ch->seg = NULL;
+}
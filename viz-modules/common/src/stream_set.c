@@ -0,0 +1,428 @@
+#define _DEFAULT_SOURCE
+#include "stream_set.h"
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+#define WAKE_INDEX (-1)
+
+/**
+ * viz_stream_set_init - Initialiser tomt sett
+ * @set: sett
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_stream_set_init(struct viz_stream_set *set)
+{
+	memset(set, 0, sizeof(*set));
+	set->poll_fd = -1;
+
+	if (viz_wake_init(&set->wake) < 0)
+		return -1;
+
+#ifdef __linux__
+	struct epoll_event ev = { .events = EPOLLIN };
+
+	set->poll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (set->poll_fd < 0) {
+		perror("epoll_create1");
+		goto err;
+	}
+
+	ev.data.u32 = (uint32_t)WAKE_INDEX;
+	if (epoll_ctl(set->poll_fd, EPOLL_CTL_ADD, set->wake.pipe[0], &ev) < 0) {
+		perror("epoll_ctl");
+		close(set->poll_fd);
+		goto err;
+	}
+#endif
+
+	return 0;
+
+#ifdef __linux__
+err:
+	viz_wake_close(&set->wake);
+	return -1;
+#endif
+}
+
+/**
+ * viz_stream_set_add - Åpne og registrer en strøm
+ * @set: sett (mottaks-tråden må ikke kjøre)
+ * @endpoint: endpoint-streng (se transport.h)
+ *
+ * Retur: strøm-indeks, eller -1 ved feil
+ */
+int viz_stream_set_add(struct viz_stream_set *set, const char *endpoint)
+{
+	struct viz_stream *s;
+	int index = set->count, fd;
+
+	if (index >= VIZ_STREAM_SET_MAX) {
+		fprintf(stderr, "stream set: max %d streams\n",
+			VIZ_STREAM_SET_MAX);
+		return -1;
+	}
+
+	s = &set->streams[index];
+	memset(s, 0, sizeof(*s));
+	if (viz_transport_open_receiver(&s->transport, endpoint) < 0)
+		return -1;
+
+	fd = viz_transport_fd(&s->transport);
+	if (fd < 0) {
+		set->unpollable++;
+	} else {
+#ifdef __linux__
+		struct epoll_event ev = { .events = EPOLLIN };
+
+		ev.data.u32 = (uint32_t)index;
+		if (epoll_ctl(set->poll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+			perror("epoll_ctl");
+			viz_transport_close(&s->transport);
+			return -1;
+		}
+#endif
+	}
+
+	set->count++;
+	return index;
+}
+
+/**
+ * viz_stream_set_add_replay - Registrer en strøm uten transport
+ * @set: sett (mottaks-tråden må ikke kjøre)
+ *
+ * Retur: strøm-indeks, eller -1 ved feil
+ */
+int viz_stream_set_add_replay(struct viz_stream_set *set)
+{
+	struct viz_stream *s;
+
+	if (set->count >= VIZ_STREAM_SET_MAX) {
+		fprintf(stderr, "stream set: max %d streams\n",
+			VIZ_STREAM_SET_MAX);
+		return -1;
+	}
+
+	s = &set->streams[set->count];
+	memset(s, 0, sizeof(*s));
+	s->transport.sock = -1;
+	s->transport.uring.ring_fd = -1;
+	s->replay = 1;
+
+	return set->count++;
+}
+
+/* Seqlock som i shm.c; én skriver per slot */
+static void slot_publish(struct viz_stream_slot *slot,
+			 const struct viz_pose_packet *pose,
+			 uint64_t send_time_ns, uint64_t recv_time_ns)
+{
+	unsigned int seq;
+
+	seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+	atomic_store_explicit(&slot->seq, seq + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	slot->pose = *pose;
+	slot->send_time_ns = send_time_ns;
+	slot->recv_time_ns = recv_time_ns;
+	atomic_store_explicit(&slot->seq, seq + 2, memory_order_release);
+}
+
+/**
+ * viz_stream_set_inject - Publiser en pose i slotten til en strøm
+ * @set: sett
+ * @index: strøm fra viz_stream_set_add_replay()
+ * @pose: pose
+ * @send_time_ns: sende-tidsstempel, 0 hvis ukjent
+ * @recv_time_ns: mottakstid (viz_time_ns()-klokken)
+ */
+void viz_stream_set_inject(struct viz_stream_set *set, int index,
+			   const struct viz_pose_packet *pose,
+			   uint64_t send_time_ns, uint64_t recv_time_ns)
+{
+	slot_publish(&set->streams[index].slot, pose, send_time_ns,
+		     recv_time_ns);
+}
+
+/* Les nyeste pose fra strøm og publiser i slotten. Retur: 1 hvis ny */
+static int stream_receive(struct viz_stream *s)
+{
+	struct viz_pose_packet pose;
+
+	if (s->replay ||
+	    viz_receive_pose(&s->transport, &pose, &s->stats) <= 0)
+		return 0;
+
+	/* Eneste skriver er mottaks-tråden */
+	slot_publish(&s->slot, &pose, s->stats.last_send_time_ns,
+		     s->stats.last_recv_time_ns);
+	return 1;
+}
+
+/* Vent på readiness og fyll @ready med indekser. Retur: antall, -1 ved feil */
+static int wait_ready(struct viz_stream_set *set, int timeout_ms, int *ready)
+{
+	int i, n, count = 0;
+
+#ifdef __linux__
+	struct epoll_event events[VIZ_STREAM_SET_MAX + 1];
+
+	n = epoll_wait(set->poll_fd, events, VIZ_STREAM_SET_MAX + 1,
+		       timeout_ms);
+	if (n < 0)
+		return errno == EINTR ? 0 : -1;
+
+	for (i = 0; i < n; i++) {
+		if ((int)events[i].data.u32 == WAKE_INDEX)
+			viz_wake_drain(&set->wake);
+		else
+			ready[count++] = (int)events[i].data.u32;
+	}
+#else
+	/* Ingen epoll: bygg pollfd-listen hver gang (få strømmer) */
+	struct pollfd fds[VIZ_STREAM_SET_MAX + 1];
+	int index[VIZ_STREAM_SET_MAX + 1];
+	int fd;
+
+	n = 0;
+	fds[n].fd = set->wake.pipe[0];
+	fds[n].events = POLLIN;
+	index[n++] = WAKE_INDEX;
+	for (i = 0; i < set->count; i++) {
+		if (set->streams[i].replay)
+			continue;
+		fd = viz_transport_fd(&set->streams[i].transport);
+		if (fd < 0)
+			continue;
+		fds[n].fd = fd;
+		fds[n].events = POLLIN;
+		index[n++] = i;
+	}
+
+	if (poll(fds, n, timeout_ms) < 0)
+		return errno == EINTR ? 0 : -1;
+
+	for (i = 0; i < n; i++) {
+		if (!(fds[i].revents & POLLIN))
+			continue;
+		if (index[i] == WAKE_INDEX)
+			viz_wake_drain(&set->wake);
+		else
+			ready[count++] = index[i];
+	}
+#endif
+
+	return count;
+}
+
+/**
+ * viz_stream_set_poll - Vent på og les strømmer som har data
+ * @set: sett
+ * @timeout_ms: maks ventetid, 0 for å ikke vente, -1 for å vente til data
+ *
+ * Bare strømmer kjernen melder som lesbare leses. Shared memory-strømmer
+ * sjekkes hver gang, og ventetiden begrenses så de ikke blir liggende.
+ *
+ * Retur: antall strømmer med ny pose, -1 ved feil
+ */
+int viz_stream_set_poll(struct viz_stream_set *set, int timeout_ms)
+{
+	int ready[VIZ_STREAM_SET_MAX];
+	int i, n, updated = 0;
+
+	if (set->unpollable &&
+	    (timeout_ms < 0 || timeout_ms > VIZ_STREAM_SET_SHM_POLL_MS))
+		timeout_ms = VIZ_STREAM_SET_SHM_POLL_MS;
+
+	n = wait_ready(set, timeout_ms, ready);
+	if (n < 0) {
+		perror("stream set wait");
+		return -1;
+	}
+
+	for (i = 0; i < n; i++)
+		updated += stream_receive(&set->streams[ready[i]]);
+
+	if (set->unpollable) {
+		for (i = 0; i < set->count; i++) {
+			if (!set->streams[i].replay &&
+			    viz_transport_fd(&set->streams[i].transport) < 0)
+				updated += stream_receive(&set->streams[i]);
+		}
+	}
+
+	return updated;
+}
+
+static void *stream_set_thread(void *arg)
+{
+	struct viz_stream_set *set = arg;
+	int i;
+
+	/* Les alle én gang først; armerer io_uring-strømmer i denne tråden */
+	for (i = 0; i < set->count; i++)
+		stream_receive(&set->streams[i]);
+	if (set->update)
+		set->update(set->update_ctx);
+
+	while (atomic_load_explicit(&set->running, memory_order_acquire)) {
+		if (viz_stream_set_poll(set, -1) < 0)
+			break;
+		if (set->update &&
+		    atomic_load_explicit(&set->running, memory_order_acquire))
+			set->update(set->update_ctx);
+	}
+
+	return NULL;
+}
+
+/**
+ * viz_stream_set_start - Start egen mottaks-tråd
+ * @set: sett
+ *
+ * Tråden blokkerer i epoll_wait() og publiserer i slottene; leseren
+ * bruker viz_stream_set_latest(). Statistikk bør ikke leses før
+ * viz_stream_set_stop().
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_stream_set_start(struct viz_stream_set *set)
+{
+	int err;
+
+	atomic_store_explicit(&set->running, 1, memory_order_release);
+	err = pthread_create(&set->thread, NULL, stream_set_thread, set);
+	if (err) {
+		fprintf(stderr, "pthread_create: %s\n", strerror(err));
+		atomic_store(&set->running, 0);
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * viz_stream_set_on_update - Registrer callback for mottaks-tråden
+ * @set: sett (mottaks-tråden må ikke kjøre)
+ * @update: callback, eller NULL
+ * @ctx: argument til @update
+ *
+ * @update kalles også når runden bare ga timeout eller wake; den sjekker
+ * selv versjonene med viz_stream_set_latest().
+ */
+void viz_stream_set_on_update(struct viz_stream_set *set,
+			      void (*update)(void *ctx), void *ctx)
+{
+	set->update = update;
+	set->update_ctx = ctx;
+}
+
+/**
+ * viz_stream_set_wake - Vekk mottaks-tråden så @update kalles
+ * @set: sett
+ */
+void viz_stream_set_wake(struct viz_stream_set *set)
+{
+	viz_wake_signal(&set->wake);
+}
+
+/**
+ * viz_stream_set_stop - Stopp mottaks-tråden og vent på den
+ * @set: sett
+ */
+void viz_stream_set_stop(struct viz_stream_set *set)
+{
+	if (!atomic_exchange(&set->running, 0))
+		return;
+
+	viz_wake_signal(&set->wake);
+	pthread_join(set->thread, NULL);
+}
+
+/**
+ * viz_stream_set_latest - Les siste pose for en strøm
+ * @set: sett
+ * @index: strøm-indeks
+ * @pose: output - siste pose
+ * @version: inn: sist sette versjon, ut: versjonen som ble lest
+ *
+ * Retur: 1 hvis posen er nyere enn *@version, ellers 0
+ */
+int viz_stream_set_latest(struct viz_stream_set *set, int index,
+			  struct viz_pose_packet *pose, unsigned int *version)
+{
+	return viz_stream_set_latest_timed(set, index, pose, NULL, NULL,
+					   version);
+}
+
+/**
+ * viz_stream_set_latest_timed - Les siste pose med tidsstempler
+ * @set: sett
+ * @index: strøm-indeks
+ * @pose: output - siste pose
+ * @send_time_ns: output - sende-tidsstempel, 0 for v1 (kan være NULL)
+ * @recv_time_ns: output - viz_time_ns() ved mottak (kan være NULL)
+ * @version: inn: sist sette versjon, ut: versjonen som ble lest
+ *
+ * Retur: 1 hvis posen er nyere enn *@version, ellers 0
+ */
+int viz_stream_set_latest_timed(struct viz_stream_set *set, int index,
+				struct viz_pose_packet *pose,
+				uint64_t *send_time_ns, uint64_t *recv_time_ns,
+				unsigned int *version)
+{
+	struct viz_stream_slot *slot = &set->streams[index].slot;
+	uint64_t send, recv;
+	unsigned int s1, s2;
+
+	do {
+		s1 = atomic_load_explicit(&slot->seq, memory_order_acquire);
+		if (s1 & 1)
+			continue; /* Skriving pågår */
+
+		if (s1 / 2 == *version)
+			return 0;
+
+		*pose = slot->pose;
+		send = slot->send_time_ns;
+		recv = slot->recv_time_ns;
+
+		atomic_thread_fence(memory_order_acquire);
+		s2 = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+	} while ((s1 & 1) || s1 != s2);
+
+	if (send_time_ns)
+		*send_time_ns = send;
+	if (recv_time_ns)
+		*recv_time_ns = recv;
+	*version = s1 / 2;
+	return 1;
+}
+
+/**
+ * viz_stream_set_destroy - Stopp tråd og lukk alle strømmer
+ * @set: sett
+ */
+void viz_stream_set_destroy(struct viz_stream_set *set)
+{
+	int i;
+
+	viz_stream_set_stop(set);
+
+	for (i = 0; i < set->count; i++) {
+		if (!set->streams[i].replay)
+			viz_transport_close(&set->streams[i].transport);
+	}
+	set->count = 0;
+
+	if (set->poll_fd >= 0)
+		close(set->poll_fd);
+	viz_wake_close(&set->wake);
+}
@@ -0,0 +1,243 @@
+#define _DEFAULT_SOURCE
+#include "trail.h"
+#include "viz_gl.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * viz_trail_init - Alloker ringen og vertex bufferen
+ * @t: trail som initialiseres
+ * @tracks: punkter per sample (maks VIZ_TRAIL_MAX_TRACKS)
+ * @capacity: antall samples, f.eks. VIZ_TRAIL_SAMPLES
+ * @seconds: hvor lenge et sample vises
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_trail_init(struct viz_trail *t, int tracks, int capacity,
+		   float seconds)
+{
+	size_t vertices;
+
+	memset(t, 0, sizeof(*t));
+	if (tracks < 1 || tracks > VIZ_TRAIL_MAX_TRACKS || capacity < 1) {
+		fprintf(stderr, "trail: invalid size %d x %d\n", tracks,
+			capacity);
+		return -1;
+	}
+
+	t->tracks = tracks;
+	t->capacity = capacity;
+	t->window_ns = (uint64_t)(seconds * 1e9);
+	memset(t->colors, 255, sizeof(t->colors));
+
+	vertices = (size_t)capacity * tracks * 2;
+	t->times = calloc((size_t)capacity, sizeof(*t->times));
+	t->vertices = calloc(vertices, sizeof(*t->vertices));
+	if (!t->times || !t->vertices) {
+		fprintf(stderr, "trail: out of memory\n");
+		viz_trail_destroy(t);
+		return -1;
+	}
+
+	/* Hele ringen allokeres én gang; deretter bare glBufferSubData */
+	glGenBuffers(1, &t->vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, t->vbo);
+	glBufferData(GL_ARRAY_BUFFER, vertices * sizeof(*t->vertices), NULL,
+		     GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return 0;
+}
+
+static uint8_t color_byte(float c)
+{
+	if (c <= 0.0f)
+		return 0;
+	if (c >= 1.0f)
+		return 255;
+	return (uint8_t)(c * 255.0f + 0.5f);
+}
+
+/**
+ * viz_trail_color - Sett farge for et spor
+ * @t: trail
+ * @track: spor
+ * @red, @green, @blue: farge (0-1)
+ */
+void viz_trail_color(struct viz_trail *t, int track, float red, float green,
+		     float blue)
+{
+	if (track < 0 || track >= t->tracks)
+		return;
+
+	t->colors[track][0] = color_byte(red);
+	t->colors[track][1] = color_byte(green);
+	t->colors[track][2] = color_byte(blue);
+	t->colors[track][3] = 255;
+}
+
+static void set_vertex(struct viz_vertex *v, const uint8_t color[4],
+		       const struct vec3 *p)
+{
+	v->x = p->x;
+	v->y = p->y;
+	v->z = p->z;
+	memcpy(v->rgba, color, sizeof(v->rgba));
+}
+
+/**
+ * viz_trail_push - Legg til et sample
+ * @t: trail
+ * @points: ett punkt per spor (@t->tracks)
+ * @now_ns: viz_time_ns() for samplet
+ *
+ * Første sample etter init, clear eller en pause lengre enn vinduet blir
+ * segmenter med null lengde, så sporet ikke trekkes fra et punkt som
+ * allerede er borte.
+ */
+void viz_trail_push(struct viz_trail *t, const struct vec3 *points,
+		    uint64_t now_ns)
+{
+	struct viz_vertex *v = &t->vertices[(size_t)t->head * t->tracks * 2];
+	const struct vec3 *from;
+	int i, prev;
+
+	prev = (t->head - 1 + t->capacity) % t->capacity;
+	if (!t->count || now_ns - t->times[prev] > t->window_ns)
+		t->has_last = 0;
+
+	for (i = 0; i < t->tracks; i++) {
+		from = t->has_last ? &t->last[i] : &points[i];
+		set_vertex(v++, t->colors[i], from);
+		set_vertex(v++, t->colors[i], &points[i]);
+		t->last[i] = points[i];
+	}
+	t->has_last = 1;
+
+	t->times[t->head] = now_ns;
+	t->head = (t->head + 1) % t->capacity;
+	if (t->count < t->capacity)
+		t->count++;
+	if (t->pending < t->capacity)
+		t->pending++;
+}
+
+/**
+ * viz_trail_clear - Fjern historikken
+ * @t: trail
+ */
+void viz_trail_clear(struct viz_trail *t)
+{
+	t->count = 0;
+	t->pending = 0;
+	t->has_last = 0;
+}
+
+/**
+ * viz_trail_expire - Fjern samples eldre enn vinduet
+ * @t: trail
+ * @now_ns: viz_time_ns()
+ *
+ * Blir ringen tom, kobles neste sample ikke til det forrige.
+ *
+ * Retur: antall samples som fortsatt vises
+ */
+int viz_trail_expire(struct viz_trail *t, uint64_t now_ns)
+{
+	int tail;
+
+	while (t->count) {
+		tail = (t->head - t->count + t->capacity) % t->capacity;
+		if (t->times[tail] + t->window_ns >= now_ns)
+			break;
+		t->count--;
+	}
+	if (!t->count)
+		t->has_last = 0;
+
+	/* Utløpte samples som aldri ble lastet opp trengs ikke */
+	if (t->pending > t->count)
+		t->pending = t->count;
+
+	return t->count;
+}
+
+/* Last opp @count samples fra @first (uten wrap) */
+static void upload(struct viz_trail *t, int first, int count)
+{
+	size_t stride = (size_t)t->tracks * 2 * sizeof(*t->vertices);
+
+	glBufferSubData(GL_ARRAY_BUFFER, first * stride, count * stride,
+			&t->vertices[(size_t)first * t->tracks * 2]);
+}
+
+/**
+ * viz_trail_draw - Last opp nye samples og tegn historikken
+ * @t: trail
+ * @width: linjebredde (piksler)
+ */
+void viz_trail_draw(struct viz_trail *t, float width)
+{
+	const int per_sample = t->tracks * 2;
+	GLint first[2];
+	GLsizei count[2];
+	int start, tail, ranges = 1;
+
+	if (!t->count)
+		return;
+
+	glBindBuffer(GL_ARRAY_BUFFER, t->vbo);
+
+	/* Bare det som er nytt siden forrige frame, i ett eller to stykker */
+	if (t->pending) {
+		start = (t->head - t->pending + t->capacity) % t->capacity;
+		if (start + t->pending <= t->capacity) {
+			upload(t, start, t->pending);
+		} else {
+			upload(t, start, t->capacity - start);
+			upload(t, 0, t->head);
+		}
+		t->pending = 0;
+	}
+
+	/* Synlige samples, delt i to når de går rundt enden av ringen */
+	tail = (t->head - t->count + t->capacity) % t->capacity;
+	first[0] = tail * per_sample;
+	if (tail + t->count <= t->capacity) {
+		count[0] = t->count * per_sample;
+	} else {
+		count[0] = (t->capacity - tail) * per_sample;
+		first[1] = 0;
+		count[1] = t->head * per_sample;
+		ranges = 2;
+	}
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(3, GL_FLOAT, sizeof(struct viz_vertex),
+			(const void *)offsetof(struct viz_vertex, x));
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(struct viz_vertex),
+		       (const void *)offsetof(struct viz_vertex, rgba));
+
+	glLineWidth(width);
+	glMultiDrawArrays(GL_LINES, first, count, ranges);
+
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/**
+ * viz_trail_destroy - Frigjør vertex buffer og minne
+ * @t: trail
+ */
+void viz_trail_destroy(struct viz_trail *t)
+{
+	if (t->vbo)
+		glDeleteBuffers(1, &t->vbo);
+	free(t->times);
+	free(t->vertices);
+	memset(t, 0, sizeof(*t));
+}
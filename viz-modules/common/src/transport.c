@@ -0,0 +1,249 @@
+#include "transport.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * parse_udp_endpoint - Del "host:port" eller "port"
+ * @spec: endpoint uten "udp:"
+ * @host: output buffer for host (tom streng hvis ikke gitt)
+ * @host_size: størrelse på @host
+ * @port: output port
+ *
+ * Retur: 0 ved suksess, -1 ved ugyldig endpoint
+ */
+static int parse_udp_endpoint(const char *spec, char *host, size_t host_size,
+			      int *port)
+{
+	const char *colon = strrchr(spec, ':');
+	const char *port_str = colon ? colon + 1 : spec;
+	char *end;
+	long value;
+
+	host[0] = '\0';
+	if (colon) {
+		if ((size_t)(colon - spec) >= host_size)
+			return -1;
+		memcpy(host, spec, colon - spec);
+		host[colon - spec] = '\0';
+	}
+
+	value = strtol(port_str, &end, 10);
+	if (end == port_str || *end != '\0' || value <= 0 || value > 65535)
+		return -1;
+
+	*port = (int)value;
+	return 0;
+}
+
+/* Fyll inn felles felt; returnerer endpoint uten "udp:"/"shm:" prefiks */
+static const char *transport_init(struct viz_transport *t,
+				  const char *endpoint)
+{
+	memset(t, 0, sizeof(*t));
+	t->sock = -1;
+	t->uring.ring_fd = -1;
+	t->sender.sock = -1;
+	t->uds_sender.sock = -1;
+	snprintf(t->endpoint, sizeof(t->endpoint), "%s", endpoint);
+
+	if (strncmp(endpoint, "shm:", 4) == 0) {
+		t->kind = VIZ_TRANSPORT_SHM;
+		return endpoint + 4;
+	}
+
+	if (strncmp(endpoint, "unix:", 5) == 0) {
+		t->kind = VIZ_TRANSPORT_UNIX;
+		t->path = t->endpoint + 5;
+		return t->path;
+	}
+
+	t->kind = VIZ_TRANSPORT_UDP;
+	if (strncmp(endpoint, "udp:", 4) == 0)
+		return endpoint + 4;
+	if (strncmp(endpoint, "uring:", 6) == 0)
+		return endpoint + 6;
+	return endpoint;
+}
+
+/**
+ * viz_transport_open_receiver - Åpne transport for mottak
+ * @t: transport som initialiseres
+ * @endpoint: endpoint-streng
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_transport_open_receiver(struct viz_transport *t, const char *endpoint)
+{
+	const char *spec = transport_init(t, endpoint);
+	char host[VIZ_ENDPOINT_MAX];
+	int port;
+
+	if (t->kind == VIZ_TRANSPORT_SHM)
+		return shm_create_receiver(&t->shm, spec);
+
+	if (t->kind == VIZ_TRANSPORT_UNIX) {
+		t->sock = uds_create_receiver(spec);
+		return t->sock < 0 ? -1 : 0;
+	}
+
+	if (parse_udp_endpoint(spec, host, sizeof(host), &port) < 0) {
+		fprintf(stderr, "Invalid endpoint: %s\n", endpoint);
+		return -1;
+	}
+
+	if (udp_is_multicast(host))
+		t->sock = udp_create_multicast_receiver(host, port);
+	else
+		t->sock = udp_create_receiver(port);
+	if (t->sock < 0)
+		return -1;
+
+	if (strncmp(endpoint, "uring:", 6) == 0) {
+		if (udp_uring_open(&t->uring, t->sock) == 0)
+			printf("Receiving port %d with io_uring\n", port);
+		else
+			fprintf(stderr, "io_uring unavailable, using recvmmsg "
+				"on port %d\n", port);
+	}
+
+	return 0;
+}
+
+static int uring_batch(void *ctx, struct udp_batch *batch)
+{
+	return udp_uring_receive_batch(ctx, batch);
+}
+
+/**
+ * viz_transport_open_sender - Åpne transport for sending
+ * @t: transport som initialiseres
+ * @endpoint: endpoint-streng
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_transport_open_sender(struct viz_transport *t, const char *endpoint)
+{
+	const char *spec = transport_init(t, endpoint);
+	char host[VIZ_ENDPOINT_MAX];
+	int port;
+
+	if (t->kind == VIZ_TRANSPORT_SHM)
+		return shm_open_sender(&t->shm, spec);
+
+	if (t->kind == VIZ_TRANSPORT_UNIX)
+		return uds_sender_open(&t->uds_sender, spec);
+
+	if (parse_udp_endpoint(spec, host, sizeof(host), &port) < 0) {
+		fprintf(stderr, "Invalid endpoint: %s\n", endpoint);
+		return -1;
+	}
+
+	return udp_sender_open(&t->sender, host[0] ? host : NULL, &port, 1, 0);
+}
+
+/**
+ * viz_transport_send - Send én melding
+ * @t: sender-transport
+ * @data: payload
+ * @length: antall bytes
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_transport_send(struct viz_transport *t, const void *data,
+		       size_t length)
+{
+	if (t->kind == VIZ_TRANSPORT_SHM)
+		return shm_send(&t->shm, data, length);
+	if (t->kind == VIZ_TRANSPORT_UNIX)
+		return uds_sender_send(&t->uds_sender, data, length);
+	return udp_sender_send(&t->sender, 0, data, length);
+}
+
+/**
+ * viz_transport_receive_batch - Motta ventende meldinger
+ * @t: mottaker-transport
+ * @batch: output - meldinger
+ *
+ * UDP og unix-sockets er begge datagram-sockets og deler mottakskode.
+ *
+ * Retur: antall meldinger, 0 hvis ingen, -1 ved feil
+ */
+int viz_transport_receive_batch(struct viz_transport *t,
+				struct udp_batch *batch)
+{
+	if (t->kind == VIZ_TRANSPORT_SHM)
+		return shm_receive_batch(&t->shm, batch);
+	if (t->uring.ring_fd >= 0)
+		return udp_uring_receive_batch(&t->uring, batch);
+	return udp_receive_batch(t->sock, batch);
+}
+
+/**
+ * viz_transport_receive_latest - Motta nyeste gyldige melding
+ * @t: mottaker-transport
+ * @buffer: output
+ * @buffer_size: størrelse på buffer
+ * @accept: validering (kan være NULL)
+ * @coalesced: output - antall eldre meldinger forkastet (kan være NULL)
+ *
+ * Retur: antall bytes i @buffer, 0 hvis ingen, -1 ved feil
+ */
+int viz_transport_receive_latest(struct viz_transport *t, void *buffer,
+				 size_t buffer_size, udp_accept_fn accept,
+				 int *coalesced)
+{
+	if (t->kind == VIZ_TRANSPORT_SHM)
+		return shm_receive_latest(&t->shm, buffer, buffer_size, accept,
+					  coalesced);
+	if (t->uring.ring_fd >= 0)
+		return udp_drain_latest(uring_batch, &t->uring, buffer,
+					buffer_size, accept, coalesced);
+	return udp_receive_latest(t->sock, buffer, buffer_size, accept,
+				  coalesced);
+}
+
+/**
+ * viz_transport_fd - File descriptor som blir lesbar ved nye meldinger
+ * @t: mottaker-transport
+ *
+ * Med io_uring er det ring-fd som blir lesbar (completions), ikke
+ * socketen.
+ *
+ * Retur: fd, eller -1 hvis transporten ikke har en
+ */
+int viz_transport_fd(const struct viz_transport *t)
+{
+	if (t->kind == VIZ_TRANSPORT_SHM)
+		return -1;
+	if (t->uring.ring_fd >= 0)
+		return t->uring.ring_fd;
+	return t->sock;
+}
+
+/**
+ * viz_transport_close - Lukk transport
+ * @t: transport
+ */
+void viz_transport_close(struct viz_transport *t)
+{
+	if (t->kind == VIZ_TRANSPORT_SHM) {
+		shm_close(&t->shm);
+		return;
+	}
+
+	if (t->kind == VIZ_TRANSPORT_UNIX) {
+		uds_close_receiver(t->sock, t->path);
+		uds_sender_close(&t->uds_sender);
+		t->sock = -1;
+		return;
+	}
+
+	if (t->uring.ring_fd >= 0)
+		udp_uring_close(&t->uring);
+	if (t->sock >= 0)
+		close(t->sock);
+	udp_sender_close(&t->sender);
+	t->sock = -1;
+}
@@ -0,0 +1,108 @@
+#define _DEFAULT_SOURCE
+#include "triple_buffer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * viz_triple_init - Alloker tre nullstilte slots
+ * @tb: buffer som initialiseres
+ * @size: størrelse per slot
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int viz_triple_init(struct viz_triple_buffer *tb, size_t size)
+{
+	tb->slots = calloc(3, size);
+	if (!tb->slots) {
+		perror("calloc");
+		return -1;
+	}
+
+	tb->size = size;
+	tb->back = 0;
+	atomic_init(&tb->middle, 1);
+	tb->front = 2;
+
+	return 0;
+}
+
+/**
+ * viz_triple_back - Slotten skriveren skal fylle
+ * @tb: buffer
+ *
+ * Retur: peker til @tb->size bytes
+ */
+void *viz_triple_back(struct viz_triple_buffer *tb)
+{
+	return tb->slots + tb->back * tb->size;
+}
+
+/**
+ * viz_triple_publish - Publiser back-slotten
+ * @tb: buffer
+ *
+ * Release gjør innholdet synlig for leseren som bytter den inn (acquire).
+ * Den gamle middle-slotten blir ny back; leseren har den ikke, for
+ * leseren bytter bare med middle.
+ *
+ * Retur: 1 hvis leseren hadde hentet forrige tilstand, 0 hvis ikke
+ */
+int viz_triple_publish(struct viz_triple_buffer *tb)
+{
+	unsigned int old;
+
+	old = atomic_exchange_explicit(&tb->middle, tb->back | VIZ_TRIPLE_FRESH,
+				       memory_order_acq_rel);
+	tb->back = old & ~VIZ_TRIPLE_FRESH;
+
+	return !(old & VIZ_TRIPLE_FRESH);
+}
+
+/**
+ * viz_triple_pending - Sjekk om det finnes en tilstand leseren ikke har hentet
+ * @tb: buffer
+ *
+ * Retur: 1 hvis viz_triple_read() vil gi en ny tilstand, ellers 0
+ */
+int viz_triple_pending(struct viz_triple_buffer *tb)
+{
+	return !!(atomic_load_explicit(&tb->middle, memory_order_relaxed) &
+		  VIZ_TRIPLE_FRESH);
+}
+
+/**
+ * viz_triple_read - Hent nyeste publiserte tilstand
+ * @tb: buffer
+ * @fresh: output - 1 hvis tilstanden er ny siden forrige kall (kan være
+ *	   NULL)
+ *
+ * Retur: peker til front-slotten
+ */
+const void *viz_triple_read(struct viz_triple_buffer *tb, int *fresh)
+{
+	unsigned int old;
+	int is_fresh = 0;
+
+	/* Billig sjekk først; byttet gjøres bare når det er noe nytt */
+	if (atomic_load_explicit(&tb->middle, memory_order_relaxed) &
+	    VIZ_TRIPLE_FRESH) {
+		old = atomic_exchange_explicit(&tb->middle, tb->front,
+					       memory_order_acq_rel);
+		tb->front = old & ~VIZ_TRIPLE_FRESH;
+		is_fresh = 1;
+	}
+
+	if (fresh)
+		*fresh = is_fresh;
+	return tb->slots + tb->front * tb->size;
+}
+
+/**
+ * viz_triple_destroy - Frigjør slottene
+ * @tb: buffer
+ */
+void viz_triple_destroy(struct viz_triple_buffer *tb)
+{
+	free(tb->slots);
+	tb->slots = NULL;
+}
@@ -1,5 +1,9 @@
+#define _GNU_SOURCE /* recvmmsg */
+#include "udp.h"
 #include <errno.h>
 #include <fcntl.h>
+#include <arpa/inet.h>
+#include <netdb.h>
 #include <netinet/in.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -47,6 +51,84 @@ int udp_create_receiver(int port)
 	return sock;
 }
 
+/**
+ * udp_is_multicast - Sjekk om host er en IPv4 multicast-adresse
+ * @host: numerisk adresse
+ *
+ * Retur: 1 hvis 224.0.0.0/4, ellers 0
+ */
+int udp_is_multicast(const char *host)
+{
+	struct in_addr addr;
+
+	if (!host || inet_pton(AF_INET, host, &addr) != 1)
+		return 0;
+	return IN_MULTICAST(ntohl(addr.s_addr));
+}
+
+/**
+ * udp_create_multicast_receiver - Lag UDP socket som mottar fra gruppe
+ * @group: multicast-gruppe
+ * @port: port
+ *
+ * SO_REUSEADDR (og SO_REUSEPORT der det finnes) lar flere prosesser
+ * binde samme port; kjernen gir hver av dem en kopi av multicast. Bind
+ * til gruppe-adressen, så unicast til samme port ikke blandes inn.
+ * Gruppen meldes inn på interfacet ruten til gruppen går ut på.
+ *
+ * Retur: non-blocking socket, eller -1 ved feil
+ */
+int udp_create_multicast_receiver(const char *group, int port)
+{
+	struct sockaddr_in addr;
+	struct ip_mreq mreq;
+	int sock, flags, one = 1;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	if (inet_pton(AF_INET, group, &addr.sin_addr) != 1 ||
+	    !IN_MULTICAST(ntohl(addr.sin_addr.s_addr))) {
+		fprintf(stderr, "%s: not a multicast address\n", group);
+		return -1;
+	}
+
+	sock = socket(AF_INET, SOCK_DGRAM, 0);
+	if (sock < 0) {
+		perror("socket");
+		return -1;
+	}
+
+	flags = fcntl(sock, F_GETFL, 0);
+	fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+
+	if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0)
+		perror("setsockopt SO_REUSEADDR");
+#ifdef SO_REUSEPORT
+	if (setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) < 0)
+		perror("setsockopt SO_REUSEPORT");
+#endif
+
+	if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		perror("bind");
+		close(sock);
+		return -1;
+	}
+
+	mreq.imr_multiaddr = addr.sin_addr;
+	mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+	if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq,
+		       sizeof(mreq)) < 0) {
+		perror("setsockopt IP_ADD_MEMBERSHIP");
+		close(sock);
+		return -1;
+	}
+
+	printf("UDP receiver listening on %s:%d (multicast)\n", group, port);
+
+	return sock;
+}
+
 /**
  * udp_receive - Motta data fra UDP socket
  * @sock: socket file descriptor
@@ -71,4 +153,351 @@ int udp_receive(int sock, void *buffer, size_t buffer_size)
 	}
 
 	return n;
-}
\ No newline at end of file
+}
+
+#ifdef __linux__
+static int receive_batch(int sock, struct udp_batch *batch)
+{
+	struct mmsghdr msgs[UDP_BATCH_MAX];
+	struct iovec iov[UDP_BATCH_MAX];
+	int i, n;
+
+	for (i = 0; i < UDP_BATCH_MAX; i++) {
+		iov[i].iov_base = batch->data[i];
+		iov[i].iov_len = UDP_DATAGRAM_MAX;
+		memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	n = recvmmsg(sock, msgs, UDP_BATCH_MAX, MSG_DONTWAIT, NULL);
+	if (n < 0)
+		return -1;
+
+	for (i = 0; i < n; i++) {
+		batch->length[i] = msgs[i].msg_len;
+		batch->truncated[i] = !!(msgs[i].msg_hdr.msg_flags & MSG_TRUNC);
+	}
+
+	return n;
+}
+#else
+static int receive_batch(int sock, struct udp_batch *batch)
+{
+	struct msghdr msg;
+	struct iovec iov;
+	ssize_t len;
+	int n;
+
+	for (n = 0; n < UDP_BATCH_MAX; n++) {
+		iov.iov_base = batch->data[n];
+		iov.iov_len = UDP_DATAGRAM_MAX;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+
+		len = recvmsg(sock, &msg, 0);
+		if (len < 0)
+			return n > 0 ? n : -1;
+
+		batch->length[n] = len;
+		batch->truncated[n] = !!(msg.msg_flags & MSG_TRUNC);
+	}
+
+	return n;
+}
+#endif
+
+/**
+ * udp_receive_batch - Motta alle ventende datagrammer (opptil UDP_BATCH_MAX)
+ * @sock: non-blocking socket
+ * @batch: output - mottatte datagrammer
+ *
+ * Retur: antall datagrammer, 0 hvis ingen data, -1 ved feil
+ */
+int udp_receive_batch(int sock, struct udp_batch *batch)
+{
+	int n;
+
+	batch->count = 0;
+
+	n = receive_batch(sock, batch);
+	if (n < 0) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+			return 0; /* Ingen data tilgjengelig */
+		perror("recvmmsg");
+		return -1;
+	}
+
+	batch->count = n;
+	return n;
+}
+
+static int socket_batch(void *ctx, struct udp_batch *batch)
+{
+	return udp_receive_batch(*(int *)ctx, batch);
+}
+
+/**
+ * udp_receive_latest - Tøm socket og behold nyeste gyldige datagram
+ * @sock: non-blocking socket
+ * @buffer: output - nyeste gyldige datagram
+ * @buffer_size: størrelse på buffer
+ * @accept: validering, NULL godtar alt som passer i @buffer
+ * @coalesced: output - antall forkastede eldre gyldige datagrammer
+ *
+ * Leser batch for batch til køen er tom. Bare det siste gyldige
+ * datagrammet kopieres ut, så eldre data koster bare recvmmsg-kallet.
+ *
+ * Retur: antall bytes i @buffer, 0 hvis ingen gyldige data, -1 ved feil
+ */
+int udp_receive_latest(int sock, void *buffer, size_t buffer_size,
+		       udp_accept_fn accept, int *coalesced)
+{
+	return udp_drain_latest(socket_batch, &sock, buffer, buffer_size,
+				accept, coalesced);
+}
+
+/**
+ * udp_drain_latest - Som udp_receive_latest() for en vilkårlig mottaker
+ * @fetch: henter én batch
+ * @ctx: sendes til @fetch
+ * @buffer: output - nyeste gyldige datagram
+ * @buffer_size: størrelse på buffer
+ * @accept: validering (kan være NULL)
+ * @coalesced: output - antall forkastede eldre gyldige datagrammer
+ *
+ * Retur: antall bytes i @buffer, 0 hvis ingen gyldige data, -1 ved feil
+ */
+int udp_drain_latest(udp_batch_fn fetch, void *ctx, void *buffer,
+		     size_t buffer_size, udp_accept_fn accept, int *coalesced)
+{
+	static _Thread_local struct udp_batch batch;
+	size_t len;
+	int i, n, valid = 0, ret = 0;
+
+	do {
+		n = fetch(ctx, &batch);
+		if (n < 0)
+			return -1;
+
+		/* Nyeste gyldige datagram i denne batchen */
+		for (i = n - 1; i >= 0; i--) {
+			len = batch.length[i];
+			if (batch.truncated[i] || len > buffer_size)
+				continue;
+			if (accept && !accept(batch.data[i], len))
+				continue;
+
+			memcpy(buffer, batch.data[i], len);
+			ret = (int)len;
+			break;
+		}
+
+		/* Tell gyldige datagrammer for coalesced-statistikk */
+		for (; i >= 0; i--) {
+			len = batch.length[i];
+			if (!batch.truncated[i] && len <= buffer_size &&
+			    (!accept || accept(batch.data[i], len)))
+				valid++;
+		}
+	} while (n == UDP_BATCH_MAX);
+
+	if (coalesced)
+		*coalesced = valid > 0 ? valid - 1 : 0;
+
+	return ret;
+}
+
+/**
+ * udp_sender_open - Lag UDP sender til én eller flere porter
+ * @sender: sender som initialiseres
+ * @host: destinasjon, NULL for 127.0.0.1
+ * @ports: destinasjonsport per strøm
+ * @num_streams: antall strømmer
+ * @sndbuf: SO_SNDBUF i bytes, 0 for default
+ *
+ * Navneoppslag og adresseoppsett gjøres bare her, ikke per packet. Er
+ * @host en multicast-gruppe, sendes ett datagram uansett antall
+ * mottakere; loopback er på, så mottakere på samme maskin får det også.
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int udp_sender_open(struct udp_sender *sender, const char *host,
+		    const int ports[], int num_streams, int sndbuf)
+{
+	const char *addr = host ? host : "127.0.0.1";
+	struct addrinfo hints, *res;
+	int i, err;
+
+	if (num_streams < 1 || num_streams > UDP_SENDER_MAX_STREAMS) {
+		fprintf(stderr, "udp_sender_open: invalid stream count %d\n",
+			num_streams);
+		return -1;
+	}
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	err = getaddrinfo(addr, NULL, &hints, &res);
+	if (err) {
+		fprintf(stderr, "%s: %s\n", addr, gai_strerror(err));
+		return -1;
+	}
+
+	for (i = 0; i < num_streams; i++) {
+		memcpy(&sender->addrs[i], res->ai_addr, sizeof(sender->addrs[i]));
+		sender->addrs[i].sin_port = htons(ports[i]);
+	}
+	freeaddrinfo(res);
+
+	sender->num_streams = num_streams;
+	sender->sock = socket(AF_INET, SOCK_DGRAM, 0);
+	if (sender->sock < 0) {
+		perror("socket");
+		return -1;
+	}
+
+	if (sndbuf > 0 && setsockopt(sender->sock, SOL_SOCKET, SO_SNDBUF,
+				     &sndbuf, sizeof(sndbuf)) < 0)
+		perror("setsockopt SO_SNDBUF");
+
+	if (IN_MULTICAST(ntohl(sender->addrs[0].sin_addr.s_addr))) {
+		unsigned char ttl = UDP_MULTICAST_TTL, loop = 1;
+
+		if (setsockopt(sender->sock, IPPROTO_IP, IP_MULTICAST_TTL, &ttl,
+			       sizeof(ttl)) < 0)
+			perror("setsockopt IP_MULTICAST_TTL");
+		if (setsockopt(sender->sock, IPPROTO_IP, IP_MULTICAST_LOOP,
+			       &loop, sizeof(loop)) < 0)
+			perror("setsockopt IP_MULTICAST_LOOP");
+	}
+
+	/* Én strøm: kernel slår opp rute og adresse én gang */
+	if (num_streams == 1 &&
+	    connect(sender->sock, (struct sockaddr *)&sender->addrs[0],
+		    sizeof(sender->addrs[0])) < 0) {
+		perror("connect");
+		close(sender->sock);
+		sender->sock = -1;
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * ECONNREFUSED kommer fra ICMP på en connect()-et socket når ingen lytter
+ * ennå. Visualizeren kan startes etter senderen, så det er ikke en feil.
+ */
+static int send_failed(const char *what)
+{
+	if (errno == ECONNREFUSED)
+		return 0;
+	perror(what);
+	return -1;
+}
+
+/**
+ * udp_sender_send - Send ett datagram
+ * @sender: sender
+ * @stream: strøm-indeks
+ * @data: payload
+ * @length: antall bytes
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int udp_sender_send(struct udp_sender *sender, int stream, const void *data,
+		    size_t length)
+{
+	ssize_t sent;
+
+	if (stream < 0 || stream >= sender->num_streams)
+		return -1;
+
+	if (sender->num_streams == 1)
+		sent = send(sender->sock, data, length, 0);
+	else
+		sent = sendto(sender->sock, data, length, 0,
+			      (struct sockaddr *)&sender->addrs[stream],
+			      sizeof(sender->addrs[stream]));
+
+	if (sent < 0)
+		return send_failed("send");
+
+	return 0;
+}
+
+#ifdef __linux__
+/**
+ * udp_sender_send_batch - Send flere datagrammer i ett kall
+ * @sender: sender
+ * @msgs: datagrammer
+ * @count: antall datagrammer (maks UDP_BATCH_MAX)
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int udp_sender_send_batch(struct udp_sender *sender,
+			  const struct udp_message *msgs, int count)
+{
+	struct mmsghdr hdrs[UDP_BATCH_MAX];
+	struct iovec iov[UDP_BATCH_MAX];
+	int i, n, done = 0;
+
+	if (count < 0 || count > UDP_BATCH_MAX)
+		return -1;
+
+	for (i = 0; i < count; i++) {
+		if (msgs[i].stream < 0 || msgs[i].stream >= sender->num_streams)
+			return -1;
+
+		iov[i].iov_base = (void *)msgs[i].data;
+		iov[i].iov_len = msgs[i].length;
+		memset(&hdrs[i].msg_hdr, 0, sizeof(hdrs[i].msg_hdr));
+		hdrs[i].msg_hdr.msg_iov = &iov[i];
+		hdrs[i].msg_hdr.msg_iovlen = 1;
+		if (sender->num_streams > 1) {
+			hdrs[i].msg_hdr.msg_name = &sender->addrs[msgs[i].stream];
+			hdrs[i].msg_hdr.msg_namelen = sizeof(sender->addrs[0]);
+		}
+	}
+
+	/* sendmmsg kan stoppe tidlig, f.eks. ved full sendebuffer */
+	while (done < count) {
+		n = sendmmsg(sender->sock, hdrs + done, count - done, 0);
+		if (n < 0) {
+			if (send_failed("sendmmsg") < 0)
+				return -1;
+			n = 1; /* Hopp over datagrammet som ble avvist */
+		}
+		done += n;
+	}
+
+	return 0;
+}
+#else
+int udp_sender_send_batch(struct udp_sender *sender,
+			  const struct udp_message *msgs, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (udp_sender_send(sender, msgs[i].stream, msgs[i].data,
+				    msgs[i].length) < 0)
+			return -1;
+	}
+
+	return 0;
+}
+#endif
+
+/**
+ * udp_sender_close - Lukk sender
+ * @sender: sender fra udp_sender_open()
+ */
+void udp_sender_close(struct udp_sender *sender)
+{
+	if (sender->sock >= 0)
+		close(sender->sock);
+	sender->sock = -1;
+}
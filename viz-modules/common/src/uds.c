@@ -0,0 +1,197 @@
+#define _DEFAULT_SOURCE
+#include "uds.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * uds_make_addr - Bygg sockaddr_un fra sti eller "@navn"
+ * @path: filsti eller abstract navn
+ * @addr: output adresse
+ * @addr_len: output lengde
+ *
+ * Retur: 0 ved suksess, -1 hvis navnet er for langt eller ikke støttes
+ */
+static int uds_make_addr(const char *path, struct sockaddr_un *addr,
+			 socklen_t *addr_len)
+{
+	size_t len = strlen(path);
+
+	memset(addr, 0, sizeof(*addr));
+	addr->sun_family = AF_UNIX;
+
+	if (len == 0 || len >= sizeof(addr->sun_path)) {
+		fprintf(stderr, "unix socket: invalid path '%s'\n", path);
+		return -1;
+	}
+
+	if (path[0] == '@') {
+#ifdef __linux__
+		/* Abstract: ledende null-byte, lengden avgjør navnet */
+		memcpy(addr->sun_path + 1, path + 1, len - 1);
+		*addr_len = offsetof(struct sockaddr_un, sun_path) + len;
+		return 0;
+#else
+		fprintf(stderr, "unix socket: abstract names need Linux\n");
+		return -1;
+#endif
+	}
+
+	memcpy(addr->sun_path, path, len);
+	*addr_len = offsetof(struct sockaddr_un, sun_path) + len + 1;
+	return 0;
+}
+
+static int uds_socket(void)
+{
+	int sock, flags;
+
+	sock = socket(AF_UNIX, SOCK_DGRAM, 0);
+	if (sock < 0) {
+		perror("socket");
+		return -1;
+	}
+
+	flags = fcntl(sock, F_GETFL, 0);
+	fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+
+	return sock;
+}
+
+/**
+ * uds_path_in_use - Sjekk om en mottaker allerede lytter på stien
+ * @addr: adresse fra uds_make_addr()
+ * @addr_len: lengde fra uds_make_addr()
+ *
+ * Socket-filen blir liggende etter en mottaker som ikke ryddet opp.
+ * Svarer den ikke (ECONNREFUSED), er den foreldet og fjernes.
+ *
+ * Retur: 1 hvis en mottaker svarer, ellers 0
+ */
+static int uds_path_in_use(const struct sockaddr_un *addr, socklen_t addr_len)
+{
+	int sock, in_use = 0;
+
+	sock = socket(AF_UNIX, SOCK_DGRAM, 0);
+	if (sock < 0)
+		return 0;
+
+	if (connect(sock, (const struct sockaddr *)addr, addr_len) == 0)
+		in_use = 1;
+	else if (errno == ECONNREFUSED)
+		unlink(addr->sun_path);
+
+	close(sock);
+	return in_use;
+}
+
+/**
+ * uds_create_receiver - Lag unix datagram-socket for mottak
+ * @path: filsti, eller "@navn" for abstract namespace
+ *
+ * Retur: socket file descriptor, eller -1 ved feil
+ */
+int uds_create_receiver(const char *path)
+{
+	struct sockaddr_un addr;
+	socklen_t addr_len;
+	int sock;
+
+	if (uds_make_addr(path, &addr, &addr_len) < 0)
+		return -1;
+
+	if (path[0] != '@' && uds_path_in_use(&addr, addr_len)) {
+		fprintf(stderr, "%s: another receiver is listening\n", path);
+		return -1;
+	}
+
+	sock = uds_socket();
+	if (sock < 0)
+		return -1;
+
+	if (bind(sock, (struct sockaddr *)&addr, addr_len) < 0) {
+		perror("bind");
+		close(sock);
+		return -1;
+	}
+
+	printf("Unix receiver listening on %s\n", path);
+
+	return sock;
+}
+
+/**
+ * uds_close_receiver - Lukk mottaker og fjern socket-filen
+ * @sock: socket fra uds_create_receiver()
+ * @path: samme sti som ved opprettelse
+ */
+void uds_close_receiver(int sock, const char *path)
+{
+	if (sock < 0)
+		return;
+
+	close(sock);
+	if (path[0] != '@')
+		unlink(path);
+}
+
+/**
+ * uds_sender_open - Lag sender
+ * @sender: sender som initialiseres
+ * @path: mottakerens filsti eller "@navn"
+ *
+ * Socketen connect()-es ikke, så mottakeren kan startes (på nytt) når
+ * som helst.
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int uds_sender_open(struct uds_sender *sender, const char *path)
+{
+	sender->sock = -1;
+	if (uds_make_addr(path, &sender->addr, &sender->addr_len) < 0)
+		return -1;
+
+	sender->sock = uds_socket();
+	return sender->sock < 0 ? -1 : 0;
+}
+
+/**
+ * uds_sender_send - Send én melding
+ * @sender: sender
+ * @data: payload
+ * @length: antall bytes
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+int uds_sender_send(struct uds_sender *sender, const void *data,
+		    size_t length)
+{
+	ssize_t sent;
+
+	sent = sendto(sender->sock, data, length, 0,
+		      (struct sockaddr *)&sender->addr, sender->addr_len);
+	if (sent < 0) {
+		/* Ingen mottaker, eller mottakskøen er full */
+		if (errno == ENOENT || errno == ECONNREFUSED ||
+		    errno == EAGAIN || errno == EWOULDBLOCK)
+			return 0;
+		perror("sendto");
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * uds_sender_close - Lukk sender
+ * @sender: sender
+ */
+void uds_sender_close(struct uds_sender *sender)
+{
+	if (sender->sock >= 0)
+		close(sender->sock);
+	sender->sock = -1;
+}
@@ -0,0 +1,378 @@
+#define _DEFAULT_SOURCE
+#include "uring.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+/* Felt delt med kjernen er vanlige heltall; samme triks som liburing */
+#define load_acquire(p) \
+	atomic_load_explicit((_Atomic __typeof__(*(p)) *)(p), \
+			     memory_order_acquire)
+#define store_release(p, v) \
+	atomic_store_explicit((_Atomic __typeof__(*(p)) *)(p), (v), \
+			      memory_order_release)
+
+#define URING_SQ_ENTRIES 4 /* Bare én multishot recv i bruk */
+#define URING_CQ_ENTRIES 512 /* > UDP_URING_BUFFERS, så CQ ikke flyter over */
+#define URING_BUFFER_GROUP 0
+
+/* Multishot recv kom i 6.0; eldre kjerner avviser den først ved mottak */
+static int kernel_has_multishot_recv(void)
+{
+	struct utsname u;
+	int major;
+
+	if (uname(&u) < 0 || sscanf(u.release, "%d.", &major) != 1)
+		return 0;
+	return major >= 6;
+}
+
+static int uring_enter(int fd, unsigned int to_submit, unsigned int flags)
+{
+	int ret;
+
+	do {
+		ret = (int)syscall(__NR_io_uring_enter, fd, to_submit, 0, flags,
+				   NULL, 0);
+	} while (ret < 0 && errno == EINTR);
+
+	return ret;
+}
+
+/* Gi buffer @bid tilbake til kjernen (synlig ved neste store_release) */
+static void uring_recycle(struct udp_uring *r, unsigned short bid)
+{
+	struct io_uring_buf *buf;
+
+	buf = &r->buf_ring->bufs[r->buf_tail & (UDP_URING_BUFFERS - 1)];
+	buf->addr = (uintptr_t)(r->buffers +
+				(size_t)bid * UDP_URING_BUFFER_SIZE);
+	buf->len = UDP_URING_BUFFER_SIZE;
+	buf->bid = bid;
+	r->buf_tail++;
+}
+
+/* Send multishot recv. Retur: 0 ved suksess, -1 ved feil */
+static int uring_arm(struct udp_uring *r)
+{
+	struct io_uring_sqe *sqe;
+	unsigned int tail, index;
+
+	tail = *r->sq_tail;
+	index = tail & *r->sq_mask;
+	sqe = &r->sqes[index];
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_RECV;
+	sqe->fd = r->sock;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = URING_BUFFER_GROUP;
+	sqe->user_data = 1;
+
+	r->sq_array[index] = index;
+	store_release(r->sq_tail, tail + 1);
+
+	if (uring_enter(r->ring_fd, 1, 0) < 0) {
+		perror("io_uring_enter");
+		return -1;
+	}
+
+	r->armed = 1;
+	r->rearms++;
+	return 0;
+}
+
+/*
+ * Les det som ligger i socketen inn i @batch fra plass @n, etter at
+ * multishot stoppet på ENOBUFS. Datagrammene har ikke fått buffer og
+ * ingen completion, så uten dette ville en ny multishot først levere dem
+ * etter at kalleren har tatt en eldre pose som nyeste. @r->draining
+ * nullstilles når socketen er tom.
+ *
+ * Retur: nytt antall datagrammer i @batch, -1 ved feil
+ */
+static int uring_drain_socket(struct udp_uring *r, struct udp_batch *batch,
+			      int n)
+{
+	ssize_t len;
+
+	while (n < UDP_BATCH_MAX) {
+		len = recv(r->sock, batch->data[n], UDP_DATAGRAM_MAX,
+			   MSG_DONTWAIT | MSG_TRUNC);
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				r->draining = 0;
+				return n;
+			}
+			perror("recv");
+			return -1;
+		}
+
+		batch->truncated[n] = len > UDP_DATAGRAM_MAX;
+		batch->length[n] = len > UDP_DATAGRAM_MAX ? UDP_DATAGRAM_MAX :
+							    (size_t)len;
+		n++;
+	}
+
+	return n;
+}
+
+/**
+ * udp_uring_open - Sett opp io_uring mottak for socket
+ * @r: mottaker som initialiseres
+ * @sock: UDP socket
+ *
+ * Retur: 0 ved suksess, -1 hvis io_uring ikke kan brukes
+ */
+int udp_uring_open(struct udp_uring *r, int sock)
+{
+	struct io_uring_params p;
+	struct io_uring_buf_reg reg;
+	size_t buf_ring_size;
+	unsigned short i;
+
+	memset(r, 0, sizeof(*r));
+	r->ring_fd = -1;
+	r->sock = sock;
+
+	if (!kernel_has_multishot_recv())
+		return -1;
+
+	memset(&p, 0, sizeof(p));
+	p.flags = IORING_SETUP_CQSIZE;
+	p.cq_entries = URING_CQ_ENTRIES;
+	r->ring_fd = (int)syscall(__NR_io_uring_setup, URING_SQ_ENTRIES, &p);
+	if (r->ring_fd < 0)
+		return -1; /* ENOSYS, EPERM (io_uring_disabled/seccomp) */
+
+	r->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+	r->cq_ring_size = p.cq_off.cqes +
+			  p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		if (r->cq_ring_size > r->sq_ring_size)
+			r->sq_ring_size = r->cq_ring_size;
+		r->cq_ring_size = r->sq_ring_size;
+	}
+
+	r->sq_ring = mmap(NULL, r->sq_ring_size, PROT_READ | PROT_WRITE,
+			  MAP_SHARED | MAP_POPULATE, r->ring_fd,
+			  IORING_OFF_SQ_RING);
+	if (r->sq_ring == MAP_FAILED) {
+		r->sq_ring = NULL;
+		goto err;
+	}
+
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		r->cq_ring = r->sq_ring;
+	} else {
+		r->cq_ring = mmap(NULL, r->cq_ring_size, PROT_READ | PROT_WRITE,
+				  MAP_SHARED | MAP_POPULATE, r->ring_fd,
+				  IORING_OFF_CQ_RING);
+		if (r->cq_ring == MAP_FAILED) {
+			r->cq_ring = NULL;
+			goto err;
+		}
+	}
+
+	r->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+	r->sqes = mmap(NULL, r->sqes_size, PROT_READ | PROT_WRITE,
+		       MAP_SHARED | MAP_POPULATE, r->ring_fd, IORING_OFF_SQES);
+	if (r->sqes == MAP_FAILED) {
+		r->sqes = NULL;
+		goto err;
+	}
+
+	r->sq_head = (unsigned int *)((char *)r->sq_ring + p.sq_off.head);
+	r->sq_tail = (unsigned int *)((char *)r->sq_ring + p.sq_off.tail);
+	r->sq_mask = (unsigned int *)((char *)r->sq_ring + p.sq_off.ring_mask);
+	r->sq_array = (unsigned int *)((char *)r->sq_ring + p.sq_off.array);
+	r->sq_flags = (unsigned int *)((char *)r->sq_ring + p.sq_off.flags);
+	r->cq_head = (unsigned int *)((char *)r->cq_ring + p.cq_off.head);
+	r->cq_tail = (unsigned int *)((char *)r->cq_ring + p.cq_off.tail);
+	r->cq_mask = (unsigned int *)((char *)r->cq_ring + p.cq_off.ring_mask);
+	r->cqes = (struct io_uring_cqe *)((char *)r->cq_ring + p.cq_off.cqes);
+
+	/* Buffer-ringen må være side-justert; mmap gir det */
+	buf_ring_size = UDP_URING_BUFFERS * sizeof(struct io_uring_buf);
+	r->buf_ring = mmap(NULL, buf_ring_size, PROT_READ | PROT_WRITE,
+			   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (r->buf_ring == MAP_FAILED) {
+		r->buf_ring = NULL;
+		goto err;
+	}
+
+	r->buffers = malloc((size_t)UDP_URING_BUFFERS * UDP_URING_BUFFER_SIZE);
+	if (!r->buffers)
+		goto err;
+
+	memset(&reg, 0, sizeof(reg));
+	reg.ring_addr = (uintptr_t)r->buf_ring;
+	reg.ring_entries = UDP_URING_BUFFERS;
+	reg.bgid = URING_BUFFER_GROUP;
+	if (syscall(__NR_io_uring_register, r->ring_fd,
+		    IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+		goto err; /* Før 5.19 */
+
+	for (i = 0; i < UDP_URING_BUFFERS; i++)
+		uring_recycle(r, i);
+	store_release(&r->buf_ring->tail, r->buf_tail);
+
+	return 0;
+
+err:
+	udp_uring_close(r);
+	r->sock = sock;
+	return -1;
+}
+
+/**
+ * udp_uring_receive_batch - Hent mottatte datagrammer (opptil UDP_BATCH_MAX)
+ * @r: mottaker
+ * @batch: output - datagrammer
+ *
+ * Leser completions og gir bufferne tilbake etter kopiering. Stopper
+ * multishot (alle buffere opptatt, ENOBUFS), leses socketen direkte etter
+ * de siste completions til den er tom, og først da armeres multishot
+ * igjen. Slik er siste datagram i siste batch alltid det nyeste, også
+ * rett etter en burst.
+ *
+ * Retur: antall datagrammer, 0 hvis ingen, -1 ved feil
+ */
+int udp_uring_receive_batch(struct udp_uring *r, struct udp_batch *batch)
+{
+	const struct io_uring_cqe *cqe;
+	unsigned int head, tail;
+	unsigned short bid;
+	size_t len;
+	int n = 0, err = 0;
+
+	batch->count = 0;
+	if (!r->armed && !r->draining && uring_arm(r) < 0)
+		return -1;
+
+	head = *r->cq_head;
+	tail = load_acquire(r->cq_tail);
+
+	/* Completions kjernen ikke fikk plass til venter i overflow-listen */
+	if (head == tail &&
+	    (load_acquire(r->sq_flags) & IORING_SQ_CQ_OVERFLOW)) {
+		uring_enter(r->ring_fd, 0, IORING_ENTER_GETEVENTS);
+		tail = load_acquire(r->cq_tail);
+	}
+
+	while (head != tail && n < UDP_BATCH_MAX) {
+		cqe = &r->cqes[head & *r->cq_mask];
+		head++;
+
+		if (cqe->flags & IORING_CQE_F_BUFFER) {
+			bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+			if (cqe->res > 0) {
+				len = (size_t)cqe->res;
+				batch->truncated[n] = len > UDP_DATAGRAM_MAX;
+				if (len > UDP_DATAGRAM_MAX)
+					len = UDP_DATAGRAM_MAX;
+				memcpy(batch->data[n],
+				       r->buffers +
+					       (size_t)bid * UDP_URING_BUFFER_SIZE,
+				       len);
+				batch->length[n] = len;
+				n++;
+			}
+			uring_recycle(r, bid);
+		}
+
+		if (!(cqe->flags & IORING_CQE_F_MORE)) {
+			r->armed = 0;
+			if (cqe->res == -ENOBUFS)
+				r->draining = 1;
+		}
+		if (cqe->res < 0 && cqe->res != -ENOBUFS) {
+			fprintf(stderr, "io_uring recv: %s\n",
+				strerror(-cqe->res));
+			err = 1;
+		}
+	}
+
+	store_release(r->cq_head, head);
+	store_release(&r->buf_ring->tail, r->buf_tail);
+
+	/* Eldre completions først, så det som ikke fikk buffer */
+	if (r->draining && head == tail) {
+		n = uring_drain_socket(r, batch, n);
+		if (n < 0) {
+			n = 0;
+			err = 1;
+			r->draining = 0;
+		}
+	}
+
+	if (!r->armed && !r->draining && uring_arm(r) < 0)
+		err = 1;
+
+	batch->count = n;
+	return err ? -1 : n;
+}
+
+/**
+ * udp_uring_close - Lukk io_uring (ikke socketen)
+ * @r: mottaker
+ */
+void udp_uring_close(struct udp_uring *r)
+{
+	/* Lukking av ring-fd kansellerer multishot og frigjør registreringer */
+	if (r->ring_fd >= 0)
+		close(r->ring_fd);
+	if (r->sqes)
+		munmap(r->sqes, r->sqes_size);
+	if (r->cq_ring && r->cq_ring != r->sq_ring)
+		munmap(r->cq_ring, r->cq_ring_size);
+	if (r->sq_ring)
+		munmap(r->sq_ring, r->sq_ring_size);
+	if (r->buf_ring)
+		munmap(r->buf_ring,
+		       UDP_URING_BUFFERS * sizeof(struct io_uring_buf));
+	free(r->buffers);
+
+	memset(r, 0, sizeof(*r));
+	r->ring_fd = -1;
+	r->sock = -1;
+}
+
+#else /* !__linux__ */
+
+int udp_uring_open(struct udp_uring *r, int sock)
+{
+	memset(r, 0, sizeof(*r));
+	r->ring_fd = -1;
+	r->sock = sock;
+	return -1;
+}
+
+int udp_uring_receive_batch(struct udp_uring *r, struct udp_batch *batch)
+{
+	(void)r;
+	batch->count = 0;
+	errno = ENOSYS;
+	return -1;
+}
+
+void udp_uring_close(struct udp_uring *r)
+{
+	r->ring_fd = -1;
+}
+
+#endif /* __linux__ */
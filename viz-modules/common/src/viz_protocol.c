@@ -0,0 +1,712 @@
+#define _DEFAULT_SOURCE
+#include "viz_protocol.h"
+#include "transport.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * viz_time_ns - Monoton tid i nanosekunder (CLOCK_MONOTONIC)
+ */
+uint64_t viz_time_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * viz_pose_decode - Dekod pose packet (v1 eller v2)
+ * @data: payload
+ * @length: antall bytes
+ * @pose: output - pose i v1-layout (kan være NULL)
+ * @info: output - metadata (kan være NULL)
+ *
+ * Nyere versjoner godtas så lenge starten av packet er v2-layout, slik at
+ * felt kan legges til på slutten uten å bryte eldre mottakere.
+ *
+ * Retur: 0 ved suksess, -1 hvis ikke en gyldig pose packet
+ */
+int viz_pose_decode(const void *data, size_t length,
+		    struct viz_pose_packet *pose, struct viz_packet_info *info)
+{
+	const struct viz_pose_packet_v2 *v2 = data;
+	uint32_t magic;
+
+	if (length < sizeof(magic))
+		return -1;
+	memcpy(&magic, data, sizeof(magic));
+
+	if (magic == VIZ_MAGIC) {
+		const struct viz_pose_packet *v1 = data;
+
+		if (length != sizeof(*v1) || v1->type != VIZ_PACKET_POSE)
+			return -1;
+		if (pose)
+			*pose = *v1;
+		if (info) {
+			info->version = 1;
+			info->sequence = 0;
+			info->send_time_ns = 0;
+		}
+		return 0;
+	}
+
+	if (magic != VIZ_MAGIC_V2 || length < sizeof(*v2) ||
+	    v2->header.version < 2 || v2->header.type != VIZ_PACKET_POSE)
+		return -1;
+
+	if (pose) {
+		pose->magic = VIZ_MAGIC;
+		pose->type = VIZ_PACKET_POSE;
+		pose->robot_type = v2->robot_type;
+		pose->rx = v2->rx;
+		pose->ry = v2->ry;
+		pose->rz = v2->rz;
+		pose->tx = v2->tx;
+		pose->ty = v2->ty;
+		pose->tz = v2->tz;
+	}
+	if (info) {
+		info->version = v2->header.version;
+		info->sequence = v2->header.sequence;
+		info->send_time_ns = v2->header.send_time_ns;
+	}
+
+	return 0;
+}
+
+/* Packet type hvis @data er en kvantisert pose, ellers 0 */
+static int q16_packet_type(const void *data, size_t length)
+{
+	const struct viz_header *header = data;
+
+	if (length < sizeof(*header) || header->magic != VIZ_MAGIC_V2 ||
+	    header->version < 2)
+		return 0;
+
+	if (header->type == VIZ_PACKET_POSE_Q16_KEY &&
+	    length >= sizeof(struct viz_pose_q16_key))
+		return VIZ_PACKET_POSE_Q16_KEY;
+	if (header->type == VIZ_PACKET_POSE_Q16_DELTA &&
+	    length >= sizeof(struct viz_pose_q16_delta))
+		return VIZ_PACKET_POSE_Q16_DELTA;
+
+	return 0;
+}
+
+/**
+ * viz_pose_packet_accept - Sjekk om datagram er en gyldig pose packet
+ * @data: payload
+ * @length: antall bytes
+ *
+ * Delta packets godtas uten å sjekke at keyframen finnes.
+ *
+ * Retur: 1 hvis gyldig, ellers 0
+ */
+int viz_pose_packet_accept(const void *data, size_t length)
+{
+	return viz_pose_decode(data, length, NULL, NULL) == 0 ||
+	       q16_packet_type(data, length) != 0;
+}
+
+/**
+ * viz_pose_encode - Lag v2 pose packet
+ * @pose: pose
+ * @sequence: sekvensnummer, økes av funksjonen
+ * @out: output packet
+ */
+void viz_pose_encode(const struct viz_pose_packet *pose, uint32_t *sequence,
+		     struct viz_pose_packet_v2 *out)
+{
+	memset(&out->header, 0, sizeof(out->header));
+	out->header.magic = VIZ_MAGIC_V2;
+	out->header.version = VIZ_PROTOCOL_VERSION;
+	out->header.type = VIZ_PACKET_POSE;
+	out->header.sequence = (*sequence)++;
+	out->robot_type = pose->robot_type;
+	out->rx = pose->rx;
+	out->ry = pose->ry;
+	out->rz = pose->rz;
+	out->tx = pose->tx;
+	out->ty = pose->ty;
+	out->tz = pose->tz;
+
+	/* Sist, så tidsstempelet er så nær send() som mulig */
+	out->header.send_time_ns = viz_time_ns();
+}
+
+/**
+ * viz_q16_encoder_init - Start kvantisert strøm
+ * @enc: encoder
+ * @scale: område
+ * @keyframe_interval: maks packets per keyframe, 0 for default
+ */
+void viz_q16_encoder_init(struct viz_q16_encoder *enc,
+			  const struct viz_q16_scale *scale,
+			  int keyframe_interval)
+{
+	memset(enc, 0, sizeof(*enc));
+	enc->scale = *scale;
+	enc->keyframe_interval = keyframe_interval > 0 ?
+					 keyframe_interval :
+					 VIZ_Q16_KEYFRAME_INTERVAL;
+	enc->since_keyframe = -1;
+}
+
+static int16_t q16_quantize(float value, float range, uint64_t *clipped)
+{
+	float q = value / range * VIZ_Q16_MAX;
+
+	if (isnan(q)) {
+		(*clipped)++;
+		return 0;
+	}
+	if (q > VIZ_Q16_MAX) {
+		(*clipped)++;
+		return VIZ_Q16_MAX;
+	}
+	if (q < -VIZ_Q16_MAX) {
+		(*clipped)++;
+		return -VIZ_Q16_MAX;
+	}
+
+	return (int16_t)lrintf(q);
+}
+
+/**
+ * viz_pose_q16_encode - Lag kvantisert pose packet (keyframe eller delta)
+ * @enc: encoder
+ * @pose: pose
+ * @sequence: sekvensnummer, økes av funksjonen
+ * @out: output packet
+ *
+ * Keyframe ved første packet, etter @enc->keyframe_interval packets, og
+ * når et felt har flyttet seg mer enn VIZ_Q16_DELTA_MAX steg fra keyframen.
+ *
+ * Retur: antall bytes som skal sendes
+ */
+size_t viz_pose_q16_encode(struct viz_q16_encoder *enc,
+			   const struct viz_pose_packet *pose,
+			   uint32_t *sequence, union viz_pose_q16_packet *out)
+{
+	const float value[6] = { pose->rx, pose->ry, pose->rz,
+				 pose->tx, pose->ty, pose->tz };
+	int16_t q[6];
+	int i, keyframe;
+	size_t size;
+
+	for (i = 0; i < 6; i++)
+		q[i] = q16_quantize(value[i],
+				    i < 3 ? enc->scale.rotation_range :
+					    enc->scale.translation_range,
+				    &enc->clipped);
+
+	keyframe = enc->since_keyframe < 0 ||
+		   enc->since_keyframe + 1 >= enc->keyframe_interval;
+	for (i = 0; i < 6 && !keyframe; i++) {
+		if (abs(q[i] - enc->key[i]) > VIZ_Q16_DELTA_MAX)
+			keyframe = 1;
+	}
+
+	memset(&out->header, 0, sizeof(out->header));
+	out->header.magic = VIZ_MAGIC_V2;
+	out->header.version = VIZ_PROTOCOL_VERSION;
+	out->header.sequence = (*sequence)++;
+
+	if (keyframe) {
+		enc->keyframe++;
+		enc->since_keyframe = 0;
+		enc->keyframes++;
+		memcpy(enc->key, q, sizeof(enc->key));
+
+		out->header.type = VIZ_PACKET_POSE_Q16_KEY;
+		out->key.keyframe = enc->keyframe;
+		out->key.robot_type = pose->robot_type;
+		out->key.rotation_range = enc->scale.rotation_range;
+		out->key.translation_range = enc->scale.translation_range;
+		memcpy(out->key.value, q, sizeof(q));
+		size = sizeof(out->key);
+	} else {
+		enc->since_keyframe++;
+		enc->deltas++;
+
+		out->header.type = VIZ_PACKET_POSE_Q16_DELTA;
+		out->delta.keyframe = enc->keyframe;
+		out->delta.robot_type = pose->robot_type;
+		for (i = 0; i < 6; i++)
+			out->delta.delta[i] = (int8_t)(q[i] - enc->key[i]);
+		size = sizeof(out->delta);
+	}
+
+	out->header.send_time_ns = viz_time_ns();
+	return size;
+}
+
+/**
+ * viz_q16_error_bound - Største kvantiseringsfeil innenfor området
+ * @scale: område
+ * @rotation_deg: output - maks feil per rotasjonsfelt (grader)
+ * @translation_mm: output - maks feil per translasjonsfelt (mm)
+ */
+void viz_q16_error_bound(const struct viz_q16_scale *scale,
+			 float *rotation_deg, float *translation_mm)
+{
+	*rotation_deg = 0.5f * scale->rotation_range / VIZ_Q16_MAX;
+	*translation_mm = 0.5f * scale->translation_range / VIZ_Q16_MAX;
+}
+
+/*
+ * En keyframe med lavere nummer enn den gjeldende (16-bit serie-
+ * sammenligning) er forsinket og ville erstattet en nyere keyframe som
+ * deltaene bygger på. Er også sekvensnummeret langt unna, er senderen
+ * startet på nytt med ny nummerering, og keyframen gjelder.
+ */
+static int q16_keyframe_stale(const struct viz_q16_decoder *dec,
+			      const union viz_pose_q16_packet *packet)
+{
+	int32_t seq_delta;
+
+	if (!dec->has_keyframe ||
+	    (int16_t)(packet->key.keyframe - dec->keyframe) >= 0)
+		return 0;
+
+	seq_delta = (int32_t)(packet->header.sequence - dec->key_sequence);
+	return seq_delta < 0 && seq_delta > -VIZ_Q16_REORDER_WINDOW;
+}
+
+/**
+ * viz_pose_decode_q16 - Dekod kvantisert pose packet
+ * @dec: mottaker-tilstand
+ * @data: payload
+ * @length: antall bytes
+ * @pose: output - pose i v1-layout
+ * @info: output - metadata (kan være NULL)
+ *
+ * Nyeste keyframe gjelder; en forsinket eldre keyframe forkastes. Etter
+ * at senderen er startet på nytt og nummereringen har begynt forfra,
+ * gjelder den nye senderens keyframe.
+ *
+ * Retur: 0 ved suksess, -1 ved ugyldig, forsinket eller foreldreløs
+ * packet
+ */
+int viz_pose_decode_q16(struct viz_q16_decoder *dec, const void *data,
+			size_t length, struct viz_pose_packet *pose,
+			struct viz_packet_info *info)
+{
+	const union viz_pose_q16_packet *packet = data;
+	int32_t q[6];
+	int i;
+
+	switch (q16_packet_type(data, length)) {
+	case VIZ_PACKET_POSE_Q16_KEY:
+		if (!(packet->key.rotation_range > 0.0f) ||
+		    !(packet->key.translation_range > 0.0f))
+			return -1;
+		if (q16_keyframe_stale(dec, packet))
+			return -1;
+
+		dec->has_keyframe = 1;
+		dec->keyframe = packet->key.keyframe;
+		dec->key_sequence = packet->header.sequence;
+		dec->rotation_step = packet->key.rotation_range / VIZ_Q16_MAX;
+		dec->translation_step =
+			packet->key.translation_range / VIZ_Q16_MAX;
+		memcpy(dec->key, packet->key.value, sizeof(dec->key));
+		for (i = 0; i < 6; i++)
+			q[i] = dec->key[i];
+		pose->robot_type = packet->key.robot_type;
+		break;
+	case VIZ_PACKET_POSE_Q16_DELTA:
+		if (!dec->has_keyframe ||
+		    packet->delta.keyframe != dec->keyframe) {
+			dec->orphans++;
+			return -1;
+		}
+
+		for (i = 0; i < 6; i++)
+			q[i] = dec->key[i] + packet->delta.delta[i];
+		pose->robot_type = packet->delta.robot_type;
+		break;
+	default:
+		return -1;
+	}
+
+	pose->magic = VIZ_MAGIC;
+	pose->type = VIZ_PACKET_POSE;
+	pose->rx = q[0] * dec->rotation_step;
+	pose->ry = q[1] * dec->rotation_step;
+	pose->rz = q[2] * dec->rotation_step;
+	pose->tx = q[3] * dec->translation_step;
+	pose->ty = q[4] * dec->translation_step;
+	pose->tz = q[5] * dec->translation_step;
+
+	if (info) {
+		info->version = packet->header.version;
+		info->sequence = packet->header.sequence;
+		info->send_time_ns = packet->header.send_time_ns;
+	}
+
+	return 0;
+}
+
+/* Dekod enhver enkelt-pose packet; kvantiserte bruker strømmens tilstand */
+static int decode_pose(struct viz_stream_stats *stats, const void *data,
+		       size_t length, struct viz_pose_packet *pose,
+		       struct viz_packet_info *info)
+{
+	if (viz_pose_decode(data, length, pose, info) == 0)
+		return 0;
+	if (q16_packet_type(data, length))
+		stats->q16.quantized = 1;
+	return viz_pose_decode_q16(&stats->q16, data, length, pose, info);
+}
+
+/**
+ * viz_pose_batch_encode - Lag v2 batch packet
+ * @records: poser (@count)
+ * @count: antall poser
+ * @sequence: sekvensnummer, økes av funksjonen
+ * @out: output packet
+ *
+ * Retur: antall bytes som skal sendes, 0 hvis @count er ugyldig
+ */
+size_t viz_pose_batch_encode(const struct viz_pose_record *records, int count,
+			     uint32_t *sequence,
+			     struct viz_pose_batch_packet *out)
+{
+	if (count < 1 || count > VIZ_BATCH_MAX_RECORDS)
+		return 0;
+
+	memset(&out->header, 0, sizeof(out->header));
+	out->header.magic = VIZ_MAGIC_V2;
+	out->header.version = VIZ_PROTOCOL_VERSION;
+	out->header.type = VIZ_PACKET_POSE_BATCH;
+	out->header.sequence = (*sequence)++;
+	out->count = count;
+	out->reserved = 0;
+	memcpy(out->records, records, count * sizeof(*records));
+	out->header.send_time_ns = viz_time_ns();
+
+	return viz_pose_batch_size(count);
+}
+
+static void fleet_update(struct viz_fleet *fleet, int robot_id,
+			 const struct viz_pose_packet *pose,
+			 uint64_t recv_time_ns)
+{
+	struct viz_fleet_slot *slot = &fleet->robots[robot_id];
+
+	slot->pose = *pose;
+	slot->updates++;
+	slot->recv_time_ns = recv_time_ns;
+	fleet->dirty[robot_id / 64] |= 1ull << (robot_id % 64);
+}
+
+/**
+ * viz_fleet_apply - Demultiplekse ett datagram inn i flåten
+ * @fleet: flåte
+ * @data: payload
+ * @length: antall bytes
+ * @recv_time_ns: viz_time_ns() ved mottak
+ *
+ * Retur: antall roboter oppdatert, -1 hvis ikke en gyldig packet
+ */
+int viz_fleet_apply(struct viz_fleet *fleet, const void *data, size_t length,
+		    uint64_t recv_time_ns)
+{
+	const struct viz_pose_batch_packet *batch = data;
+	struct viz_packet_info info;
+	struct viz_pose_packet pose;
+	int i, updated = 0;
+
+	/* Enkelt-pose packet (v1, v2 eller kvantisert) er robot 0 */
+	if (decode_pose(&fleet->stats, data, length, &pose, &info) == 0) {
+		fleet_update(fleet, 0, &pose, recv_time_ns);
+		viz_stream_stats_update(&fleet->stats, &info, recv_time_ns, 0);
+		return 1;
+	}
+
+	if (length < viz_pose_batch_size(0) ||
+	    batch->header.magic != VIZ_MAGIC_V2 ||
+	    batch->header.version < 2 ||
+	    batch->header.type != VIZ_PACKET_POSE_BATCH ||
+	    batch->count > VIZ_BATCH_MAX_RECORDS ||
+	    length < viz_pose_batch_size(batch->count))
+		return -1;
+
+	pose.magic = VIZ_MAGIC;
+	pose.type = VIZ_PACKET_POSE;
+	for (i = 0; i < batch->count; i++) {
+		const struct viz_pose_record *rec = &batch->records[i];
+
+		if (rec->robot_id >= VIZ_FLEET_MAX_ROBOTS) {
+			fleet->rejected++;
+			continue;
+		}
+
+		pose.robot_type = rec->robot_type;
+		pose.rx = rec->rx;
+		pose.ry = rec->ry;
+		pose.rz = rec->rz;
+		pose.tx = rec->tx;
+		pose.ty = rec->ty;
+		pose.tz = rec->tz;
+		fleet_update(fleet, rec->robot_id, &pose, recv_time_ns);
+		updated++;
+	}
+
+	info.version = batch->header.version;
+	info.sequence = batch->header.sequence;
+	info.send_time_ns = batch->header.send_time_ns;
+	viz_stream_stats_update(&fleet->stats, &info, recv_time_ns, 0);
+
+	return updated;
+}
+
+/**
+ * viz_receive_fleet - Tøm transport inn i flåten
+ * @t: mottaker-transport
+ * @fleet: flåte
+ *
+ * Retur: antall robot-oppdateringer, 0 hvis ingen data, -1 ved feil
+ */
+int viz_receive_fleet(struct viz_transport *t, struct viz_fleet *fleet)
+{
+	static _Thread_local struct udp_batch batch;
+	uint64_t now;
+	int i, n, updated = 0;
+
+	do {
+		n = viz_transport_receive_batch(t, &batch);
+		if (n < 0)
+			return -1;
+
+		now = viz_time_ns();
+		for (i = 0; i < n; i++) {
+			int ret;
+
+			if (batch.truncated[i])
+				continue;
+			ret = viz_fleet_apply(fleet, batch.data[i],
+					      batch.length[i], now);
+			if (ret > 0)
+				updated += ret;
+		}
+	} while (n == UDP_BATCH_MAX);
+
+	return updated;
+}
+
+/*
+ * Float-poser fra shared memory: bare latest-slotten, O(1) uansett hvor
+ * mye som ligger i ringen. Slotten teller alle sendte meldinger, så
+ * coalesced kommer derfra.
+ */
+static int receive_pose_latest(struct viz_transport *t,
+			       struct viz_pose_packet *pose,
+			       struct viz_stream_stats *stats)
+{
+	unsigned char buffer[UDP_DATAGRAM_MAX];
+	struct viz_packet_info info;
+	int n, coalesced;
+
+	n = viz_transport_receive_latest(t, buffer, sizeof(buffer),
+					 viz_pose_packet_accept, &coalesced);
+	if (n <= 0)
+		return n;
+	if (decode_pose(stats, buffer, n, pose, &info) < 0)
+		return 0;
+
+	viz_stream_stats_update(stats, &info, viz_time_ns(), coalesced);
+	return 1;
+}
+
+/**
+ * viz_receive_pose - Motta nyeste pose og oppdater statistikk
+ * @t: mottaker-transport
+ * @pose: output - nyeste pose
+ * @stats: strøm-statistikk
+ *
+ * Retur: 1 hvis ny pose, 0 hvis ingen, -1 ved feil
+ */
+int viz_receive_pose(struct viz_transport *t, struct viz_pose_packet *pose,
+		     struct viz_stream_stats *stats)
+{
+	static _Thread_local struct udp_batch batch;
+	struct viz_packet_info info, latest_info = { 0 };
+	struct viz_pose_packet decoded;
+	uint64_t now;
+	int i, n, count = 0;
+
+	if (t->kind == VIZ_TRANSPORT_SHM && !stats->q16.quantized &&
+	    !stats->record)
+		return receive_pose_latest(t, pose, stats);
+
+	/*
+	 * Alle i rekkefølge, så keyframes oppdaterer stats->q16 selv om et
+	 * nyere delta kom i samme mottak
+	 */
+	now = viz_time_ns();
+	do {
+		n = viz_transport_receive_batch(t, &batch);
+		if (n < 0)
+			return -1;
+
+		for (i = 0; i < n; i++) {
+			if (batch.truncated[i] ||
+			    decode_pose(stats, batch.data[i], batch.length[i],
+					&decoded, &info) < 0)
+				continue;
+			if (stats->record)
+				stats->record(stats->record_ctx, &decoded,
+					      &info, now);
+			*pose = decoded;
+			latest_info = info;
+			count++;
+		}
+	} while (n == UDP_BATCH_MAX);
+
+	if (count == 0)
+		return 0;
+
+	viz_stream_stats_update(stats, &latest_info, now, count - 1);
+	return 1;
+}
+
+/* Bøtte for latency i us: 4 bøtter per dobling, bøtte 0 er < 1 us */
+static int latency_bucket(uint64_t latency_ns)
+{
+	double us = latency_ns / 1000.0;
+	int bucket;
+
+	if (us < 1.0)
+		return 0;
+
+	bucket = 1 + (int)(4.0 * log2(us));
+	return bucket < VIZ_LATENCY_BUCKETS ? bucket : VIZ_LATENCY_BUCKETS - 1;
+}
+
+/**
+ * viz_stream_stats_update - Registrer en mottatt packet
+ * @stats: strøm-statistikk
+ * @info: metadata fra viz_pose_decode()
+ * @recv_time_ns: viz_time_ns() ved mottak
+ * @coalesced: antall eldre packets forkastet i samme mottak
+ *
+ * Et hull i sekvensen telles som tap; kommer en "tapt" packet senere,
+ * telles den som reordered og trekkes fra tapet igjen. Samme
+ * sekvensnummer som det høyeste telles som duplikat og endrer ikke tapet.
+ * Sammenligning med fortegn på differansen tåler wrap ved 2^32.
+ */
+void viz_stream_stats_update(struct viz_stream_stats *stats,
+			     const struct viz_packet_info *info,
+			     uint64_t recv_time_ns, int coalesced)
+{
+	int32_t delta;
+	uint64_t gap;
+
+	stats->received++;
+	stats->coalesced += coalesced;
+	stats->last_send_time_ns = info->version < 2 ? 0 : info->send_time_ns;
+	stats->last_recv_time_ns = recv_time_ns;
+
+	if (info->version < 2) {
+		stats->v1_packets++;
+		return;
+	}
+
+	if (!stats->has_sequence) {
+		stats->highest_sequence = info->sequence;
+		stats->has_sequence = 1;
+	} else {
+		delta = (int32_t)(info->sequence - stats->highest_sequence);
+		if (delta > 0) {
+			/* Forkastede (coalesced) packets kom fram, er ikke tapt */
+			gap = (uint64_t)delta - 1;
+			stats->lost += gap > (uint64_t)coalesced ?
+					       gap - coalesced : 0;
+			stats->highest_sequence = info->sequence;
+		} else if (delta == 0) {
+			stats->duplicates++;
+		} else {
+			stats->reordered++;
+			if (stats->lost > 0)
+				stats->lost--;
+		}
+	}
+
+	if (recv_time_ns >= info->send_time_ns) {
+		stats->latency_hist[latency_bucket(recv_time_ns -
+						   info->send_time_ns)]++;
+		stats->latency_count++;
+	}
+}
+
+/**
+ * viz_stream_stats_latency_ms - Latency-persentil
+ * @stats: strøm-statistikk
+ * @percentile: 0..100
+ *
+ * Retur: øvre grense for bøtten persentilen faller i (ms)
+ */
+double viz_stream_stats_latency_ms(const struct viz_stream_stats *stats,
+				   double percentile)
+{
+	uint64_t target, sum = 0;
+	int i;
+
+	if (stats->latency_count == 0)
+		return 0.0;
+
+	target = (uint64_t)ceil(percentile / 100.0 * stats->latency_count);
+	if (target < 1)
+		target = 1;
+
+	for (i = 0; i < VIZ_LATENCY_BUCKETS; i++) {
+		sum += stats->latency_hist[i];
+		if (sum >= target)
+			break;
+	}
+	if (i == VIZ_LATENCY_BUCKETS)
+		i--;
+
+	/* Bøtte i dekker [2^((i-1)/4), 2^(i/4)) us */
+	return exp2(i / 4.0) / 1000.0;
+}
+
+/**
+ * viz_stream_stats_print - Print statistikk for strøm
+ * @stats: strøm-statistikk
+ * @name: navn på strømmen
+ */
+void viz_stream_stats_print(const struct viz_stream_stats *stats,
+			    const char *name)
+{
+	printf("%s: %llu received, %llu coalesced, %llu lost, "
+	       "%llu reordered", name, (unsigned long long)stats->received,
+	       (unsigned long long)stats->coalesced,
+	       (unsigned long long)stats->lost,
+	       (unsigned long long)stats->reordered);
+	if (stats->duplicates)
+		printf(", %llu duplicates",
+		       (unsigned long long)stats->duplicates);
+	if (stats->v1_packets)
+		printf(", %llu v1", (unsigned long long)stats->v1_packets);
+	if (stats->q16.orphans)
+		printf(", %llu q16 deltas without keyframe",
+		       (unsigned long long)stats->q16.orphans);
+	printf("\n");
+
+	if (stats->latency_count) {
+		printf("  latency p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, "
+		       "max %.3f ms\n", viz_stream_stats_latency_ms(stats, 50),
+		       viz_stream_stats_latency_ms(stats, 90),
+		       viz_stream_stats_latency_ms(stats, 99),
+		       viz_stream_stats_latency_ms(stats, 100));
+	}
+}
@@ -1,235 +1,171 @@
+#define _DEFAULT_SOURCE
 #include "robotics/math/geometry.h"
 #include "robotics/math/matrix.h"
 #include "robotics/math/utils.h"
 #include "robotics/math/vec3.h"
 #include "stewart/geometry.h"
+#include "stewart/geometry_slot.h"
+#include "stewart/ik_cache.h"
 #include "stewart/kinematics.h"
 #include "stewart/pose.h"
 #include "viz_protocol.h"
+#include "bench.h"
+#include "camera.h"
+#include "render.h"
+#include "scene.h"
+#include "stream_set.h"
+#include "trail.h"
+#include "triple_buffer.h"
 #include "udp.h"
+#include "viz_gl.h"
 #include <GLFW/glfw3.h>
-#include <OpenGL/glu.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846f
-#endif
+/* Frame-intervall mens spor forsvinner; ellers tegnes bare ved endring */
+#define TRAIL_FRAME_S (1.0 / 30.0)
 
-/* Global state */
+/**
+ * struct frame_state - Det render-tråden trenger for begge poser
+ * @base_points: base punkter fra aktiv geometri
+ * @result1: IK for pose 1
+ * @result2: IK for pose 2
+ */
+struct frame_state {
+	struct vec3 base_points[6];
+	struct stewart_inverse_result result1;
+	struct stewart_inverse_result result2;
+};
+
+/* Global state, eies av mottaks-tråden etter oppstart */
 static struct viz_pose_packet pose1; /* Reference/Target (port 9001) */
 static struct viz_pose_packet pose2; /* Actual/Current (port 9002) */
-static struct stewart_geometry geometry;
-static struct stewart_inverse_result result1;
-static struct stewart_inverse_result result2;
-static int udp_sock1 = -1; /* Port 9001 */
-static int udp_sock2 = -1; /* Port 9002 */
+static struct viz_geometry_set geometries; /* Lastes på nytt ved SIGHUP */
+static struct stewart_geometry_slot *geometry = &geometries.mx64; /* Aktiv */
+static const char *geometry_file_mx64; /* -m */
+static const char *geometry_file_ax18; /* -a */
+static struct frame_state state; /* Arbeidskopi, publiseres i frames */
+static struct viz_triple_buffer frames; /* Mottaks-tråd -> render */
+static struct viz_stream_set streams; /* Mottak og IK i egen tråd */
+static struct stewart_ik_cache ik_cache; /* Begge poser, gjentatt IK */
+static int stream1 = -1; /* Pose 1, default port 9001 */
+static int stream2 = -1; /* Pose 2, default port 9002 */
+static unsigned int version1, version2; /* Siste pose brukt per strøm */
+static const char *endpoint1 = "udp:9001";
+static const char *endpoint2 = "udp:9002";
 static int has_error1 = 0;
 static int has_error2 = 0;
+static struct viz_window win; /* Vindu, eller offscreen context med -B */
+static int bench_frames; /* -B, 0 = vanlig vindu */
+static struct viz_renderer renderer;
+static struct viz_trail trail; /* Pose-historikk for begge poser */
+static float trail_seconds = VIZ_TRAIL_DEFAULT_S; /* -t */
+static int trail_on; /* -t eller T */
+static int trail_fading; /* Samples igjen, tegn på nytt etter TRAIL_FRAME_S */
 
-/* Camera state */
-static float camera_azimuth = 45.0f; /* Horizontal rotation (degrees) */
-static float camera_elevation = 30.0f; /* Vertical tilt (degrees) */
-static float camera_distance = 600.0f; /* Distance from target */
-static float ortho_scale = 400.0f; /* Orthographic view scale */
+static struct viz_camera camera; /* Piltaster, zoom og reset */
 
-/**
- * draw_sphere - Tegn en sfære på gitt posisjon
- * @x, @y, @z: senterpunkt
- * @radius: radius
- * @slices: antall vertikale segmenter
- * @stacks: antall horisontale segmenter
- */
-static void draw_sphere(float x, float y, float z, float radius, int slices,
-			int stacks)
-{
-	GLUquadric *quad;
-
-	quad = gluNewQuadric();
-	glPushMatrix();
-	glTranslatef(x, y, z);
-	gluSphere(quad, radius, slices, stacks);
-	glPopMatrix();
-	gluDeleteQuadric(quad);
-}
+static const float pose1_color[3] = { 0.2f, 0.9f, 0.9f }; /* Cyan */
+static const float pose2_color[3] = { 0.9f, 0.2f, 0.9f }; /* Magenta */
 
 /**
- * key_callback - Håndter tastatur-input
+ * handle_key - Taster utenom kameraet (viz_key_fn)
+ * @ctx: ubrukt
+ * @key: GLFW_KEY_*
+ *
+ * T: Spor av/på
  */
-static void key_callback(GLFWwindow *window, int key, int scancode, int action,
-			 int mods)
+static void handle_key(void *ctx, int key)
 {
-	(void)scancode;
-	(void)mods;
+	(void)ctx;
 
-	if (action != GLFW_PRESS && action != GLFW_REPEAT)
+	if (key != GLFW_KEY_T)
 		return;
 
-	switch (key) {
-	case GLFW_KEY_LEFT:
-		camera_azimuth -= 5.0f;
-		break;
-	case GLFW_KEY_RIGHT:
-		camera_azimuth += 5.0f;
-		break;
-	case GLFW_KEY_UP:
-		camera_elevation += 5.0f;
-		if (camera_elevation > 89.0f)
-			camera_elevation = 89.0f;
-		break;
-	case GLFW_KEY_DOWN:
-		camera_elevation -= 5.0f;
-		if (camera_elevation < -89.0f)
-			camera_elevation = -89.0f;
-		break;
-	case GLFW_KEY_EQUAL: /* + key */
-	case GLFW_KEY_Q:
-		ortho_scale *= 0.9f;
-		if (ortho_scale < 50.0f)
-			ortho_scale = 50.0f;
-		break;
-	case GLFW_KEY_MINUS: /* - key */
-	case GLFW_KEY_W:
-		ortho_scale *= 1.1f;
-		if (ortho_scale > 2000.0f)
-			ortho_scale = 2000.0f;
-		break;
-	case GLFW_KEY_R:
-		/* Reset kamera */
-		camera_azimuth = 45.0f;
-		camera_elevation = 30.0f;
-		ortho_scale = 400.0f;
-		printf("Camera reset\n");
-		break;
-	case GLFW_KEY_ESCAPE:
-		glfwSetWindowShouldClose(window, GLFW_TRUE);
-		break;
-	}
+	trail_on = !trail_on;
+	if (!trail_on)
+		viz_trail_clear(&trail);
+	printf("Trail %s\n", trail_on ? "on" : "off");
 }
 
 /**
  * render_pose - Render en pose med gitt farge
+ * @base_points: base punkter
  * @result: inverse kinematics result
- * @r, @g, @b: base RGB color (0-1)
- * @label: label for debugging
+ * @color: base RGB color (0-1)
  */
-static void render_pose(const struct stewart_inverse_result *result, float r,
-			float g, float b, const char *label)
+static void render_pose(const struct vec3 *base_points,
+			const struct stewart_inverse_result *result,
+			const float color[3])
 {
-	int i;
-
-	(void)label; /* Unused for now */
+	struct viz_leg_colors legs;
 
 	/* Tegn platform sekskant */
-	glColor3f(r * 0.8f, g * 0.8f, b * 0.8f);
-	glLineWidth(3.0f);
-	glBegin(GL_LINE_LOOP);
-	for (i = 0; i < 6; i++) {
-		struct vec3 *p = &result->platform_points_transformed[i];
-		glVertex3f(p->x, p->y, p->z);
-	}
-	glEnd();
-
-	/* Tegn motor arms (base → knee) */
-	glColor3f(r * 0.9f, g * 0.9f, b * 0.5f);
-	glLineWidth(2.0f);
-	glBegin(GL_LINES);
-	for (i = 0; i < 6; i++) {
-		struct vec3 *base = &geometry.base_points[i];
-		struct vec3 *knee = &result->knee_points[i];
-		glVertex3f(base->x, base->y, base->z);
-		glVertex3f(knee->x, knee->y, knee->z);
-	}
-	glEnd();
-
-	/* Tegn pushrods (knee → platform) */
-	glColor3f(r, g * 0.6f, b * 0.6f);
-	glLineWidth(2.0f);
-	glBegin(GL_LINES);
-	for (i = 0; i < 6; i++) {
-		struct vec3 *knee = &result->knee_points[i];
-		struct vec3 *platform = &result->platform_points_transformed[i];
-		glVertex3f(knee->x, knee->y, knee->z);
-		glVertex3f(platform->x, platform->y, platform->z);
-	}
-	glEnd();
-
-	/* Tegn knee points (kuler) */
-	glColor3f(r, g, b);
-	for (i = 0; i < 6; i++) {
-		struct vec3 *knee = &result->knee_points[i];
-		draw_sphere(knee->x, knee->y, knee->z, 5.0f, 12, 12);
-	}
+	viz_render_color(&renderer, color[0] * 0.8f, color[1] * 0.8f,
+			 color[2] * 0.8f);
+	viz_render_line_width(&renderer, 3.0f);
+	viz_render_line_loop(&renderer, result->platform_points_transformed,
+			     6);
+
+	/* Tegn motor arms, pushrods og knee points */
+	viz_leg_colors_from(&legs, color);
+	viz_scene_draw_legs(&renderer, base_points, result, &legs);
 }
 
 /**
  * render_comparison - Render begge poser side-om-side
+ * @ctx: ubrukt (viz_draw_fn)
  */
-static void render_comparison(void)
+static void render_comparison(void *ctx)
 {
-	int i;
-	float azimuth_rad, elevation_rad;
-	float eye_x, eye_y, eye_z;
-
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	const struct stewart_inverse_result *poses[2];
+	const struct frame_state *frame;
+	int fresh;
 
-	/* Oppdater orthographic projection */
-	glMatrixMode(GL_PROJECTION);
-	glLoadIdentity();
-	float aspect = 1024.0f / 768.0f;
-	glOrtho(-ortho_scale * aspect, ortho_scale * aspect, -ortho_scale,
-		ortho_scale, -2000.0, 2000.0);
+	(void)ctx;
 
-	glMatrixMode(GL_MODELVIEW);
-	glLoadIdentity();
+	viz_scene_begin(&camera, &win);
 
-	/* Beregn kamera posisjon */
-	azimuth_rad = camera_azimuth * M_PI / 180.0f;
-	elevation_rad = camera_elevation * M_PI / 180.0f;
-
-	eye_x = camera_distance * cosf(elevation_rad) * cosf(azimuth_rad);
-	eye_y = camera_distance * sinf(elevation_rad);
-	eye_z = camera_distance * cosf(elevation_rad) * sinf(azimuth_rad);
-
-	gluLookAt(eye_x, eye_y + 100.0f, eye_z, /* eye */
-		  0.0, 100.0, 0.0, /* center */
-		  0.0, 1.0, 0.0); /* up */
+	/* Nyeste komplette tilstand, stabil for hele framen */
+	frame = viz_triple_read(&frames, &fresh);
+	poses[0] = &frame->result1;
+	poses[1] = &frame->result2;
+	trail_fading = trail_on &&
+		       viz_scene_trail_update(&trail, poses, 2, fresh);
 
 	/* Tegn base sekskant (grå - deles av begge poser) */
-	glColor3f(0.4f, 0.4f, 0.4f);
-	glLineWidth(3.0f);
-	glBegin(GL_LINE_LOOP);
-	for (i = 0; i < 6; i++) {
-		struct vec3 *p = &geometry.base_points[i];
-		glVertex3f(p->x, p->y, p->z);
-	}
-	glEnd();
+	viz_render_color(&renderer, 0.4f, 0.4f, 0.4f);
+	viz_render_line_width(&renderer, 3.0f);
+	viz_render_line_loop(&renderer, frame->base_points, 6);
 
 	/* Tegn pose 1 (cyan - reference/target) */
-	render_pose(&result1, 0.2f, 0.9f, 0.9f, "Pose 1");
+	render_pose(frame->base_points, &frame->result1, pose1_color);
 
 	/* Tegn pose 2 (magenta - actual/current) */
-	render_pose(&result2, 0.9f, 0.2f, 0.9f, "Pose 2");
-
-	/* Tegn koordinatsystem */
-	glLineWidth(4.0f);
-	glBegin(GL_LINES);
-	/* X-akse (rød) */
-	glColor3f(1.0f, 0.0f, 0.0f);
-	glVertex3f(0.0f, 0.0f, 0.0f);
-	glVertex3f(100.0f, 0.0f, 0.0f);
-	/* Y-akse (grønn) */
-	glColor3f(0.0f, 1.0f, 0.0f);
-	glVertex3f(0.0f, 0.0f, 0.0f);
-	glVertex3f(0.0f, 100.0f, 0.0f);
-	/* Z-akse (blå) */
-	glColor3f(0.0f, 0.0f, 1.0f);
-	glVertex3f(0.0f, 0.0f, 0.0f);
-	glVertex3f(0.0f, 0.0f, 100.0f);
-	glEnd();
+	render_pose(frame->base_points, &frame->result2, pose2_color);
+
+	/* Begge poser: kulene i ett kall, linjene i ett kall per bredde */
+	viz_scene_end(&renderer, trail_on ? &trail : NULL);
+}
+
+/**
+ * init_trail - Sett opp spor for begge poser i samme farger som posene
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+static int init_trail(void)
+{
+	if (viz_trail_init(&trail, 2 * VIZ_SCENE_TRAIL_TRACKS,
+			   VIZ_TRAIL_SAMPLES, trail_seconds) < 0)
+		return -1;
+
+	viz_scene_trail_color(&trail, 0, pose1_color);
+	viz_scene_trail_color(&trail, 1, pose2_color);
+
+	return 0;
 }
 
 /**
@@ -239,6 +175,7 @@ static void compute_kinematics_for_pose(const struct viz_pose_packet *packet,
 					struct stewart_inverse_result *result,
 					int *has_error, int pose_num)
 {
+	const struct stewart_geometry_prepared *prep;
 	struct stewart_pose pose;
 
 	stewart_pose_init(&pose);
@@ -249,7 +186,11 @@ static void compute_kinematics_for_pose(const struct viz_pose_packet *packet,
 	pose.ty = packet->ty;
 	pose.tz = packet->tz;
 
-	stewart_kinematics_inverse(&geometry, &pose, result, 0);
+	prep = stewart_geometry_slot_acquire(geometry);
+	stewart_ik_cache_inverse(&ik_cache, prep,
+				 stewart_geometry_slot_generation(geometry),
+				 &pose, result);
+	stewart_geometry_slot_release(geometry, prep);
 	*has_error = result->error;
 
 	/* Print motor angles ved endring */
@@ -277,53 +218,154 @@ static void compute_kinematics_for_pose(const struct viz_pose_packet *packet,
 }
 
 /**
- * poll_udp - Poll begge UDP sockets for nye packets
+ * publish_state - Publiser begge IK-resultatene for render-tråden
+ */
+static void publish_state(void)
+{
+	const struct stewart_geometry_prepared *prep;
+
+	prep = stewart_geometry_slot_acquire(geometry);
+	memcpy(state.base_points, prep->geom.base_points,
+	       sizeof(state.base_points));
+	stewart_geometry_slot_release(geometry, prep);
+
+	*(struct frame_state *)viz_triple_back(&frames) = state;
+	/* Vekk render-løkken fra glfwWaitEvents(); ingen vindu med -B */
+	if (viz_triple_publish(&frames) && win.window)
+		glfwPostEmptyEvent();
+}
+
+/**
+ * poll_udp - Hent nyeste pose for begge strømmer og beregn IK
+ *
+ * Kjører i mottaks-tråden og bruker bare nyeste pose per strøm.
+ *
+ * Retur: 1 hvis en av posene var ny, ellers 0
  */
-static void poll_udp(void)
+static int poll_udp(void)
 {
 	struct viz_pose_packet packet;
-	int n;
-
-	/* Poll socket 1 (port 9001) */
-	n = udp_receive(udp_sock1, &packet, sizeof(packet));
-	if (n == sizeof(packet)) {
-		if (packet.magic == VIZ_MAGIC &&
-		    packet.type == VIZ_PACKET_POSE) {
-			pose1 = packet;
-
-			/* Oppdater geometri hvis nødvendig */
-			if (packet.robot_type == ROBOT_TYPE_MX64) {
-				geometry = ROBOT_MX64;
-			} else if (packet.robot_type == ROBOT_TYPE_AX18) {
-				geometry = ROBOT_AX18;
-			}
+	int updated = 0;
 
-			compute_kinematics_for_pose(&pose1, &result1,
-						    &has_error1, 1);
-		}
+	/* Pose 1 (port 9001), bare nyeste pose brukes */
+	if (viz_stream_set_latest(&streams, stream1, &packet, &version1)) {
+		pose1 = packet;
+
+		/* Bytt aktiv geometri hvis nødvendig (kun peker) */
+		if (packet.robot_type == ROBOT_TYPE_MX64 ||
+		    packet.robot_type == ROBOT_TYPE_AX18)
+			geometry = viz_geometry_select(&geometries,
+						       packet.robot_type);
+
+		compute_kinematics_for_pose(&pose1, &state.result1,
+					    &has_error1, 1);
+		updated = 1;
 	}
 
-	/* Poll socket 2 (port 9002) */
-	n = udp_receive(udp_sock2, &packet, sizeof(packet));
-	if (n == sizeof(packet)) {
-		if (packet.magic == VIZ_MAGIC &&
-		    packet.type == VIZ_PACKET_POSE) {
-			pose2 = packet;
-			compute_kinematics_for_pose(&pose2, &result2,
-						    &has_error2, 2);
-		}
+	/* Pose 2 (port 9002) */
+	if (viz_stream_set_latest(&streams, stream2, &packet, &version2)) {
+		pose2 = packet;
+		compute_kinematics_for_pose(&pose2, &state.result2,
+					    &has_error2, 2);
+		updated = 1;
+	}
+
+	return updated;
+}
+
+/**
+ * ingest_update - IK og publisering i mottaks-tråden
+ * @ctx: ubrukt
+ *
+ * Kalles etter hver mottaks-runde og etter SIGHUP, så IK-raten bare
+ * begrenses av pakkene og ikke av vsync.
+ */
+static void ingest_update(void *ctx)
+{
+	int updated = 0;
+
+	(void)ctx;
+
+	if (viz_geometry_reload_pending(&geometries)) {
+		viz_geometry_reload(&geometries);
+		compute_kinematics_for_pose(&pose1, &state.result1,
+					    &has_error1, 1);
+		compute_kinematics_for_pose(&pose2, &state.result2,
+					    &has_error2, 2);
+		updated = 1;
 	}
+
+	if (poll_udp() || updated)
+		publish_state();
 }
 
-int main(void)
+static void print_usage(const char *prog)
 {
-	GLFWwindow *window;
+	printf("Usage: %s [-m mx64.geom] [-a ax18.geom] [-t s] [-B frames] "
+	       "[endpoint1 endpoint2]\n", prog);
+	printf("  -m <file>  MX64 geometry file (default: built-in)\n");
+	printf("  -a <file>  AX18 geometry file (default: built-in)\n");
+	printf("  -t <s>     Show the last s seconds as trails (T toggles, "
+	       "default %.0f s)\n", VIZ_TRAIL_DEFAULT_S);
+	printf("  -B <n>     Headless: render n frames offscreen and print "
+	       "frame times\n");
+	printf("  endpoint   udp:<port> or shm:<name> "
+	       "(default udp:9001 udp:9002)\n");
+	printf("Send SIGHUP to reload the geometry files.\n");
+}
+
+int main(int argc, char **argv)
+{
+	int opt;
+
+	while ((opt = getopt(argc, argv, "m:a:t:B:h")) != -1) {
+		switch (opt) {
+		case 'm':
+			geometry_file_mx64 = optarg;
+			break;
+		case 'a':
+			geometry_file_ax18 = optarg;
+			break;
+		case 't':
+			trail_seconds = atof(optarg);
+			if (trail_seconds <= 0.0f) {
+				fprintf(stderr, "Trail length must be > 0\n");
+				return 1;
+			}
+			trail_on = 1;
+			break;
+		case 'B':
+			bench_frames = atoi(optarg);
+			if (bench_frames < 1) {
+				fprintf(stderr, "Frame count must be > 0\n");
+				return 1;
+			}
+			break;
+		default:
+			print_usage(argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (optind + 2 == argc) {
+		endpoint1 = argv[optind];
+		endpoint2 = argv[optind + 1];
+	} else if (optind != argc) {
+		print_usage(argv[0]);
+		return 1;
+	}
 
 	printf("Stewart Platform Comparison Visualizer\n");
 	printf("======================================\n\n");
 
 	/* Initialiser geometry */
-	geometry = ROBOT_MX64;
+	stewart_ik_cache_init(&ik_cache, 0.0f);
+	if (viz_geometry_init(&geometries, geometry_file_mx64,
+			      geometry_file_ax18) < 0)
+		return 1;
+
+	if (viz_triple_init(&frames, sizeof(struct frame_state)) < 0)
+		return 1;
 
 	/* Initialiser begge poser til home */
 	memset(&pose1, 0, sizeof(pose1));
@@ -337,72 +379,94 @@ int main(void)
 	pose2.robot_type = ROBOT_TYPE_MX64;
 
 	/* Beregn initial kinematikk */
-	compute_kinematics_for_pose(&pose1, &result1, &has_error1, 1);
-	compute_kinematics_for_pose(&pose2, &result2, &has_error2, 2);
+	compute_kinematics_for_pose(&pose1, &state.result1, &has_error1, 1);
+	compute_kinematics_for_pose(&pose2, &state.result2, &has_error2, 2);
+	publish_state();
+
+	/* Lag receivers */
+	if (viz_stream_set_init(&streams) < 0)
+		return 1;
 
-	/* Lag UDP receivers */
-	udp_sock1 = udp_create_receiver(9001);
-	if (udp_sock1 < 0) {
-		fprintf(stderr, "Failed to create UDP receiver on port 9001\n");
+	stream1 = viz_stream_set_add(&streams, endpoint1);
+	if (stream1 < 0) {
+		fprintf(stderr, "Failed to create receiver on %s\n", endpoint1);
+		viz_stream_set_destroy(&streams);
 		return 1;
 	}
 
-	udp_sock2 = udp_create_receiver(9002);
-	if (udp_sock2 < 0) {
-		fprintf(stderr, "Failed to create UDP receiver on port 9002\n");
-		close(udp_sock1);
+	stream2 = viz_stream_set_add(&streams, endpoint2);
+	if (stream2 < 0) {
+		fprintf(stderr, "Failed to create receiver on %s\n", endpoint2);
+		viz_stream_set_destroy(&streams);
 		return 1;
 	}
 
 	printf("Listening on:\n");
-	printf("  Port 9001: Pose 1 (CYAN - reference/target)\n");
-	printf("  Port 9002: Pose 2 (MAGENTA - actual/current)\n\n");
+	printf("  %s: Pose 1 (CYAN - reference/target)\n", endpoint1);
+	printf("  %s: Pose 2 (MAGENTA - actual/current)\n\n", endpoint2);
 
-	/* Initialiser GLFW */
-	if (!glfwInit()) {
-		fprintf(stderr, "Failed to initialize GLFW\n");
+	viz_camera_init(&camera);
+	if (viz_window_open(&win, "Stewart Compare", 1024, 768,
+			    bench_frames) < 0)
 		return 1;
-	}
+	viz_camera_attach(&camera, &win, handle_key, NULL);
 
-	/* Lag vindu */
-	window = glfwCreateWindow(1024, 768, "Stewart Compare", NULL, NULL);
-	if (!window) {
-		fprintf(stderr, "Failed to create window\n");
-		glfwTerminate();
+	if (viz_scene_init(&renderer) < 0 || init_trail() < 0) {
+		viz_window_close(&win);
 		return 1;
 	}
 
-	glfwMakeContextCurrent(window);
-	glfwSwapInterval(1); /* VSync */
-
-	/* Register keyboard callback */
-	glfwSetKeyCallback(window, key_callback);
-
-	/* Setup OpenGL */
-	glEnable(GL_DEPTH_TEST);
-	glClearColor(0.05f, 0.05f, 0.1f, 1.0f);
-
-	printf("Window created. Ready to compare!\n");
-	printf("\nControls:\n");
-	printf("  Arrow keys:  Rotate camera\n");
-	printf("  Q/W:         Zoom in/out\n");
-	printf("  R:           Reset camera\n");
-	printf("  ESC:         Exit\n\n");
+	/* Mottak og IK i egen tråd, uavhengig av vsync; etter vinduet */
+	viz_stream_set_on_update(&streams, ingest_update, NULL);
+	if (viz_stream_set_start(&streams) < 0) {
+		viz_trail_destroy(&trail);
+		viz_render_destroy(&renderer);
+		viz_window_close(&win);
+		viz_stream_set_destroy(&streams);
+		return 1;
+	}
+	viz_geometry_watch(&geometries, &streams.wake);
+
+	if (bench_frames) {
+		viz_bench_run(bench_frames, render_comparison, NULL, "compare");
+	} else {
+		printf("Window created. Ready to compare!\n");
+		printf("\nControls:\n");
+		printf("  Arrow keys:  Rotate camera\n");
+		printf("  +/- or Q/W:  Zoom in/out\n");
+		printf("  R:           Reset camera\n");
+		printf("  T:           Toggle trails\n");
+		printf("  ESC:         Exit\n\n");
+	}
 
-	/* Main loop */
-	while (!glfwWindowShouldClose(window)) {
-		poll_udp();
-		render_comparison();
+	/* Main loop: tegn bare ved nye poser, kamera- eller vindusendring */
+	while (win.window && !glfwWindowShouldClose(win.window)) {
+		if (win.redraw || viz_triple_pending(&frames)) {
+			win.redraw = 0;
+			render_comparison(NULL);
+			glfwSwapBuffers(win.window);
+		}
 
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+		if (trail_fading) {
+			glfwWaitEventsTimeout(TRAIL_FRAME_S);
+			win.redraw = 1;
+		} else {
+			glfwWaitEvents();
+		}
 	}
 
-	/* Cleanup */
-	glfwDestroyWindow(window);
-	glfwTerminate();
-	close(udp_sock1);
-	close(udp_sock2);
+	/* Cleanup, mottaks-tråden kan vekke vinduet til den er stoppet */
+	viz_geometry_unwatch();
+	viz_stream_set_stop(&streams);
+	viz_trail_destroy(&trail);
+	viz_render_destroy(&renderer);
+	viz_window_close(&win);
+	viz_stream_stats_print(&streams.streams[stream1].stats, endpoint1);
+	viz_stream_stats_print(&streams.streams[stream2].stats, endpoint2);
+	stewart_ik_cache_stats_print(&ik_cache, "Both poses");
+	viz_stream_set_destroy(&streams);
+	viz_geometry_destroy(&geometries);
+	viz_triple_destroy(&frames);
 
 	return 0;
 }
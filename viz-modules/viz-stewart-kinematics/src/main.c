@@ -1,124 +1,133 @@
+#define _DEFAULT_SOURCE
 #include "robotics/math/geometry.h"
 #include "robotics/math/matrix.h"
 #include "robotics/math/utils.h"
 #include "robotics/math/vec3.h"
+#include "stewart/collision.h"
 #include "stewart/geometry.h"
+#include "stewart/geometry_slot.h"
+#include "stewart/ik_cache.h"
 #include "stewart/kinematics.h"
 #include "stewart/pose.h"
 #include "viz_protocol.h"
+#include "bench.h"
+#include "camera.h"
+#include "fleet_view.h"
+#include "ingest.h"
+#include "render.h"
+#include "scene.h"
+#include "trail.h"
+#include "transport.h"
+#include "triple_buffer.h"
 #include "udp.h"
+#include "viz_gl.h"
 #include <GLFW/glfw3.h>
-#include <OpenGL/glu.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846f
-#endif
+/* Ben nærmere hverandre (senterlinje) enn dette markeres i rødt (mm) */
+#define COLLISION_WARN_MM 10.0f
 
-/* Global state */
-static struct viz_pose_packet current_pose;
-static struct stewart_geometry geometry;
-static struct stewart_inverse_result inverse_result;
-static int udp_sock = -1;
-static int has_error = 0;
+/*
+ * Frame-intervall mens platformen blinker eller spor forsvinner; ellers
+ * tegnes bare ved endring
+ */
+#define ANIMATE_FRAME_S (1.0 / 30.0)
 
-/* Camera state */
-static float camera_azimuth = 45.0f; /* Horizontal rotation (degrees) */
-static float camera_elevation = 30.0f; /* Vertical tilt (degrees) */
-static float camera_distance = 600.0f; /* Distance from target */
-static float ortho_scale = 400.0f; /* Orthographic view scale */
+/**
+ * struct frame_state - Det render-tråden trenger for å tegne én robot
+ * @base_points: base punkter fra geometrien IK ble kjørt med
+ * @inverse: IK-resultat
+ * @collision: kollisjonssjekk
+ * @has_error: 1 hvis posen ikke kan nås
+ * @near_collision: 1 hvis to ben eller kne og plate er for nær
+ */
+struct frame_state {
+	struct vec3 base_points[6];
+	struct stewart_inverse_result inverse;
+	struct stewart_collision_result collision;
+	int has_error;
+	int near_collision;
+};
+
+/* Global state, eies av ingest-tråden etter oppstart */
+static struct viz_pose_packet current_pose;
+static struct viz_geometry_set geometries; /* Lastes på nytt ved SIGHUP */
+static struct stewart_geometry_slot *geometry = &geometries.mx64; /* Aktiv */
+static const char *geometry_file_mx64; /* -m */
+static const char *geometry_file_ax18; /* -a */
+static struct frame_state state; /* Arbeidskopi, publiseres i frames */
+static struct viz_transport transport;
+static const char *endpoint = "udp:9001";
+static struct viz_fleet fleet; /* Poser per robot_id fra batch packets */
+static int robot_id; /* -i, roboten som vises */
+static struct viz_fleet_leg fleet_legs[VIZ_FLEET_MAX_ROBOTS * 6];
+static struct viz_ingest ingest; /* Mottak og IK */
+static struct stewart_ik_cache ik_cache; /* Gjentatte poser hopper over IK */
+
+/* Ingest -> render, render-tråden ser bare komplette tilstander */
+static struct viz_triple_buffer frames; /* struct frame_state */
+static struct viz_triple_buffer fleet_frames; /* fleet_count * 6 ben */
+
+static struct viz_window win; /* Vindu, eller offscreen context med -B */
+static int bench_frames; /* -B, 0 = vanlig vindu */
+static int animate; /* Blink eller spor, tegn igjen etter ANIMATE_FRAME_S */
+static struct viz_renderer renderer;
+static struct viz_trail trail; /* Pose-historikk, bare enkelt-robot */
+static float trail_seconds = VIZ_TRAIL_DEFAULT_S; /* -t */
+static int trail_on; /* -t eller T */
+static struct viz_fleet_view fleet_view; /* Flåtemodus, alle roboter */
+static int fleet_count; /* -n, 0 = vis bare robot_id */
+static float fleet_spacing = VIZ_FLEET_VIEW_SPACING; /* -g */
+static const char *fleet_positions; /* -P */
+
+static struct viz_camera camera; /* Piltaster, zoom og reset */
+
+/* Gule motor arms, oransje pushrods og grønne knær */
+static const struct viz_leg_colors leg_colors = {
+	.arm = { 0.9f, 0.9f, 0.2f },
+	.pushrod = { 1.0f, 0.5f, 0.1f },
+	.knee = { 0.2f, 0.9f, 0.2f },
+};
 
 /**
- * draw_sphere - Tegn en sfære på gitt posisjon
- * @x, @y, @z: senterpunkt
- * @radius: radius
- * @slices: antall vertikale segmenter
- * @stacks: antall horisontale segmenter
+ * handle_key - Taster utenom kameraet (viz_key_fn)
+ * @ctx: ubrukt
+ * @key: GLFW_KEY_*
  *
- * Bruker GLU for å tegne en enkel sfære.
+ * T: Spor av/på
  */
-static void draw_sphere(float x, float y, float z, float radius, int slices,
-			int stacks)
+static void handle_key(void *ctx, int key)
 {
-	GLUquadric *quad;
-
-	quad = gluNewQuadric();
-	glPushMatrix();
-	glTranslatef(x, y, z);
-	gluSphere(quad, radius, slices, stacks);
-	glPopMatrix();
-	gluDeleteQuadric(quad);
+	(void)ctx;
+
+	if (key != GLFW_KEY_T || fleet_count)
+		return;
+
+	trail_on = !trail_on;
+	if (!trail_on)
+		viz_trail_clear(&trail);
+	printf("Trail %s\n", trail_on ? "on" : "off");
 }
 
 /**
- * key_callback - Håndter tastatur-input
- * @window: GLFW vindu
- * @key: tast som ble trykket
- * @scancode: system-spesifikk scancode
- * @action: GLFW_PRESS, GLFW_RELEASE, eller GLFW_REPEAT
- * @mods: modifier bits (shift, ctrl, alt, etc)
+ * wake_render - Vekk render-tråden fra glfwWaitEvents*()
  *
- * Piltaster: Roter kamera
- * +/-: Zoom inn/ut
- * R: Reset kamera
+ * Kalles fra ingest-tråden etter publisering. Vinduet finnes så lenge
+ * ingest-tråden kjører; med -B er det ikke noe å vekke.
  */
-static void key_callback(GLFWwindow *window, int key, int scancode, int action,
-			 int mods)
+static void wake_render(void)
 {
-	(void)scancode;
-	(void)mods;
-
-	if (action != GLFW_PRESS && action != GLFW_REPEAT)
-		return;
-
-	switch (key) {
-	case GLFW_KEY_LEFT:
-		camera_azimuth -= 5.0f;
-		break;
-	case GLFW_KEY_RIGHT:
-		camera_azimuth += 5.0f;
-		break;
-	case GLFW_KEY_UP:
-		camera_elevation += 5.0f;
-		if (camera_elevation > 89.0f)
-			camera_elevation = 89.0f;
-		break;
-	case GLFW_KEY_DOWN:
-		camera_elevation -= 5.0f;
-		if (camera_elevation < -89.0f)
-			camera_elevation = -89.0f;
-		break;
-	case GLFW_KEY_EQUAL: /* + key */
-	case GLFW_KEY_Q:
-		ortho_scale *= 0.9f;
-		if (ortho_scale < 50.0f)
-			ortho_scale = 50.0f;
-		break;
-	case GLFW_KEY_MINUS: /* - key */
-	case GLFW_KEY_W:
-		ortho_scale *= 1.1f;
-		if (ortho_scale > 2000.0f)
-			ortho_scale = 2000.0f;
-		break;
-	case GLFW_KEY_R:
-		/* Reset kamera */
-		camera_azimuth = 45.0f;
-		camera_elevation = 30.0f;
-		ortho_scale = 400.0f;
-		printf("Camera reset\n");
-		break;
-	case GLFW_KEY_ESCAPE:
-		glfwSetWindowShouldClose(window, GLFW_TRUE);
-		break;
-	}
+	if (win.window)
+		glfwPostEmptyEvent();
 }
 
 /**
  * render_stewart_kinematics - Render Stewart platform med kinematikk
+ * @ctx: ubrukt (viz_draw_fn)
  *
  * Tegner:
  * - Base sekskant (blå)
@@ -128,123 +137,76 @@ static void key_callback(GLFWwindow *window, int key, int scancode, int action,
  * - Knee points (grønne kuler)
  * - Koordinatsystem
  *
- * Viser faktisk kinematikk fra inverse beregning.
+ * Viser nyeste kinematikk publisert av ingest-tråden.
  */
-static void render_stewart_kinematics(void)
+static void render_stewart_kinematics(void *ctx)
 {
-	int i;
-	float azimuth_rad, elevation_rad;
-	float eye_x, eye_y, eye_z;
+	const struct stewart_inverse_result *ik;
+	const struct frame_state *frame;
+	const struct viz_fleet_leg *legs;
+	int pair[2], fresh;
 
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	(void)ctx;
 
-	/* Oppdater orthographic projection basert på ortho_scale */
-	glMatrixMode(GL_PROJECTION);
-	glLoadIdentity();
-	float aspect = 1024.0f / 768.0f;
-	glOrtho(-ortho_scale * aspect, ortho_scale * aspect, -ortho_scale,
-		ortho_scale, -2000.0, 2000.0);
+	viz_scene_begin(&camera, &win);
 
-	glMatrixMode(GL_MODELVIEW);
-	glLoadIdentity();
-
-	/* Beregn kamera posisjon fra azimuth og elevation */
-	azimuth_rad = camera_azimuth * M_PI / 180.0f;
-	elevation_rad = camera_elevation * M_PI / 180.0f;
-
-	eye_x = camera_distance * cosf(elevation_rad) * cosf(azimuth_rad);
-	eye_y = camera_distance * sinf(elevation_rad);
-	eye_z = camera_distance * cosf(elevation_rad) * sinf(azimuth_rad);
+	/* Flåtemodus: alle roboter med to instansierte kall */
+	if (fleet_count) {
+		legs = viz_triple_read(&fleet_frames, &fresh);
+		viz_fleet_view_draw(&fleet_view, fresh ? legs : NULL);
+		return;
+	}
 
-	/* Kamera ser på (0, 100, 0) - midt på Stewart platform */
-	gluLookAt(eye_x, eye_y + 100.0f, eye_z, /* eye */
-		  0.0, 100.0, 0.0, /* center */
-		  0.0, 1.0, 0.0); /* up */
+	/* Nyeste komplette tilstand, stabil for hele framen */
+	frame = viz_triple_read(&frames, &fresh);
+	ik = &frame->inverse;
+	animate = frame->has_error;
+	if (trail_on)
+		animate |= viz_scene_trail_update(&trail, &ik, 1, fresh);
 
 	/* Tegn base sekskant (blå) */
-	glColor3f(0.4f, 0.4f, 1.0f);
-	glLineWidth(6.0f);
-	glBegin(GL_LINE_LOOP);
-	for (i = 0; i < 6; i++) {
-		struct vec3 *p = &geometry.base_points[i];
-		glVertex3f(p->x, p->y, p->z);
-	}
-	glEnd();
+	viz_render_color(&renderer, 0.4f, 0.4f, 1.0f);
+	viz_render_line_width(&renderer, 6.0f);
+	viz_render_line_loop(&renderer, frame->base_points, 6);
 
 	/* Tegn platform sekskant (hvit hvis ok, rød blink hvis error) */
-	if (has_error) {
+	if (frame->has_error) {
 		/* Blink rød hvis error */
-		float intensity = 0.5f + 0.5f * sinf(glfwGetTime() * 5.0f);
-		glColor3f(1.0f, intensity * 0.2f, intensity * 0.2f);
+		/* Ikke glfwGetTime(), GLFW er ikke initialisert med -B */
+		double t = (double)viz_time_ns() / 1e9;
+		float intensity = 0.5f + 0.5f * (float)sin(t * 5.0);
+		viz_render_color(&renderer, 1.0f, intensity * 0.2f,
+				 intensity * 0.2f);
 	} else {
-		glColor3f(1.0f, 1.0f, 1.0f);
-	}
-	glLineWidth(6.0f);
-	glBegin(GL_LINE_LOOP);
-	for (i = 0; i < 6; i++) {
-		struct vec3 *p = &inverse_result.platform_points_transformed[i];
-		glVertex3f(p->x, p->y, p->z);
-	}
-	glEnd();
-
-	/* Tegn motor arms (gul: base → knee) */
-	glColor3f(0.9f, 0.9f, 0.2f);
-	glLineWidth(2.0f);
-	glBegin(GL_LINES);
-	for (i = 0; i < 6; i++) {
-		struct vec3 *base = &geometry.base_points[i];
-		struct vec3 *knee = &inverse_result.knee_points[i];
-		glVertex3f(base->x, base->y, base->z);
-		glVertex3f(knee->x, knee->y, knee->z);
+		viz_render_color(&renderer, 1.0f, 1.0f, 1.0f);
 	}
-	glEnd();
-
-	/* Tegn pushrods (oransje: knee → platform) */
-	glColor3f(1.0f, 0.5f, 0.1f);
-	glLineWidth(2.0f);
-	glBegin(GL_LINES);
-	for (i = 0; i < 6; i++) {
-		struct vec3 *knee = &inverse_result.knee_points[i];
-		struct vec3 *platform =
-			&inverse_result.platform_points_transformed[i];
-		glVertex3f(knee->x, knee->y, knee->z);
-		glVertex3f(platform->x, platform->y, platform->z);
+	viz_render_line_loop(&renderer,
+			     frame->inverse.platform_points_transformed, 6);
+
+	/* Tegn motor arms, pushrods og knee points */
+	viz_scene_draw_legs(&renderer, frame->base_points, ik, &leg_colors);
+
+	/* Tegn ben-paret som er nærmest kollisjon (rødt) */
+	if (frame->near_collision) {
+		stewart_collision_pair_legs(frame->collision.min_pair,
+					    &pair[0], &pair[1]);
+		viz_scene_draw_collision_pair(&renderer, frame->base_points,
+					      ik, pair);
 	}
-	glEnd();
 
-	/* Tegn knee points (grønne kuler) */
-	glColor3f(0.2f, 0.9f, 0.2f);
-	for (i = 0; i < 6; i++) {
-		struct vec3 *knee = &inverse_result.knee_points[i];
-		draw_sphere(knee->x, knee->y, knee->z, 5.0f, 12, 12);
-	}
-
-	/* Tegn koordinatsystem i origo */
-	glLineWidth(4.0f);
-	glBegin(GL_LINES);
-	/* X-akse (rød) */
-	glColor3f(1.0f, 0.0f, 0.0f);
-	glVertex3f(0.0f, 0.0f, 0.0f);
-	glVertex3f(100.0f, 0.0f, 0.0f);
-	/* Y-akse (grønn) */
-	glColor3f(0.0f, 1.0f, 0.0f);
-	glVertex3f(0.0f, 0.0f, 0.0f);
-	glVertex3f(0.0f, 100.0f, 0.0f);
-	/* Z-akse (blå) */
-	glColor3f(0.0f, 0.0f, 1.0f);
-	glVertex3f(0.0f, 0.0f, 0.0f);
-	glVertex3f(0.0f, 0.0f, 100.0f);
-	glEnd();
+	/* Akser, kulene i ett kall og linjene i ett kall per bredde */
+	viz_scene_end(&renderer, trail_on ? &trail : NULL);
 }
 
 /**
  * compute_kinematics - Beregn inverse kinematics for current pose
  *
  * Konverterer UDP pose packet til stewart_pose og kjører inverse
- * kinematics. Oppdaterer inverse_result og has_error flag.
+ * kinematics og kollisjonssjekk, og publiserer resultatet i frames.
  */
 static void compute_kinematics(void)
 {
+	const struct stewart_geometry_prepared *prep;
 	struct stewart_pose pose;
 
 	/* Konverter UDP packet til stewart pose */
@@ -256,20 +218,36 @@ static void compute_kinematics(void)
 	pose.ty = current_pose.ty;
 	pose.tz = current_pose.tz;
 
-	/* Kjør inverse kinematics */
-	stewart_kinematics_inverse(&geometry, &pose, &inverse_result, 0);
+	/* Kjør inverse kinematics og kollisjonssjekk på samme geometri */
+	prep = stewart_geometry_slot_acquire(geometry);
+	stewart_ik_cache_inverse(&ik_cache, prep,
+				 stewart_geometry_slot_generation(geometry),
+				 &pose, &state.inverse);
+	stewart_collision_check(&prep->geom, &state.inverse, &state.collision);
+	memcpy(state.base_points, prep->geom.base_points,
+	       sizeof(state.base_points));
+	stewart_geometry_slot_release(geometry, prep);
 
 	/* Sjekk for error */
-	has_error = inverse_result.error;
+	state.has_error = state.inverse.error;
+
+	/* Ben-ben og kne-plate klaringer */
+	state.near_collision =
+		state.collision.min_pair_distance_mm < COLLISION_WARN_MM ||
+		state.collision.min_plate_clearance_mm < 0.0f;
+
+	*(struct frame_state *)viz_triple_back(&frames) = state;
+	if (viz_triple_publish(&frames))
+		wake_render();
 
 	/* Print motor angles (kun ved endring) */
 	static float last_angles[6] = { 0 };
 	int changed = 0;
 	for (int i = 0; i < 6; i++) {
-		if (fabsf(inverse_result.motor_angles_deg[i] - last_angles[i]) >
+		if (fabsf(state.inverse.motor_angles_deg[i] - last_angles[i]) >
 		    0.5f) {
 			changed = 1;
-			last_angles[i] = inverse_result.motor_angles_deg[i];
+			last_angles[i] = state.inverse.motor_angles_deg[i];
 		}
 	}
 
@@ -277,55 +255,304 @@ static void compute_kinematics(void)
 		printf("Motors: ");
 		for (int i = 0; i < 6; i++) {
 			printf("[%d]=%.1f° ", i,
-			       inverse_result.motor_angles_deg[i]);
+			       state.inverse.motor_angles_deg[i]);
 		}
-		if (has_error)
+		if (state.has_error)
 			printf(" ⚠️  ERROR: Pose unreachable!");
+		if (state.near_collision) {
+			int a, b;
+
+			stewart_collision_pair_legs(state.collision.min_pair,
+						    &a, &b);
+			printf(" ⚠️  Legs %d-%d %.1f mm, plate %.1f mm", a, b,
+			       state.collision.min_pair_distance_mm,
+			       state.collision.min_plate_clearance_mm);
+		}
 		printf("\n");
 	}
 }
 
 /**
- * poll_udp - Poll UDP socket for nye pose packets
+ * compute_fleet_kinematics - Beregn IK for robotene i flåtemodus
+ * @all: 1 for alle roboter, 0 for bare de som har fått ny pose
  *
- * Sjekker om det er kommet nye pose-data via UDP.
- * Oppdaterer current_pose og kjører kinematikk hvis gyldig packet mottas.
+ * Posene samles per robot-type og kjøres gjennom
+ * stewart_kinematics_inverse_batch() med én geometri-acquire per type.
+ * Alle benene publiseres deretter samlet i fleet_frames.
  */
-static void poll_udp(void)
+static void compute_fleet_kinematics(int all)
+{
+	static struct stewart_pose poses[2][VIZ_FLEET_MAX_ROBOTS];
+	static int ids[2][VIZ_FLEET_MAX_ROBOTS];
+	static struct stewart_inverse_result results[VIZ_FLEET_MAX_ROBOTS];
+	struct stewart_geometry_slot *slots[2] = { &geometries.mx64,
+						   &geometries.ax18 };
+	const struct stewart_geometry_prepared *prep;
+	const struct viz_pose_packet *packet;
+	struct stewart_pose *pose;
+	int count[2] = { 0, 0 };
+	int id, type, k;
+
+	for (id = 0; id < fleet_view.count; id++) {
+		if (!all && !viz_fleet_is_dirty(&fleet, id))
+			continue;
+
+		packet = &fleet.robots[id].pose;
+		type = packet->robot_type == ROBOT_TYPE_AX18;
+		k = count[type]++;
+		ids[type][k] = id;
+
+		pose = &poses[type][k];
+		stewart_pose_init(pose);
+		pose->rx = packet->rx;
+		pose->ry = packet->ry;
+		pose->rz = packet->rz;
+		pose->tx = packet->tx;
+		pose->ty = packet->ty;
+		pose->tz = packet->tz;
+	}
+
+	for (type = 0; type < 2; type++) {
+		if (!count[type])
+			continue;
+
+		prep = stewart_geometry_slot_acquire(slots[type]);
+		stewart_kinematics_inverse_batch(prep, poses[type], count[type],
+						 results);
+		for (k = 0; k < count[type]; k++)
+			viz_fleet_view_set(&fleet_view, fleet_legs,
+					   ids[type][k], prep, &results[k]);
+		stewart_geometry_slot_release(slots[type], prep);
+	}
+
+	memcpy(viz_triple_back(&fleet_frames), fleet_legs, fleet_frames.size);
+	if (viz_triple_publish(&fleet_frames))
+		wake_render();
+}
+
+/**
+ * receive_poses - Motta nye pose packets
+ *
+ * Tømmer socket-køen inn i flåten (enkelt-poser er robot 0, batch
+ * packets fordeles på robot_id). Oppdaterer current_pose og kjører
+ * kinematikk hvis roboten som vises har fått ny pose.
+ */
+static void receive_poses(void)
 {
 	struct viz_pose_packet packet;
-	int n;
 
-	n = udp_receive(udp_sock, &packet, sizeof(packet));
+	if (viz_receive_fleet(&transport, &fleet) <= 0)
+		return;
 
-	if (n == sizeof(packet)) {
-		/* Valider packet */
-		if (packet.magic == VIZ_MAGIC &&
-		    packet.type == VIZ_PACKET_POSE) {
-			current_pose = packet;
+	if (fleet_count) {
+		compute_fleet_kinematics(0);
+		viz_fleet_clear_dirty(&fleet);
+		return;
+	}
 
-			/* Oppdater geometri hvis robot type endres */
-			if (packet.robot_type == ROBOT_TYPE_MX64) {
-				geometry = ROBOT_MX64;
-			} else if (packet.robot_type == ROBOT_TYPE_AX18) {
-				geometry = ROBOT_AX18;
-			}
+	if (viz_fleet_is_dirty(&fleet, robot_id)) {
+		viz_fleet_clear_dirty(&fleet);
+		packet = fleet.robots[robot_id].pose;
+		current_pose = packet;
 
-			/* Beregn kinematikk */
+		/* Bytt aktiv geometri hvis robot type endres (kun peker) */
+		if (packet.robot_type == ROBOT_TYPE_MX64 ||
+		    packet.robot_type == ROBOT_TYPE_AX18)
+			geometry = viz_geometry_select(&geometries,
+						       packet.robot_type);
+
+		/* Beregn kinematikk */
+		compute_kinematics();
+	}
+}
+
+/**
+ * ingest_step - Mottak og IK (ingest-tråden)
+ * @ctx: ubrukt
+ *
+ * Kalles når transporten har data og etter SIGHUP. Render-tråden ser
+ * bare det som publiseres i frames og fleet_frames.
+ */
+static void ingest_step(void *ctx)
+{
+	(void)ctx;
+
+	if (viz_geometry_reload_pending(&geometries)) {
+		viz_geometry_reload(&geometries);
+		if (fleet_count)
+			compute_fleet_kinematics(1);
+		else
 			compute_kinematics();
-		}
 	}
+
+	receive_poses();
+}
+
+/**
+ * init_fleet_view - Sett opp flåtemodus hvis -n eller -P er gitt
+ *
+ * Tilpasser zoom og klipping til flåten og beregner IK for alle.
+ * Kalles før ingest-tråden startes.
+ *
+ * Retur: 0 ved suksess (eller ingen flåtemodus), -1 ved feil
+ */
+static int init_fleet_view(void)
+{
+	float size;
+
+	if (!fleet_count && !fleet_positions)
+		return 0;
+
+	if (viz_fleet_view_init(&fleet_view, fleet_count ? fleet_count : 1) < 0)
+		return -1;
+	if (fleet_positions) {
+		if (viz_fleet_view_load_positions(&fleet_view,
+						  fleet_positions) < 0)
+			return -1;
+	} else {
+		viz_fleet_view_grid(&fleet_view, fleet_spacing);
+	}
+	fleet_count = fleet_view.count;
+
+	if (viz_triple_init(&fleet_frames,
+			    fleet_count * 6 * sizeof(struct viz_fleet_leg)) < 0)
+		return -1;
+
+	size = fleet_view.extent + 300.0f;
+	if (size > camera.default_ortho_scale)
+		camera.default_ortho_scale = size;
+	if (2.0f * size > camera.max_ortho_scale)
+		camera.max_ortho_scale = 2.0f * size;
+	if (camera.distance + size > camera.clip_depth)
+		camera.clip_depth = camera.distance + size;
+	camera.ortho_scale = camera.default_ortho_scale;
+
+	compute_fleet_kinematics(1);
+	printf("Fleet mode: %d robots\n", fleet_count);
+
+	return 0;
 }
 
-int main(void)
+/**
+ * init_trail - Sett opp spor for platform-senter og knær
+ *
+ * Spor vises bare for enkelt-robot; i flåtemodus er -t og T uten effekt.
+ *
+ * Retur: 0 ved suksess (eller flåtemodus), -1 ved feil
+ */
+static int init_trail(void)
 {
-	GLFWwindow *window;
+	int i;
+
+	if (fleet_count) {
+		trail_on = 0;
+		return 0;
+	}
+
+	if (viz_trail_init(&trail, VIZ_SCENE_TRAIL_TRACKS, VIZ_TRAIL_SAMPLES,
+			   trail_seconds) < 0)
+		return -1;
+
+	/* Senteret som platformen (hvit), knærne som kulene (grønn) */
+	viz_trail_color(&trail, 0, 1.0f, 1.0f, 1.0f);
+	for (i = 1; i < VIZ_SCENE_TRAIL_TRACKS; i++)
+		viz_trail_color(&trail, i, leg_colors.knee[0],
+				leg_colors.knee[1], leg_colors.knee[2]);
+
+	return 0;
+}
+
+static void print_usage(const char *prog)
+{
+	printf("Usage: %s [-m mx64.geom] [-a ax18.geom] [-i robot] "
+	       "[-n count [-g mm] | -P file] [-t s] [-B frames] [endpoint]\n",
+	       prog);
+	printf("  -m <file>  MX64 geometry file (default: built-in)\n");
+	printf("  -a <file>  AX18 geometry file (default: built-in)\n");
+	printf("  -i <id>    Robot to show from batch packets (default 0)\n");
+	printf("  -n <count> Fleet mode: show robots 0..count-1 in a grid\n");
+	printf("  -g <mm>    Fleet grid spacing (default %.0f)\n",
+	       VIZ_FLEET_VIEW_SPACING);
+	printf("  -P <file>  Fleet mode with positions from file "
+	       "(\"x z\" per robot)\n");
+	printf("  -t <s>     Show the last s seconds as trails (T toggles, "
+	       "default %.0f s)\n", VIZ_TRAIL_DEFAULT_S);
+	printf("  -B <n>     Headless: render n frames offscreen and print "
+	       "frame times\n");
+	printf("  endpoint   udp:<port> or shm:<name> (default udp:9001)\n");
+	printf("Send SIGHUP to reload the geometry files.\n");
+}
+
+int main(int argc, char **argv)
+{
+	int opt;
+
+	while ((opt = getopt(argc, argv, "m:a:i:n:g:P:t:B:h")) != -1) {
+		switch (opt) {
+		case 'm':
+			geometry_file_mx64 = optarg;
+			break;
+		case 'a':
+			geometry_file_ax18 = optarg;
+			break;
+		case 'i':
+			robot_id = atoi(optarg);
+			if (robot_id < 0 || robot_id >= VIZ_FLEET_MAX_ROBOTS) {
+				fprintf(stderr, "Robot id must be 0..%d\n",
+					VIZ_FLEET_MAX_ROBOTS - 1);
+				return 1;
+			}
+			break;
+		case 'n':
+			fleet_count = atoi(optarg);
+			if (fleet_count < 1 ||
+			    fleet_count > VIZ_FLEET_MAX_ROBOTS) {
+				fprintf(stderr, "Fleet size must be 1..%d\n",
+					VIZ_FLEET_MAX_ROBOTS);
+				return 1;
+			}
+			break;
+		case 'g':
+			fleet_spacing = atof(optarg);
+			break;
+		case 'P':
+			fleet_positions = optarg;
+			break;
+		case 't':
+			trail_seconds = atof(optarg);
+			if (trail_seconds <= 0.0f) {
+				fprintf(stderr, "Trail length must be > 0\n");
+				return 1;
+			}
+			trail_on = 1;
+			break;
+		case 'B':
+			bench_frames = atoi(optarg);
+			if (bench_frames < 1) {
+				fprintf(stderr, "Frame count must be > 0\n");
+				return 1;
+			}
+			break;
+		default:
+			print_usage(argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (optind < argc)
+		endpoint = argv[optind];
 
 	printf("Stewart Platform Kinematics Visualizer\n");
 	printf("======================================\n\n");
 
-	/* Initialiser geometry til MX64 (default) */
-	geometry = ROBOT_MX64;
+	/* Initialiser geometry, MX64 er default */
+	stewart_ik_cache_init(&ik_cache, 0.0f);
+	if (viz_geometry_init(&geometries, geometry_file_mx64,
+			      geometry_file_ax18) < 0)
+		return 1;
+
+	if (viz_triple_init(&frames, sizeof(struct frame_state)) < 0)
+		return 1;
 
 	/* Initialiser current_pose til home */
 	memset(&current_pose, 0, sizeof(current_pose));
@@ -336,59 +563,81 @@ int main(void)
 	/* Beregn initial kinematikk for home pose */
 	compute_kinematics();
 
-	/* Lag UDP receiver */
-	udp_sock = udp_create_receiver(VIZ_PORT);
-	if (udp_sock < 0) {
-		fprintf(stderr, "Failed to create UDP receiver\n");
+	/* Lag receiver */
+	if (viz_transport_open_receiver(&transport, endpoint) < 0) {
+		fprintf(stderr, "Failed to create receiver on %s\n", endpoint);
 		return 1;
 	}
 
-	printf("Listening on UDP port %d...\n\n", VIZ_PORT);
+	printf("Listening on %s...\n\n", endpoint);
 
-	/* Initialiser GLFW */
-	if (!glfwInit()) {
-		fprintf(stderr, "Failed to initialize GLFW\n");
+	viz_camera_init(&camera);
+	if (viz_window_open(&win, "Stewart Kinematics", 1024, 768,
+			    bench_frames) < 0)
 		return 1;
-	}
+	viz_camera_attach(&camera, &win, handle_key, NULL);
 
-	/* Lag vindu */
-	window = glfwCreateWindow(1024, 768, "Stewart Kinematics", NULL, NULL);
-	if (!window) {
-		fprintf(stderr, "Failed to create window\n");
-		glfwTerminate();
+	if (viz_scene_init(&renderer) < 0 || init_fleet_view() < 0 ||
+	    init_trail() < 0) {
+		viz_window_close(&win);
 		return 1;
 	}
 
-	glfwMakeContextCurrent(window);
-	glfwSwapInterval(1); /* VSync */
-
-	/* Register keyboard callback */
-	glfwSetKeyCallback(window, key_callback);
-
-	/* Setup OpenGL */
-	glEnable(GL_DEPTH_TEST);
-	glClearColor(0.05f, 0.05f, 0.1f, 1.0f);
+	/* Mottak og IK i egen tråd, uavhengig av vsync */
+	if (viz_ingest_start(&ingest, viz_transport_fd(&transport),
+			     ingest_step, NULL) < 0) {
+		viz_window_close(&win);
+		return 1;
+	}
+	viz_geometry_watch(&geometries, &ingest.wake);
 
-	printf("Window created. Ready to visualize!\n");
-	printf("\nControls:\n");
-	printf("  Arrow keys:  Rotate camera\n");
-	printf("  +/-:         Zoom in/out\n");
-	printf("  R:           Reset camera\n");
-	printf("  ESC:         Exit\n\n");
+	if (bench_frames) {
+		viz_bench_run(bench_frames, render_stewart_kinematics, NULL,
+			      fleet_count ? "fleet" : "kinematics");
+	} else {
+		printf("Window created. Ready to visualize!\n");
+		printf("\nControls:\n");
+		printf("  Arrow keys:  Rotate camera\n");
+		printf("  +/- or Q/W:  Zoom in/out\n");
+		printf("  R:           Reset camera\n");
+		printf("  T:           Toggle trails\n");
+		printf("  ESC:         Exit\n\n");
+	}
 
-	/* Main loop */
-	while (!glfwWindowShouldClose(window)) {
-		poll_udp();
-		render_stewart_kinematics();
+	/*
+	 * Main loop: tegn bare når ingest har publisert noe nytt eller
+	 * kamera/vindu er endret, og sov i glfwWaitEvents() ellers. Ingest
+	 * vekker løkken med glfwPostEmptyEvent().
+	 */
+	while (win.window && !glfwWindowShouldClose(win.window)) {
+		if (win.redraw ||
+		    viz_triple_pending(fleet_count ? &fleet_frames : &frames)) {
+			win.redraw = 0;
+			render_stewart_kinematics(NULL);
+			glfwSwapBuffers(win.window);
+		}
 
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+		if (animate) {
+			glfwWaitEventsTimeout(ANIMATE_FRAME_S);
+			win.redraw = 1;
+		} else {
+			glfwWaitEvents();
+		}
 	}
 
 	/* Cleanup */
-	glfwDestroyWindow(window);
-	glfwTerminate();
-	close(udp_sock);
+	viz_geometry_unwatch();
+	viz_ingest_stop(&ingest);
+	viz_fleet_view_destroy(&fleet_view);
+	viz_trail_destroy(&trail);
+	viz_render_destroy(&renderer);
+	viz_window_close(&win);
+	viz_transport_close(&transport);
+	viz_stream_stats_print(&fleet.stats, endpoint);
+	stewart_ik_cache_stats_print(&ik_cache, endpoint);
+	viz_triple_destroy(&frames);
+	viz_triple_destroy(&fleet_frames);
+	viz_geometry_destroy(&geometries);
 
 	return 0;
 }
@@ -0,0 +1,1030 @@
+#define _DEFAULT_SOURCE
+#include "robotics/math/vec3.h"
+#include "stewart/collision.h"
+#include "stewart/geometry.h"
+#include "stewart/geometry_slot.h"
+#include "stewart/ik_cache.h"
+#include "stewart/kinematics.h"
+#include "stewart/pose.h"
+#include "viz_protocol.h"
+#include "bench.h"
+#include "camera.h"
+#include "pose_estimator.h"
+#include "recording.h"
+#include "render.h"
+#include "scene.h"
+#include "stream_set.h"
+#include "trail.h"
+#include "triple_buffer.h"
+#include "viz_gl.h"
+#include <GLFW/glfw3.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+/* Seks kne-kuler per strøm, alle i samme batch */
+#define MAX_STREAMS (VIZ_RENDER_MAX_SPHERES / 6)
+
+/* Ben nærmere hverandre (senterlinje) enn dette markeres i rødt (mm) */
+#define COLLISION_WARN_MM 10.0f
+
+/* Frame-intervall mens spor forsvinner; ellers tegnes bare ved endring */
+#define TRAIL_FRAME_S (1.0 / 30.0)
+
+/* Lengste søvn i avspillings-tråden, så stopp virker midt i en pause */
+#define REPLAY_SLEEP_MAX_US 50000
+
+/**
+ * struct stream_config - Én strøm fra kommandolinjen
+ * @endpoint: endpoint-streng (se transport.h)
+ * @label: navn i utskrifter (label=, default @endpoint)
+ * @geometry_file: egen geometri-fil (geom=), eller NULL
+ * @robot_type: robot type (robot=), -1 = fra pakkene
+ * @color: farge (color=)
+ * @index: strøm-indeks i streams
+ * @version: siste pose brukt (viz_stream_set_latest())
+ * @geometry: egen slot når @geometry_file er gitt, ellers NULL
+ * @ik_cache: IK-cache for strømmen, bare mottaks-tråden
+ * @pose: siste pose, bare mottaks-tråden
+ * @send_time_ns: sende-tidsstempel for @pose, bare mottaks-tråden
+ * @recv_time_ns: mottakstid for @pose, bare mottaks-tråden
+ * @estimator: pose ved render-tidspunktet (-e/-d), bare render-tråden
+ * @estimated_version: siste sample gitt til @estimator
+ */
+struct stream_config {
+	const char *endpoint;
+	const char *label;
+	const char *geometry_file;
+	int robot_type;
+	float color[3];
+	int index;
+	unsigned int version;
+	struct stewart_geometry_slot *geometry;
+	struct stewart_ik_cache ik_cache;
+	struct viz_pose_packet pose;
+	uint64_t send_time_ns;
+	uint64_t recv_time_ns;
+	struct viz_pose_estimator estimator;
+	unsigned int estimated_version;
+};
+
+/**
+ * struct stream_frame - Det render-tråden trenger for å tegne én strøm
+ * @pose: posen IK ble kjørt for
+ * @send_time_ns: sende-tidsstempel for @pose, 0 for v1
+ * @recv_time_ns: mottakstid for @pose
+ * @version: versjon av @pose i strømmen, 0 for home pose
+ * @base_points: base punkter fra geometrien IK ble kjørt med
+ * @inverse: IK-resultat
+ * @has_error: 1 hvis posen ikke kan nås
+ * @near_collision: 1 hvis to ben eller kne og plate er for nær
+ * @pair: ben-paret nærmest kollisjon
+ */
+struct stream_frame {
+	struct viz_pose_packet pose;
+	uint64_t send_time_ns;
+	uint64_t recv_time_ns;
+	unsigned int version;
+	struct vec3 base_points[6];
+	struct stewart_inverse_result inverse;
+	int has_error;
+	int near_collision;
+	int pair[2];
+};
+
+/**
+ * struct named_color - Farge som kan gis med navn i color=
+ * @name: navn
+ * @rgb: farge (0-1)
+ */
+struct named_color {
+	const char *name;
+	float rgb[3];
+};
+
+/* Default-farger i rekkefølge; de to første som i viz-stewart-compare */
+static const struct named_color colors[] = {
+	{ "cyan", { 0.2f, 0.9f, 0.9f } },
+	{ "magenta", { 0.9f, 0.2f, 0.9f } },
+	{ "yellow", { 0.9f, 0.9f, 0.2f } },
+	{ "green", { 0.2f, 0.9f, 0.2f } },
+	{ "orange", { 1.0f, 0.5f, 0.1f } },
+	{ "blue", { 0.4f, 0.4f, 1.0f } },
+	{ "white", { 1.0f, 1.0f, 1.0f } },
+	{ "red", { 1.0f, 0.2f, 0.2f } },
+};
+
+#define COLOR_COUNT ((int)(sizeof(colors) / sizeof(colors[0])))
+
+/* Strømmer, konfigurert før mottaks-tråden startes */
+static struct stream_config stream_configs[MAX_STREAMS];
+static int stream_count;
+static struct viz_stream_set streams; /* Mottak og IK i egen tråd */
+
+/* Delt geometri for strømmer uten geom=, valgt per pakke */
+static struct viz_geometry_set geometry; /* Lastes på nytt ved SIGHUP */
+static const char *geometry_file_mx64; /* -m */
+static const char *geometry_file_ax18; /* -a */
+
+/* Mottaks-tråd -> render, stream_count frames per slot */
+static struct stream_frame *work; /* Arbeidskopi i mottaks-tråden */
+static struct viz_triple_buffer frames;
+
+static struct viz_window win; /* Vindu, eller offscreen context med -B */
+static int bench_frames; /* -B, 0 = vanlig vindu */
+static struct viz_renderer renderer;
+static struct viz_trail trail; /* Pose-historikk for alle strømmer */
+static float trail_seconds = VIZ_TRAIL_DEFAULT_S; /* -t */
+static int trail_on; /* -t eller T */
+static int trail_fading; /* Samples igjen, tegn på nytt etter TRAIL_FRAME_S */
+static int trail_streams; /* De første, høyst VIZ_SCENE_TRAIL_MAX_POSES */
+static float estimate_ms = VIZ_POSE_ESTIMATOR_DEFAULT_MS; /* -e */
+static float estimate_delay_ms; /* -d */
+static int estimating; /* -e eller -d */
+static int estimate_moving; /* Estimert pose endrer seg, tegn hver frame */
+static struct stream_frame estimated[MAX_STREAMS]; /* Det som tegnes */
+
+/* Opptak (-r) og avspilling (-P) av strømmene */
+static const char *record_file;
+static struct viz_recorder recorder; /* Skrives fra mottaks-tråden */
+static const char *replay_file;
+static float replay_speed = 1.0f; /* -S, 0 = så fort som mulig */
+static struct viz_replay replay;
+static pthread_t replay_thread;
+static atomic_int replay_running;
+static uint64_t replay_elapsed_ns; /* Tid fra start til avspillingen stoppet */
+static int replay_finished; /* Hele opptaket er spilt av */
+
+static struct viz_camera camera; /* Piltaster, zoom og reset */
+
+/**
+ * handle_key - Taster utenom kameraet (viz_key_fn)
+ * @ctx: ubrukt
+ * @key: GLFW_KEY_*
+ *
+ * T: Spor av/på
+ */
+static void handle_key(void *ctx, int key)
+{
+	(void)ctx;
+
+	if (key != GLFW_KEY_T || !trail.tracks)
+		return;
+
+	trail_on = !trail_on;
+	if (!trail_on)
+		viz_trail_clear(&trail);
+	printf("Trail %s\n", trail_on ? "on" : "off");
+}
+
+/**
+ * stream_geometry - Geometri-slot for en strøm
+ * @s: strøm
+ * @pose: posen som skal regnes
+ *
+ * Retur: egen slot (geom=), ellers delt slot etter robot= eller pakken
+ */
+static struct stewart_geometry_slot *
+stream_geometry(const struct stream_config *s,
+		const struct viz_pose_packet *pose)
+{
+	int type = s->robot_type >= 0 ? s->robot_type : (int)pose->robot_type;
+
+	if (s->geometry)
+		return s->geometry;
+	return viz_geometry_select(&geometry, type);
+}
+
+/**
+ * solve_pose - IK og kollisjonssjekk for en pose i en strøm
+ * @s: strøm
+ * @packet: pose
+ * @cache: IK-cache, eller NULL for å regne direkte
+ * @f: output - IK-resultat, kollisjon og base punkter
+ *
+ * Samme pipeline for alle strømmer; bare geometrien og cachen er per
+ * strøm.
+ */
+static void solve_pose(const struct stream_config *s,
+		       const struct viz_pose_packet *packet,
+		       struct stewart_ik_cache *cache, struct stream_frame *f)
+{
+	struct stewart_geometry_slot *slot = stream_geometry(s, packet);
+	const struct stewart_geometry_prepared *prep;
+	struct stewart_collision_result collision;
+	struct stewart_pose pose;
+
+	stewart_pose_set(&pose, packet->rx, packet->ry, packet->rz, packet->tx,
+			 packet->ty, packet->tz);
+
+	prep = stewart_geometry_slot_acquire(slot);
+	if (cache)
+		stewart_ik_cache_inverse(cache, prep,
+					 stewart_geometry_slot_generation(slot),
+					 &pose, &f->inverse);
+	else
+		stewart_kinematics_inverse_prepared(prep, &pose, &f->inverse,
+						    0);
+	stewart_collision_check(&prep->geom, &f->inverse, &collision);
+	memcpy(f->base_points, prep->geom.base_points, sizeof(f->base_points));
+	stewart_geometry_slot_release(slot, prep);
+
+	f->has_error = f->inverse.error;
+	f->near_collision =
+		collision.min_pair_distance_mm < COLLISION_WARN_MM ||
+		collision.min_plate_clearance_mm < 0.0f;
+	stewart_collision_pair_legs(collision.min_pair, &f->pair[0],
+				    &f->pair[1]);
+}
+
+/**
+ * compute_stream - Regn siste pose i en strøm
+ * @s: strøm
+ * @f: output - tilstanden render-tråden tegner
+ */
+static void compute_stream(struct stream_config *s, struct stream_frame *f)
+{
+	f->pose = s->pose;
+	f->send_time_ns = s->send_time_ns;
+	f->recv_time_ns = s->recv_time_ns;
+	f->version = s->version;
+	solve_pose(s, &s->pose, &s->ik_cache, f);
+}
+
+/**
+ * publish_frames - Publiser alle strømmene for render-tråden
+ */
+static void publish_frames(void)
+{
+	memcpy(viz_triple_back(&frames), work, frames.size);
+
+	/* Vekk render-løkken fra glfwWaitEvents(); ingen vindu med -B */
+	if (viz_triple_publish(&frames) && win.window)
+		glfwPostEmptyEvent();
+}
+
+/**
+ * reload_geometry - Last delt geometri og geom=-filene på nytt
+ *
+ * Retur: 0 ved suksess, -1 hvis en fil ikke kunne lastes
+ */
+static int reload_geometry(void)
+{
+	struct stream_config *s;
+	int i, ret;
+
+	ret = viz_geometry_reload(&geometry);
+
+	for (i = 0; i < stream_count; i++) {
+		s = &stream_configs[i];
+		if (!s->geometry) /* geom= ikke gitt, eller ikke åpnet ennå */
+			continue;
+		if (stewart_geometry_slot_reload(s->geometry,
+						 s->geometry_file) < 0)
+			ret = -1;
+		else
+			printf("%s: geometry loaded from %s\n", s->label,
+			       s->geometry_file);
+	}
+
+	return ret;
+}
+
+/**
+ * ingest_update - IK og publisering i mottaks-tråden
+ * @ctx: ubrukt
+ *
+ * Kalles etter hver mottaks-runde og etter SIGHUP. Bare strømmer med
+ * ny pose regnes på nytt, og alle publiseres samlet.
+ */
+static void ingest_update(void *ctx)
+{
+	struct stream_config *s;
+	int i, updated = 0, reload = 0;
+
+	(void)ctx;
+
+	if (viz_geometry_reload_pending(&geometry)) {
+		reload_geometry();
+		reload = 1;
+	}
+
+	for (i = 0; i < stream_count; i++) {
+		s = &stream_configs[i];
+		if (viz_stream_set_latest_timed(&streams, s->index, &s->pose,
+						&s->send_time_ns,
+						&s->recv_time_ns,
+						&s->version) || reload) {
+			compute_stream(s, &work[i]);
+			updated = 1;
+		}
+	}
+
+	if (updated)
+		publish_frames();
+}
+
+/**
+ * record_pose - Skriv mottatt pose til opptaket
+ * @ctx: strømmen (struct stream_config)
+ * @pose: pose
+ * @info: metadata fra dekodingen
+ * @recv_time_ns: viz_time_ns() ved mottak
+ *
+ * Kalles i mottaks-tråden for hver pose, også de latest-wins forkaster.
+ */
+static void record_pose(void *ctx, const struct viz_pose_packet *pose,
+			const struct viz_packet_info *info,
+			uint64_t recv_time_ns)
+{
+	const struct stream_config *s = ctx;
+
+	viz_recorder_write(&recorder, (int)(s - stream_configs), pose, info,
+			   recv_time_ns);
+}
+
+/**
+ * replay_main - Spill av opptaket gjennom samme pipeline som mottak
+ * @arg: ubrukt
+ *
+ * Hver pose legges i slotten til strømmen sin og regnes med
+ * ingest_update(), én og én, så hver pose i opptaket går gjennom IK
+ * også når avspillingen går fortere enn render-tråden tegner.
+ */
+static void *replay_main(void *arg)
+{
+	struct viz_pose_packet pose;
+	uint64_t send, recv, now, start = viz_time_ns();
+	int stream, n = 1;
+
+	(void)arg;
+
+	while (atomic_load_explicit(&replay_running, memory_order_acquire)) {
+		n = viz_replay_next(&replay, &stream, &pose, &send, &recv);
+		if (n <= 0)
+			break;
+
+		/* Vent til posen skal ha kommet; med -S 0 er den allerede der */
+		while ((now = viz_time_ns()) < recv &&
+		       atomic_load_explicit(&replay_running,
+					    memory_order_acquire)) {
+			if (recv - now > REPLAY_SLEEP_MAX_US * 1000ULL)
+				usleep(REPLAY_SLEEP_MAX_US);
+			else
+				usleep((useconds_t)((recv - now) / 1000));
+		}
+
+		viz_stream_set_inject(&streams, stream_configs[stream].index,
+				      &pose, send, recv);
+		ingest_update(NULL);
+	}
+
+	replay_elapsed_ns = viz_time_ns() - start;
+	replay_finished = n == 0;
+	return NULL;
+}
+
+/**
+ * start_input - Start mottaks-tråden, eller avspillingen med -P
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+static int start_input(void)
+{
+	int err;
+
+	if (!replay_file) {
+		viz_stream_set_on_update(&streams, ingest_update, NULL);
+		return viz_stream_set_start(&streams);
+	}
+
+	atomic_store_explicit(&replay_running, 1, memory_order_release);
+	err = pthread_create(&replay_thread, NULL, replay_main, NULL);
+	if (err) {
+		fprintf(stderr, "pthread_create: %s\n", strerror(err));
+		atomic_store(&replay_running, 0);
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * stop_input - Stopp mottaks- eller avspillings-tråden og vent på den
+ */
+static void stop_input(void)
+{
+	if (!replay_file) {
+		viz_stream_set_stop(&streams);
+		return;
+	}
+
+	if (atomic_exchange(&replay_running, 0))
+		pthread_join(replay_thread, NULL);
+}
+
+/**
+ * start_recording - Åpne opptaksfilen og koble den til alle strømmene
+ *
+ * Strøm-navnene i opptaket er endpointene, så -P uten strømmer lytter
+ * ikke, men viser dem med samme navn.
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+static int start_recording(void)
+{
+	const char *names[MAX_STREAMS];
+	struct viz_stream_stats *stats;
+	int i;
+
+	for (i = 0; i < stream_count; i++)
+		names[i] = stream_configs[i].endpoint;
+	if (viz_recorder_open(&recorder, record_file, names, stream_count) < 0)
+		return -1;
+
+	for (i = 0; i < stream_count; i++) {
+		stats = &streams.streams[stream_configs[i].index].stats;
+		stats->record = record_pose;
+		stats->record_ctx = &stream_configs[i];
+	}
+
+	printf("Recording to %s\n\n", record_file);
+	return 0;
+}
+
+/**
+ * print_replay_summary - Skriv hvor mange poser som ble spilt av og hvor fort
+ */
+static void print_replay_summary(void)
+{
+	double seconds = replay_elapsed_ns / 1e9;
+
+	printf("replay: %llu poses in %.3f s",
+	       (unsigned long long)replay.records, seconds);
+	if (seconds > 0.0)
+		printf(" (%.0f poses/s)", replay.records / seconds);
+	printf("%s\n", replay_finished ? "" : ", stopped");
+}
+
+/**
+ * estimate_streams - Estimer posene ved render-tidspunktet
+ * @f: nyeste publiserte tilstand
+ *
+ * Nye samples gis til estimatorene, og strømmer der estimert pose
+ * avviker fra siste sample regnes på nytt i render-tråden (uten cache,
+ * posen er ny hver frame). Resultatet legges i estimated. Kosten er én
+ * IK per strøm i bevegelse, uavhengig av pakkeraten.
+ *
+ * Retur: 1 hvis en estimert pose fortsatt endrer seg
+ */
+static int estimate_streams(const struct stream_frame *f)
+{
+	struct stream_config *s;
+	struct viz_pose_packet pose;
+	uint64_t now = viz_time_ns();
+	int i, moving = 0;
+
+	for (i = 0; i < stream_count; i++) {
+		s = &stream_configs[i];
+		if (f[i].version != s->estimated_version) {
+			viz_pose_estimator_push(&s->estimator, &f[i].pose,
+						f[i].send_time_ns,
+						f[i].recv_time_ns);
+			s->estimated_version = f[i].version;
+		}
+
+		pose = f[i].pose;
+		moving |= viz_pose_estimator_predict(&s->estimator, now,
+						     &pose);
+		if (memcmp(&pose, &f[i].pose, sizeof(pose)) == 0) {
+			estimated[i] = f[i];
+		} else {
+			estimated[i].pose = pose;
+			solve_pose(s, &pose, NULL, &estimated[i]);
+		}
+	}
+
+	return moving;
+}
+
+/**
+ * draw_stream - Legg én strøm i render-batchen
+ * @f: tilstand
+ * @color: strømmens farge
+ *
+ * Platformen er rød ved IK-feil, og ben-paret nærmest kollisjon rødt.
+ */
+static void draw_stream(const struct stream_frame *f, const float color[3])
+{
+	const struct vec3 *platform = f->inverse.platform_points_transformed;
+	float r = color[0], g = color[1], b = color[2];
+	struct viz_leg_colors legs;
+
+	/* Base sekskant (dempet) */
+	viz_render_color(&renderer, r * 0.5f, g * 0.5f, b * 0.5f);
+	viz_render_line_width(&renderer, 3.0f);
+	viz_render_line_loop(&renderer, f->base_points, 6);
+
+	/* Platform sekskant */
+	if (f->has_error)
+		viz_render_color(&renderer, 1.0f, 0.1f, 0.1f);
+	else
+		viz_render_color(&renderer, r, g, b);
+	viz_render_line_loop(&renderer, platform, 6);
+
+	viz_leg_colors_from(&legs, color);
+	viz_scene_draw_legs(&renderer, f->base_points, &f->inverse, &legs);
+	if (f->near_collision)
+		viz_scene_draw_collision_pair(&renderer, f->base_points,
+					      &f->inverse, f->pair);
+}
+
+/**
+ * render_streams - Render alle strømmene i samme scene
+ * @ctx: ubrukt (viz_draw_fn)
+ *
+ * Alle strømmene legges i samme batch, så kostnaden per strøm er bare
+ * vertices; antall draw calls er det samme for én og mange strømmer.
+ */
+static void render_streams(void *ctx)
+{
+	const struct stewart_inverse_result *poses[VIZ_SCENE_TRAIL_MAX_POSES];
+	const struct stream_frame *f;
+	int i, fresh;
+
+	(void)ctx;
+
+	viz_scene_begin(&camera, &win);
+
+	/* Nyeste komplette tilstand for alle strømmer, stabil for framen */
+	f = viz_triple_read(&frames, &fresh);
+	if (estimating) {
+		/* Forrige frame var i bevegelse, så også denne er ny */
+		fresh = fresh || estimate_moving;
+		estimate_moving = estimate_streams(f);
+		f = estimated;
+	}
+	for (i = 0; i < trail_streams; i++)
+		poses[i] = &f[i].inverse;
+	trail_fading = trail_on && viz_scene_trail_update(&trail, poses,
+							  trail_streams, fresh);
+
+	for (i = 0; i < stream_count; i++)
+		draw_stream(&f[i], stream_configs[i].color);
+
+	/* Alle strømmer: kulene i ett kall, linjene i ett kall per bredde */
+	viz_scene_end(&renderer, trail_on ? &trail : NULL);
+}
+
+/**
+ * init_trail - Sett opp spor for strømmene i strømmenes farger
+ *
+ * Sporet har plass til VIZ_SCENE_TRAIL_MAX_POSES strømmer; de første
+ * får spor, resten tegnes uten.
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+static int init_trail(void)
+{
+	int i;
+
+	trail_streams = stream_count;
+	if (trail_streams > VIZ_SCENE_TRAIL_MAX_POSES) {
+		trail_streams = VIZ_SCENE_TRAIL_MAX_POSES;
+		printf("Trails cover the first %d of %d streams\n",
+		       trail_streams, stream_count);
+	}
+
+	if (viz_trail_init(&trail, trail_streams * VIZ_SCENE_TRAIL_TRACKS,
+			   VIZ_TRAIL_SAMPLES, trail_seconds) < 0)
+		return -1;
+
+	for (i = 0; i < trail_streams; i++)
+		viz_scene_trail_color(&trail, i, stream_configs[i].color);
+
+	return 0;
+}
+
+/**
+ * parse_color - Les farge fra navn eller RRGGBB
+ * @text: "cyan", "ff8000", ...
+ * @rgb: output - farge (0-1)
+ *
+ * Retur: 0 ved suksess, -1 ved ukjent farge
+ */
+static int parse_color(const char *text, float rgb[3])
+{
+	unsigned int r, g, b;
+	int i;
+
+	for (i = 0; i < COLOR_COUNT; i++) {
+		if (strcasecmp(text, colors[i].name) == 0) {
+			memcpy(rgb, colors[i].rgb, sizeof(colors[i].rgb));
+			return 0;
+		}
+	}
+
+	if (*text == '#')
+		text++;
+	if (strlen(text) != 6 || sscanf(text, "%2x%2x%2x", &r, &g, &b) != 3)
+		return -1;
+
+	rgb[0] = r / 255.0f;
+	rgb[1] = g / 255.0f;
+	rgb[2] = b / 255.0f;
+	return 0;
+}
+
+/**
+ * parse_stream - Les en strøm-spesifikasjon fra kommandolinjen
+ * @spec: "endpoint[,color=c][,geom=file][,robot=mx64|ax18][,label=name]"
+ *	  (endres; delene peker inn i den)
+ * @s: output - strøm
+ * @n: strømmens nummer, velger default-farge
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+static int parse_stream(char *spec, struct stream_config *s, int n)
+{
+	char *option, *value;
+
+	memset(s, 0, sizeof(*s));
+	s->robot_type = -1;
+	memcpy(s->color, colors[n % COLOR_COUNT].rgb, sizeof(s->color));
+
+	s->endpoint = strsep(&spec, ",");
+	if (!*s->endpoint) {
+		fprintf(stderr, "Missing endpoint in stream\n");
+		return -1;
+	}
+	s->label = s->endpoint;
+
+	while ((option = strsep(&spec, ",")) != NULL) {
+		value = strchr(option, '=');
+		if (!value) {
+			fprintf(stderr, "%s: expected key=value, got '%s'\n",
+				s->endpoint, option);
+			return -1;
+		}
+		*value++ = '\0';
+
+		if (strcmp(option, "color") == 0) {
+			if (parse_color(value, s->color) < 0) {
+				fprintf(stderr, "%s: unknown color '%s'\n",
+					s->endpoint, value);
+				return -1;
+			}
+		} else if (strcmp(option, "geom") == 0) {
+			s->geometry_file = value;
+		} else if (strcmp(option, "robot") == 0) {
+			if (strcasecmp(value, "mx64") == 0) {
+				s->robot_type = ROBOT_TYPE_MX64;
+			} else if (strcasecmp(value, "ax18") == 0) {
+				s->robot_type = ROBOT_TYPE_AX18;
+			} else {
+				fprintf(stderr, "%s: unknown robot '%s'\n",
+					s->endpoint, value);
+				return -1;
+			}
+		} else if (strcmp(option, "label") == 0) {
+			s->label = value;
+		} else {
+			fprintf(stderr, "%s: unknown option '%s'\n",
+				s->endpoint, option);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * init_stream - Åpne strømmen og regn IK for home pose
+ * @s: strøm fra parse_stream()
+ * @f: output - starttilstand
+ *
+ * Retur: 0 ved suksess, -1 ved feil
+ */
+static int init_stream(struct stream_config *s, struct stream_frame *f)
+{
+	const struct stewart_geometry *home =
+		s->robot_type == ROBOT_TYPE_AX18 ? &ROBOT_AX18 : &ROBOT_MX64;
+
+	s->pose.magic = VIZ_MAGIC;
+	s->pose.type = VIZ_PACKET_POSE;
+	s->pose.robot_type = s->robot_type >= 0 ? (uint32_t)s->robot_type :
+						  ROBOT_TYPE_MX64;
+	stewart_ik_cache_init(&s->ik_cache, 0.0f);
+	viz_pose_estimator_init(&s->estimator, estimate_ms, estimate_delay_ms);
+
+	if (s->geometry_file) {
+		s->geometry = malloc(sizeof(*s->geometry));
+		if (!s->geometry) {
+			perror("malloc");
+			return -1;
+		}
+		stewart_geometry_slot_init(s->geometry, home);
+		if (stewart_geometry_slot_reload(s->geometry,
+						 s->geometry_file) < 0)
+			return -1;
+		printf("%s: geometry loaded from %s\n", s->label,
+		       s->geometry_file);
+	}
+
+	if (replay_file)
+		s->index = viz_stream_set_add_replay(&streams);
+	else
+		s->index = viz_stream_set_add(&streams, s->endpoint);
+	if (s->index < 0) {
+		fprintf(stderr, "Failed to create receiver on %s\n",
+			s->endpoint);
+		return -1;
+	}
+
+	compute_stream(s, f);
+	return 0;
+}
+
+/**
+ * cleanup_streams - Frigjør geometri og buffere for strømmene
+ *
+ * Mottaks-tråden må være stoppet.
+ */
+static void cleanup_streams(void)
+{
+	struct stream_config *s;
+	int i;
+
+	for (i = 0; i < stream_count; i++) {
+		s = &stream_configs[i];
+		if (s->geometry) {
+			stewart_geometry_slot_destroy(s->geometry);
+			free(s->geometry);
+		}
+	}
+
+	viz_stream_set_destroy(&streams);
+	viz_triple_destroy(&frames);
+	viz_replay_close(&replay);
+	if (record_file && recorder.file) {
+		printf("recording: %llu poses written to %s\n",
+		       (unsigned long long)recorder.records, record_file);
+		viz_recorder_close(&recorder);
+	}
+	free(work);
+	viz_geometry_destroy(&geometry);
+}
+
+static void print_usage(const char *prog)
+{
+	printf("Usage: %s [-m mx64.geom] [-a ax18.geom] [-t s] [-e ms] [-d ms] "
+	       "[-r file]\n", prog);
+	printf("       [-P file [-S speed]] [-B frames] [stream ...]\n");
+	printf("  -m <file>  MX64 geometry file (default: built-in)\n");
+	printf("  -a <file>  AX18 geometry file (default: built-in)\n");
+	printf("  -t <s>     Show the last s seconds as trails (T toggles, "
+	       "default %.0f s)\n", VIZ_TRAIL_DEFAULT_S);
+	printf("  -e <ms>    Extrapolate poses to the render time, at most ms "
+	       "past the\n");
+	printf("             last packet (default %d ms with -d)\n",
+	       VIZ_POSE_ESTIMATOR_DEFAULT_MS);
+	printf("  -d <ms>    Draw streams ms behind, interpolating between "
+	       "packets\n");
+	printf("  -r <file>  Record every received pose to file\n");
+	printf("  -P <file>  Replay a recording instead of receiving (streams "
+	       "default to\n");
+	printf("             the recorded ones)\n");
+	printf("  -S <x>     Replay speed: 1 = as recorded (default), 10 = "
+	       "10x, 0 = max\n");
+	printf("  -B <n>     Headless: render n frames offscreen and print "
+	       "frame times\n");
+	printf("  stream     endpoint[,color=c][,geom=file][,robot=mx64|ax18]"
+	       "[,label=name]\n");
+	printf("             endpoint is udp:<port> or shm:<name> "
+	       "(default udp:9001)\n");
+	printf("             up to %d streams\n", MAX_STREAMS);
+	printf("             color is a name (cyan, magenta, yellow, green, "
+	       "orange, blue,\n");
+	printf("             white, red) or RRGGBB\n");
+	printf("Send SIGHUP to reload the geometry files.\n");
+}
+
+int main(int argc, char **argv)
+{
+	static char default_stream[] = "udp:9001";
+	struct stream_config *s;
+	int i, opt;
+
+	while ((opt = getopt(argc, argv, "m:a:t:e:d:r:P:S:B:h")) != -1) {
+		switch (opt) {
+		case 'm':
+			geometry_file_mx64 = optarg;
+			break;
+		case 'a':
+			geometry_file_ax18 = optarg;
+			break;
+		case 't':
+			trail_seconds = atof(optarg);
+			if (trail_seconds <= 0.0f) {
+				fprintf(stderr, "Trail length must be > 0\n");
+				return 1;
+			}
+			trail_on = 1;
+			break;
+		case 'e':
+			estimate_ms = atof(optarg);
+			if (estimate_ms < 0.0f) {
+				fprintf(stderr, "Extrapolation must be >= 0\n");
+				return 1;
+			}
+			estimating = 1;
+			break;
+		case 'd':
+			estimate_delay_ms = atof(optarg);
+			if (estimate_delay_ms < 0.0f) {
+				fprintf(stderr, "Delay must be >= 0\n");
+				return 1;
+			}
+			estimating = 1;
+			break;
+		case 'r':
+			record_file = optarg;
+			break;
+		case 'P':
+			replay_file = optarg;
+			break;
+		case 'S':
+			replay_speed = atof(optarg);
+			if (replay_speed < 0.0f) {
+				fprintf(stderr, "Replay speed must be >= 0\n");
+				return 1;
+			}
+			break;
+		case 'B':
+			bench_frames = atoi(optarg);
+			if (bench_frames < 1) {
+				fprintf(stderr, "Frame count must be > 0\n");
+				return 1;
+			}
+			break;
+		default:
+			print_usage(argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (record_file && replay_file) {
+		fprintf(stderr, "-r and -P cannot be combined\n");
+		return 1;
+	}
+	if (replay_file && viz_replay_open(&replay, replay_file,
+					   replay_speed) < 0)
+		return 1;
+
+	/* Avspilling uten strømmer på kommandolinjen: navnene fra opptaket */
+	stream_count = optind < argc ? argc - optind :
+		       replay_file ? replay.streams : 1;
+	if (stream_count > MAX_STREAMS) {
+		fprintf(stderr, "At most %d streams\n", MAX_STREAMS);
+		return 1;
+	}
+	if (replay_file && stream_count != replay.streams) {
+		fprintf(stderr, "%s has %d streams, %d given\n", replay_file,
+			replay.streams, stream_count);
+		return 1;
+	}
+	for (i = 0; i < stream_count; i++) {
+		if (parse_stream(optind < argc ? argv[optind + i] :
+				 replay_file ? replay.names[i] :
+					       default_stream,
+				 &stream_configs[i], i) < 0)
+			return 1;
+	}
+
+	printf("Stewart Platform Multi-Stream Visualizer\n");
+	printf("=======================================\n\n");
+
+	work = calloc(stream_count, sizeof(*work));
+	if (!work || viz_stream_set_init(&streams) < 0 ||
+	    viz_triple_init(&frames, stream_count * sizeof(*work)) < 0) {
+		fprintf(stderr, "Failed to allocate streams\n");
+		return 1;
+	}
+
+	/* Initialiser delt geometri */
+	if (viz_geometry_init(&geometry, geometry_file_mx64,
+			      geometry_file_ax18) < 0) {
+		cleanup_streams();
+		return 1;
+	}
+
+	/* Lag receivers og beregn home pose for alle */
+	if (replay_file)
+		printf("Replaying %s at %s:\n", replay_file,
+		       replay_speed > 0.0f ? "recorded pace" : "max speed");
+	else
+		printf("Listening on:\n");
+	for (i = 0; i < stream_count; i++) {
+		s = &stream_configs[i];
+		if (init_stream(s, &work[i]) < 0) {
+			cleanup_streams();
+			return 1;
+		}
+		printf("  %-20s %s (#%02x%02x%02x)\n", s->endpoint, s->label,
+		       (unsigned int)(s->color[0] * 255.0f + 0.5f),
+		       (unsigned int)(s->color[1] * 255.0f + 0.5f),
+		       (unsigned int)(s->color[2] * 255.0f + 0.5f));
+	}
+	printf("\n");
+	if (record_file && start_recording() < 0) {
+		cleanup_streams();
+		return 1;
+	}
+	publish_frames();
+
+	viz_camera_init(&camera);
+	if (viz_window_open(&win, "Stewart Multi", 1024, 768,
+			    bench_frames) < 0) {
+		cleanup_streams();
+		return 1;
+	}
+	viz_camera_attach(&camera, &win, handle_key, NULL);
+
+	if (viz_scene_init(&renderer) < 0 || init_trail() < 0) {
+		viz_window_close(&win);
+		cleanup_streams();
+		return 1;
+	}
+
+	/* Mottak og IK i egen tråd, uavhengig av vsync; etter vinduet */
+	if (start_input() < 0) {
+		viz_trail_destroy(&trail);
+		viz_render_destroy(&renderer);
+		viz_window_close(&win);
+		cleanup_streams();
+		return 1;
+	}
+	viz_geometry_watch(&geometry, &streams.wake);
+
+	if (bench_frames) {
+		viz_bench_run(bench_frames, render_streams, NULL, "multi");
+	} else {
+		printf("Window created. Ready to visualize!\n");
+		printf("\nControls:\n");
+		printf("  Arrow keys:  Rotate camera\n");
+		printf("  +/- or Q/W:  Zoom in/out\n");
+		printf("  R:           Reset camera\n");
+		if (trail.tracks)
+			printf("  T:           Toggle trails\n");
+		printf("  ESC:         Exit\n\n");
+	}
+
+	/* Main loop: tegn bare ved nye poser, kamera- eller vindusendring */
+	while (win.window && !glfwWindowShouldClose(win.window)) {
+		if (win.redraw || viz_triple_pending(&frames)) {
+			win.redraw = 0;
+			render_streams(NULL);
+			glfwSwapBuffers(win.window);
+		}
+
+		if (estimate_moving) {
+			/* Ny estimert pose hver frame; vsync holder takten */
+			glfwPollEvents();
+			win.redraw = 1;
+		} else if (trail_fading) {
+			glfwWaitEventsTimeout(TRAIL_FRAME_S);
+			win.redraw = 1;
+		} else {
+			glfwWaitEvents();
+		}
+	}
+
+	/* Cleanup, mottaks-tråden kan vekke vinduet til den er stoppet */
+	viz_geometry_unwatch();
+	stop_input();
+	viz_trail_destroy(&trail);
+	viz_render_destroy(&renderer);
+	viz_window_close(&win);
+	if (replay_file)
+		print_replay_summary();
+	for (i = 0; i < stream_count; i++) {
+		s = &stream_configs[i];
+		if (!replay_file)
+			viz_stream_stats_print(&streams.streams[s->index].stats,
+					       s->label);
+		stewart_ik_cache_stats_print(&s->ik_cache, s->label);
+		if (estimating)
+			printf("%s estimator: %lu frames extrapolated, "
+			       "%lu capped\n", s->label,
+			       (unsigned long)s->estimator.extrapolated,
+			       (unsigned long)s->estimator.capped);
+	}
+	cleanup_streams();
+
+	return 0;
+}
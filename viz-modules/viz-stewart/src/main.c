@@ -1,10 +1,16 @@
+#define _DEFAULT_SOURCE
 #include "robotics/math/matrix.h"
 #include "robotics/math/utils.h"
 #include "robotics/math/vec3.h"
 #include "viz_protocol.h"
+#include "bench.h"
+#include "ingest.h"
+#include "transport.h"
+#include "render.h"
+#include "triple_buffer.h"
 #include "udp.h"
+#include "viz_gl.h"
 #include <GLFW/glfw3.h>
-#include <OpenGL/glu.h> /* ← LEGG TIL */
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -16,8 +22,14 @@
 #endif
 
 /* Globale variabler */
-static struct viz_pose_packet current_pose;
-static int udp_sock = -1;
+static struct viz_transport transport;
+static const char *endpoint = "udp:9001";
+static struct viz_stream_stats stream_stats; /* Skrives av ingest-tråden */
+static struct viz_ingest ingest;
+static struct viz_triple_buffer poses; /* Ingest -> render */
+static struct viz_window win; /* Vindu, eller offscreen context med -B */
+static int bench_frames; /* -B, 0 = vanlig vindu */
+static struct viz_renderer renderer;
 
 /* MX64 geometri (hardkoded fra ROBOT_MX64) */
 static const float base_points[6][3] = {
@@ -66,12 +78,13 @@ static void transform_point(float x, float y, float z,
 
 /**
  * render_stewart - Render Stewart platform
+ * @current_pose: nyeste pose fra ingest-tråden
  *
  * Tegner base sekskant, platform sekskant (transformert), og ben.
  */
-static void render_stewart(void)
+static void render_stewart(const struct viz_pose_packet *current_pose)
 {
-	float platform_transformed[6][3];
+	struct vec3 base[6], platform[6];
 	int i;
 
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -86,147 +99,158 @@ static void render_stewart(void)
 
 	/* Transform platform punkter med current_pose */
 	for (i = 0; i < 6; i++) {
+		base[i].x = base_points[i][0];
+		base[i].y = base_points[i][1];
+		base[i].z = base_points[i][2];
 		transform_point(platform_points[i][0], platform_points[i][1],
-				platform_points[i][2], &current_pose,
-				&platform_transformed[i][0],
-				&platform_transformed[i][1],
-				&platform_transformed[i][2]);
+				platform_points[i][2], current_pose,
+				&platform[i].x, &platform[i].y,
+				&platform[i].z);
 	}
 
 	/* Tegn base sekskant (blå) */
-	glColor3f(0.3f, 0.3f, 0.8f);
-	glLineWidth(2.0f);
-	glBegin(GL_LINE_LOOP);
-	for (i = 0; i < 6; i++)
-		glVertex3f(base_points[i][0], base_points[i][1],
-			   base_points[i][2]);
-	glEnd();
+	viz_render_color(&renderer, 0.3f, 0.3f, 0.8f);
+	viz_render_line_width(&renderer, 2.0f);
+	viz_render_line_loop(&renderer, base, 6);
 
 	/* Tegn platform sekskant (rød) */
-	glColor3f(0.8f, 0.3f, 0.3f);
-	glBegin(GL_LINE_LOOP);
-	for (i = 0; i < 6; i++)
-		glVertex3f(platform_transformed[i][0],
-			   platform_transformed[i][1],
-			   platform_transformed[i][2]);
-	glEnd();
+	viz_render_color(&renderer, 0.8f, 0.3f, 0.3f);
+	viz_render_line_loop(&renderer, platform, 6);
 
 	/* Tegn ben (grå linjer fra base til platform) */
-	glColor3f(0.5f, 0.5f, 0.5f);
-	glBegin(GL_LINES);
-	for (i = 0; i < 6; i++) {
-		glVertex3f(base_points[i][0], base_points[i][1],
-			   base_points[i][2]);
-		glVertex3f(platform_transformed[i][0],
-			   platform_transformed[i][1],
-			   platform_transformed[i][2]);
-	}
-	glEnd();
+	viz_render_color(&renderer, 0.5f, 0.5f, 0.5f);
+	for (i = 0; i < 6; i++)
+		viz_render_line(&renderer, &base[i], &platform[i]);
 
 	/* Tegn koordinatsystem i origo */
-	glLineWidth(3.0f);
-	glBegin(GL_LINES);
-	/* X-akse (rød) */
-	glColor3f(1.0f, 0.0f, 0.0f);
-	glVertex3f(0.0f, 0.0f, 0.0f);
-	glVertex3f(100.0f, 0.0f, 0.0f);
-	/* Y-akse (grønn) */
-	glColor3f(0.0f, 1.0f, 0.0f);
-	glVertex3f(0.0f, 0.0f, 0.0f);
-	glVertex3f(0.0f, 100.0f, 0.0f);
-	/* Z-akse (blå) */
-	glColor3f(0.0f, 0.0f, 1.0f);
-	glVertex3f(0.0f, 0.0f, 0.0f);
-	glVertex3f(0.0f, 0.0f, 100.0f);
-	glEnd();
+	viz_render_axes(&renderer, 100.0f, 3.0f);
+
+	/* Alt over tegnes her, ett kall per linjebredde */
+	viz_render_flush(&renderer);
 }
 
 /**
- * poll_udp - Poll UDP socket for nye pose packets
+ * ingest_step - Motta nyeste pose og publiser den (ingest-tråden)
+ * @ctx: ubrukt
  *
- * Sjekker om det er kommet nye pose-data via UDP.
- * Oppdaterer current_pose hvis gyldig packet mottas.
+ * Tømmer socket-køen og publiserer nyeste gyldige packet (v1 eller v2).
+ * Eldre packets i køen forkastes og telles i stream_stats sammen med
+ * tap, reordering og latency.
  */
-static void poll_udp(void)
+static void ingest_step(void *ctx)
 {
 	struct viz_pose_packet packet;
-	int n;
-
-	n = udp_receive(udp_sock, &packet, sizeof(packet));
-
-	if (n == sizeof(packet)) {
-		/* Valider packet */
-		if (packet.magic == VIZ_MAGIC &&
-		    packet.type == VIZ_PACKET_POSE) {
-			current_pose = packet;
-			/*
-			printf("Pose: rx=%.1f ry=%.1f rz=%.1f "
-			       "tx=%.1f ty=%.1f tz=%.1f\n",
-			       packet.rx, packet.ry, packet.rz, packet.tx,
-			       packet.ty, packet.tz);
-			       */
-		}
+
+	(void)ctx;
+
+	if (viz_receive_pose(&transport, &packet, &stream_stats) > 0) {
+		*(struct viz_pose_packet *)viz_triple_back(&poses) = packet;
+
+		/* Vekk render-løkken fra glfwWaitEvents() */
+		if (viz_triple_publish(&poses) && win.window)
+			glfwPostEmptyEvent();
 	}
 }
 
-int main(void)
+/**
+ * draw_frame - Tegn nyeste pose (viz_draw_fn)
+ * @ctx: ubrukt
+ */
+static void draw_frame(void *ctx)
+{
+	(void)ctx;
+	render_stewart(viz_triple_read(&poses, NULL));
+}
+
+int main(int argc, char **argv)
 {
-	GLFWwindow *window;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "B:h")) != -1) {
+		switch (opt) {
+		case 'B':
+			bench_frames = atoi(optarg);
+			if (bench_frames < 1) {
+				fprintf(stderr, "Frame count must be > 0\n");
+				return 1;
+			}
+			break;
+		default:
+			printf("Usage: %s [-B frames] [endpoint]\n", argv[0]);
+			printf("  -B <n>     Headless: render n frames "
+			       "offscreen and print frame times\n");
+			printf("  endpoint   udp:<port> or shm:<name> "
+			       "(default udp:9001)\n");
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	/* Valgfri endpoint, f.eks. "shm:stewart" (default udp:9001) */
+	if (optind < argc)
+		endpoint = argv[optind];
 
 	printf("Stewart Platform Visualizer\n");
 	printf("============================\n\n");
 
-	/* Initialiser current_pose til home */
-	memset(&current_pose, 0, sizeof(current_pose));
-
-	/* Lag UDP receiver */
-	udp_sock = udp_create_receiver(VIZ_PORT);
-	if (udp_sock < 0) {
-		fprintf(stderr, "Failed to create UDP receiver\n");
+	/* Alle slots starter nullstilt, dvs. home */
+	if (viz_triple_init(&poses, sizeof(struct viz_pose_packet)) < 0)
 		return 1;
-	}
 
-	/* Initialiser GLFW */
-	if (!glfwInit()) {
-		fprintf(stderr, "Failed to initialize GLFW\n");
+	/* Lag receiver */
+	if (viz_transport_open_receiver(&transport, endpoint) < 0) {
+		fprintf(stderr, "Failed to create receiver on %s\n", endpoint);
 		return 1;
 	}
 
-	/* Lag vindu */
-	window = glfwCreateWindow(800, 600, "Stewart Platform", NULL, NULL);
-	if (!window) {
-		fprintf(stderr, "Failed to create window\n");
-		glfwTerminate();
+	if (viz_window_open(&win, "Stewart Platform", 800, 600,
+			    bench_frames) < 0)
 		return 1;
-	}
-
-	glfwMakeContextCurrent(window);
-	glfwSwapInterval(1); /* VSync */
 
 	/* Setup OpenGL */
 	glEnable(GL_DEPTH_TEST);
 	glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 
+	if (viz_render_init(&renderer) < 0) {
+		viz_window_close(&win);
+		return 1;
+	}
+
+	/* Mottak i egen tråd, uavhengig av vsync; startes etter vinduet */
+	if (viz_ingest_start(&ingest, viz_transport_fd(&transport),
+			     ingest_step, NULL) < 0) {
+		viz_render_destroy(&renderer);
+		viz_window_close(&win);
+		return 1;
+	}
+
 	/* Perspective projection */
 	glMatrixMode(GL_PROJECTION);
 	glLoadIdentity();
 	gluPerspective(45.0, 800.0 / 600.0, 1.0, 2000.0);
 
-	printf("Window created. Listening for UDP packets...\n\n");
-
-	/* Main loop */
-	while (!glfwWindowShouldClose(window)) {
-		poll_udp();
-		render_stewart();
+	if (bench_frames)
+		viz_bench_run(bench_frames, draw_frame, NULL, "stewart");
+	else
+		printf("Window created. Listening on %s...\n\n", endpoint);
+
+	/* Main loop: tegn bare ved ny pose eller når vinduet krever det */
+	while (win.window && !glfwWindowShouldClose(win.window)) {
+		if (win.redraw || viz_triple_pending(&poses)) {
+			win.redraw = 0;
+			draw_frame(NULL);
+			glfwSwapBuffers(win.window);
+		}
 
-		glfwSwapBuffers(window);
-		glfwPollEvents();
+		glfwWaitEvents();
 	}
 
-	/* Cleanup */
-	glfwDestroyWindow(window);
-	glfwTerminate();
-	close(udp_sock);
+	/* Cleanup, ingest-tråden kan vekke vinduet til den er stoppet */
+	viz_ingest_stop(&ingest);
+	viz_render_destroy(&renderer);
+	viz_window_close(&win);
+	viz_transport_close(&transport);
+	viz_stream_stats_print(&stream_stats, endpoint);
+	viz_triple_destroy(&poses);
 
 	return 0;
 }
\ No newline at end of file